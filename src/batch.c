@@ -0,0 +1,612 @@
+/*
+*				batch.c
+*
+* Run a batch of independent conversion jobs listed in a manifest file.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "batch.h"
+#include "prefs.h"
+#include "timing.h"
+#include "xml.h"
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
+
+/* Persistent pool of threads running conversion jobs */
+struct structbatchpool
+  {
+  prefstruct		*prefs0;		/* Base configuration */
+  int			njob;			/* Number of jobs in flight */
+#ifdef USE_THREADS
+  pthread_t		*thread;		/* Pool threads */
+  pthread_mutex_t	mutex;			/* Protects the queue */
+  pthread_cond_t	todocond;		/* Signaled on new jobs */
+  pthread_cond_t	donecond;		/* Signaled on completed jobs */
+  batchjobstruct	*first, *last;		/* Queue of pending jobs */
+  int			endflag;		/* Set to stop the threads */
+#else
+  prefstruct		*jobprefs;		/* Job configuration */
+#endif
+  };
+
+extern const char	notokstr[];
+
+static void	run_batchjob(batchjobstruct *job, prefstruct *prefs0);
+#ifdef USE_THREADS
+static void	*pthread_batchjob(void *arg);
+#endif
+
+/****** makebatch *************************************************************
+PROTO	void makebatch(char *filename)
+PURPOSE	Run the conversion jobs listed in a manifest file, one per line.
+INPUT	Manifest file name.
+OUTPUT	-.
+NOTES	Each line follows the command line syntax: input FITS file(s),
+	followed by -<keyword> <value> overrides, e.g.
+	"r.fits,g.fits,b.fits -OUTFILE_NAME rgb.tif -MAX_LEVEL 10".
+	Overrides apply on top of the configuration read once at startup,
+	which must not have gone through useprefs() yet.
+	Empty lines and lines starting with '#' are skipped. BATCH_NJOBS jobs
+	(NTHREADS if 0) run at the same time on a persistent pool of threads,
+	sharing the NTHREADS threads unless NTHREADS is overridden. Failed
+	jobs are reported and skipped. A single XML file with per-job
+	timings, in manifest order, and a single trace file, are written at
+	the end.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	makebatch(char *filename)
+  {
+   static prefstruct	prefs0;
+   FILE			*file;
+   batchpoolstruct	*pool;
+   batchjobstruct	**job;
+   char			str[MAXCHARL],
+			*pstr;
+   double		nlines, npix;
+   int			j, njob, njobmax, njobdone, xmlflag, traceflag,
+			lineno;
+
+  if (!(file = fopen(filename, "r")))
+    error(EXIT_FAILURE, "*Error*: cannot open batch manifest ", filename);
+
+/* Processing start date and time */
+  prefs.time_start = counter_seconds();
+  set_datetime(prefs.sdate_start, prefs.stime_start);
+
+/* Jobs do not write XML themselves: a single file collects all jobs */
+  xmlflag = prefs.xml_flag;
+  if (xmlflag)
+    init_xml(0);
+  prefs.xml_flag = 0;
+/* Same for the trace */
+  traceflag = prefs.trace_flag;
+  if (traceflag)
+    init_trace();
+  prefs.trace_flag = 0;
+  prefs0 = prefs;
+
+/* Jobs in flight share the available threads */
+  pool = init_batchpool(&prefs0, prefs.batch_njobs);
+
+/* Completed jobs are collected in manifest order */
+  njobmax = 2*get_batchpoolsize(pool);
+  QCALLOC(job, batchjobstruct *, njobmax);
+  nlines = npix = 0.0;
+  njob = njobdone = lineno = 0;
+  for (;;)
+    {
+    if (fgets(str, MAXCHARL, file))
+      {
+      lineno++;
+      for (pstr=str; *pstr==' ' || *pstr=='\t'; pstr++);
+      if (!*pstr || *pstr=='#' || *pstr=='\n' || *pstr=='\r')
+        continue;
+      }
+    else if (njobdone == njob)
+      break;
+    else
+      pstr = NULL;
+/*-- Collect the oldest job when the window is full or at the end */
+    if (!pstr || njob-njobdone >= njobmax)
+      {
+      j = njobdone%njobmax;
+      wait_batchjob(pool, job[j]);
+      if (job[j]->status == RETURN_OK)
+        {
+        if (xmlflag)
+          update_xmljob(&job[j]->xml);
+        nlines += job[j]->xml.nlines;
+        npix += job[j]->xml.npix;
+        }
+      else
+        {
+        sprintf(gstr, "batch job #%d (line %d) failed: ",
+		job[j]->index, job[j]->lineno);
+        warning(gstr, job[j]->error_msg);
+        }
+      free(job[j]);
+      job[j] = NULL;
+      njobdone++;
+      }
+    if (pstr)
+      {
+      j = njob%njobmax;
+      QCALLOC(job[j], batchjobstruct, 1);
+      strcpy(job[j]->str, pstr);
+      job[j]->index = ++njob;
+      job[j]->lineno = lineno;
+      submit_batchjob(pool, job[j]);
+      }
+    }
+  fclose(file);
+  free(job);
+  end_batchpool(pool);
+
+/* Back to the base configuration for the global XML and statistics */
+  prefs = prefs0;
+  prefs.xml_flag = xmlflag;
+  prefs.trace_flag = traceflag;
+  prefs.nlines = nlines;
+  prefs.npix = npix;
+  set_datetime(prefs.sdate_end, prefs.stime_end);
+  prefs.time_diff = counter_seconds() - prefs.time_start;
+  QPRINTF(OUTPUT, "\n===== %d batch job%s processed\n", njob, njob>1? "s":"");
+
+  if (traceflag)
+    {
+    if (write_trace(prefs.trace_name) != RETURN_OK)
+      warning("cannot write trace file ", prefs.trace_name);
+    end_trace();
+    }
+
+  if (xmlflag)
+    {
+    write_xml(prefs.xml_name);
+    end_xml();
+    }
+
+  return;
+  }
+
+
+/****** init_batchpool ********************************************************
+PROTO	batchpoolstruct *init_batchpool(prefstruct *prefs0, int njob)
+PURPOSE	Start a persistent pool of threads for running conversion jobs.
+INPUT	Pointer to the base configuration,
+	number of jobs run at the same time (0 = NTHREADS).
+OUTPUT	Pointer to the new pool.
+NOTES	The NTHREADS threads of the base configuration are shared among the
+	jobs in flight (NTHREADS is modified accordingly in prefs0, which must
+	remain available until end_batchpool() is called). Each pool thread
+	keeps its own job configuration for the lifetime of the pool.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+batchpoolstruct	*init_batchpool(prefstruct *prefs0, int njob)
+  {
+   batchpoolstruct	*pool;
+#ifdef USE_THREADS
+   pthread_attr_t	pthread_attr;
+   int			t;
+#endif
+
+  QCALLOC(pool, batchpoolstruct, 1);
+  pool->prefs0 = prefs0;
+#ifdef USE_THREADS
+  if (njob<1)
+    njob = prefs0->nthreads;
+  if (njob<1)
+    njob = 1;
+  pool->njob = njob;
+  prefs0->nthreads = prefs0->nthreads/njob;
+  if (prefs0->nthreads<1)
+    prefs0->nthreads = 1;
+  QMALLOC(pool->thread, pthread_t, njob);
+  QPTHREAD_MUTEX_INIT(&pool->mutex, NULL);
+  QPTHREAD_COND_INIT(&pool->todocond, NULL);
+  QPTHREAD_COND_INIT(&pool->donecond, NULL);
+  QPTHREAD_ATTR_INIT(&pthread_attr);
+  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
+  for (t=0; t<njob; t++)
+    QPTHREAD_CREATE(&pool->thread[t], &pthread_attr, &pthread_batchjob, pool);
+  QPTHREAD_ATTR_DESTROY(&pthread_attr);
+#else
+  pool->njob = 1;
+  QCALLOC(pool->jobprefs, prefstruct, 1);
+#endif
+
+  return pool;
+  }
+
+
+/****** get_batchpoolsize *****************************************************
+PROTO	int get_batchpoolsize(batchpoolstruct *pool)
+PURPOSE	Return the number of jobs a pool runs at the same time.
+INPUT	Pointer to the pool.
+OUTPUT	Number of jobs.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	get_batchpoolsize(batchpoolstruct *pool)
+  {
+  return pool->njob;
+  }
+
+
+/****** submit_batchjob *******************************************************
+PROTO	void submit_batchjob(batchpoolstruct *pool, batchjobstruct *job)
+PURPOSE	Queue a conversion job for the pool.
+INPUT	Pointer to the pool,
+	pointer to the job.
+OUTPUT	-.
+NOTES	The job must remain available until wait_batchjob() returns. In
+	single-threaded builds the job is run immediately.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	submit_batchjob(batchpoolstruct *pool, batchjobstruct *job)
+  {
+#ifndef USE_THREADS
+   prefstruct	*oldprefs;
+#endif
+
+  job->doneflag = 0;
+  job->next = NULL;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&pool->mutex);
+  if (pool->last)
+    pool->last->next = job;
+  else
+    pool->first = job;
+  pool->last = job;
+  QPTHREAD_COND_SIGNAL(&pool->todocond);
+  QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+#else
+  oldprefs = bindprefs(pool->jobprefs);
+  run_batchjob(job, pool->prefs0);
+  bindprefs(oldprefs);
+  job->doneflag = 1;
+#endif
+
+  return;
+  }
+
+
+/****** wait_batchjob *********************************************************
+PROTO	void wait_batchjob(batchpoolstruct *pool, batchjobstruct *job)
+PURPOSE	Wait for a queued conversion job to complete.
+INPUT	Pointer to the pool,
+	pointer to the job.
+OUTPUT	-.
+NOTES	The outcome is found in the status, error_msg and xml members.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	wait_batchjob(batchpoolstruct *pool, batchjobstruct *job)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&pool->mutex);
+  while (!job->doneflag)
+    QPTHREAD_COND_WAIT(&pool->donecond, &pool->mutex);
+  QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+#endif
+
+  return;
+  }
+
+
+/****** end_batchpool *********************************************************
+PROTO	void end_batchpool(batchpoolstruct *pool)
+PURPOSE	Stop the threads of a pool and free it.
+INPUT	Pointer to the pool.
+OUTPUT	-.
+NOTES	Jobs still queued are run first.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_batchpool(batchpoolstruct *pool)
+  {
+#ifdef USE_THREADS
+   int	t;
+
+  QPTHREAD_MUTEX_LOCK(&pool->mutex);
+  pool->endflag = 1;
+  QPTHREAD_COND_BROADCAST(&pool->todocond);
+  QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+  for (t=0; t<pool->njob; t++)
+    QPTHREAD_JOIN(pool->thread[t], NULL);
+  QPTHREAD_MUTEX_DESTROY(&pool->mutex);
+  QPTHREAD_COND_DESTROY(&pool->todocond);
+  QPTHREAD_COND_DESTROY(&pool->donecond);
+  free(pool->thread);
+#else
+  free(pool->jobprefs);
+#endif
+  free(pool);
+
+  return;
+  }
+
+
+#ifdef USE_THREADS
+/****** pthread_batchjob ******************************************************
+PROTO	void *pthread_batchjob(void *arg)
+PURPOSE	Thread of the job pool: run queued jobs until the pool is ended.
+INPUT	Pointer to the pool.
+OUTPUT	NULL.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	*pthread_batchjob(void *arg)
+  {
+   batchpoolstruct	*pool;
+   batchjobstruct	*job;
+   prefstruct		*jobprefs;
+
+  pool = (batchpoolstruct *)arg;
+  QCALLOC(jobprefs, prefstruct, 1);
+  bindprefs(jobprefs);
+  for (;;)
+    {
+    QPTHREAD_MUTEX_LOCK(&pool->mutex);
+    while (!pool->first && !pool->endflag)
+      QPTHREAD_COND_WAIT(&pool->todocond, &pool->mutex);
+    if (!(job = pool->first))
+      {
+      QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+      break;
+      }
+    if (!(pool->first = job->next))
+      pool->last = NULL;
+    QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+    run_batchjob(job, pool->prefs0);
+    QPTHREAD_MUTEX_LOCK(&pool->mutex);
+    job->doneflag = 1;
+    QPTHREAD_COND_BROADCAST(&pool->donecond);
+    QPTHREAD_MUTEX_UNLOCK(&pool->mutex);
+    }
+  bindprefs(NULL);
+  free(jobprefs);
+
+  return NULL;
+  }
+#endif
+
+
+/****** run_batchjob **********************************************************
+PROTO	void run_batchjob(batchjobstruct *job, prefstruct *prefs0)
+PURPOSE	Run a single conversion job in the calling thread.
+INPUT	Pointer to the job,
+	pointer to the base configuration.
+OUTPUT	-.
+NOTES	The job configuration is set up in the preferences bound to the
+	calling thread. Errors are trapped and reported in the job.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	run_batchjob(batchjobstruct *job, prefstruct *prefs0)
+  {
+   jmp_buf	trap, *oldtrap;
+   char		*argkey[BATCH_MAXARG], *argval[BATCH_MAXARG],
+		*filename[MAXFILE];
+   int		narg, nim;
+
+  job->status = RETURN_ERROR;
+  *job->error_msg = '\0';
+/* Split the line into input file names and keyword/value overrides */
+  if (splitjob(job->str, filename, &nim, argkey, argval, &narg,
+	job->error_msg) != RETURN_OK)
+    return;
+  if (!nim)
+    {
+    sprintf(job->error_msg, "no input image");
+    return;
+    }
+  oldtrap = error_settrap(&trap);
+  if (setjmp(trap))
+    {
+    error_settrap(oldtrap);
+    strncpy(job->error_msg, error_trapmsg(), MAXCHAR-1);
+    freejob();
+    return;
+    }
+  setjob(prefs0, filename, nim, argkey, argval, narg);
+  error_settrap(oldtrap);
+  prefs.xml_flag = prefs.trace_flag = 0;
+
+  NFPRINTF(OUTPUT, "");
+  QPRINTF(OUTPUT, "\n===== Batch job #%d: %s\n\n", job->index, prefs.tiff_name);
+  if ((job->status = makeit()) == RETURN_OK)
+    set_xmljob(&job->xml);
+  else
+    strcpy(job->error_msg, prefs.error_msg);
+  freejob();
+
+  return;
+  }
+
+
+/****** splitjob **************************************************************
+PROTO	int splitjob(char *str, char **filename, int *nfile,
+		char **argkey, char **argval, int *narg, char *errstr)
+PURPOSE	Split a job description into input file names and keyword/value
+	overrides.
+INPUT	Job description, following the command line syntax (modified),
+	array of MAXFILE input file name pointers,
+	pointer to the number of input files,
+	array of BATCH_MAXARG keyword pointers,
+	array of BATCH_MAXARG value pointers,
+	pointer to the number of overrides,
+	error message string (output).
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Everything following a '#' is ignored; empty descriptions return
+	RETURN_OK with no file and no override. Pointers refer to the
+	content of str.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	splitjob(char *str, char **filename, int *nfile,
+		char **argkey, char **argval, int *narg, char *errstr)
+  {
+   char	*tok[BATCH_MAXARG],
+	*fstr, *sptr;
+   int	t, ntok, nim, n;
+
+  ntok = nim = n = 0;
+  for (fstr=mystrtok(str, " \t\n\r"); fstr && *fstr!='#';
+		fstr=mystrtok(NULL, " \t\n\r"))
+    {
+    if (ntok>=BATCH_MAXARG)
+      {
+      sprintf(errstr, "too many arguments");
+      return RETURN_ERROR;
+      }
+    tok[ntok++] = fstr;
+    }
+
+  for (t=0; t<ntok && *tok[t]!='-'; t++)
+    for (fstr=NULL; (fstr=strtok_r(fstr?NULL:tok[t], notokstr, &sptr)); nim++)
+      {
+      if (nim>=MAXFILE)
+        {
+        sprintf(errstr, "too many input images");
+        return RETURN_ERROR;
+        }
+      filename[nim] = fstr;
+      }
+  for (; t<ntok; t++)
+    {
+    if (*tok[t]!='-' || t+1>=ntok)
+      {
+      sprintf(errstr, "-<keyword> <value> expected");
+      return RETURN_ERROR;
+      }
+    argkey[n] = tok[t]+1;
+    argval[n++] = tok[++t];
+    }
+  *nfile = nim;
+  *narg = n;
+
+  return RETURN_OK;
+  }
+
+
+/****** setjob ****************************************************************
+PROTO	void setjob(prefstruct *prefs0, char **filename, int nfile,
+		char **argkey, char **argval, int narg)
+PURPOSE	Set up the configuration of the current thread for a single conversion
+	job.
+INPUT	Pointer to the base configuration,
+	array of input file names,
+	number of input files,
+	array of keywords to override,
+	array of override values,
+	number of overrides.
+OUTPUT	-.
+NOTES	The base configuration must have been read (and passed through
+	preprefs()) but not through useprefs(). It is left untouched: string
+	lists are duplicated, and must be released with freejob() once the
+	job has been run with makeit().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	setjob(prefstruct *prefs0, char **filename, int nfile,
+		char **argkey, char **argval, int narg)
+  {
+   int	t;
+
+  if (nfile>MAXFILE)
+    error(EXIT_FAILURE, "*Error*: Too many input images: ", filename[MAXFILE]);
+  prefs = *prefs0;
+/* String lists are re-allocated by overrides */
+  for (t=0; t<MAXTAG; t++)
+    prefs.channel_tags[t] = NULL;
+  for (t=0; t<2; t++)
+    prefs.mosaic_key[t] = NULL;
+  for (t=0; t<MAXTAG; t++)
+    if (prefs0->channel_tags[t])
+      {
+      QMALLOC(prefs.channel_tags[t], char, MAXCHAR);
+      strcpy(prefs.channel_tags[t], prefs0->channel_tags[t]);
+      }
+  for (t=0; t<2; t++)
+    if (prefs0->mosaic_key[t])
+      {
+      QMALLOC(prefs.mosaic_key[t], char, MAXCHAR);
+      strcpy(prefs.mosaic_key[t], prefs0->mosaic_key[t]);
+      }
+  for (t=0; t<nfile; t++)
+    prefs.file_name[t] = filename[t];
+  prefs.nfile = nfile;
+  overprefs(argkey, argval, narg);
+  useprefs();
+
+  return;
+  }
+
+
+/****** freejob ***************************************************************
+PROTO	void freejob(void)
+PURPOSE	Free the job-specific part of the global configuration.
+INPUT	-.
+OUTPUT	-.
+NOTES	See setjob().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	freejob(void)
+  {
+   int	t;
+
+  for (t=0; t<MAXTAG; t++)
+    {
+    free(prefs.channel_tags[t]);
+    prefs.channel_tags[t] = NULL;
+    }
+  for (t=0; t<2; t++)
+    {
+    free(prefs.mosaic_key[t]);
+    prefs.mosaic_key[t] = NULL;
+    }
+
+  return;
+  }
+
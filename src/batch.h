@@ -0,0 +1,78 @@
+/*
+*				batch.h
+*
+* Include file for batch.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#ifndef _PREFS_H_
+#include "prefs.h"
+#endif
+
+#ifndef _XML_H_
+#include "xml.h"
+#endif
+
+/*----------------------------- Internal constants --------------------------*/
+#define	BATCH_MAXARG	1024		/* Max. number of arguments per job */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct structbatchjob
+  {
+  char			str[MAXCHARL];		/* Job description */
+  int			index;			/* Job index (from 1) */
+  int			lineno;			/* Manifest line number */
+  int			status;			/* RETURN_OK or RETURN_ERROR */
+  int			doneflag;		/* Set once the job has run */
+  char			error_msg[MAXCHAR];	/* Error message */
+  xmljobstruct		xml;			/* Job meta-data */
+  struct structbatchjob	*next;			/* Next job in the queue */
+  }	batchjobstruct;
+
+typedef struct structbatchpool	batchpoolstruct;	/* Opaque job pool */
+
+/*------------------------------- functions ---------------------------------*/
+extern batchpoolstruct	*init_batchpool(prefstruct *prefs0, int njob);
+
+extern int		get_batchpoolsize(batchpoolstruct *pool),
+			splitjob(char *str, char **filename, int *nfile,
+				char **argkey, char **argval, int *narg,
+				char *errstr);
+
+extern void		end_batchpool(batchpoolstruct *pool),
+			freejob(void),
+			makebatch(char *filename),
+			setjob(prefstruct *prefs0, char **filename, int nfile,
+				char **argkey, char **argval, int narg),
+			submit_batchjob(batchpoolstruct *pool,
+				batchjobstruct *job),
+			wait_batchjob(batchpoolstruct *pool,
+				batchjobstruct *job);
+
+#endif
+
@@ -0,0 +1,654 @@
+/*
+*				bench.c
+*
+* Benchmark the conversion pipeline on synthetic images.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include	<errno.h>
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<time.h>
+#include	<unistd.h>
+#include	<sys/stat.h>
+#include	<sys/types.h>
+
+#include	"define.h"
+#include	"globals.h"
+#include	"fits/fitscat.h"
+#include	"batch.h"
+#include	"field.h"
+#include	"image.h"
+#include	"prefs.h"
+#include	"regress.h"
+#include	"synth.h"
+#include	"tag.h"
+#include	"timing.h"
+
+#define		SYNTAX \
+"stiff-bench [-c <configuration_file>] [-d <work_directory>]\n"\
+"      [-s <image_size>] [-n <repeats>] [-t <max_threads>] [-b <bitpix>]\n"\
+"      [-o <output_file>] [-k] [-r|-w <reference_file>] [-T <fraction>]\n"\
+"      [-<keyword> <value>]\n"\
+"> -d: directory for synthetic images and outputs (default " BENCH_DIR ")\n"\
+"> -s: width and height of synthetic images (default 2048)\n"\
+"> -n: number of runs of each benchmark; the fastest is kept (default 3)\n"\
+"> -t: max. number of threads for conversions (default NTHREADS)\n"\
+"> -b: BITPIX of the images used for conversions (default -32)\n"\
+"> -o: output file (default: standard output)\n"\
+"> -k: keep synthetic images and outputs\n"\
+"> -r: run regression tests against a reference file instead of benchmarks\n"\
+"> -w: run regression tests and write the reference file\n"\
+"> -T: max. fractional loss of throughput in regression tests (default 0.2)\n"\
+"> -<keyword> <value>: configuration overrides for all conversions\n"
+
+/*----------------------------- Internal constants --------------------------*/
+#define	BENCH_DIR	"stiff_bench"	/* Default work directory */
+#define	BENCH_SIZE	2048		/* Default image width and height */
+#define	BENCH_NCHAN	3		/* Number of channels in colour runs */
+#define	BENCH_NREP	3		/* Default number of runs */
+#define	BENCH_BITPIX	BP_FLOAT	/* Default BITPIX for conversions */
+#define	BENCH_SEED	1		/* Random seed of synthetic images */
+#define	BENCH_NBITPIX	5		/* Number of BITPIX values */
+#define	BENCH_NCONV	3		/* Number of conversion modes */
+#define	BENCH_NARG	8		/* Number of built-in overrides */
+
+extern const char	notokstr[];
+
+static const int	bench_bitpix[BENCH_NBITPIX] = {BP_BYTE, BP_SHORT,
+				BP_LONG, BP_FLOAT, BP_DOUBLE},
+			bench_bits[3] = {8, 16, -32};
+
+static const char	*bench_convname[BENCH_NCONV] = {"single", "binned",
+				"pyramid"},
+			*bench_convext[BENCH_NCONV] = {"tif", "tif", "ptif"},
+			*bench_convbin[BENCH_NCONV] = {"1", "2", "1"};
+
+static prefstruct	bench_prefs0;
+
+static void		bench_conv(FILE *file, char *dirname, int size,
+				int bitpix, int nthreads, int nrep),
+			bench_filename(char *filename, char *dirname,
+				int size, int bitpix, int chan),
+			bench_micro(FILE *file, char *dirname, int size,
+				int nrep),
+			bench_pixels(FILE *file, char *dirname, int size,
+				int bitpix, int nchan, int nrep),
+			bench_stages(FILE *file, timingcountstruct *stage),
+			bench_sumstages(timingcountstruct *stage);
+
+/********************************** main ************************************/
+int	main(int argc, char *argv[])
+  {
+   FILE		*file;
+   struct tm	*tm;
+   time_t	thetime;
+   char		filename[MAXCHAR],
+		*regressname[BENCH_NCHAN],
+		**argkey, **argval, *dirname, *outname, *prefsname, *goldname;
+   double	slowfrac;
+   int		a,b,c, narg, opt, size, nrep, nthreads, bitpix, keepflag,
+		writeflag, nfail;
+
+  if (argc>1 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help")))
+    error(EXIT_SUCCESS, "SYNTAX: ", SYNTAX);
+  QMALLOC(argkey, char *, argc);
+  QMALLOC(argval, char *, argc);
+
+/* Default parameters */
+  prefs.command_line = argv;
+  prefs.ncommand_line = argc;
+  prefsname = "stiff.conf";
+  dirname = BENCH_DIR;
+  outname = goldname = NULL;
+  slowfrac = REGRESS_SLOWFRAC;
+  size = BENCH_SIZE;
+  nrep = BENCH_NREP;
+  bitpix = BENCH_BITPIX;
+  nthreads = keepflag = writeflag = nfail = 0;
+  narg = 0;
+
+  for (a=1; a<argc; a++)
+    {
+    if (*argv[a] != '-')
+      error(EXIT_FAILURE, "SYNTAX: ", SYNTAX);
+    opt = (int)argv[a][1];
+    if (strlen(argv[a])==2)
+      {
+      if (opt != 'k' && a>=argc-1)
+        error(EXIT_FAILURE, "SYNTAX: ", SYNTAX);
+      switch(opt)
+        {
+        case 'c':
+          prefsname = argv[++a];
+          break;
+        case 'd':
+          dirname = argv[++a];
+          break;
+        case 's':
+          size = atoi(argv[++a]);
+          break;
+        case 'n':
+          nrep = atoi(argv[++a]);
+          break;
+        case 't':
+          nthreads = atoi(argv[++a]);
+          break;
+        case 'b':
+          bitpix = atoi(argv[++a]);
+          break;
+        case 'o':
+          outname = argv[++a];
+          break;
+        case 'k':
+          keepflag = 1;
+          break;
+        case 'r':
+          goldname = argv[++a];
+          writeflag = 0;
+          break;
+        case 'w':
+          goldname = argv[++a];
+          writeflag = 1;
+          break;
+        case 'T':
+          slowfrac = atof(argv[++a]);
+          break;
+        default:
+          error(EXIT_FAILURE, "SYNTAX: ", SYNTAX);
+        }
+      }
+    else if (a<argc-1)
+      {
+      argkey[narg] = &argv[a][1];
+      argval[narg++] = argv[++a];
+      }
+    else
+      error(EXIT_FAILURE, "SYNTAX: ", SYNTAX);
+    }
+
+  if (size<16 || nrep<1)
+    error(EXIT_FAILURE, "*Error*: invalid image size or number of repeats",
+	"");
+  for (b=0; b<BENCH_NBITPIX; b++)
+    if (bitpix == bench_bitpix[b])
+      break;
+  if (b>=BENCH_NBITPIX)
+    error(EXIT_FAILURE, "*Error*: unsupported BITPIX for conversions", "");
+
+/* Base configuration, shared by all runs */
+  strcpy(prefs.prefs_name, prefsname);
+  readprefs(prefs.prefs_name, argkey, argval, narg);
+  preprefs();
+  if (nthreads<1)
+    nthreads = prefs.nthreads;
+  bench_prefs0 = prefs;
+
+/* Synthetic images */
+  if (mkdir(dirname, 0755) && errno != EEXIST)
+    error(EXIT_FAILURE, "*Error*: cannot create directory ", dirname);
+  for (b=0; b<BENCH_NBITPIX; b++)
+    for (c=0; c<(bench_bitpix[b]==bitpix? BENCH_NCHAN : 1); c++)
+      {
+      if (goldname && bench_bitpix[b]!=bitpix)
+        continue;
+      bench_filename(filename, dirname, size, bench_bitpix[b], c);
+      if (access(filename, R_OK))
+        {
+        fprintf(OUTPUT, "> Simulating %s\n", filename);
+        if (synth_fits(filename, size, size, bench_bitpix[b], c, BENCH_SEED)
+		!= RETURN_OK)
+          error(EXIT_FAILURE, "*Error*: cannot write ", filename);
+        }
+      }
+
+/* Regression tests */
+  if (goldname)
+    {
+    for (c=0; c<BENCH_NCHAN; c++)
+      {
+      QMALLOC(regressname[c], char, MAXCHAR);
+      bench_filename(regressname[c], dirname, size, bitpix, c);
+      }
+    nfail = regress_run(&bench_prefs0, regressname, BENCH_NCHAN, size*size,
+	dirname, goldname, writeflag, slowfrac, nrep);
+    for (c=0; c<BENCH_NCHAN; c++)
+      free(regressname[c]);
+    }
+  else
+    {
+    if (!outname)
+      file = stdout;
+    else if (!(file = fopen(outname, "w")))
+      error(EXIT_FAILURE, "*Error*: cannot open for writing ", outname);
+
+    thetime = time(NULL);
+    tm = localtime(&thetime);
+    fprintf(file, "{\n \"software\": \"%s-bench\",\n \"version\": \"%s\",\n"
+	" \"date\": \"%04d-%02d-%02dT%02d:%02d:%02d\",\n"
+	" \"threads_max\": %d,\n \"image_size\": [%d, %d],\n"
+	" \"repeats\": %d,\n",
+	BANNER, MYVERSION,
+	tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday,
+	tm->tm_hour, tm->tm_min, tm->tm_sec,
+	nthreads, size, size, nrep);
+
+/*-- Microbenchmarks */
+    fprintf(file, " \"kernels\": [");
+    bench_micro(file, dirname, size, nrep);
+    bench_pixels(file, dirname, size, bitpix, 1, nrep);
+    bench_pixels(file, dirname, size, bitpix, BENCH_NCHAN, nrep);
+    fprintf(file, "\n ],\n");
+
+/*-- End-to-end conversions */
+    fprintf(file, " \"conversions\": [");
+    bench_conv(file, dirname, size, bitpix, nthreads, nrep);
+    fprintf(file, "\n ]\n}\n");
+
+    if (file != stdout)
+      fclose(file);
+    }
+
+/* Clean up */
+  if (!keepflag)
+    {
+    for (b=0; b<BENCH_NBITPIX; b++)
+      for (c=0; c<(bench_bitpix[b]==bitpix? BENCH_NCHAN : 1); c++)
+        {
+        bench_filename(filename, dirname, size, bench_bitpix[b], c);
+        remove(filename);
+        }
+    for (c=0; c<BENCH_NCONV; c++)
+      {
+      sprintf(filename, "%s/bench_%s.%s", dirname, bench_convname[c],
+	bench_convext[c]);
+      remove(filename);
+      }
+    rmdir(dirname);
+    }
+
+  free(argkey);
+  free(argval);
+
+  exit(nfail? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+
+/****** bench_micro ***********************************************************
+PROTO	void bench_micro(FILE *file, char *dirname, int size, int nrep)
+PURPOSE	Benchmark the reading of FITS rows and the computation of image
+	statistics for all BITPIX values.
+INPUT	Output file,
+	work directory,
+	image size,
+	number of runs.
+OUTPUT	-.
+NOTES	Rows are read with read_fieldrow(), which calls read_body(). The
+	fastest run is reported. Every run of make_imastats() starts from the
+	same min and max quantiles.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	bench_micro(FILE *file, char *dirname, int size, int nrep)
+  {
+   fieldstruct	*field;
+   PIXTYPE	*buf,
+		min, max;
+   char		filename[MAXCHAR],
+		*pfilename;
+   double	npix, dtime, treadmin, tstatmin;
+   int		b, r, y;
+
+  npix = (double)size*size;
+  QMALLOC(buf, PIXTYPE, size);
+  pfilename = filename;
+  for (b=0; b<BENCH_NBITPIX; b++)
+    {
+    bench_filename(filename, dirname, size, bench_bitpix[b], 0);
+    fprintf(OUTPUT, "> Reading and statistics: BITPIX %d\n", bench_bitpix[b]);
+    setjob(&bench_prefs0, &pfilename, 1, NULL, NULL, 0);
+    field = load_field(filename, NULL, 0);
+    tag_fields(&field, 1);
+    min = field->min;
+    max = field->max;
+    treadmin = tstatmin = BIG;
+    for (r=0; r<nrep; r++)
+      {
+      dtime = counter_seconds();
+      seek_fieldrow(field, 0);
+      for (y=0; y<size; y++)
+        read_fieldrow(field, buf);
+      if ((dtime = counter_seconds() - dtime) < treadmin)
+        treadmin = dtime;
+/*---- make_imastats() replaces the min and max quantiles with levels */
+      field->min = min;
+      field->max = max;
+      dtime = counter_seconds();
+      make_imastats(field, NULL, 0, 1, 1, 1);
+      if ((dtime = counter_seconds() - dtime) < tstatmin)
+        tstatmin = dtime;
+      }
+    fprintf(file, "%s\n  {\"kernel\": \"read_body\", \"bitpix\": %d,"
+	" \"nchan\": 1, \"time\": %.6f, \"mpix_s\": %.3f}",
+	b? ",":"", bench_bitpix[b], treadmin, npix/treadmin*1e-6);
+    fprintf(file, ",\n  {\"kernel\": \"make_imastats\", \"bitpix\": %d,"
+	" \"nchan\": 1, \"time\": %.6f, \"mpix_s\": %.3f}",
+	bench_bitpix[b], tstatmin, npix/tstatmin*1e-6);
+    end_field(field);
+    freejob();
+    }
+  free(buf);
+
+  return;
+  }
+
+
+/****** bench_pixels **********************************************************
+PROTO	void bench_pixels(FILE *file, char *dirname, int size, int bitpix,
+			int nchan, int nrep)
+PURPOSE	Benchmark the conversion of data to pixel values and the
+	re-arrangement of pixels into tiles.
+INPUT	Output file,
+	work directory,
+	image size,
+	BITPIX of the input images,
+	number of channels,
+	number of runs.
+OUTPUT	-.
+NOTES	data_to_pix() is called on chunks of IMAGE_NLINES lines, and
+	raster_to_tiles() on rows of tiles, as in the conversion pipeline.
+	Both are benchmarked for 8, 16 and -32 bits per channel. The fastest
+	run is reported.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	bench_pixels(FILE *file, char *dirname, int size, int bitpix,
+			int nchan, int nrep)
+  {
+   fieldstruct	*field[BENCH_NCHAN];
+   float	*data[BENCH_NCHAN], *data0[BENCH_NCHAN],
+		*buffer;
+   unsigned char *pix, *tiles;
+   char		filename[BENCH_NCHAN][MAXCHAR],
+		*pfilename[BENCH_NCHAN];
+   size_t	npix, nbytes;
+   double	dtime, tconvmin, ttilemin;
+   int		a,b, r, y, nlines, bypp, tilesize;
+
+  npix = (size_t)size*size;
+  for (a=0; a<nchan; a++)
+    {
+    bench_filename(filename[a], dirname, size, bitpix, a);
+    pfilename[a] = filename[a];
+    }
+  setjob(&bench_prefs0, pfilename, nchan, NULL, NULL, 0);
+  tilesize = prefs.tile_size;
+  for (a=0; a<nchan; a++)
+    field[a] = load_field(filename[a], NULL, 0);
+  tag_fields(field, nchan);
+  for (a=0; a<nchan; a++)
+    {
+    set_fieldlevels(field[a], NULL, 0);
+    QMALLOC(data0[a], float, npix);
+    QMALLOC(data[a], float, npix);
+    seek_fieldrow(field[a], 0);
+    for (y=0; y<size; y++)
+      read_fieldrow(field[a], data0[a] + (size_t)y*size);
+    }
+  QMALLOC(buffer, float, (size_t)size*IMAGE_NLINES);
+  QMALLOC(pix, unsigned char, npix*nchan*sizeof(float));
+  QMALLOC(tiles, unsigned char,
+	(size_t)(size+tilesize-1)/tilesize*tilesize*tilesize*nchan
+	*sizeof(float));
+
+  for (b=0; b<3; b++)
+    {
+    fprintf(OUTPUT, "> Pixel conversion and tiling: %d channel%s, %d bits\n",
+	nchan, nchan>1? "s":"", bench_bits[b]);
+    bypp = bench_bits[b]>0? bench_bits[b]/8 : (int)sizeof(float);
+    nbytes = (size_t)nchan*bypp;
+    tconvmin = ttilemin = BIG;
+    for (r=0; r<nrep; r++)
+      {
+/*---- data_to_pix() modifies its input: start from the original data */
+      for (a=0; a<nchan; a++)
+        memcpy(data[a], data0[a], npix*sizeof(float));
+      dtime = counter_seconds();
+      for (y=0; y<size; y+=IMAGE_NLINES)
+        {
+        nlines = size-y<IMAGE_NLINES? size-y : IMAGE_NLINES;
+        data_to_pix(field, data, (size_t)y*size, pix + (size_t)y*size*nbytes,
+		(size_t)nlines*size, nchan, bypp, bench_bits[b]<0, buffer);
+        }
+      if ((dtime = counter_seconds() - dtime) < tconvmin)
+        tconvmin = dtime;
+      dtime = counter_seconds();
+      for (y=0; y<size; y+=tilesize)
+        raster_to_tiles(pix + (size_t)y*size*nbytes, tiles, size,
+		size-y<tilesize? size-y : tilesize, tilesize, (int)nbytes);
+      if ((dtime = counter_seconds() - dtime) < ttilemin)
+        ttilemin = dtime;
+      }
+    fprintf(file, ",\n  {\"kernel\": \"data_to_pix\", \"bitpix\": %d,"
+	" \"nchan\": %d, \"bits\": %d, \"time\": %.6f, \"mpix_s\": %.3f}",
+	bitpix, nchan, bench_bits[b], tconvmin, npix/tconvmin*1e-6);
+    fprintf(file, ",\n  {\"kernel\": \"raster_to_tiles\", \"nchan\": %d,"
+	" \"bits\": %d, \"tile_size\": %d, \"time\": %.6f, \"mpix_s\": %.3f}",
+	nchan, bench_bits[b], tilesize, ttilemin, npix/ttilemin*1e-6);
+    }
+
+  for (a=0; a<nchan; a++)
+    {
+    free(data0[a]);
+    free(data[a]);
+    end_field(field[a]);
+    }
+  free(buffer);
+  free(pix);
+  free(tiles);
+  freejob();
+
+  return;
+  }
+
+
+/****** bench_conv ************************************************************
+PROTO	void bench_conv(FILE *file, char *dirname, int size, int bitpix,
+			int nthreads, int nrep)
+PURPOSE	Benchmark end-to-end conversions with an increasing number of
+	threads.
+INPUT	Output file,
+	work directory,
+	image size,
+	BITPIX of the input images,
+	max. number of threads,
+	number of runs.
+OUTPUT	-.
+NOTES	Colour images are converted to a single TIFF, to a binned TIFF and to
+	a tiled pyramid, with 1, 2, 4, ... threads up to the max. number of
+	threads. The time spent in every processing stage by the fastest run
+	is reported, so that the binning loops and the reading of FITS rows
+	are benchmarked in context.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	bench_conv(FILE *file, char *dirname, int size, int bitpix,
+			int nthreads, int nrep)
+  {
+   timingcountstruct	stage[TIMING_NSTAGE];
+   char		filename[BENCH_NCHAN][MAXCHAR], outname[MAXCHAR],
+		nthreadstr[16],
+		*pfilename[BENCH_NCHAN],
+		*argkey[BENCH_NARG], *argval[BENCH_NARG];
+   double	npix, dtime, tmin, tmin1;
+   int		a,c, n, r, nt, firstflag;
+
+  for (a=0; a<BENCH_NCHAN; a++)
+    {
+    bench_filename(filename[a], dirname, size, bitpix, a);
+    pfilename[a] = filename[a];
+    }
+
+  firstflag = 1;
+  for (c=0; c<BENCH_NCONV; c++)
+    {
+    sprintf(outname, "%s/bench_%s.%s", dirname, bench_convname[c],
+	bench_convext[c]);
+    n = 0;
+    argkey[n] = "OUTFILE_NAME"; argval[n++] = outname;
+    argkey[n] = "BINNING"; argval[n++] = (char *)bench_convbin[c];
+    argkey[n] = "NTHREADS"; argval[n++] = nthreadstr;
+    argkey[n] = "VERBOSE_TYPE"; argval[n++] = "QUIET";
+    argkey[n] = "WRITE_XML"; argval[n++] = "N";
+    argkey[n] = "WRITE_TRACE"; argval[n++] = "N";
+    npix = (double)size*size;
+    tmin1 = 0.0;
+    for (nt=1; nt<=nthreads; nt = (nt<nthreads && nt*2>nthreads)? nthreads
+						: nt*2)
+      {
+      fprintf(OUTPUT, "> Conversion: %s, %d thread%s\n", bench_convname[c],
+		nt, nt>1? "s":"");
+      sprintf(nthreadstr, "%d", nt);
+      tmin = BIG;
+      for (r=0; r<nrep; r++)
+        {
+        setjob(&bench_prefs0, pfilename, BENCH_NCHAN, argkey, argval, n);
+        reset_timing();
+        dtime = counter_seconds();
+        if (makeit() != RETURN_OK)
+          error(EXIT_FAILURE, "*Error*: benchmark conversion failed: ",
+		prefs.error_msg);
+        dtime = counter_seconds() - dtime;
+        freejob();
+/*------ Keep the stage timings of the fastest run */
+        if (dtime < tmin)
+          {
+          tmin = dtime;
+          bench_sumstages(stage);
+          }
+        }
+      if (nt==1)
+        tmin1 = tmin;
+      fprintf(file, "%s\n  {\"mode\": \"%s\", \"bitpix\": %d, \"nchan\": %d,"
+	" \"binning\": %s, \"nthreads\": %d, \"time\": %.6f,"
+	" \"mpix_s\": %.3f, \"speedup\": %.3f,\n   \"stages\": ",
+	firstflag? "":",", bench_convname[c], bitpix, BENCH_NCHAN,
+	bench_convbin[c], nt, tmin, npix/tmin*1e-6, tmin1/tmin);
+      bench_stages(file, stage);
+      fprintf(file, "}");
+      firstflag = 0;
+      if (nt==nthreads)
+        break;
+      }
+    }
+
+  return;
+  }
+
+
+/****** bench_sumstages *******************************************************
+PROTO	void bench_sumstages(timingcountstruct *stage)
+PURPOSE	Sum up the timing counters of all threads, stage by stage.
+INPUT	Array of TIMING_NSTAGE counters.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	bench_sumstages(timingcountstruct *stage)
+  {
+   timingthreadstruct	*thread;
+   timingcountstruct	*count;
+   int			s;
+
+  memset(stage, 0, TIMING_NSTAGE*sizeof(timingcountstruct));
+  for (thread=get_timingthreads(); thread; thread=thread->next)
+    for (count=thread->count, s=0; s<TIMING_NSTAGE; s++, count++)
+      {
+      stage[s].ncall += count->ncall;
+      stage[s].wall += count->wall;
+      stage[s].cpu += count->cpu;
+      stage[s].npix += count->npix;
+      stage[s].nbytes += count->nbytes;
+      }
+
+  return;
+  }
+
+
+/****** bench_stages **********************************************************
+PROTO	void bench_stages(FILE *file, timingcountstruct *stage)
+PURPOSE	Write the timings of processing stages as a JSON object.
+INPUT	Output file,
+	array of TIMING_NSTAGE counters.
+OUTPUT	-.
+NOTES	Times are summed over threads. The throughput of a stage is the
+	number of pixels it processed divided by its (summed) wall-clock time.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	bench_stages(FILE *file, timingcountstruct *stage)
+  {
+   int	s;
+
+  fprintf(file, "{");
+  for (s=0; s<TIMING_NSTAGE; s++)
+    fprintf(file, "%s\n    \"%s\": {\"ncall\": %ld, \"wall\": %.6f,"
+	" \"cpu\": %.6f, \"mpix_s\": %.3f}",
+	s? ",":"", timing_stagename[s], stage[s].ncall, stage[s].wall,
+	stage[s].cpu,
+	stage[s].wall>0.0? stage[s].npix/stage[s].wall*1e-6 : 0.0);
+  fprintf(file, "}");
+
+  return;
+  }
+
+
+/****** bench_filename ********************************************************
+PROTO	void bench_filename(char *filename, char *dirname, int size,
+			int bitpix, int chan)
+PURPOSE	Build the name of a synthetic image.
+INPUT	Pointer to the file name (MAXCHAR characters),
+	work directory,
+	image size,
+	BITPIX,
+	channel index.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	bench_filename(char *filename, char *dirname, int size,
+			int bitpix, int chan)
+  {
+  sprintf(filename, "%s/synth_%d_bp%d_c%d.fits", dirname, size, bitpix, chan);
+
+  return;
+  }
+
@@ -0,0 +1,707 @@
+/*
+*				cutout.c
+*
+* Extract multiple cutouts from the input images in a single pass.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <math.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "cutout.h"
+#include "datamem.h"
+#include "field.h"
+#include "image.h"
+#include "prefs.h"
+#include "progress.h"
+#include "quicklook.h"
+#include "tiff.h"
+#include "timing.h"
+
+static int	compare_cutouts(const void *cutout1, const void *cutout2);
+static void	bin_cutoutline(cutoutstruct *cutout, int a, int binsizey),
+		convert_cutoutlines(cutoutstruct *cutout, int nchan),
+		name_cutout(char *filename, int n, char *name);
+
+#ifdef USE_THREADS
+#include "threads.h"
+
+/* Multithreading context of a cutout conversion */
+typedef struct structcutoutthread
+  {
+  cutoutstruct		**queue;		/* Cutouts with strips to convert */
+  pthread_mutex_t	mutex;			/* Queue and cutout state lock */
+  pthread_cond_t	cond;			/* Queue and cutout state changes */
+  int			ncutout,		/* Number of cutouts (queue size) */
+			nchan,			/* Number of channels */
+			qfirst,			/* First cutout in the queue */
+			nqueue,			/* Number of cutouts in the queue */
+			endflag,		/* Set at the end of the sweep */
+			errflag;		/* Error flag */
+  char			error_msg[MAXCHAR];	/* First error message */
+  }	cutoutthreadstruct;
+
+   static void		*pthread_convert_cutouts(void *arg),
+			queue_cutout(cutoutthreadstruct *cthread,
+				cutoutstruct *cutout);
+#endif
+
+/* First row swept in a cutout channel: rows are swept top-down unless */
+/* flipped, so that binned lines come out in output order */
+#define	CUTOUT_START(cutout, a, flipyflag) \
+		((flipyflag)? (cutout)->field[a].origin[1] \
+		: -((cutout)->field[a].origin[1]+(cutout)->field[a].size[1]-1))
+
+/****** image_convert_cutouts *************************************************
+PROTO	void image_convert_cutouts(char *filename, fieldstruct **field,
+			int nchan)
+PURPOSE	Extract all the REGION cutouts from the input images in a single
+	pass, and convert them to TIFF, JPEG or PNG images.
+INPUT	Output file name (each cutout number is appended to the base name),
+	array of pointers to the input fields,
+	number of input fields (channels).
+OUTPUT	-.
+NOTES	Uses the global preferences. All channels are swept once and in
+	step, reading only the column span of the cutouts that overlap the
+	current row. Row segments are binned as they are read into a ring of
+	CUTOUT_NLINES-line strips per cutout, held in a data store charged
+	to MEM_MAX. Complete strips are converted and written while the sweep
+	goes on, in parallel across cutouts, and each cutout is released
+	after its last strip.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	image_convert_cutouts(char *filename, fieldstruct **field, int nchan)
+  {
+   cutoutstruct		*cutout, *cut, **sorted, **active;
+   catstruct		*descat;
+   tabstruct		*tab, *destab;
+   PIXTYPE		*rowbuf;
+   char			keyword[80];
+   double		npix, npixrow;
+   int			*nactive, *next,
+			a,b,c,k, s, y, ncutout, nleft, nline, nready, nstrip,
+			xmin,xmax, ymin,ymax, fwidth,fheight, binsizey0,
+			binsizey, flipxflag, flipyflag, naxis1max, widthmax,
+			errflag, nproc;
+
+  if (prefs.format_type2 != FORMAT_TIFF && prefs.format_type2 != FORMAT_JPEG
+	&& prefs.format_type2 != FORMAT_PNG)
+    error(EXIT_FAILURE, "*Error*: multiple cutouts require ",
+	"TIFF, JPEG or PNG output");
+
+  flipxflag = (prefs.flip_type == FLIP_X) || (prefs.flip_type == FLIP_XY);
+  flipyflag = (prefs.flip_type == FLIP_Y) || (prefs.flip_type == FLIP_XY);
+  binsizey0 = prefs.bin_size[1];
+  descat = NULL;
+  destab = NULL;
+  if (prefs.header_flag)
+    {
+/*-- Create a new dummy cat/tab for storing the description header */
+    descat = new_cat(1);
+    copy_tab_fromptr(field[0]->tab, descat, 0);
+    destab = descat->tab;
+    for (a=0; a<nchan; a++)
+      {
+      sprintf(keyword, "CHAN%04d", a+1);
+      addkeywordto_head(destab, keyword, "Channel tagname");
+      fitswrite(destab->headbuf, keyword, field[a]->channeltag,
+	H_STRING, T_STRING);
+      }
+    }
+
+/* Set up the cutout regions in every channel */
+  ncutout = prefs.nregion/4;
+  QCALLOC(cutout, cutoutstruct, ncutout);
+  widthmax = 0;
+  npix = 0.0;
+  for (c=0; c<ncutout; c++)
+    {
+    name_cutout(filename, c+1, cutout[c].filename);
+    QMALLOC(cutout[c].field, fieldstruct, nchan);
+    QMALLOC(cutout[c].fieldp, fieldstruct *, nchan);
+    QCALLOC(cutout[c].rbuf, PIXTYPE *, nchan);
+    QCALLOC(cutout[c].nrow, int, nchan);
+    QCALLOC(cutout[c].nline, int, nchan);
+    for (a=0; a<nchan; a++)
+      {
+      cutout[c].field[a] = *field[a];
+      cutout[c].field[a].cache = NULL;
+      cutout[c].fieldp[a] = &cutout[c].field[a];
+      set_fieldregion(&cutout[c].field[a], prefs.region_type,
+		prefs.region + 4*c);
+      if (cutout[c].field[a].size[0] != cutout[c].field[0].size[0]
+	|| cutout[c].field[a].size[1] != cutout[c].field[0].size[1])
+        error(EXIT_FAILURE, "*Error*: cutout size doesn't match in ",
+		field[a]->cat->filename);
+      }
+    cutout[c].width = prefs.bin_size[0]>1?
+	  (cutout[c].field[0].size[0]+prefs.bin_size[0]-1)/prefs.bin_size[0]
+	: cutout[c].field[0].size[0];
+    cutout[c].height = binsizey0>1?
+	  (cutout[c].field[0].size[1]+binsizey0-1)/binsizey0
+	: cutout[c].field[0].size[1];
+    if (cutout[c].width > widthmax)
+      widthmax = cutout[c].width;
+    npix += (double)cutout[c].width*cutout[c].height;
+/*-- The ring must hold the lines binned ahead by the leading channel */
+    ymin = ymax = cutout[c].field[0].origin[1];
+    for (a=1; a<nchan; a++)
+      if (cutout[c].field[a].origin[1] < ymin)
+        ymin = cutout[c].field[a].origin[1];
+      else if (cutout[c].field[a].origin[1] > ymax)
+        ymax = cutout[c].field[a].origin[1];
+    nline = (ymax-ymin+binsizey0-1)/binsizey0 + 1;
+    cutout[c].nring = 2 + (nline+CUTOUT_NLINES-1)/CUTOUT_NLINES;
+    nstrip = (cutout[c].height+CUTOUT_NLINES-1)/CUTOUT_NLINES;
+    if (cutout[c].nring > nstrip)
+      cutout[c].nring = nstrip;
+    if (prefs.header_flag)
+      cutout[c].description = fitshead_to_desc(destab->headbuf,
+		destab->headnblock, cutout[c].width, cutout[c].height,
+		cutout[c].field[0].origin[0], cutout[c].field[0].origin[1],
+		prefs.bin_size[0], prefs.bin_size[1], flipxflag, flipyflag);
+    }
+  if (prefs.header_flag)
+    free_cat(&descat, 1);
+
+/* Levels are measured on the cutout pixels if requested */
+  if (prefs.regionstats_type == REGIONSTATS_REGION)
+    for (c=0; c<ncutout; c++)
+      for (a=0; a<nchan; a++)
+        set_fieldlevels(&cutout[c].field[a], NULL, 0);
+
+/* Pre-size the scratch buffers of concurrent conversions (see below) */
+#ifdef USE_THREADS
+  nproc = prefs.nthreads<ncutout? prefs.nthreads : ncutout;
+#else
+  nproc = 1;
+#endif
+  reserve_scratch((size_t)widthmax*CUTOUT_NLINES*sizeof(float), nproc);
+  set_progresstotal(npix);
+
+/* Start the conversion threads, fed as strips are completed */
+#ifdef USE_THREADS
+   pthread_attr_t		pthread_attr;
+   cutoutthreadstruct		cthread;
+   pthread_t			*thread;
+   int				p;
+
+  memset(&cthread, 0, sizeof(cthread));
+  QMALLOC(cthread.queue, cutoutstruct *, ncutout);
+  cthread.ncutout = ncutout;
+  cthread.nchan = nchan;
+  QPTHREAD_MUTEX_INIT(&cthread.mutex, NULL);
+  QPTHREAD_COND_INIT(&cthread.cond, NULL);
+  QPTHREAD_ATTR_INIT(&pthread_attr);
+  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
+  QMALLOC(thread, pthread_t, nproc);
+  for (p=0; p<nproc; p++)
+    QPTHREAD_CREATE(&thread[p], &pthread_attr, &pthread_convert_cutouts,
+	&cthread);
+#endif
+
+/* Sort the cutouts of every channel by first row swept */
+  QMALLOC(sorted, cutoutstruct *, ncutout*nchan);
+  QMALLOC(active, cutoutstruct *, ncutout*nchan);
+  QCALLOC(nactive, int, nchan);
+  QCALLOC(next, int, nchan);
+  naxis1max = 0;
+  npix = 0.0;
+  for (a=0; a<nchan; a++)
+    {
+    if (field[a]->tab->naxisn[0] > naxis1max)
+      naxis1max = field[a]->tab->naxisn[0];
+    for (c=0; c<ncutout; c++)
+      {
+      cutout[c].ymin = CUTOUT_START(&cutout[c], a, flipyflag);
+      sorted[a*ncutout+c] = &cutout[c];
+      npix += (double)cutout[c].field[a].size[0]*cutout[c].field[a].size[1];
+      }
+    qsort(sorted+a*ncutout, ncutout, sizeof(cutoutstruct *),
+	compare_cutouts);
+    }
+  QMALLOC(rowbuf, PIXTYPE, naxis1max);
+  set_progressstage("extracting", -1, npix);
+
+/* Sweep all channels once, routing row segments to the active cutouts */
+  nleft = ncutout*nchan;
+  errflag = 0;
+  for (s=0; nleft && !errflag; s++)
+    {
+/*-- Skip the rows that no cutout covers */
+    for (k=a=0; a<nchan; a++)
+      k += nactive[a];
+    if (!k)
+      for (a=0; a<nchan; a++)
+        if (next[a]<ncutout && (!k++
+		|| CUTOUT_START(sorted[a*ncutout+next[a]], a, flipyflag) < s))
+          s = CUTOUT_START(sorted[a*ncutout+next[a]], a, flipyflag);
+    y = flipyflag? s : -s;
+    npixrow = 0.0;
+    for (a=0; a<nchan && !errflag; a++)
+      {
+      tab = field[a]->tab;
+      while (next[a]<ncutout
+		&& CUTOUT_START(sorted[a*ncutout+next[a]], a, flipyflag)==s)
+        {
+        cut = sorted[a*ncutout+next[a]++];
+        QMALLOC(cut->rbuf[a], PIXTYPE,
+		(size_t)binsizey0*cut->field[a].size[0]);
+        if (!cut->store)
+          cut->store = new_datastore(prefs.arena, cut->width,
+		nchan*cut->nring*CUTOUT_NLINES, CUTOUT_NLINES, DATA_FLOAT32,
+		0.0, 1.0);
+        active[a*ncutout+nactive[a]++] = cut;
+        }
+      if (!nactive[a])
+        continue;
+      if (!(y%100))
+        NPRINTF(OUTPUT, "\33[1M> Channel %1d/%-1d: "
+		"Extracting cutouts from line %7d/%-7d\n\33[1A",
+		a+1, nchan, y+1, tab->naxisn[1]);
+/*---- Read the column span covered by all active cutouts */
+      xmin = tab->naxisn[0];
+      xmax = 0;
+      for (k=0; k<nactive[a]; k++)
+        {
+        cut = active[a*ncutout+k];
+        if (cut->field[a].origin[0] < xmin)
+          xmin = cut->field[a].origin[0];
+        if (cut->field[a].origin[0]+cut->field[a].size[0] > xmax)
+          xmax = cut->field[a].origin[0]+cut->field[a].size[0];
+        }
+      QFSEEK(field[a]->cat->file,
+		tab->bodypos + ((size_t)tab->naxisn[0]*y + xmin)*tab->bytepix,
+		SEEK_SET, field[a]->cat->filename);
+      read_body(tab, rowbuf, xmax-xmin);
+      for (k=0; k<nactive[a] && !errflag; k++)
+        {
+        cut = active[a*ncutout+k];
+        fwidth = cut->field[a].size[0];
+        fheight = cut->field[a].size[1];
+        npixrow += (double)fwidth;
+/*------ Rows of a bin are stacked bottom-up, as in image_convert_single() */
+        nline = cut->nline[a];
+        if ((nline+1)<cut->height || !(binsizey = fheight%binsizey0))
+          binsizey = binsizey0;
+        memcpy(cut->rbuf[a] + (size_t)fwidth*(flipyflag?
+			cut->nrow[a] : binsizey-1-cut->nrow[a]),
+		rowbuf + cut->field[a].origin[0] - xmin,
+		fwidth*sizeof(PIXTYPE));
+        if (++cut->nrow[a] == binsizey)
+          {
+          cut->nrow[a] = 0;
+#ifdef USE_THREADS
+/*-------- Wait for the strip to be overwritten in the ring to be converted */
+          if (!(nline%CUTOUT_NLINES) && nline/CUTOUT_NLINES >= cut->nring)
+            {
+            QPTHREAD_MUTEX_LOCK(&cthread.mutex);
+            while (cut->nconv <= nline/CUTOUT_NLINES-cut->nring
+		&& !cthread.errflag)
+              QPTHREAD_COND_WAIT(&cthread.cond, &cthread.mutex);
+            errflag = cthread.errflag;
+            QPTHREAD_MUTEX_UNLOCK(&cthread.mutex);
+            if (errflag)
+              break;
+            }
+#endif
+          bin_cutoutline(cut, a, binsizey);
+/*-------- Hand over the strips completed in all channels */
+          for (nline=cut->height, b=0; b<nchan; b++)
+            if (cut->nline[b] < nline)
+              nline = cut->nline[b];
+          nready = nline<cut->height? nline/CUTOUT_NLINES
+			: (nline+CUTOUT_NLINES-1)/CUTOUT_NLINES;
+          if (nready > cut->nready)
+            {
+#ifdef USE_THREADS
+            QPTHREAD_MUTEX_LOCK(&cthread.mutex);
+            cut->nready = nready;
+            queue_cutout(&cthread, cut);
+            errflag = cthread.errflag;
+            QPTHREAD_MUTEX_UNLOCK(&cthread.mutex);
+#else
+            for (cut->nready=nready; cut->nconv<nready; cut->nconv++)
+              convert_cutoutlines(cut, nchan);
+#endif
+            }
+          }
+/*------ Retire cutouts once their last row has been read */
+        if (y-cut->field[a].origin[1] == (flipyflag? fheight-1 : 0))
+          {
+          free(cut->rbuf[a]);
+          cut->rbuf[a] = NULL;
+          active[a*ncutout+k--] = active[a*ncutout+--nactive[a]];
+          nleft--;
+          }
+        }
+      }
+    add_progress(npixrow, 0.0);
+    }
+  free(rowbuf);
+  free(sorted);
+  free(active);
+  free(nactive);
+  free(next);
+
+#ifdef USE_THREADS
+/* Let the conversion threads drain the queue */
+  QPTHREAD_MUTEX_LOCK(&cthread.mutex);
+  cthread.endflag = 1;
+  QPTHREAD_COND_BROADCAST(&cthread.cond);
+  QPTHREAD_MUTEX_UNLOCK(&cthread.mutex);
+  for (p=0; p<nproc; p++)
+    QPTHREAD_JOIN(thread[p], NULL);
+  QPTHREAD_ATTR_DESTROY(&pthread_attr);
+  QPTHREAD_COND_DESTROY(&cthread.cond);
+  QPTHREAD_MUTEX_DESTROY(&cthread.mutex);
+  free(thread);
+  free(cthread.queue);
+  errflag = cthread.errflag;
+#endif
+
+  for (c=0; c<ncutout; c++)
+    {
+/*-- Cutouts are left unfinished only after an error */
+    if (cutout[c].image)
+      {
+      if (prefs.format_type2 == FORMAT_TIFF)
+        end_tiff(cutout[c].image);
+      else
+        abort_quicklook(cutout[c].image);
+      }
+    if (cutout[c].store)
+      free_datastore(cutout[c].store);
+    for (a=0; a<nchan; a++)
+      free(cutout[c].rbuf[a]);
+    free(cutout[c].field);
+    free(cutout[c].fieldp);
+    free(cutout[c].rbuf);
+    free(cutout[c].nrow);
+    free(cutout[c].nline);
+    free(cutout[c].description);
+    }
+  free(cutout);
+
+#ifdef USE_THREADS
+/* Errors met by the conversion threads are raised in the calling thread */
+  if (errflag)
+    error(EXIT_FAILURE, cthread.error_msg, "");
+#endif
+
+  return;
+  }
+
+
+/****** bin_cutoutline ********************************************************
+PROTO	void bin_cutoutline(cutoutstruct *cutout, int a, int binsizey)
+PURPOSE	Bin the rows read for the next output line of a cutout channel.
+INPUT	Pointer to the cutout,
+	channel index,
+	number of rows in the bin.
+OUTPUT	-.
+NOTES	Uses the global preferences. Binning and flipping follow
+	image_convert_single(). The line is stored in the ring of strips of
+	the cutout.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	bin_cutoutline(cutoutstruct *cutout, int a, int binsizey)
+  {
+   float		*fbuft0,*fbuft;
+   PIXTYPE		*ibuft,
+			fpix;
+   int			x, bx,by, y, width, fwidth, binsizex0,binsizexmax,
+			binsizex, flipxflag;
+
+  fwidth = cutout->field[a].size[0];
+  width = cutout->width;
+  flipxflag = (prefs.flip_type == FLIP_X) || (prefs.flip_type == FLIP_XY);
+  binsizex0 = prefs.bin_size[0];
+  if (!(binsizexmax = fwidth%binsizex0))
+    binsizexmax = binsizex0;
+  y = (a*cutout->nring*CUTOUT_NLINES)
+	+ cutout->nline[a]%(cutout->nring*CUTOUT_NLINES);
+  fbuft0 = get_datarows(cutout->store, y, 1);
+  memset(fbuft0, 0, (size_t)width*sizeof(float));
+  for (by=binsizey; by--;)
+    {
+    ibuft = cutout->rbuf[a] + (size_t)(binsizey-1-by)*fwidth;
+    if (flipxflag)
+      {
+      fbuft = fbuft0 + width;
+      for (x=width; x--;)
+        {
+        fpix = 0;
+        binsizex = x>0? binsizex0:binsizexmax;
+        for (bx=binsizex; bx--;)
+          fpix += *(ibuft++);
+        *(--fbuft) += fpix / (binsizex*binsizey);
+        }
+      }
+    else
+      {
+      fbuft = fbuft0;
+      for (x=width; x--;)
+        {
+        fpix = 0;
+        binsizex = x>0? binsizex0:binsizexmax;
+        for (bx=binsizex; bx--;)
+          fpix += *(ibuft++);
+        *(fbuft++) += fpix / (binsizex*binsizey);
+        }
+      }
+    }
+  release_datarows(cutout->store, y);
+  cutout->nline[a]++;
+
+  return;
+  }
+
+
+/****** convert_cutoutlines ***************************************************
+PROTO	void convert_cutoutlines(cutoutstruct *cutout, int nchan)
+PURPOSE	Convert and write the next strip of binned lines of a cutout.
+INPUT	Pointer to the cutout,
+	number of channels.
+OUTPUT	-.
+NOTES	Uses the global preferences. The output image is created with the
+	first strip; the image, the ring of strips and the description are
+	released after the last strip.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	convert_cutoutlines(cutoutstruct *cutout, int nchan)
+  {
+   imagestruct		*image;
+   double		minvalue[MAXFILE], maxvalue[MAXFILE];
+   float		*data[MAXFILE],
+			*fsbuf;
+   size_t		npix;
+   int			a, y, yring, nlines, nringlines;
+
+  if (!(image = cutout->image))
+    {
+    for (a=0; a<nchan; a++)
+      {
+      minvalue[a] = cutout->field[a].min;
+      maxvalue[a] = cutout->field[a].max;
+      }
+    if (prefs.format_type2 == FORMAT_TIFF)
+      image = create_tiff(cutout->filename, cutout->width, cutout->height,
+		nchan, prefs.bpp, 0, minvalue, maxvalue,
+		prefs.bigtiff_type, prefs.compress_type, prefs.compress_quality,
+		prefs.copyright,
+		cutout->description? cutout->description : prefs.description);
+    else
+      image = create_quicklook(cutout->filename,
+		prefs.format_type2 == FORMAT_JPEG? QUICKLOOK_JPEG:QUICKLOOK_PNG,
+		cutout->width, cutout->height, nchan, prefs.bpp,
+		prefs.compress_quality, 1);
+    cutout->image = image;
+    }
+
+  y = cutout->nconv*CUTOUT_NLINES;
+  if ((nlines = cutout->height - y) > CUTOUT_NLINES)
+    nlines = CUTOUT_NLINES;
+  npix = (size_t)cutout->width*nlines;
+  nringlines = cutout->nring*CUTOUT_NLINES;
+  yring = y%nringlines;
+  for (a=0; a<nchan; a++)
+    data[a] = get_datarows(cutout->store, a*nringlines + yring, 0);
+  QSCRATCH(fsbuf, float, npix);
+  data_to_pix(cutout->fieldp, data, 0, image->buf, npix, nchan, image->bypp,
+	prefs.bpp<0, fsbuf);
+  free_scratch(fsbuf);
+  for (a=0; a<nchan; a++)
+    release_datarows(cutout->store, a*nringlines + yring);
+  image->y = y;
+  image->nlines = nlines;
+  if ((prefs.format_type2 == FORMAT_TIFF?
+		write_tifflines(image) : write_quicklooklines(image))
+	!= RETURN_OK)
+    error(EXIT_FAILURE, "*Error*: cannot write ", cutout->filename);
+  add_progress(0.0, (double)npix);
+
+/* Release the cutout after its last strip */
+  if (y+nlines >= cutout->height)
+    {
+    if (prefs.format_type2 == FORMAT_TIFF)
+      end_tiff(image);
+    else
+      end_quicklook(image);
+    cutout->image = NULL;
+    free_datastore(cutout->store);
+    cutout->store = NULL;
+    free(cutout->description);
+    cutout->description = NULL;
+    }
+
+  return;
+  }
+
+
+/****** name_cutout ***********************************************************
+PROTO	void name_cutout(char *filename, int n, char *name)
+PURPOSE	Build the output file name of a cutout.
+INPUT	Output file name,
+	cutout number,
+	pointer to the cutout file name (at least MAXCHAR long).
+OUTPUT	-.
+NOTES	The cutout number is inserted before the file name extension, e.g.
+	stiff.tif becomes stiff_12.tif.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	name_cutout(char *filename, int n, char *name)
+  {
+   char	*str, *str2;
+
+  str = strrchr(filename, '.');
+  str2 = strrchr(filename, '/');
+  if (!str || (str2 && str2>str))
+    str = filename + strlen(filename);
+  snprintf(name, MAXCHAR, "%.*s_%d%s", (int)(str-filename), filename, n, str);
+
+  return;
+  }
+
+
+/****** compare_cutouts *******************************************************
+PROTO	int compare_cutouts(const void *cutout1, const void *cutout2)
+PURPOSE	Provide a cutout sorting criterion for qsort(): first image row.
+INPUT	Pointer to a pointer to the first cutout,
+	pointer to a pointer to the second cutout.
+OUTPUT	<0 if the first cutout starts lower, >0 if higher, 0 otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	compare_cutouts(const void *cutout1, const void *cutout2)
+  {
+  return (*(cutoutstruct **)cutout1)->ymin - (*(cutoutstruct **)cutout2)->ymin;
+  }
+
+
+#ifdef USE_THREADS
+
+/****** queue_cutout **********************************************************
+PROTO   void queue_cutout(cutoutthreadstruct *cthread, cutoutstruct *cutout)
+PURPOSE Queue a cutout for conversion if it has strips waiting.
+INPUT   Pointer to the cutout conversion context,
+	pointer to the cutout.
+OUTPUT  -.
+NOTES   Must be called with the context mutex locked. A cutout is converted
+	by one thread at a time, and queued at most once.
+AUTHOR  E. Bertin (IAP)
+VERSION 19/10/2026
+ ***/
+static void	queue_cutout(cutoutthreadstruct *cthread, cutoutstruct *cutout)
+  {
+  if (cutout->busyflag || cutout->queueflag || cutout->nconv>=cutout->nready)
+    return;
+  cthread->queue[(cthread->qfirst+cthread->nqueue++)%cthread->ncutout]
+	= cutout;
+  cutout->queueflag = 1;
+  QPTHREAD_COND_BROADCAST(&cthread->cond);
+
+  return;
+  }
+
+
+/****** pthread_convert_cutouts ***********************************************
+PROTO   void *pthread_convert_cutouts(void *arg)
+PURPOSE thread that takes care of converting and writing cutout strips.
+INPUT   Pointer to the cutout conversion context.
+OUTPUT  -.
+NOTES   Strips are taken from the queue until the end of the sweep. Errors
+	are trapped and stored in the context, and stop the sweep and the
+	conversion of the remaining strips.
+AUTHOR  E. Bertin (IAP)
+VERSION 19/10/2026
+ ***/
+static void	*pthread_convert_cutouts(void *arg)
+  {
+   cutoutthreadstruct	*cthread;
+   cutoutstruct		*cutout;
+   jmp_buf		trap;
+
+  cthread = (cutoutthreadstruct *)arg;
+  set_timingthread("cutout");
+  error_settrap(&trap);
+  if (setjmp(trap))
+    {
+/*-- Keep the first error only, and wake up the sweep */
+    QPTHREAD_MUTEX_LOCK(&cthread->mutex);
+    if (!cthread->errflag++)
+      strncpy(cthread->error_msg, error_trapmsg(), MAXCHAR-1);
+    QPTHREAD_COND_BROADCAST(&cthread->cond);
+    QPTHREAD_MUTEX_UNLOCK(&cthread->mutex);
+    pthread_exit(NULL);
+    }
+  QPTHREAD_MUTEX_LOCK(&cthread->mutex);
+  while (!cthread->errflag)
+    {
+    if (!cthread->nqueue)
+      {
+      if (cthread->endflag)
+        break;
+      QPTHREAD_COND_WAIT(&cthread->cond, &cthread->mutex);
+      continue;
+      }
+    cutout = cthread->queue[cthread->qfirst];
+    cthread->qfirst = (cthread->qfirst+1)%cthread->ncutout;
+    cthread->nqueue--;
+    cutout->queueflag = 0;
+    cutout->busyflag = 1;
+    QPTHREAD_MUTEX_UNLOCK(&cthread->mutex);
+    convert_cutoutlines(cutout, cthread->nchan);
+    QPTHREAD_MUTEX_LOCK(&cthread->mutex);
+    cutout->busyflag = 0;
+    cutout->nconv++;
+/*-- Strips may have been completed meanwhile */
+    queue_cutout(cthread, cutout);
+    QPTHREAD_COND_BROADCAST(&cthread->cond);
+    }
+  QPTHREAD_MUTEX_UNLOCK(&cthread->mutex);
+
+  error_settrap(NULL);
+  pthread_exit(NULL);
+
+  return (void *)NULL;
+  }
+
+#endif
+
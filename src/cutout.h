@@ -0,0 +1,71 @@
+/*
+*				cutout.h
+*
+* Include file for cutout.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _CUTOUT_H_
+#define _CUTOUT_H_
+
+#ifndef _DATAMEM_H_
+#include "datamem.h"
+#endif
+
+#ifndef _FIELD_H_
+#include "field.h"
+#endif
+
+#ifndef _IMAGE_H_
+#include "image.h"
+#endif
+
+/*----------------------------- Internal constants --------------------------*/
+#define	CUTOUT_NLINES	32	/* Lines per converted strip (multiple of */
+				/* IMAGE_ROWS and of JPEG MCU heights) */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct cutout
+  {
+  char		filename[MAXCHAR];	/* Output filename */
+  fieldstruct	*field;			/* Field copies (one per channel) */
+  fieldstruct	**fieldp;		/* Pointers to the field copies */
+  PIXTYPE	**rbuf;			/* Rows of the current bins (per chan.)*/
+  int		*nrow;			/* Rows in the current bins (per chan.)*/
+  int		*nline;			/* Binned lines (per channel) */
+  datastorestruct *store;		/* Binned lines, in a ring of strips */
+  imagestruct	*image;			/* Output image (while converted) */
+  int		width, height;		/* Output image size */
+  int		nring;			/* Number of strips in the ring */
+  int		nready, nconv;		/* Strips binned, strips converted */
+  int		busyflag, queueflag;	/* Being converted? In the queue? */
+  int		ymin;			/* First row swept (current channel) */
+  char		*description;		/* Image description (or NULL) */
+  }	cutoutstruct;
+
+/*------------------------------- functions ---------------------------------*/
+extern void	image_convert_cutouts(char *filename, fieldstruct **field,
+			int nchan);
+
+#endif
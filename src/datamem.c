@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		13/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -30,52 +30,196 @@
 #include	"config.h"
 #endif
 
+#include	<math.h>
 #include	<stdio.h>
 #include	<stdlib.h>
 #include	<string.h>
 #include	<unistd.h>
 #include	<sys/types.h>
 #include	<sys/stat.h>
+#include	<sys/statvfs.h>
 #include	<fcntl.h>
 
 #ifdef	HAVE_SYS_MMAN_H
 #include	<sys/mman.h>
 #endif
+#ifdef	__linux__
+#include	<sys/syscall.h>
+#endif
+#include	<zlib.h>
+#if defined(__GNUC__) && !defined(__INTEL_COMPILER) \
+	&& (defined(__x86_64__) || defined(__i386__))
+#include	<immintrin.h>
+#define		SIMD_X86
+#endif
+
 #include	"fits/fitscat_defs.h"
 #include	"fits/fitscat.h"
 #include	"datamem.h"
 
-size_t	data_maxram = BODY_DEFRAM,
-	data_maxvram = BODY_DEFVRAM,
-	data_ramleft, data_vramleft, data_ramflag;
+#ifdef USE_THREADS
+#include	"threads.h"
+#endif
+
+/* Allocator of image data, with its own budgets */
+struct structdataarena
+  {
+  size_t		maxram, maxvram;	/* RAM and swap space budgets */
+  size_t		ramleft, vramleft;	/* Room left in the budgets */
+  size_t		rampeak, vrampeak;	/* Largest amounts used */
+  size_t		cacheram;		/* RAM of decompressed blocks */
+  int			compressflag;		/* Compress stores? */
+  char			swapdirname[MAXCHARS];	/* Swap file directory */
+  datablockstruct	**cache;		/* Decompressed blocks (LRU) */
+  int			ncache, ncachemax;	/* Cached blocks, room */
+  unsigned long		cachestamp;		/* Last block use stamp */
+#ifdef USE_THREADS
+  pthread_mutex_t	mutex;			/* Protects the allocator */
+  pthread_cond_t	cond;			/* Signals the end of block I/Os */
+#endif
+  };
+
+int	data_pagetype = DATA_PAGE_NORMAL,
+	data_numatype = DATA_NUMA_DEFAULT;
+
+/* Swap files of all allocators are numbered in the same sequence and */
+/* registered in the same cleanup list, both protected by data_swapmutex */
+static unsigned int	data_vmnumber;
+
+/* Vector instruction set of half-precision conversions (-1: not probed) */
+static int		data_halfsimd = -1;
+
+/* Pool of reusable scratch buffers */
+static scratchbufstruct	*data_scratch;
+static int		data_nscratch, data_nscratchmax, data_scratchnpeak;
+static size_t		data_scratchsize, data_scratchpeak;
+
+#ifdef USE_THREADS
+static pthread_mutex_t	data_scratchmutex = PTHREAD_MUTEX_INITIALIZER,
+			data_swapmutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void	cache_datablock(datablockstruct *block),
+		uncache_datablock(dataarenastruct *arena, int c),
+		compress_datablock(datablockstruct *block),
+		decompress_datablock(datablockstruct *block),
+		floats_to_halves(float *in, unsigned short *out, size_t n),
+		halves_to_floats(unsigned short *in, float *out, size_t n),
+		pack_datablock(datastorestruct *store, float *buf,
+			unsigned short *pack, size_t npix),
+		unpack_datablock(datastorestruct *store, unsigned short *pack,
+			float *buf, size_t npix);
+
+static int	get_halfsimdlevel(void),
+		new_scratch(size_t size, int busyflag);
+
+#ifdef SIMD_X86
+static size_t	floats_to_halves_f16c(float *in, unsigned short *out, size_t n),
+		floats_to_halves_avx512(float *in, unsigned short *out,
+			size_t n),
+		halves_to_floats_f16c(unsigned short *in, float *out, size_t n),
+		halves_to_floats_avx512(unsigned short *in, float *out,
+			size_t n);
+#endif
+
+static size_t	datablock_npix(datablockstruct *block),
+		get_dataroom(dataarenastruct *arena),
+		pixbuf_mapsize(size_t size);
+
+static int	read_datasizefile(char *filename, double *size);
+
+static void	interleave_pixbuf(void *buf, size_t size),
+		name_dataswap(dataarenastruct *arena, char *filename),
+		trim_scratch(size_t size),
+		update_datapeaks(dataarenastruct *arena);
+
+/******* new_dataarena ********************************************************
+PROTO	dataarenastruct *new_dataarena(int maxram, int maxvram,
+			char *swapdirname, int compressflag)
+PURPOSE	Create an allocator of image data.
+INPUT	Maximum amount of RAM (in MB),
+	maximum amount of swap space (in MB),
+	path name of the directory of swap files,
+	flag set for compressed stores, unset for swap files (see
+	new_datastore()).
+OUTPUT	Pointer to the new allocator.
+NOTES	Budgets, settings and peaks of different allocators are independent:
+	every conversion job, or every libstiff context, has its own. Budgets
+	are at least 1 MB. The swap directory name must leave room for the
+	swap file names (see name_dataswap()).
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+dataarenastruct	*new_dataarena(int maxram, int maxvram, char *swapdirname,
+			int compressflag)
+  {
+   dataarenastruct	*arena;
+
+  QCALLOC(arena, dataarenastruct, 1);
+  arena->ramleft = arena->maxram = (maxram>1? maxram : 1)*(size_t)MBYTE;
+  arena->vramleft = arena->maxvram = (maxvram>1? maxvram : 1)*(size_t)MBYTE;
+  arena->compressflag = compressflag;
+  if (!swapdirname)
+    swapdirname = BODY_DEFSWAPDIR;
+  if (strlen(swapdirname) > MAXCHARS-DATA_SWAPNAMELEN)
+    error(EXIT_FAILURE, "*Error*: swap directory name too long: ",
+	swapdirname);
+  strcpy(arena->swapdirname, swapdirname);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_INIT(&arena->mutex, NULL);
+  QPTHREAD_COND_INIT(&arena->cond, NULL);
+#endif
+
+  return arena;
+  }
+
+
+/******* end_dataarena ********************************************************
+PROTO	void end_dataarena(dataarenastruct *arena)
+PURPOSE	Free an allocator of image data.
+INPUT	Pointer to the allocator.
+OUTPUT	-.
+NOTES	All the stores of the allocator must have been freed, except those
+	left behind by failed conversions, which can no longer be used.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_dataarena(dataarenastruct *arena)
+  {
+  if (!arena)
+    return;
+
+  free(arena->cache);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_DESTROY(&arena->mutex);
+  QPTHREAD_COND_DESTROY(&arena->cond);
+#endif
+  free(arena);
 
-int	data_vmnumber;
+  return;
+  }
 
-char	data_swapdirname[MAXCHARS] = BODY_DEFSWAPDIR;
 
 /******* alloc_data ***********************************************************
-PROTO	float *alloc_data(size_t ndata, char **swapname)
+PROTO	float *alloc_data(dataarenastruct *arena, size_t ndata,
+			char **swapname)
 PURPOSE	Allocate memory for image data. If not enough RAM is available, a swap
 	file is created.
-INPUT	Number of pixels.
+INPUT	Pointer to the allocator,
+	number of pixels,
+	pointer to the swap file name (output, NULL for data in RAM).
 OUTPUT	Pointer to the mapped data if OK, or NULL otherwise.
-NOTES	-.
+NOTES	Thread-safe.
 AUTHOR	E. Bertin (IAP)
-VERSION	19/12/2009
+VERSION	19/10/2026
  ***/
-float	*alloc_data(size_t ndata, char **swapname)
+float	*alloc_data(dataarenastruct *arena, size_t ndata, char **swapname)
   {
    float	*data;
    size_t	size;
-   int		fd;
+   int		fd, ramflag, vramflag;
 
   *swapname = NULL;
-  if (!data_ramflag)
-    {
-    data_ramleft = data_maxram;
-    data_vramleft = data_maxvram;
-    data_ramflag = 1;
-    }
 
 /* Return a NULL pointer if size is zero */
   if (!ndata)
@@ -83,34 +227,60 @@ float	*alloc_data(size_t ndata, char **swapname)
 
 /* Decide if the data will go in physical memory or on swap-space */
   size = ndata*sizeof(float);
-  if (size < data_ramleft)
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  if ((ramflag = (size < get_dataroom(arena))))
     {
-/*-- There should be enough RAM left: try to do a malloc() */
-    if ((data = (float *)malloc(size)))
-      {
-      data_ramleft -= size;
-
+    arena->ramleft -= size;
+    update_datapeaks(arena);
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+  if (ramflag)
+    {
+/*-- There should be enough RAM left: try to get a scratch buffer */
+    if ((data = (float *)alloc_scratch(size)))
       return data;
-      }
-    else
-      data = (float *)NULL;
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+    arena->ramleft += size;
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
     }
 
-  if (size < data_vramleft)
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  if ((vramflag = (size < arena->vramleft)))
+    {
+    arena->vramleft -= size;
+    update_datapeaks(arena);
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+  if (vramflag)
     {
 /*-- Convert and copy the data to a swap file, and mmap() it */
     QMALLOC(*swapname, char, MAXCHARS);
-    sprintf(*swapname, "%s/vm%05ld_%05x.tmp",
-		data_swapdirname, (long)getpid(),
-		(unsigned int)++data_vmnumber) ;
+    name_dataswap(arena, *swapname);
     if ((fd=open(*swapname, O_RDWR|O_CREAT|O_TRUNC, 0666)) == -1)
       error(EXIT_FAILURE, "*Error*: cannot create swap-file ", *swapname);
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_LOCK(&data_swapmutex);
+#endif
     add_cleanupfilename(*swapname);
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_UNLOCK(&data_swapmutex);
+#endif
     lseek(fd, size - 1, SEEK_SET);
     write(fd, "\0", 1);
     data = mmap(NULL,size,PROT_WRITE|PROT_READ,MAP_SHARED, fd, (off_t)0);
     close(fd);
-    data_vramleft -= size;
 
 /*-- Memory mapping problem */
     if (data == (void *)-1)
@@ -124,17 +294,20 @@ float	*alloc_data(size_t ndata, char **swapname)
 
 
 /******* free_data ************************************************************
-PROTO	void free_data(float *data, int ndata, char *swapname)
+PROTO	void free_data(dataarenastruct *arena, float *data, size_t ndata,
+			char *swapname)
 PURPOSE	Free image data.
-INPUT	Pointer to the data,
+INPUT	Pointer to the allocator the data were taken from,
+	pointer to the data,
 	number of pixels,
 	swap filename.
 OUTPUT	-.
-NOTES	.
+NOTES	Thread-safe.
 AUTHOR	E. Bertin (IAP)
-VERSION	19/12/2009
+VERSION	19/10/2026
  ***/
-void	free_data(float *data, size_t ndata, char *swapname)
+void	free_data(dataarenastruct *arena, float *data, size_t ndata,
+		char *swapname)
 
   {
    size_t	size;
@@ -147,86 +320,1676 @@ void	free_data(float *data, size_t ndata, char *swapname)
       {
       if (munmap(data, size))
         warning("Can't unmap virtual memory file ", swapname);
-      data_vramleft += size;
       if (unlink(swapname))
         warning("Can't delete ", swapname);
+#ifdef USE_THREADS
+      QPTHREAD_MUTEX_LOCK(&data_swapmutex);
+#endif
       remove_cleanupfilename(swapname);
+#ifdef USE_THREADS
+      QPTHREAD_MUTEX_UNLOCK(&data_swapmutex);
+#endif
       free(swapname);
       }
     else
+      free_scratch(data);
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+    if (swapname)
+      arena->vramleft += size;
+    else
+      arena->ramleft += size;
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+    }
+
+  return;
+  }
+
+
+/******* name_dataswap ********************************************************
+PROTO	void name_dataswap(dataarenastruct *arena, char *filename)
+PURPOSE	Build a new swap file name.
+INPUT	Pointer to the allocator,
+	pointer to the file name (at least MAXCHARS bytes, output).
+OUTPUT	-.
+NOTES	Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	name_dataswap(dataarenastruct *arena, char *filename)
+  {
+   unsigned int	vmnumber;
+
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&data_swapmutex);
+#endif
+  vmnumber = ++data_vmnumber;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&data_swapmutex);
+#endif
+  snprintf(filename, MAXCHARS, "%.*s/vm%05d_%05x.tmp",
+	MAXCHARS-DATA_SWAPNAMELEN, arena->swapdirname, (int)getpid(), vmnumber);
+
+  return;
+  }
+
+
+/******* alloc_pixbuf *********************************************************
+PROTO	void *alloc_pixbuf(size_t size, size_t *mapsize)
+PURPOSE	Allocate a large pixel buffer, following the page type and NUMA
+	placement policy set with set_datapages().
+INPUT	Buffer size (in bytes),
+	pointer to the size of the mapping (0 for heap buffers).
+OUTPUT	Pointer to the buffer if OK, or NULL otherwise.
+NOTES	Buffers are aligned on DATA_ALIGN bytes. Buffers smaller than
+	DATA_MINPIXBUF, or all buffers with the default policies, are taken
+	from the heap. Larger ones are mapped anonymously,
+	hence left untouched until first written; huge pages are used for
+	buffers of at least DATA_HUGEPAGESIZE bytes. If no explicit huge pages
+	are available, transparent huge pages are used instead.
+	Must be freed with free_pixbuf() and the returned mapping size, as the
+	policy may have changed in the meantime.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	*alloc_pixbuf(size_t size, size_t *mapsize)
+  {
+   void		*buf;
+
+  if (!(*mapsize = pixbuf_mapsize(size)))
+    return posix_memalign(&buf, DATA_ALIGN, size)? NULL : buf;
+
+#ifdef	HAVE_SYS_MMAN_H
+  buf = MAP_FAILED;
+#ifdef	MAP_HUGETLB
+  if (data_pagetype == DATA_PAGE_EXPLICIT && *mapsize%DATA_HUGEPAGESIZE == 0)
+    {
+    buf = mmap(NULL, *mapsize, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, (off_t)0);
+    if (buf == MAP_FAILED)
       {
-      QFREE(data);
-      data_ramleft += size;
+      warning("No explicit huge pages left: ",
+		"switching to transparent huge pages");
+      data_pagetype = DATA_PAGE_TRANSPARENT;
       }
     }
+#endif
+  if (buf == MAP_FAILED)
+    {
+    buf = mmap(NULL, *mapsize, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS, -1, (off_t)0);
+    if (buf == MAP_FAILED)
+      return NULL;
+#ifdef	MADV_HUGEPAGE
+    if (data_pagetype != DATA_PAGE_NORMAL
+	&& *mapsize%DATA_HUGEPAGESIZE == 0)
+      madvise(buf, *mapsize, MADV_HUGEPAGE);
+#endif
+    }
+  if (data_numatype == DATA_NUMA_INTERLEAVE)
+    interleave_pixbuf(buf, *mapsize);
+
+  return buf;
+#else
+  *mapsize = 0;
+  return posix_memalign(&buf, DATA_ALIGN, size)? NULL : buf;
+#endif
+  }
+
+
+/******* free_pixbuf **********************************************************
+PROTO	void free_pixbuf(void *buf, size_t mapsize)
+PURPOSE	Free a pixel buffer allocated with alloc_pixbuf().
+INPUT	Pointer to the buffer,
+	mapping size (in bytes), as returned by alloc_pixbuf().
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	free_pixbuf(void *buf, size_t mapsize)
+  {
+  if (!buf)
+    return;
+#ifdef	HAVE_SYS_MMAN_H
+  if (mapsize)
+    {
+    if (munmap(buf, mapsize))
+      warning("Can't unmap pixel buffer", "");
+    return;
+    }
+#endif
+  free(buf);
 
   return;
   }
 
 
-/******* set_maxdataram *******************************************************
-PROTO	int set_maxdataram(size_t maxram)
-PURPOSE	Set the maximum amount of silicon memory that can be allocated for
-	storing image data.
-INPUT	The maximum amount of RAM (in bytes).
-OUTPUT	RETURN_OK if within limits, RETURN_ERROR otherwise.
-NOTES	.
+/******* alloc_scratch ********************************************************
+PROTO	void *alloc_scratch(size_t size)
+PURPOSE	Get a scratch buffer from the run-wide pool.
+INPUT	Buffer size (in bytes).
+OUTPUT	Pointer to the buffer if OK, or NULL otherwise.
+NOTES	The smallest idle buffer of the pool that is large enough is reused,
+	unless it is more than DATA_SCRATCHSLACK times larger than requested:
+	a new buffer is then allocated, so that large buffers remain
+	available for large requests. Idle buffers that are too small are
+	released before a new one is allocated. Content is undefined. Buffers are
+	aligned on DATA_ALIGN bytes and must be returned with free_scratch().
+	Thread-safe.
 AUTHOR	E. Bertin (IAP)
-VERSION	18/12/2009
+VERSION	19/10/2026
  ***/
-int set_maxdataram(size_t maxram)
+void	*alloc_scratch(size_t size)
   {
+   void		*buf;
+   int		i, best;
 
-  if (maxram<1)
-    return RETURN_ERROR;
+  if (!size)
+    size = 1;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&data_scratchmutex);
+#endif
+  best = -1;
+  for (i=0; i<data_nscratch; i++)
+    if (!data_scratch[i].busyflag && data_scratch[i].size >= size
+	&& data_scratch[i].size/DATA_SCRATCHSLACK <= size
+	&& (best<0 || data_scratch[i].size < data_scratch[best].size))
+      best = i;
+  if (best<0)
+    {
+/*-- No idle buffer of the right size: release the small ones first */
+    trim_scratch(size);
+    buf = new_scratch(size, 1)? data_scratch[data_nscratch-1].buf : NULL;
+    }
+  else
+    {
+    data_scratch[best].busyflag = 1;
+    buf = data_scratch[best].buf;
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&data_scratchmutex);
+#endif
+
+  return buf;
+  }
+
+
+/******* free_scratch *********************************************************
+PROTO	void free_scratch(void *buf)
+PURPOSE	Return a scratch buffer to the pool.
+INPUT	Pointer to the buffer.
+OUTPUT	-.
+NOTES	The buffer is kept for later use until release_scratch() is called
+	(at the end of each job) or end_scratch(). Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	free_scratch(void *buf)
+  {
+   int		i, foundflag;
 
-  data_maxram = maxram*(size_t)(1024*1024);
+  if (!buf)
+    return;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&data_scratchmutex);
+#endif
+  for (i=0; i<data_nscratch && data_scratch[i].buf!=buf; i++);
+/* The pool may be trimmed by other jobs as soon as the mutex is released */
+  if ((foundflag = (i<data_nscratch)))
+    data_scratch[i].busyflag = 0;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&data_scratchmutex);
+#endif
+  if (!foundflag)
+    error(EXIT_FAILURE, "*Internal Error*: unknown scratch buffer in ",
+	"free_scratch()");
 
-  return RETURN_OK;
+  return;
   }
 
 
-/******* set_maxdatavram ******************************************************
-PROTO	int set_maxdatavram(size_t maxram)
-PURPOSE	Set the maximum amount of total virtual memory that can be used for
-	storing pixel data.
-INPUT	The maximum amount of VRAM (in bytes).
-OUTPUT	RETURN_OK if within limits, RETURN_ERROR otherwise.
-NOTES	.
+/******* reserve_scratch ******************************************************
+PROTO	void reserve_scratch(size_t size, int nbuf)
+PURPOSE	Pre-size the scratch buffer pool.
+INPUT	Buffer size (in bytes),
+	number of buffers.
+OUTPUT	-.
+NOTES	Makes sure that at least nbuf idle buffers of at least size bytes are
+	available, typically for the largest geometry of a series of jobs.
+	Thread-safe.
 AUTHOR	E. Bertin (IAP)
-VERSION	18/12/2009
+VERSION	19/10/2026
  ***/
-int set_maxdatavram(size_t maxvram)
+void	reserve_scratch(size_t size, int nbuf)
   {
+   int		i, n;
 
-  if (maxvram<1)
-    return RETURN_ERROR;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&data_scratchmutex);
+#endif
+  for (n=i=0; i<data_nscratch; i++)
+    if (!data_scratch[i].busyflag && data_scratch[i].size >= size)
+      n++;
+  if (n<nbuf)
+    {
+/*-- Replace smaller idle buffers */
+    trim_scratch(size);
+    for (; n<nbuf && new_scratch(size, 0); n++);
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&data_scratchmutex);
+#endif
+
+  return;
+  }
+
+
+/******* release_scratch ******************************************************
+PROTO	void release_scratch(void)
+PURPOSE	Free the idle buffers of the scratch buffer pool.
+INPUT	-.
+OUTPUT	-.
+NOTES	Buffers are only reused for requests at most DATA_SCRATCHSLACK times
+	smaller, hence the large buffers of a job would otherwise stay mapped
+	for the life of the process. Buffers of the conversions still running
+	are left alone. Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	release_scratch(void)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&data_scratchmutex);
+#endif
+  trim_scratch((size_t)-1);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&data_scratchmutex);
+#endif
+
+  return;
+  }
+
+
+/******* end_scratch **********************************************************
+PROTO	void end_scratch(void)
+PURPOSE	Free all the buffers of the scratch buffer pool.
+INPUT	-.
+OUTPUT	-.
+NOTES	High-water marks are kept (see get_scratchpeaks()). The pool is
+	shared by all conversions: this must not be called while one of them
+	is running.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_scratch(void)
+  {
+   int		i;
 
-  data_maxvram = maxvram*(size_t)(1024*1024);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&data_scratchmutex);
+#endif
+  for (i=0; i<data_nscratch; i++)
+    free_pixbuf(data_scratch[i].buf, data_scratch[i].mapsize);
+  free(data_scratch);
+  data_scratch = NULL;
+  data_nscratch = data_nscratchmax = 0;
+  data_scratchsize = 0;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&data_scratchmutex);
+#endif
 
-  return RETURN_OK;
+  return;
   }
 
 
-/******* set_dataswapdir ******************************************************
-PROTO	int set_dataswapdir(char *dirname)
-PURPOSE	Set the path name of the directory that will be used for storing
-	memory swap files.
-INPUT	The pointer to the path string.
-OUTPUT	RETURN_OK if path appropriate, RETURN_ERROR otherwise.
-NOTES	.
+/******* get_scratchpeaks *****************************************************
+PROTO	void get_scratchpeaks(size_t *peaksize, int *peaknbuf)
+PURPOSE	Return the high-water marks of the scratch buffer pool.
+INPUT	Pointer to the largest total size of the pool (in bytes),
+	pointer to the largest number of buffers in the pool.
+OUTPUT	-.
+NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	05/12/2009
+VERSION	19/10/2026
  ***/
-int set_dataswapdir(char *dirname)
+void	get_scratchpeaks(size_t *peaksize, int *peaknbuf)
   {
+  *peaksize = data_scratchpeak;
+  *peaknbuf = data_scratchnpeak;
 
-  if (!dirname)
-    return RETURN_ERROR;
+  return;
+  }
+
+
+/******* new_scratch **********************************************************
+PROTO	int new_scratch(size_t size, int busyflag)
+PURPOSE	Add a new buffer to the scratch buffer pool.
+INPUT	Buffer size (in bytes),
+	flag set if the buffer is handed out right away.
+OUTPUT	1 if the buffer could be allocated, 0 otherwise.
+NOTES	The new buffer is the last one of the pool. Must be called with the
+	scratch mutex locked.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	new_scratch(size_t size, int busyflag)
+  {
+   void		*buf;
+   size_t	mapsize;
+
+  if (!(buf = alloc_pixbuf(size, &mapsize)))
+    return 0;
+  if (data_nscratch >= data_nscratchmax)
+    {
+    data_nscratchmax += DATA_NSCRATCH;
+    QREALLOC(data_scratch, scratchbufstruct, data_nscratchmax);
+    }
+  data_scratch[data_nscratch].buf = buf;
+  data_scratch[data_nscratch].size = size;
+  data_scratch[data_nscratch].mapsize = mapsize;
+  data_scratch[data_nscratch++].busyflag = busyflag;
+  data_scratchsize += size;
+  if (data_scratchsize > data_scratchpeak)
+    data_scratchpeak = data_scratchsize;
+  if (data_nscratch > data_scratchnpeak)
+    data_scratchnpeak = data_nscratch;
+
+  return 1;
+  }
+
+
+/******* trim_scratch *********************************************************
+PROTO	void trim_scratch(size_t size)
+PURPOSE	Release the small idle buffers of the scratch buffer pool.
+INPUT	Size below which idle buffers are released (in bytes).
+OUTPUT	-.
+NOTES	Must be called with the scratch mutex locked.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	trim_scratch(size_t size)
+  {
+   int		i;
+
+  for (i=0; i<data_nscratch; )
+    if (!data_scratch[i].busyflag && data_scratch[i].size < size)
+      {
+      free_pixbuf(data_scratch[i].buf, data_scratch[i].mapsize);
+      data_scratchsize -= data_scratch[i].size;
+      data_scratch[i] = data_scratch[--data_nscratch];
+      }
+    else
+      i++;
+
+  return;
+  }
+
+
+/******* pixbuf_mapsize *******************************************************
+PROTO	size_t pixbuf_mapsize(size_t size)
+PURPOSE	Compute the size of the memory mapping of a pixel buffer.
+INPUT	Buffer size (in bytes).
+OUTPUT	Mapping size (in bytes), or 0 if the buffer is taken from the heap.
+NOTES	Depends on the policies set with set_datapages() at the time of the
+	call; the result is kept with the buffer for free_pixbuf().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static size_t	pixbuf_mapsize(size_t size)
+  {
+   size_t	pagesize;
+
+  if ((data_pagetype == DATA_PAGE_NORMAL
+	&& data_numatype == DATA_NUMA_DEFAULT)
+	|| size < DATA_MINPIXBUF)
+    return 0;
+
+  pagesize = (data_pagetype != DATA_PAGE_NORMAL && size >= DATA_HUGEPAGESIZE)?
+	DATA_HUGEPAGESIZE : (size_t)sysconf(_SC_PAGESIZE);
+
+  return (size+pagesize-1)/pagesize*pagesize;
+  }
 
-  strcpy(data_swapdirname, dirname);
 
-  return RETURN_OK;
+/******* interleave_pixbuf ****************************************************
+PROTO	void interleave_pixbuf(void *buf, size_t size)
+PURPOSE	Interleave the pages of a mapped buffer over all online NUMA nodes.
+INPUT	Pointer to the (page-aligned) buffer,
+	buffer size (in bytes).
+OUTPUT	-.
+NOTES	Calls the Linux mbind() system call directly, to avoid depending on
+	libnuma. Does nothing on single-node or non-Linux systems.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	interleave_pixbuf(void *buf, size_t size)
+  {
+#if defined(__linux__) && defined(SYS_mbind)
+   FILE			*file;
+   unsigned long	nodemask;
+   int			n1,n2, nnode;
+   char			c;
+
+/* Build the mask of online nodes from a list such as "0-1,3" */
+  if (!(file = fopen("/sys/devices/system/node/online", "r")))
+    return;
+  nodemask = 0;
+  nnode = 0;
+  while (fscanf(file, "%d", &n1) == 1)
+    {
+    n2 = n1;
+    if ((c = fgetc(file)) == '-')
+      {
+      if (fscanf(file, "%d", &n2) != 1)
+        break;
+      c = fgetc(file);
+      }
+    for (; n1<=n2 && n1<(int)(8*sizeof(unsigned long)); n1++, nnode++)
+      nodemask |= 1UL<<n1;
+    if (c != ',')
+      break;
+    }
+  fclose(file);
+  if (nnode>1
+	&& syscall(SYS_mbind, buf, size, DATA_MPOL_INTERLEAVE, &nodemask,
+		(unsigned long)(8*sizeof(unsigned long)), 0))
+    warning("Cannot interleave pixel buffer over NUMA nodes", "");
+#endif
+
+  return;
+  }
+
+
+/******* new_datastore ********************************************************
+PROTO	datastorestruct *new_datastore(dataarenastruct *arena, size_t width,
+				int height, int blockheight, int datatype,
+				float zero, float range)
+PURPOSE	Create a store for a 2D array of pixel values.
+INPUT	Pointer to the allocator,
+	row length (in pixels),
+	number of rows,
+	number of rows per block,
+	storage type (DATA_FLOAT32, DATA_FLOAT16 or DATA_UINT16),
+	pixel value mapped to 0 by DATA_FLOAT16 and DATA_UINT16,
+	pixel value range mapped to 1 by DATA_FLOAT16 and DATA_UINT16.
+OUTPUT	Pointer to the new store if OK, or NULL otherwise.
+NOTES	If the data do not fit in the remaining RAM and compression is on (see
+	new_dataarena()), rows are kept as byte-shuffled, deflated blocks of
+	blockheight rows. Compressed blocks are kept in RAM as long as possible,
+	and are spilled to a file in the swap directory beyond that. Otherwise
+	the data are stored contiguously, using alloc_data().
+	DATA_FLOAT16 and DATA_UINT16 stores always use blocks (deflated only
+	if compression is on). Both are lossy (see pack_datablock()).
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+datastorestruct	*new_datastore(dataarenastruct *arena, size_t width,
+			int height, int blockheight, int datatype,
+			float zero, float range)
+  {
+   datastorestruct	*store;
+   size_t		ndata;
+   int			b, ramflag;
+
+  QCALLOC(store, datastorestruct, 1);
+  store->arena = arena;
+  store->width = width;
+  store->height = height;
+  store->blockheight = blockheight;
+  store->datatype = datatype;
+  store->compressflag = arena->compressflag;
+  store->zero = zero;
+  store->range = range>0.0? range : 1.0;
+  store->fd = -1;
+  ndata = width*(size_t)height;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  ramflag = ndata*sizeof(float) < get_dataroom(arena);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+  if (datatype==DATA_FLOAT32 && (!store->compressflag || ramflag))
+    {
+    if (!(store->data = alloc_data(arena, ndata, &store->swapname)))
+      {
+      free(store);
+      return NULL;
+      }
+    return store;
+    }
+
+  store->nblock = (height+blockheight-1)/blockheight;
+  QCALLOC(store->block, datablockstruct, store->nblock);
+  for (b=0; b<store->nblock; b++)
+    {
+    store->block[b].store = store;
+    store->block[b].zpos = -1;
+    }
+
+  return store;
+  }
+
+
+/******* get_datarows *********************************************************
+PROTO	float *get_datarows(datastorestruct *store, int y, int writeflag)
+PURPOSE	Give access to a row of a data store.
+INPUT	Pointer to the store,
+	row index,
+	flag set if the row is to be modified.
+OUTPUT	Pointer to the first pixel of the row.
+NOTES	The following rows of the same block are contiguous in memory. With
+	compressed stores, the block is pinned in the cache of decompressed
+	blocks: the pointer remains valid until release_datarows() is called
+	with the same row index. Blocks are decompressed without holding the
+	allocator mutex; other threads needing the same block wait for it.
+	Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+float	*get_datarows(datastorestruct *store, int y, int writeflag)
+  {
+   dataarenastruct	*arena;
+   datablockstruct	*block;
+   float		*buf;
+
+  if (store->data)
+    return store->data + (size_t)y*store->width;
+
+  arena = store->arena;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  block = &store->block[y/store->blockheight];
+/* Pin the block first, so that it is not picked for eviction */
+  block->pincount++;
+#ifdef USE_THREADS
+  while (block->busyflag)
+    QPTHREAD_COND_WAIT(&arena->cond, &arena->mutex);
+#endif
+  if (!block->buf)
+    cache_datablock(block);
+  block->lastuse = ++arena->cachestamp;
+  if (writeflag)
+    block->dirtyflag = 1;
+  buf = block->buf + (size_t)(y%store->blockheight)*store->width;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+
+  return buf;
+  }
+
+
+/******* release_datarows *****************************************************
+PROTO	void release_datarows(datastorestruct *store, int y)
+PURPOSE	Release the access to a row of a data store given by get_datarows().
+INPUT	Pointer to the store,
+	row index.
+OUTPUT	-.
+NOTES	Unpins the block of the row. Blocks loaded while all the cached
+	blocks were pinned are evicted as soon as they are unpinned.
+	Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	release_datarows(datastorestruct *store, int y)
+  {
+   dataarenastruct	*arena;
+   datablockstruct	*block;
+   int			c;
+
+  if (store->data)
+    return;
+
+  arena = store->arena;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  block = &store->block[y/store->blockheight];
+  if (!--block->pincount && arena->ncache > DATA_NCACHEBLOCK)
+    {
+    for (c=0; arena->cache[c]!=block; c++);
+    uncache_datablock(arena, c);
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+
+  return;
+  }
+
+
+/******* free_datastore *******************************************************
+PROTO	void free_datastore(datastorestruct *store)
+PURPOSE	Free a data store.
+INPUT	Pointer to the store.
+OUTPUT	-.
+NOTES	Waits for the blocks of the store being evicted by other threads.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	free_datastore(datastorestruct *store)
+  {
+   dataarenastruct	*arena;
+   datablockstruct	*block;
+   int			b,c;
+
+  arena = store->arena;
+  if (store->data)
+    free_data(arena, store->data, store->width*(size_t)store->height,
+	store->swapname);
+  else
+    {
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+    for (block=store->block, b=store->nblock; b--; block++)
+      {
+#ifdef USE_THREADS
+      while (block->busyflag)
+        QPTHREAD_COND_WAIT(&arena->cond, &arena->mutex);
+#endif
+      if (block->buf)
+        {
+        for (c=0; arena->cache[c]!=block; c++);
+        arena->cache[c] = arena->cache[--arena->ncache];
+        free(block->buf);
+        arena->cacheram -= datablock_npix(block)*sizeof(float);
+        }
+      if (block->zbuf)
+        {
+        free(block->zbuf);
+        arena->ramleft += block->zsize;
+        }
+      if (block->zpos>=0)
+        arena->vramleft += block->zslot;
+      }
+    if (!arena->ncache)
+      {
+      QFREE(arena->cache);
+      arena->ncachemax = 0;
+      }
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+    if (store->swapname)
+      {
+      close(store->fd);
+      if (unlink(store->swapname))
+        warning("Can't delete ", store->swapname);
+#ifdef USE_THREADS
+      QPTHREAD_MUTEX_LOCK(&data_swapmutex);
+#endif
+      remove_cleanupfilename(store->swapname);
+#ifdef USE_THREADS
+      QPTHREAD_MUTEX_UNLOCK(&data_swapmutex);
+#endif
+      free(store->swapname);
+      }
+    free(store->block);
+    }
+  free(store);
+
+  return;
+  }
+
+
+/******* cache_datablock ******************************************************
+PROTO	void cache_datablock(datablockstruct *block)
+PURPOSE	Load a block in the cache of decompressed blocks.
+INPUT	Pointer to the (pinned) block.
+OUTPUT	-.
+NOTES	Decompressed blocks are charged to the RAM budget. The least recently
+	used unpinned blocks of the allocator of the store are evicted while
+	the cache is full, or while it holds DATA_NCACHEMIN blocks or more and
+	the new block does not fit in the budget; the working set of a pyramid
+	level is thus not evicted row after row. The cache grows beyond
+	DATA_NCACHEBLOCK blocks, or overdraws the budget, if they are all
+	pinned. Must be called with the allocator mutex
+	locked; the mutex is released while the blocks are (de)compressed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	cache_datablock(datablockstruct *block)
+  {
+   dataarenastruct	*arena;
+   size_t		size;
+   int			c, cmin;
+
+  arena = block->store->arena;
+  block->busyflag = 1;
+  size = datablock_npix(block)*sizeof(float);
+  while (arena->ncache >= DATA_NCACHEBLOCK
+	|| (arena->ncache >= DATA_NCACHEMIN && size >= get_dataroom(arena)))
+    {
+    cmin = -1;
+    for (c=0; c<arena->ncache; c++)
+      if (!arena->cache[c]->pincount && !arena->cache[c]->busyflag
+	&& (cmin<0 || arena->cache[c]->lastuse < arena->cache[cmin]->lastuse))
+        cmin = c;
+    if (cmin<0)
+      break;
+    uncache_datablock(arena, cmin);
+    }
+  if (arena->ncache >= arena->ncachemax)
+    {
+    arena->ncachemax += DATA_NCACHEBLOCK;
+    QREALLOC(arena->cache, datablockstruct *, arena->ncachemax);
+    }
+  arena->cache[arena->ncache++] = block;
+  arena->cacheram += size;
+  update_datapeaks(arena);
+#ifdef USE_THREADS
+/* Errors must remain fatal while the block is busy */
+  error_holdtrap(1);
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+  if (block->zbuf || block->zpos>=0)
+    decompress_datablock(block);
+  else
+    QCALLOC(block->buf, float, datablock_npix(block));
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+  error_holdtrap(-1);
+  QPTHREAD_COND_BROADCAST(&arena->cond);
+#endif
+  block->busyflag = 0;
+
+  return;
+  }
+
+
+/******* uncache_datablock ****************************************************
+PROTO	void uncache_datablock(dataarenastruct *arena, int c)
+PURPOSE	Evict a block from the cache of decompressed blocks.
+INPUT	Pointer to the allocator,
+	index of the block in the cache.
+OUTPUT	-.
+NOTES	Modified data are compressed before eviction.
+	Must be called with the allocator mutex locked; the mutex is released
+	while the block is compressed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	uncache_datablock(dataarenastruct *arena, int c)
+  {
+   datablockstruct	*block;
+
+  block = arena->cache[c];
+  arena->cache[c] = arena->cache[--arena->ncache];
+  block->busyflag = 1;
+#ifdef USE_THREADS
+  error_holdtrap(1);
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+  if (block->dirtyflag)
+    compress_datablock(block);
+  QFREE(block->buf);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+  error_holdtrap(-1);
+  QPTHREAD_COND_BROADCAST(&arena->cond);
+#endif
+  arena->cacheram -= datablock_npix(block)*sizeof(float);
+  block->busyflag = 0;
+
+  return;
+  }
+
+
+/******* compress_datablock ***************************************************
+PROTO	void compress_datablock(datablockstruct *block)
+PURPOSE	Compress the content of a decompressed block.
+INPUT	Pointer to the block.
+OUTPUT	-.
+NOTES	Pixel values are first converted to the storage type of the store.
+	With compression on, bytes are then shuffled by significance and
+	deflated. The result is kept in RAM if there is room left for it, and
+	written to the spill file otherwise. Must be called with the block
+	busy and the allocator mutex unlocked: only the bookkeeping is done
+	with the mutex locked.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	compress_datablock(datablockstruct *block)
+  {
+   dataarenastruct	*arena;
+   datastorestruct	*store;
+   unsigned char	*raw, *sbuf,*sbuft, *zbuf, *pix;
+   uLongf		zsize;
+   OFF_T		zpos;
+   size_t		npix, rawsize, i;
+   int			k, esize;
+
+  store = block->store;
+  arena = store->arena;
+  npix = datablock_npix(block);
+  esize = store->datatype==DATA_FLOAT32? sizeof(float) : sizeof(unsigned short);
+  rawsize = npix*esize;
+  if (store->datatype==DATA_FLOAT32)
+    raw = (unsigned char *)block->buf;
+  else
+    {
+    QMALLOC(raw, unsigned char, rawsize);
+    pack_datablock(store, block->buf, (unsigned short *)raw, npix);
+    }
+  if (store->compressflag)
+    {
+/*-- Byte shuffling */
+    QMALLOC(sbuf, unsigned char, rawsize);
+    for (sbuft=sbuf, k=0; k<esize; k++)
+      for (pix=raw+k, i=npix; i--; pix+=esize)
+        *(sbuft++) = *pix;
+    zsize = compressBound((uLong)rawsize);
+    QMALLOC(zbuf, unsigned char, zsize);
+    if (compress2(zbuf, &zsize, sbuf, (uLong)rawsize, DATA_ZLEVEL) != Z_OK)
+      error(EXIT_FAILURE, "*Error*: cannot compress data block", "");
+    free(sbuf);
+    if (raw != (unsigned char *)block->buf)
+      free(raw);
+    }
+  else
+    {
+    zbuf = raw;
+    zsize = rawsize;
+    }
+
+/* Release the previous version */
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  if (block->zbuf)
+    {
+    QFREE(block->zbuf);
+    arena->ramleft += block->zsize;
+    }
+  block->zsize = zsize;
+  zpos = -1;
+  if (zsize < get_dataroom(arena))
+    {
+/*-- Keep the compressed data in RAM */
+    QREALLOC(zbuf, unsigned char, zsize);
+    block->zbuf = zbuf;
+    arena->ramleft -= zsize;
+    update_datapeaks(arena);
+    if (block->zpos>=0)
+      {
+      arena->vramleft += block->zslot;
+      block->zpos = -1;
+      block->zslot = 0;
+      }
+    }
+  else
+    {
+/*-- Spill the compressed data to disk */
+    if (!store->swapname)
+      {
+      QMALLOC(store->swapname, char, MAXCHARS);
+      name_dataswap(arena, store->swapname);
+      if ((store->fd=open(store->swapname, O_RDWR|O_CREAT|O_TRUNC, 0666))
+		== -1)
+        error(EXIT_FAILURE, "*Error*: cannot create swap-file ",
+		store->swapname);
+#ifdef USE_THREADS
+      QPTHREAD_MUTEX_LOCK(&data_swapmutex);
+#endif
+      add_cleanupfilename(store->swapname);
+#ifdef USE_THREADS
+      QPTHREAD_MUTEX_UNLOCK(&data_swapmutex);
+#endif
+      }
+    if (block->zpos<0 || block->zslot<zsize)
+      {
+      if (block->zpos>=0)
+        arena->vramleft += block->zslot;
+      if (zsize >= arena->vramleft)
+        error(EXIT_FAILURE, "*Error*: not enough virtual memory for ",
+		store->swapname);
+      block->zpos = store->fsize;
+      block->zslot = zsize;
+      store->fsize += zsize;
+      arena->vramleft -= zsize;
+      update_datapeaks(arena);
+      }
+    zpos = block->zpos;
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+/* Slots are reserved: blocks of the same store are written concurrently */
+  if (zpos>=0)
+    {
+    if (pwrite(store->fd, zbuf, zsize, (off_t)zpos) != (ssize_t)zsize)
+      error(EXIT_FAILURE, "*Error*: cannot write to swap-file ",
+		store->swapname);
+    free(zbuf);
+    }
+  block->dirtyflag = 0;
+
+  return;
+  }
+
+
+/******* decompress_datablock *************************************************
+PROTO	void decompress_datablock(datablockstruct *block)
+PURPOSE	Decompress the content of a compressed block.
+INPUT	Pointer to the block.
+OUTPUT	-.
+NOTES	Must be called with the block busy and the allocator mutex unlocked.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	decompress_datablock(datablockstruct *block)
+  {
+   datastorestruct	*store;
+   unsigned char	*raw, *sbuf,*sbuft, *zbuf, *pix;
+   uLongf		size;
+   size_t		npix, rawsize, i;
+   int			k, esize;
+
+  store = block->store;
+  npix = datablock_npix(block);
+  esize = store->datatype==DATA_FLOAT32? sizeof(float) : sizeof(unsigned short);
+  rawsize = npix*esize;
+  if (!(zbuf = block->zbuf))
+    {
+    QMALLOC(zbuf, unsigned char, block->zsize);
+    if (pread(store->fd, zbuf, block->zsize, (off_t)block->zpos)
+	!= (ssize_t)block->zsize)
+      error(EXIT_FAILURE, "*Error*: cannot read from swap-file ",
+		store->swapname);
+    }
+  QMALLOC(block->buf, float, npix);
+  raw = store->datatype==DATA_FLOAT32? (unsigned char *)block->buf : NULL;
+  if (store->compressflag)
+    {
+    size = rawsize;
+    QMALLOC(sbuf, unsigned char, size);
+    if (uncompress(sbuf, &size, zbuf, (uLong)block->zsize) != Z_OK
+	|| size != rawsize)
+      error(EXIT_FAILURE, "*Error*: corrupted data block", "");
+/*-- Byte unshuffling */
+    if (!raw)
+      QMALLOC(raw, unsigned char, rawsize);
+    for (sbuft=sbuf, k=0; k<esize; k++)
+      for (pix=raw+k, i=npix; i--; pix+=esize)
+        *pix = *(sbuft++);
+    free(sbuf);
+    }
+  else if (!raw)
+    raw = zbuf;
+  else
+    memcpy(raw, zbuf, rawsize);
+  if (store->datatype!=DATA_FLOAT32)
+    {
+    unpack_datablock(store, (unsigned short *)raw, block->buf, npix);
+    if (raw != zbuf)
+      free(raw);
+    }
+  if (!block->zbuf)
+    free(zbuf);
+
+  return;
+  }
+
+
+/******* pack_datablock *******************************************************
+PROTO	void pack_datablock(datastorestruct *store, float *buf,
+			unsigned short *pack, size_t npix)
+PURPOSE	Convert pixel values to 16-bit storage values.
+INPUT	Pointer to the store,
+	pointer to the pixel values (modified),
+	pointer to the output 16-bit values,
+	number of pixels.
+OUTPUT	-.
+NOTES	Pixel values are first normalized with the zero and range of the store.
+	With DATA_FLOAT16, bad pixels (<= -BIG) are stored as -Inf, and other
+	values are clipped to the half-precision range. The pixel values are
+	normalized in place.
+	With DATA_UINT16, normalized values x are companded as
+	asinh(x/DATA_QSOFT), which is linear close to the zero point and
+	logarithmic beyond, then quantized in steps of 1/DATA_QSCALE, offset
+	by DATA_QZERO and clipped to [0,DATA_QMAX]. This covers x from about
+	-1 to DATA_HALFMAX, so that bright pixels are not clipped before they
+	are binned into the next levels. Bad pixels are stored as DATA_QBAD.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	pack_datablock(datastorestruct *store, float *buf,
+			unsigned short *pack, size_t npix)
+  {
+   float	*buft, zero, scale, val;
+   size_t	i;
+
+  zero = store->zero;
+  if (store->datatype == DATA_UINT16)
+    {
+    scale = 1.0/(store->range*DATA_QSOFT);
+    for (buft=buf, i=npix; i--; buft++)
+      if (*buft > -BIG)
+        {
+        val = asinhf((*buft - zero)*scale)*DATA_QSCALE + DATA_QZERO + 0.5;
+        *(pack++) = val<1.0? 0
+		: (val>=DATA_QMAX? DATA_QMAX : (unsigned short)val);
+        }
+      else
+        *(pack++) = DATA_QBAD;
+    return;
+    }
+
+  scale = 1.0/store->range;
+  for (buft=buf, i=npix; i--; buft++)
+    if (*buft > -BIG)
+      {
+      val = (*buft - zero)*scale;
+      *buft = val<-DATA_HALFMAX? -DATA_HALFMAX
+		: (val>DATA_HALFMAX? DATA_HALFMAX : val);
+      }
+    else
+      *buft = -INFINITY;
+  floats_to_halves(buf, pack, npix);
+
+  return;
+  }
+
+
+/******* unpack_datablock *****************************************************
+PROTO	void unpack_datablock(datastorestruct *store, unsigned short *pack,
+			float *buf, size_t npix)
+PURPOSE	Convert 16-bit storage values back to pixel values.
+INPUT	Pointer to the store,
+	pointer to the 16-bit values,
+	pointer to the output pixel values,
+	number of pixels.
+OUTPUT	-.
+NOTES	See pack_datablock().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	unpack_datablock(datastorestruct *store, unsigned short *pack,
+			float *buf, size_t npix)
+  {
+   float	*buft, zero, range;
+   size_t	i;
+
+  zero = store->zero;
+  range = store->range;
+  if (store->datatype == DATA_UINT16)
+    {
+    range *= DATA_QSOFT;
+    for (buft=buf, i=npix; i--; pack++)
+      if (*pack == DATA_QBAD)
+        *(buft++) = -BIG;
+      else
+        {
+        *(buft++) = sinhf(((int)*pack - DATA_QZERO)/DATA_QSCALE)*range
+		+ zero;
+        }
+    return;
+    }
+
+  halves_to_floats(pack, buf, npix);
+  for (buft=buf, i=npix; i--; buft++)
+    *buft = *buft > -INFINITY? *buft*range + zero : -BIG;
+
+  return;
+  }
+
+
+/******* floats_to_halves *****************************************************
+PROTO	void floats_to_halves(float *in, unsigned short *out, size_t n)
+PURPOSE	Convert single precision floating point values to half precision.
+INPUT	Pointer to the input values,
+	pointer to the output (IEEE 754 binary16) values,
+	number of values.
+OUTPUT	-.
+NOTES	Rounding is to the nearest even value, like the F16C and AVX-512
+	instructions, which are used if the CPU supports them.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	floats_to_halves(float *in, unsigned short *out, size_t n)
+  {
+   union {float f; unsigned int i;}	u;
+   unsigned int				x, m, h, rem, halfway, sign;
+   size_t				i;
+   int					shift;
+
+#ifdef SIMD_X86
+  switch(get_halfsimdlevel())
+    {
+    case SIMD_AVX512:
+      i = floats_to_halves_avx512(in, out, n);
+      break;
+    case SIMD_AVX2:
+      i = floats_to_halves_f16c(in, out, n);
+      break;
+    default:
+      i = 0;
+    }
+  in += i;
+  out += i;
+  n -= i;
+#endif
+  for (; n--;)
+    {
+    u.f = *(in++);
+    sign = (u.i>>16) & 0x8000;
+    x = u.i & 0x7fffffff;
+    if (x >= 0x7f800000)			/* Inf or NaN */
+      h = x>0x7f800000? 0x7e00 | ((x>>13)&0x3ff) : 0x7c00;
+    else if (x >= 0x477ff000)			/* Overflow */
+      h = 0x7c00;
+    else if (x < 0x38800000)			/* Subnormal */
+      {
+      if (x < 0x33000000)
+        h = 0;
+      else
+        {
+        m = (x & 0x7fffff) | 0x800000;
+        shift = 126 - (int)(x>>23);
+        h = m >> shift;
+        rem = m & ((1u<<shift)-1);
+        halfway = 1u<<(shift-1);
+        if (rem > halfway || (rem == halfway && (h&1)))
+          h++;
+        }
+      }
+    else					/* Normal */
+      {
+      h = (x - 0x38000000) >> 13;
+      rem = x & 0x1fff;
+      if (rem > 0x1000 || (rem == 0x1000 && (h&1)))
+        h++;
+      }
+    *(out++) = (unsigned short)(sign | h);
+    }
+
+  return;
+  }
+
+
+/******* halves_to_floats *****************************************************
+PROTO	void halves_to_floats(unsigned short *in, float *out, size_t n)
+PURPOSE	Convert half precision floating point values to single precision.
+INPUT	Pointer to the input (IEEE 754 binary16) values,
+	pointer to the output values,
+	number of values.
+OUTPUT	-.
+NOTES	The conversion is exact. F16C and AVX-512 instructions are used if the
+	CPU supports them.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	halves_to_floats(unsigned short *in, float *out, size_t n)
+  {
+   union {float f; unsigned int i;}	u;
+   unsigned int				h, e, m;
+   size_t				i;
+
+#ifdef SIMD_X86
+  switch(get_halfsimdlevel())
+    {
+    case SIMD_AVX512:
+      i = halves_to_floats_avx512(in, out, n);
+      break;
+    case SIMD_AVX2:
+      i = halves_to_floats_f16c(in, out, n);
+      break;
+    default:
+      i = 0;
+    }
+  in += i;
+  out += i;
+  n -= i;
+#endif
+  for (; n--;)
+    {
+    h = *(in++);
+    e = (h>>10) & 0x1f;
+    m = h & 0x3ff;
+    u.i = (h & 0x8000)<<16;
+    if (e == 31)				/* Inf or NaN */
+      u.i |= 0x7f800000 | (m? 0x400000 | (m<<13) : 0);
+    else if (e)					/* Normal */
+      u.i |= ((e+112)<<23) | (m<<13);
+    else if (m)					/* Subnormal */
+      {
+      for (e=113; !(m&0x400); e--)
+        m <<= 1;
+      u.i |= (e<<23) | ((m&0x3ff)<<13);
+      }
+    *(out++) = u.f;
+    }
+
+  return;
+  }
+
+
+/******* get_halfsimdlevel ****************************************************
+PROTO	int get_halfsimdlevel(void)
+PURPOSE	Find out the vector instruction set of half-precision conversions.
+INPUT	-.
+OUTPUT	SIMD_AVX512 (AVX-512F), SIMD_AVX2 (F16C) or SIMD_NONE.
+NOTES	The CPU is probed only once (see get_simdlevel()). Concurrent first
+	calls are harmless.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	get_halfsimdlevel(void)
+  {
+  if (data_halfsimd < 0)
+    {
+#ifdef SIMD_X86
+    if (get_simdlevel() == SIMD_AVX512)
+      data_halfsimd = SIMD_AVX512;
+    else if (__builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c"))
+      data_halfsimd = SIMD_AVX2;
+    else
+#endif
+      data_halfsimd = SIMD_NONE;
+    }
+
+  return data_halfsimd;
+  }
+
+
+#ifdef SIMD_X86
+/******* floats_to_halves_f16c ************************************************
+PROTO	size_t floats_to_halves_f16c(float *in, unsigned short *out, size_t n)
+PURPOSE	Convert single precision values to half precision with F16C
+	instructions.
+INPUT	Pointer to the input values,
+	pointer to the output values,
+	number of values.
+OUTPUT	Number of values converted (a multiple of 8).
+NOTES	The remaining values are left to the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("avx,f16c")))
+static size_t	floats_to_halves_f16c(float *in, unsigned short *out, size_t n)
+  {
+   size_t	i;
+
+  for (i=0; i+8<=n; i+=8)
+    _mm_storeu_si128((__m128i *)(out+i),
+	_mm256_cvtps_ph(_mm256_loadu_ps(in+i), _MM_FROUND_TO_NEAREST_INT));
+
+  return i;
+  }
+
+
+/******* floats_to_halves_avx512 **********************************************
+PROTO	size_t floats_to_halves_avx512(float *in, unsigned short *out,
+			size_t n)
+PURPOSE	Convert single precision values to half precision with AVX-512
+	instructions.
+INPUT	Pointer to the input values,
+	pointer to the output values,
+	number of values.
+OUTPUT	Number of values converted (a multiple of 16).
+NOTES	The remaining values are left to the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("avx512f")))
+static size_t	floats_to_halves_avx512(float *in, unsigned short *out,
+			size_t n)
+  {
+   size_t	i;
+
+  for (i=0; i+16<=n; i+=16)
+    _mm256_storeu_si256((__m256i *)(out+i),
+	_mm512_cvtps_ph(_mm512_loadu_ps(in+i), _MM_FROUND_TO_NEAREST_INT));
+
+  return i;
+  }
+
+
+/******* halves_to_floats_f16c ************************************************
+PROTO	size_t halves_to_floats_f16c(unsigned short *in, float *out, size_t n)
+PURPOSE	Convert half precision values to single precision with F16C
+	instructions.
+INPUT	Pointer to the input values,
+	pointer to the output values,
+	number of values.
+OUTPUT	Number of values converted (a multiple of 8).
+NOTES	The remaining values are left to the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("avx,f16c")))
+static size_t	halves_to_floats_f16c(unsigned short *in, float *out, size_t n)
+  {
+   size_t	i;
+
+  for (i=0; i+8<=n; i+=8)
+    _mm256_storeu_ps(out+i,
+	_mm256_cvtph_ps(_mm_loadu_si128((__m128i *)(in+i))));
+
+  return i;
+  }
+
+
+/******* halves_to_floats_avx512 **********************************************
+PROTO	size_t halves_to_floats_avx512(unsigned short *in, float *out,
+			size_t n)
+PURPOSE	Convert half precision values to single precision with AVX-512
+	instructions.
+INPUT	Pointer to the input values,
+	pointer to the output values,
+	number of values.
+OUTPUT	Number of values converted (a multiple of 16).
+NOTES	The remaining values are left to the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("avx512f")))
+static size_t	halves_to_floats_avx512(unsigned short *in, float *out,
+			size_t n)
+  {
+   size_t	i;
+
+  for (i=0; i+16<=n; i+=16)
+    _mm512_storeu_ps(out+i,
+	_mm512_cvtph_ps(_mm256_loadu_si256((__m256i *)(in+i))));
+
+  return i;
+  }
+#endif
+
+
+/******* datablock_npix *******************************************************
+PROTO	size_t datablock_npix(datablockstruct *block)
+PURPOSE	Return the number of pixels in a block.
+INPUT	Pointer to the block.
+OUTPUT	Number of pixels.
+NOTES	The last block of a store may be shorter.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static size_t	datablock_npix(datablockstruct *block)
+  {
+   datastorestruct	*store;
+   int			b, nrow;
+
+  store = block->store;
+  b = block - store->block;
+  nrow = store->height - b*store->blockheight;
+  if (nrow > store->blockheight)
+    nrow = store->blockheight;
+
+  return store->width*(size_t)nrow;
+  }
+
+
+/******* set_datapages *******************************************************
+PROTO	void set_datapages(int pagetype, int numatype)
+PURPOSE	Set the page type and the NUMA placement policy of pixel buffers.
+INPUT	Page type (DATA_PAGE_NORMAL, DATA_PAGE_TRANSPARENT or
+	DATA_PAGE_EXPLICIT),
+	NUMA placement (DATA_NUMA_DEFAULT, DATA_NUMA_INTERLEAVE or
+	DATA_NUMA_FIRSTTOUCH).
+OUTPUT	-.
+NOTES	Applies to the pixel buffers allocated from then on; buffers already
+	in the scratch pool keep their placement. DATA_NUMA_FIRSTTOUCH only
+	maps buffers without touching them: pages end up on the node of the
+	(pinned) worker thread that writes them first.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_datapages(int pagetype, int numatype)
+  {
+
+  data_pagetype = pagetype;
+  data_numatype = numatype;
+
+  return;
+  }
+
+
+/******* auto_maxdataram ******************************************************
+PROTO	int auto_maxdataram(char *source)
+PURPOSE	Find a suitable maximum amount of RAM for storing image data.
+INPUT	Pointer to a string describing where the limit comes from (output).
+OUTPUT	Maximum amount of RAM (in MB).
+NOTES	The available memory is the smallest of the MemAvailable field of
+	/proc/meminfo and of the room left below the cgroup (v2 or v1) memory
+	limit of the process. Only a fraction DATA_AUTORAMFRAC of it is used,
+	to leave headroom for the other buffers.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	auto_maxdataram(char *source)
+  {
+   FILE		*file;
+   char		str[MAXCHARS], path[MAXCHARS], filename[MAXCHARS*2],
+		*pstr;
+   double	avail, limit, usage;
+   int		v;
+
+  avail = -1.0;
+  strcpy(source, "none");
+  if ((file = fopen("/proc/meminfo", "r")))
+    {
+    while (fgets(str, MAXCHARS, file))
+      if (!strncmp(str, "MemAvailable:", 13))
+        {
+        avail = atof(str+13)*1024.0;
+        strcpy(source, "meminfo");
+        break;
+        }
+    fclose(file);
+    }
+
+/* Find the cgroup of the process (v2 "0::/path", or v1 "n:memory:/path") */
+  for (v=2; v>0; v--)
+    {
+    *path = '\0';
+    if ((file = fopen("/proc/self/cgroup", "r")))
+      {
+      while (fgets(str, MAXCHARS, file))
+        if ((v==2 && !strncmp(str, "0::", 3))
+		|| (v==1 && strstr(str, "memory:")))
+          {
+          strcpy(path, strrchr(str, ':')+1);
+          if ((pstr = strchr(path, '\n')))
+            *pstr = '\0';
+          break;
+          }
+      fclose(file);
+      }
+/*-- The cgroup hierarchy may be mounted from the process cgroup itself */
+    for (pstr=path; pstr; pstr = *pstr? "" : NULL)
+      {
+      sprintf(filename, v==2? "/sys/fs/cgroup%s/memory.max"
+		: "/sys/fs/cgroup/memory%s/memory.limit_in_bytes", pstr);
+      if (read_datasizefile(filename, &limit) == RETURN_OK)
+        break;
+      }
+    if (!pstr)
+      continue;
+    sprintf(filename, v==2? "/sys/fs/cgroup%s/memory.current"
+		: "/sys/fs/cgroup/memory%s/memory.usage_in_bytes", pstr);
+    if (read_datasizefile(filename, &usage) != RETURN_OK)
+      usage = 0.0;
+    if (limit-usage < avail || avail<0.0)
+      {
+      avail = limit>usage? limit-usage : 0.0;
+      sprintf(source, "cgroup v%d", v);
+      }
+    break;
+    }
+
+  if (avail<0.0)
+    {
+    strcpy(source, "default");
+    return (int)(BODY_DEFRAM/MBYTE);
+    }
+  avail *= DATA_AUTORAMFRAC/MBYTE;
+
+  return avail<1.0? 1 : (avail>1e9? 1000000000 : (int)avail);
+  }
+
+
+/******* auto_maxdatavram *****************************************************
+PROTO	int auto_maxdatavram(char *dirname, char *source)
+PURPOSE	Find a suitable maximum amount of disk space for swapping image data.
+INPUT	Path name of the swap directory,
+	pointer to a string describing where the limit comes from (output).
+OUTPUT	Maximum amount of swap space (in MB).
+NOTES	Only a fraction DATA_AUTOVRAMFRAC of the free space is used.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	auto_maxdatavram(char *dirname, char *source)
+  {
+   struct statvfs	fs;
+   double		avail;
+
+  if (statvfs(dirname, &fs))
+    {
+    strcpy(source, "default");
+    return (int)(BODY_DEFVRAM/MBYTE);
+    }
+  strcpy(source, "statvfs");
+  avail = (double)fs.f_bavail*fs.f_frsize*DATA_AUTOVRAMFRAC/MBYTE;
+
+  return avail<1.0? 1 : (avail>1e9? 1000000000 : (int)avail);
+  }
+
+
+/******* get_datapeaks ********************************************************
+PROTO	void get_datapeaks(dataarenastruct *arena, size_t *peakram,
+			size_t *peakvram)
+PURPOSE	Return the largest amounts of RAM and swap space used so far for
+	storing image data.
+INPUT	Pointer to the allocator (or NULL),
+	pointer to the peak RAM usage (in bytes),
+	pointer to the peak swap space usage (in bytes).
+OUTPUT	-.
+NOTES	Both are 0 without an allocator. Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	get_datapeaks(dataarenastruct *arena, size_t *peakram,
+		size_t *peakvram)
+  {
+  *peakram = *peakvram = 0;
+  if (!arena)
+    return;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  *peakram = arena->rampeak;
+  *peakvram = arena->vrampeak;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+
+  return;
+  }
+
+
+/******* get_datause **********************************************************
+PROTO	void get_datause(dataarenastruct *arena, size_t *ram, size_t *vram)
+PURPOSE	Return the amounts of RAM and swap space currently used for storing
+	image data.
+INPUT	Pointer to the allocator (or NULL),
+	pointer to the current RAM usage (in bytes),
+	pointer to the current swap space usage (in bytes).
+OUTPUT	-.
+NOTES	Both are 0 without an allocator. Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	get_datause(dataarenastruct *arena, size_t *ram, size_t *vram)
+  {
+  *ram = *vram = 0;
+  if (!arena)
+    return;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&arena->mutex);
+#endif
+  *ram = arena->maxram - arena->ramleft + arena->cacheram;
+  *vram = arena->maxvram - arena->vramleft;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&arena->mutex);
+#endif
+
+  return;
+  }
+
+
+/******* update_datapeaks *****************************************************
+PROTO	void update_datapeaks(dataarenastruct *arena)
+PURPOSE	Keep track of the largest amounts of RAM and swap space used.
+INPUT	Pointer to the allocator.
+OUTPUT	-.
+NOTES	Must be called after every allocation, with the allocator mutex
+	locked.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	update_datapeaks(dataarenastruct *arena)
+  {
+   size_t	ram;
+
+  ram = arena->maxram - arena->ramleft + arena->cacheram;
+  if (ram > arena->rampeak)
+    arena->rampeak = ram;
+  if (arena->maxvram - arena->vramleft > arena->vrampeak)
+    arena->vrampeak = arena->maxvram - arena->vramleft;
+
+  return;
+  }
+
+
+/******* get_dataroom *********************************************************
+PROTO	size_t get_dataroom(dataarenastruct *arena)
+PURPOSE	Return the RAM left in the budget of an allocator.
+INPUT	Pointer to the allocator.
+OUTPUT	Room left (in bytes).
+NOTES	Decompressed blocks are accounted for separately, as the cache may
+	have to overdraw the budget to load pinned blocks. Must be called with
+	the allocator mutex locked.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static size_t	get_dataroom(dataarenastruct *arena)
+  {
+  return arena->ramleft > arena->cacheram? arena->ramleft - arena->cacheram
+					: 0;
+  }
+
+
+/******* read_datasizefile ****************************************************
+PROTO	int read_datasizefile(char *filename, double *size)
+PURPOSE	Read a size (in bytes) from a (pseudo-)file.
+INPUT	File name,
+	pointer to the size read.
+OUTPUT	RETURN_OK if a number could be read, RETURN_ERROR otherwise.
+NOTES	"max" (no cgroup v2 limit) is not a number.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	read_datasizefile(char *filename, double *size)
+  {
+   FILE	*file;
+   int	status;
+
+  if (!(file = fopen(filename, "r")))
+    return RETURN_ERROR;
+  status = fscanf(file, "%lf", size)==1? RETURN_OK : RETURN_ERROR;
+  fclose(file);
+
+  return status;
   }
 
 
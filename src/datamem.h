@@ -22,16 +22,137 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		13/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
+#ifndef _DATAMEM_H_
+#define _DATAMEM_H_
+
+#ifndef _FITSCAT_H_
+#include "fits/fitscat.h"
+#endif
+
+/*----------------------------- Internal constants --------------------------*/
+#define	DATA_NCACHEBLOCK	8	/* Unpinned decompressed blocks in RAM */
+#define	DATA_NCACHEMIN		4	/* Decompressed blocks beyond budget */
+#define	DATA_ZLEVEL		1	/* zlib level for compressed blocks */
+#define	DATA_SWAPNAMELEN	32	/* Room for swap file names in VMEM_DIR */
+#define	DATA_AUTORAMFRAC	0.8	/* Fraction of available RAM used */
+#define	DATA_AUTOVRAMFRAC	0.9	/* Fraction of free swap space used */
+
+/* Storage types of data stores */
+#define	DATA_FLOAT32	0		/* 32-bit floating point */
+#define	DATA_FLOAT16	1		/* 16-bit floating point, normalized */
+#define	DATA_UINT16	2		/* 16-bit integer, companded */
+#define	DATA_HALFMAX	65504.0		/* Largest half-precision value */
+#define	DATA_QSOFT	(1.0/1024.0)	/* DATA_UINT16 linear part (normalized) */
+#define	DATA_QSCALE	2490.0		/* DATA_UINT16 steps per unit asinh() */
+#define	DATA_QZERO	18987		/* DATA_UINT16 value of the zero point */
+#define	DATA_QMAX	65534		/* Largest DATA_UINT16 value */
+#define	DATA_QBAD	65535		/* DATA_UINT16 value of bad pixels */
+
+/* Page types and NUMA placement policies of pixel buffers */
+#define	DATA_PAGE_NORMAL	0	/* Default page size */
+#define	DATA_PAGE_TRANSPARENT	1	/* Transparent huge pages (madvise) */
+#define	DATA_PAGE_EXPLICIT	2	/* Explicit huge pages (hugetlbfs) */
+#define	DATA_NUMA_DEFAULT	0	/* System default placement */
+#define	DATA_NUMA_INTERLEAVE	1	/* Pages interleaved over all nodes */
+#define	DATA_NUMA_FIRSTTOUCH	2	/* Pages placed by the first writer */
+#define	DATA_HUGEPAGESIZE	(2*1024*1024)	/* Huge page size (bytes) */
+#define	DATA_MINPIXBUF		(256*1024)	/* Smaller buffers: malloc() */
+#define	DATA_MPOL_INTERLEAVE	3	/* MPOL_INTERLEAVE of <numaif.h> */
+#define	DATA_ALIGN		64	/* Pixel buffer alignment (bytes) */
+#define	DATA_NSCRATCH		16	/* Scratch buffer pool increment */
+#define	DATA_SCRATCHSLACK	2	/* Max. scratch size/request size ratio */
+
+/*----------------------------------- macros --------------------------------*/
+#define	QSCRATCH(ptr, typ, nel) \
+		{if (!(ptr = (typ *)alloc_scratch((size_t)(nel)*sizeof(typ)))) \
+		   { \
+		   sprintf(gstr, #ptr " (" #nel "=%lld elements) " \
+			"at line %d in module " __FILE__ " !", \
+			(size_t)(nel)*sizeof(typ), __LINE__); \
+		   error(EXIT_FAILURE, "Could not allocate memory for ", gstr);\
+		   }; \
+		 }
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct structdataarena	dataarenastruct;	/* Opaque allocator */
+
+typedef struct datablock
+  {
+  struct datastore *store;		/* Parent store */
+  unsigned char	*zbuf;			/* Compressed data in RAM (or NULL) */
+  size_t	zsize;			/* Compressed data size (bytes) */
+  size_t	zslot;			/* Size reserved in the spill file */
+  OFF_T		zpos;			/* Position in the spill file (or -1) */
+  float		*buf;			/* Decompressed data (or NULL) */
+  int		dirtyflag;		/* Decompressed data modified? */
+  int		pincount;		/* Number of get_datarows() users */
+  int		busyflag;		/* Being loaded or evicted? */
+  unsigned long	lastuse;		/* Last use stamp (for LRU eviction) */
+  }	datablockstruct;
+
+typedef struct scratchbuf
+  {
+  void		*buf;			/* Buffer (from alloc_pixbuf()) */
+  size_t	size;			/* Allocated size (bytes) */
+  size_t	mapsize;		/* Mapping size (bytes), 0 if on heap */
+  int		busyflag;		/* Currently handed out? */
+  }	scratchbufstruct;
+
+typedef struct datastore
+  {
+  dataarenastruct *arena;		/* Allocator of the data */
+  float		*data;			/* Contiguous data (or NULL) */
+  char		*swapname;		/* Swap or spill file name (or NULL) */
+  int		fd;			/* Spill file descriptor (or -1) */
+  OFF_T		fsize;			/* Spill file size */
+  int		datatype;		/* Storage type (DATA_*) */
+  int		compressflag;		/* Deflated blocks? */
+  float		zero, range;		/* Normalization of 16-bit storage */
+  size_t	width;			/* Row length (pixels) */
+  int		height;			/* Number of rows */
+  int		blockheight;		/* Number of rows per block */
+  datablockstruct *block;		/* Compressed row blocks (or NULL) */
+  int		nblock;			/* Number of row blocks */
+  }	datastorestruct;
+
 /*------------------------------- functions ---------------------------------*/
 
-extern void	free_data(float *pixbuf, size_t ndata, char *swapname);
+extern void	free_data(dataarenastruct *arena, float *pixbuf, size_t ndata,
+			char *swapname),
+		free_pixbuf(void *buf, size_t mapsize),
+		free_scratch(void *buf);
+
+extern int	auto_maxdataram(char *source),
+		auto_maxdatavram(char *dirname, char *source);
+
+extern void	*alloc_pixbuf(size_t size, size_t *mapsize),
+		*alloc_scratch(size_t size);
+
+extern float	*alloc_data(dataarenastruct *arena, size_t ndata,
+			char **swapname),
+		*get_datarows(datastorestruct *store, int y, int writeflag);
+
+extern dataarenastruct	*new_dataarena(int maxram, int maxvram,
+				char *swapdirname, int compressflag);
+
+extern datastorestruct	*new_datastore(dataarenastruct *arena, size_t width,
+				int height, int blockheight, int datatype,
+				float zero, float range);
 
-extern int	set_maxdataram(size_t maxram),
-		set_maxdatavram(size_t maxvram),
-		set_dataswapdir(char *dirname);
+extern void	end_dataarena(dataarenastruct *arena),
+		free_datastore(datastorestruct *store),
+		end_scratch(void),
+		get_datapeaks(dataarenastruct *arena, size_t *peakram,
+			size_t *peakvram),
+		get_datause(dataarenastruct *arena, size_t *ram, size_t *vram),
+		get_scratchpeaks(size_t *peaksize, int *peaknbuf),
+		release_datarows(datastorestruct *store, int y),
+		release_scratch(void),
+		reserve_scratch(size_t size, int nbuf),
+		set_datapages(int pagetype, int numatype);
 
-extern float	*alloc_data(size_t ndata, char **swapname);
+#endif
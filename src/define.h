@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		26/03/2015
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -51,6 +51,7 @@
 #ifndef PI
 #define PI      	3.1415926535898
 #endif
+#define	DEG		(PI/180.0)	/* 1 deg in radians */
 
 /*----------------------------- Internal constants --------------------------*/
 
@@ -65,6 +66,14 @@
 #define	NO_ENVVAR
 #endif
 
+#ifndef THREAD_LOCAL
+#ifdef USE_THREADS
+#define	THREAD_LOCAL	__thread	/* Thread-local storage class */
+#else
+#define	THREAD_LOCAL
+#endif
+#endif
+
 /*--------------------- in case of missing constants ------------------------*/
 
 #ifndef         SEEK_SET
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		13/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -34,31 +34,84 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include "define.h"
 #include "globals.h"
 #include "fits/fitscat.h"
 #include "field.h"
+#include "mosaic.h"
 #include "prefs.h"
+#include "timing.h"
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
+
+#define	FIELDSTAT_BACK	1		/* Cached background */
+#define	FIELDSTAT_MIN	2		/* Cached min. level quantile */
+#define	FIELDSTAT_MAX	4		/* Cached max. level quantile */
+
+#define	FIELDREAD_UNSIGNED	1	/* Read with FITS_UNSIGNED */
+
+/* Cached input field, kept open between conversions */
+typedef struct fieldcache
+  {
+  char		name[MAXCHAR];		/* File name (with extension) */
+  catstruct	*cat;			/* Cat structure */
+  tabstruct	*tab;			/* Selected structure */
+  char		ident[MAXCHAR];		/* Field identifier */
+  time_t	mtime;			/* File modification time */
+  off_t		fsize;			/* File size */
+  int		bitsgn;			/* Original pixel signedness */
+  int		readflags;		/* Read settings (FIELDREAD_*) */
+  int		inuse;			/* Currently attached to a field? */
+  unsigned long	lastuse;		/* Last use stamp (for recycling) */
+  int		statflags;		/* Cached statistics (FIELDSTAT_*) */
+  PIXTYPE	minfrac, maxfrac;	/* Quantiles of the cached stats */
+  PIXTYPE	back, min, max;		/* Cached statistics */
+  }	fieldcachestruct;
+
+static fieldcachestruct	*fieldcache;
+static int		nfieldcache, nfieldcachemax;
+static unsigned long	fieldcache_stamp;
+#ifdef USE_THREADS
+static pthread_mutex_t	fieldcache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static fieldcachestruct	*get_fieldcache(char *filename, char *fullname);
+
+static int		get_fieldreadflags(void);
+
+static void		release_fieldcache(fieldcachestruct *cache,
+				int dropflag);
 
 /****** load_field ***********************************************************
-PROTO   fieldstruct *load_field(char *filename)
+PROTO   fieldstruct *load_field(char *filename, void *buf, size_t bufsize)
 PURPOSE Load field infos.
-INPUT   Character string that contains the file name.
+INPUT   Character string that contains the file name,
+	pointer to the in-memory FITS content (or NULL),
+	size of the in-memory FITS content.
 OUTPUT  A pointer to the created field structure.
-NOTES   Global preferences are used. The function is not reentrant because
-	of static variables (prefs structure members are updated).
+NOTES   Preferences of the current job are used.
+	If the field cache is active (see init_fieldcache()), fields are
+	kept open and re-used as long as the file is left unchanged.
+	If buf is not NULL, the FITS data are read from buf and filename is
+	only used to name the field; such fields are never cached.
 AUTHOR  E. Bertin (IAP)
-VERSION 05/10/2010
+VERSION 19/10/2026
 */
-fieldstruct	*load_field(char *filename)
+fieldstruct	*load_field(char *filename, void *buf, size_t bufsize)
   {
    tabstruct	*tab;
    fieldstruct	*field;
-   char		*rfilename, *str, *str2;
+   char		fullname[MAXCHAR],
+		*rfilename, *str, *str2;
    int		ext;
    
-   if ((str = strrchr(filename, '[')))
+  strncpy(fullname, filename, MAXCHAR-1);
+  fullname[MAXCHAR-1] = '\0';
+  if ((str = strrchr(filename, '[')))
     {
     *str = '\0';
     if ((str2 = strrchr(str, ']')))
@@ -67,16 +120,48 @@ fieldstruct	*load_field(char *filename)
 
   QCALLOC(field, fieldstruct, 1);
 
+/* Re-use an already opened field if possible */
+  if (!buf && nfieldcachemax && (field->cache = get_fieldcache(filename, fullname))
+	&& field->cache->cat)
+    {
+    field->cat = field->cache->cat;
+    field->tab = tab = field->cache->tab;
+    tab->bitsgn = field->cache->bitsgn;
+    if (tab->bitsgn && prefs.fitsunsigned_flag)
+      tab->bitsgn = 0;
+/*-- Checksums of cached fields are verified only once */
+    if (prefs.checksum_flag && !tab->sumflag)
+      init_readsum(tab);
+    field->size[0] = tab->naxisn[0];
+    field->size[1] = tab->naxisn[1];
+    if (!(rfilename = strrchr(field->cat->filename, '/')))
+      rfilename = field->cat->filename;
+    else
+      rfilename++;
+    field->rfilename = rfilename;
+    strcpy(field->ident, field->cache->ident);
+    set_fieldregion(field, (prefs.nregion>4 || prefs.pyrupdate_flag)?
+	REGION_NONE : prefs.region_type, prefs.region);
+    return field;
+    }
+
 /* A short, "relative" version of the filename */
   if (!(rfilename = strrchr(filename, '/')))
     rfilename = filename;
   else
     rfilename++;
-  sprintf(gstr,"Examining File %s", rfilename);
+  snprintf(gstr, MAXCHAR, "Examining File %s", rfilename);
   NFPRINTF(OUTPUT, gstr);
 
-  if (! (field->cat = read_cat(filename)))
+  if (!(field->cat = buf? read_memcat(filename, buf, bufsize)
+			: read_cat(filename)))
+    {
+    if (field->cache)
+      release_fieldcache(field->cache, 1);
+    free(field);
     error(EXIT_FAILURE, "*Error*: no FITS data in ", filename);
+    return NULL;
+    }
   if (str)
     {
     if (!(tab = name_to_tab(field->cat, str+1, 0)))
@@ -97,6 +182,10 @@ fieldstruct	*load_field(char *filename)
   if (tab->bitsgn && prefs.fitsunsigned_flag)
     tab->bitsgn = 0;
 
+/*-- Verify checksums while the data are read */
+  if (prefs.checksum_flag)
+    init_readsum(tab);
+
 /*-- Get image dimensions */
   field->size[0] = tab->naxisn[0];
   field->size[1] = tab->naxisn[1];
@@ -114,6 +203,28 @@ fieldstruct	*load_field(char *filename)
 	H_STRING,T_STRING)!= RETURN_OK)
     strcpy(field->ident, "no ident");
 
+/* Keep uncompressed fields open for subsequent conversions */
+  if (field->cache)
+    {
+    if (tab->compress_type == COMPRESS_NONE)
+      {
+      field->cache->cat = field->cat;
+      field->cache->tab = tab;
+      field->cache->bitsgn = tab->bitsgn;
+      strcpy(field->cache->ident, field->ident);
+      }
+    else
+      {
+      release_fieldcache(field->cache, 1);
+      field->cache = NULL;
+      }
+    }
+
+/* Cutout (multiple cutouts and pyramid updates are set up at conversion */
+/* time) */
+  set_fieldregion(field, (prefs.nregion>4 || prefs.pyrupdate_flag)?
+	REGION_NONE : prefs.region_type, prefs.region);
+
   return field;
   }
 
@@ -123,13 +234,18 @@ PROTO   void end_field(fieldstruct *field)
 PURPOSE Terminate a field structure.
 INPUT   Pointer to the field.
 OUTPUT	-.
-NOTES   -.
+NOTES   Cached fields are left open.
 AUTHOR  E. Bertin (IAP)
-VERSION 25/01/2003
+VERSION 19/10/2026
 */
 void	end_field(fieldstruct *field)
   {
-  free_cat(&field->cat, 1);
+  if (field->mosaic)
+    end_mosaic(field->mosaic);
+  else if (field->cache)
+    release_fieldcache(field->cache, 0);
+  else
+    free_cat(&field->cat, 1);
   free(field);
 
   return;
@@ -143,7 +259,7 @@ INPUT	Pointer to the field.
 OUTPUT	-.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	04/01/2010
+VERSION	19/10/2026
  ***/
 void	print_fieldinfo(fieldstruct *field)
 
@@ -176,6 +292,565 @@ void	print_fieldinfo(fieldstruct *field)
         tab->bitpix>0? (tab->compress_type!=COMPRESS_NONE ?
                         "compressed":"integers") : "floats",
 	field->back, field->min, field->max);
+  if (field->mosaic)
+    QPRINTF(OUTPUT, "Mosaic: %d tile%s  %dx%d\n",
+	field->mosaic->ntile, field->mosaic->ntile>1? "s":"",
+	field->size[0], field->size[1]);
+  if (is_fieldregion(field))
+    QPRINTF(OUTPUT, "Region: [%d:%d,%d:%d]  %dx%d\n",
+	field->origin[0]+1, field->origin[0]+field->size[0],
+	field->origin[1]+1, field->origin[1]+field->size[1],
+	field->size[0], field->size[1]);
+
+  return;
+  }
+
+
+/****** set_fieldregion *******************************************************
+PROTO	void set_fieldregion(fieldstruct *field, int regiontype,
+			double *corner)
+PURPOSE	Set the origin and size of the image region to be converted.
+INPUT	Pointer to the field,
+	region type (REGION_NONE, REGION_PIXEL or REGION_WORLD),
+	pointer to the 4 region corner coordinates.
+OUTPUT	-.
+NOTES	Region corners are either FITS pixel coordinates or celestial
+	coordinates (in deg.); in the latter case the region is the bounding
+	box of the 4 corners projected on the image pixel grid. The region is
+	clipped to the image limits.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_fieldregion(fieldstruct *field, int regiontype, double *corner)
+  {
+   tabstruct	*tab;
+   double	wcspos[2], pixpos[2],
+		xmin,ymin, xmax,ymax;
+   int		c, xmini,ymini, xmaxi,ymaxi;
+
+  tab = field->tab;
+  field->origin[0] = field->origin[1] = 0;
+  field->size[0] = tab->naxisn[0];
+  field->size[1] = tab->naxisn[1];
+  if (regiontype == REGION_NONE)
+    return;
+
+  if (regiontype == REGION_WORLD)
+    {
+    xmin = ymin = BIG;
+    xmax = ymax = -BIG;
+    pixpos[0] = pixpos[1] = 0.0;	/* to avoid gcc -Wall warnings */
+    for (c=0; c<4; c++)
+      {
+      wcspos[0] = corner[(c&1)? 2:0];
+      wcspos[1] = corner[(c&2)? 3:1];
+      if (wcs_to_fieldpix(field, wcspos, pixpos) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: cannot project REGION corners on ",
+		field->rfilename);
+      if (pixpos[0]<xmin)
+        xmin = pixpos[0];
+      if (pixpos[0]>xmax)
+        xmax = pixpos[0];
+      if (pixpos[1]<ymin)
+        ymin = pixpos[1];
+      if (pixpos[1]>ymax)
+        ymax = pixpos[1];
+      }
+    }
+  else
+    {
+    xmin = corner[0]<corner[2]? corner[0] : corner[2];
+    xmax = corner[0]<corner[2]? corner[2] : corner[0];
+    ymin = corner[1]<corner[3]? corner[1] : corner[3];
+    ymax = corner[1]<corner[3]? corner[3] : corner[1];
+    }
+
+/* FITS pixel i covers [i-0.5,i+0.5[; convert to 0-based indices */
+  xmini = (int)floor(xmin + 0.5) - 1;
+  ymini = (int)floor(ymin + 0.5) - 1;
+  xmaxi = (int)floor(xmax + 0.5) - 1;
+  ymaxi = (int)floor(ymax + 0.5) - 1;
+  if (xmini<0)
+    xmini = 0;
+  if (ymini<0)
+    ymini = 0;
+  if (xmaxi>=tab->naxisn[0])
+    xmaxi = tab->naxisn[0]-1;
+  if (ymaxi>=tab->naxisn[1])
+    ymaxi = tab->naxisn[1]-1;
+  if (xmaxi<xmini || ymaxi<ymini)
+    error(EXIT_FAILURE, "*Error*: REGION does not overlap ", field->rfilename);
+
+  if (tab->compress_type != COMPRESS_NONE
+	&& (xmaxi-xmini+1<tab->naxisn[0] || ymaxi-ymini+1<tab->naxisn[1]))
+    error(EXIT_FAILURE, "*Error*: REGION not supported for compressed image ",
+		field->rfilename);
+
+  field->origin[0] = xmini;
+  field->origin[1] = ymini;
+  field->size[0] = xmaxi - xmini + 1;
+  field->size[1] = ymaxi - ymini + 1;
+
+  return;
+  }
+
+
+/****** wcs_to_fieldpix *******************************************************
+PROTO	int wcs_to_fieldpix(fieldstruct *field, double *wcspos,
+			double *pixpos)
+PURPOSE	Convert celestial coordinates to FITS pixel coordinates.
+INPUT	Pointer to the field,
+	pointer to the input longitude and latitude (in deg.),
+	pointer to the output pixel coordinates.
+OUTPUT	RETURN_OK if the position could be projected, RETURN_ERROR otherwise.
+NOTES	Only the gnomonic (TAN, and TPV without its distortion terms) and
+	linear (no projection) mappings are supported, with either a CD or a
+	CDELT(+PC) matrix. Axis 1 must be the longitude axis.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	wcs_to_fieldpix(fieldstruct *field, double *wcspos,
+			double *pixpos)
+  {
+   char		*head, ctype[80];
+   double	crval[2], crpix[2], cd[4], cdelt[2],
+		da, sd,cd0, sd0,cdd, cosc, x,y, det;
+   int		i, j, projflag;
+
+  if (!(head = field->tab->headbuf))
+    return RETURN_ERROR;
+  if (fitsread(head, "CTYPE1  ", ctype, H_STRING, T_STRING) != RETURN_OK)
+    return RETURN_ERROR;
+  if (strlen(ctype)>=8 && (!strncmp(ctype+4, "-TAN", 4)
+	|| !strncmp(ctype+4, "-TPV", 4)))
+    projflag = 1;
+  else if (strlen(ctype)<=4 || !strncmp(ctype+4, "----", 4)
+	|| !strncmp(ctype+4, "    ", 4))
+    projflag = 0;
+  else
+    {
+    warning("Unsupported projection for REGION in ", field->rfilename);
+    return RETURN_ERROR;
+    }
+
+  for (i=0; i<2; i++)
+    {
+    sprintf(ctype, "CRVAL%1d  ", i+1);
+    if (fitsread(head, ctype, &crval[i], H_EXPO, T_DOUBLE) != RETURN_OK)
+      return RETURN_ERROR;
+    sprintf(ctype, "CRPIX%1d  ", i+1);
+    if (fitsread(head, ctype, &crpix[i], H_EXPO, T_DOUBLE) != RETURN_OK)
+      return RETURN_ERROR;
+    }
+
+/* Linear transformation matrix: CD, or PC scaled by CDELT */
+  if (fitsread(head, "CD1_1   ", &cd[0], H_EXPO, T_DOUBLE) == RETURN_OK)
+    {
+    for (i=1; i<4; i++)
+      {
+      sprintf(ctype, "CD%1d_%1d   ", i/2+1, i%2+1);
+      if (fitsread(head, ctype, &cd[i], H_EXPO, T_DOUBLE) != RETURN_OK)
+        cd[i] = 0.0;
+      }
+    }
+  else
+    {
+    for (i=0; i<2; i++)
+      {
+      sprintf(ctype, "CDELT%1d  ", i+1);
+      if (fitsread(head, ctype, &cdelt[i], H_EXPO, T_DOUBLE) != RETURN_OK)
+        return RETURN_ERROR;
+      }
+    for (i=0; i<4; i++)
+      {
+      j = i/2;
+      sprintf(ctype, "PC%1d_%1d   ", j+1, i%2+1);
+      if (fitsread(head, ctype, &cd[i], H_EXPO, T_DOUBLE) != RETURN_OK)
+        cd[i] = (i%2==j)? 1.0 : 0.0;
+      cd[i] *= cdelt[j];
+      }
+    }
+
+/* Intermediate world coordinates (in deg.) */
+  if (projflag)
+    {
+    da = (wcspos[0] - crval[0])*DEG;
+    sd = sin(wcspos[1]*DEG);
+    cdd = cos(wcspos[1]*DEG);
+    sd0 = sin(crval[1]*DEG);
+    cd0 = cos(crval[1]*DEG);
+    if ((cosc = sd0*sd + cd0*cdd*cos(da)) <= 0.0)
+      return RETURN_ERROR;		/* Beyond the projection horizon */
+    x = cdd*sin(da)/cosc/DEG;
+    y = (cd0*sd - sd0*cdd*cos(da))/cosc/DEG;
+    }
+  else
+    {
+    x = wcspos[0] - crval[0];
+    y = wcspos[1] - crval[1];
+    }
+
+  if (fabs(det = cd[0]*cd[3] - cd[1]*cd[2]) < 1e-30)
+    return RETURN_ERROR;
+  pixpos[0] = crpix[0] + ( cd[3]*x - cd[1]*y)/det;
+  pixpos[1] = crpix[1] + (-cd[2]*x + cd[0]*y)/det;
+
+  return RETURN_OK;
+  }
+
+
+/****** is_fieldregion ********************************************************
+PROTO	int is_fieldregion(fieldstruct *field)
+PURPOSE	Tell whether only a region of the field image is converted.
+INPUT	Pointer to the field.
+OUTPUT	1 if the region is smaller than the image, 0 otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	is_fieldregion(fieldstruct *field)
+  {
+  return field->size[0] < field->tab->naxisn[0]
+	|| field->size[1] < field->tab->naxisn[1];
+  }
+
+
+/****** seek_fieldrow *********************************************************
+PROTO	void seek_fieldrow(fieldstruct *field, int y)
+PURPOSE	Position the field file pointer at the beginning of a region row.
+INPUT	Pointer to the field,
+	row index in the region (starting from 0).
+OUTPUT	-.
+NOTES	Region rows are field->size[0] pixels long; reading past the end of a
+	row requires another call if the region is narrower than the image.
+	For mosaics, only the index of the next row to be read is set.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	seek_fieldrow(fieldstruct *field, int y)
+  {
+   tabstruct	*tab;
+
+  if (field->mosaic)
+    {
+    field->mosaic->y = y;
+    return;
+    }
+  tab = field->tab;
+  QFSEEK(field->cat->file, tab->bodypos
+	+ ((size_t)tab->naxisn[0]*(field->origin[1]+y) + field->origin[0])
+	  * tab->bytepix, SEEK_SET, field->cat->filename);
+
+  return;
+  }
+
+
+/****** read_fieldrow *********************************************************
+PROTO	void read_fieldrow(fieldstruct *field, PIXTYPE *buf)
+PURPOSE	Read the current row of the field region and move to the next one.
+INPUT	Pointer to the field,
+	pointer to the output buffer (field->size[0] pixels).
+OUTPUT	-.
+NOTES	Rows of mosaics are assembled from the overlapping input tiles.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	read_fieldrow(fieldstruct *field, PIXTYPE *buf)
+  {
+  start_timing(TIMING_READ);
+  if (field->mosaic)
+    read_mosaicrow(field->mosaic, buf);
+  else
+    read_body(field->tab, buf, (size_t)field->size[0]);
+  stop_timing(TIMING_READ, (double)field->size[0],
+	(double)field->size[0]*field->tab->bytepix);
+
+  return;
+  }
+
+
+/****** init_fieldcache *******************************************************
+PROTO	void init_fieldcache(int nmax)
+PURPOSE	Activate the cache of opened input fields and image statistics.
+INPUT	Maximum number of cached fields.
+OUTPUT	-.
+NOTES	Meant for long-running processes that convert the same inputs over
+	and over. Only uncompressed images are cached.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	init_fieldcache(int nmax)
+  {
+  end_fieldcache();
+  if (nmax<1)
+    return;
+  QCALLOC(fieldcache, fieldcachestruct, nmax);
+  nfieldcachemax = nmax;
+  nfieldcache = 0;
+  fieldcache_stamp = 0;
+
+  return;
+  }
+
+
+/****** end_fieldcache ********************************************************
+PROTO	void end_fieldcache(void)
+PURPOSE	Close all cached fields and deactivate the field cache.
+INPUT	-.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_fieldcache(void)
+  {
+   int	c;
+
+  for (c=0; c<nfieldcache; c++)
+    if (fieldcache[c].cat)
+      free_cat(&fieldcache[c].cat, 1);
+  free(fieldcache);
+  fieldcache = NULL;
+  nfieldcache = nfieldcachemax = 0;
+
+  return;
+  }
+
+
+/****** get_fieldcache ********************************************************
+PROTO	fieldcachestruct *get_fieldcache(char *filename, char *fullname)
+PURPOSE	Find or allocate the field cache entry of an input image.
+INPUT	File name (without extension),
+	file name including the extension specification.
+OUTPUT	Pointer to the cache entry (with a NULL cat member if the field
+	must be loaded), or NULL if the cache cannot be used.
+NOTES	Entries are flagged as in use; entries of modified files are
+	refreshed, and the least recently used entry is recycled when the
+	cache is full. Entries are keyed by file name and by all the
+	settings that affect how pixels are read (see get_fieldreadflags()).
+	Thread-safe: an entry is used by only one field at a time.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static fieldcachestruct	*get_fieldcache(char *filename, char *fullname)
+  {
+   struct stat		st;
+   fieldcachestruct	*cache, *cachet;
+   int			c, readflags;
+
+  if (stat(filename, &st))
+    return NULL;
+  readflags = get_fieldreadflags();
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&fieldcache_mutex);
+#endif
+  fieldcache_stamp++;
+  cache = NULL;
+  for (c=0; c<nfieldcache; c++)
+    {
+    cachet = fieldcache + c;
+    if (!cachet->inuse && cachet->readflags==readflags
+	&& !strcmp(cachet->name, fullname))
+      {
+      if (cachet->cat && cachet->mtime==st.st_mtime
+		&& cachet->fsize==st.st_size)
+        {
+        cachet->inuse = 1;
+        cachet->lastuse = fieldcache_stamp;
+#ifdef USE_THREADS
+        QPTHREAD_MUTEX_UNLOCK(&fieldcache_mutex);
+#endif
+        return cachet;
+        }
+/*---- The file has changed: refresh the entry */
+      cache = cachet;
+      break;
+      }
+    }
+
+  if (!cache)
+    {
+    if (nfieldcache<nfieldcachemax)
+      cache = fieldcache + nfieldcache++;
+    else
+      {
+/*---- Recycle the least recently used entry */
+      for (c=0; c<nfieldcache; c++)
+        {
+        cachet = fieldcache + c;
+        if (!cachet->inuse && (!cache || cachet->lastuse<cache->lastuse))
+          cache = cachet;
+        }
+      }
+    }
+
+  if (cache)
+    {
+    if (cache->cat)
+      free_cat(&cache->cat, 1);
+    memset(cache, 0, sizeof(fieldcachestruct));
+    strcpy(cache->name, fullname);
+    cache->mtime = st.st_mtime;
+    cache->fsize = st.st_size;
+    cache->readflags = readflags;
+    cache->inuse = 1;
+    cache->lastuse = fieldcache_stamp;
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&fieldcache_mutex);
+#endif
+
+  return cache;
+  }
+
+
+/****** release_fieldcache ****************************************************
+PROTO	void release_fieldcache(fieldcachestruct *cache, int dropflag)
+PURPOSE	Release a field cache entry after use.
+INPUT	Pointer to the cache entry,
+	flag set if the entry must not be re-used.
+OUTPUT	-.
+NOTES	Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	release_fieldcache(fieldcachestruct *cache, int dropflag)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&fieldcache_mutex);
+#endif
+  cache->inuse = 0;
+  if (dropflag)
+    cache->name[0] = '\0';
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&fieldcache_mutex);
+#endif
+
+  return;
+  }
+
+
+/****** get_fieldreadflags ****************************************************
+PROTO	int get_fieldreadflags(void)
+PURPOSE	Encode the current settings that affect how pixels are read.
+INPUT	-.
+OUTPUT	Combination of FIELDREAD_* flags.
+NOTES	Any new setting affecting the pixel values read from the input
+	files (and hence the cached statistics) must be added here.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	get_fieldreadflags(void)
+  {
+  return prefs.fitsunsigned_flag? FIELDREAD_UNSIGNED : 0;
+  }
+
+
+/****** load_fieldstats *******************************************************
+PROTO	int load_fieldstats(fieldstruct *field, int backflag, int minflag,
+			int maxflag)
+PURPOSE	Retrieve image statistics from the field cache.
+INPUT	Pointer to the field,
+	flag to request the median background,
+	flag to request the min. level quantile,
+	flag to request the max. level quantile.
+OUTPUT	RETURN_OK if all requested statistics were found in the cache,
+	RETURN_ERROR otherwise.
+NOTES	On input, field->min and field->max contain the requested quantiles,
+	as in make_imastats().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	load_fieldstats(fieldstruct *field, int backflag, int minflag,
+			int maxflag)
+  {
+   fieldcachestruct	*cache;
+   int			flags;
+
+  if (!(cache = field->cache))
+    return RETURN_ERROR;
+  flags = (backflag? FIELDSTAT_BACK:0) | (minflag? FIELDSTAT_MIN:0)
+	| (maxflag? FIELDSTAT_MAX:0);
+  if ((cache->statflags&flags) != flags
+	|| (minflag && cache->minfrac != field->min)
+	|| (maxflag && cache->maxfrac != field->max))
+    return RETURN_ERROR;
+
+  if (backflag)
+    field->back = cache->back;
+  if (minflag)
+    field->min = cache->min;
+  if (maxflag)
+    field->max = cache->max;
+
+  return RETURN_OK;
+  }
+
+
+/****** save_fieldstats *******************************************************
+PROTO	void save_fieldstats(fieldstruct *field, int backflag, int minflag,
+			int maxflag, PIXTYPE minfrac, PIXTYPE maxfrac)
+PURPOSE	Store image statistics in the field cache.
+INPUT	Pointer to the field,
+	flag set if the median background has been computed,
+	flag set if the min. level quantile has been computed,
+	flag set if the max. level quantile has been computed,
+	min. level quantile,
+	max. level quantile.
+OUTPUT	-.
+NOTES	Does nothing if the field is not cached.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	save_fieldstats(fieldstruct *field, int backflag, int minflag,
+			int maxflag, PIXTYPE minfrac, PIXTYPE maxfrac)
+  {
+   fieldcachestruct	*cache;
+
+  if (!(cache = field->cache))
+    return;
+  cache->statflags = (backflag? FIELDSTAT_BACK:0)
+		| (minflag? FIELDSTAT_MIN:0) | (maxflag? FIELDSTAT_MAX:0);
+  cache->minfrac = minfrac;
+  cache->maxfrac = maxfrac;
+  cache->back = field->back;
+  cache->min = field->min;
+  cache->max = field->max;
+
+  return;
+  }
+
+
+/****** verify_fieldsum *******************************************************
+PROTO	void verify_fieldsum(fieldstruct *field)
+PURPOSE	Verify the FITS checksums of the field data.
+INPUT	Pointer to the field.
+OUTPUT	-.
+NOTES	Checksums are computed while the data are read (see init_readsum());
+	only data that have not been read sequentially are read again. A
+	mosaic is flagged as bad if any of its tiles is.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	verify_fieldsum(fieldstruct *field)
+  {
+   tabstruct	*tab;
+   int		t, ntab, status;
+
+  field->checksum_status = CHECKSUM_NONE;
+  ntab = field->mosaic? field->mosaic->ntile : 1;
+  for (t=0; t<ntab; t++)
+    {
+    tab = field->mosaic? field->mosaic->tile[t].tab : field->tab;
+    if ((status = verify_readsum(tab)) == RETURN_ERROR)
+      {
+      warning("checksum mismatch (corrupted data?) in ",
+		tab->cat? tab->cat->filename : field->rfilename);
+      field->checksum_status = CHECKSUM_BAD;
+      }
+    else if (status == RETURN_OK && field->checksum_status == CHECKSUM_NONE)
+      field->checksum_status = CHECKSUM_OK;
+    }
 
   return;
   }
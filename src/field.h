@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -39,6 +39,8 @@
 
 
 /*----------------------------- Internal constants --------------------------*/
+#define	FIELDCACHE_NMAX	64		/* Default max. number of cached fields */
+
 /*--------------------------------- typedefs --------------------------------*/
 
 typedef struct field
@@ -51,16 +53,37 @@ typedef struct field
   char		channeltag[MAXCHAR];	/* Channel tag */
   catstruct	*cat;			/* Cat structure */
   tabstruct	*tab;			/* Selected structure */
-  int		size[2];		/* Image size */
+  int		size[2];		/* Image (or cutout region) size */
+  int		origin[2];		/* Region origin in the image */
   PIXTYPE	back;			/* Median */
   PIXTYPE	min;			/* Low cut */
   PIXTYPE	max;			/* High cut */
+  struct fieldcache *cache;		/* Cache entry (or NULL) */
+  struct mosaic	*mosaic;		/* Input mosaic (or NULL) */
+  enum {CHECKSUM_UNCHECKED, CHECKSUM_NONE, CHECKSUM_OK, CHECKSUM_BAD}
+		checksum_status;	/* FITS checksum verification */
   }	fieldstruct;
 
 /*------------------------------- functions ---------------------------------*/
 
-extern fieldstruct	*load_field(char *filename);
+extern fieldstruct	*load_field(char *filename, void *buf, size_t bufsize);
+
+extern int		is_fieldregion(fieldstruct *field),
+			load_fieldstats(fieldstruct *field, int backflag,
+				int minflag, int maxflag),
+			wcs_to_fieldpix(fieldstruct *field, double *wcspos,
+				double *pixpos);
 
 extern void		end_field(fieldstruct *field),
-			print_fieldinfo(fieldstruct *field);
+			end_fieldcache(void),
+			init_fieldcache(int nmax),
+			print_fieldinfo(fieldstruct *field),
+			read_fieldrow(fieldstruct *field, PIXTYPE *buf),
+			seek_fieldrow(fieldstruct *field, int y),
+			set_fieldregion(fieldstruct *field, int regiontype,
+				double *corner),
+			verify_fieldsum(fieldstruct *field),
+			save_fieldstats(fieldstruct *field, int backflag,
+				int minflag, int maxflag,
+				PIXTYPE minfrac, PIXTYPE maxfrac);
 #endif
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		28/03/2013
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -51,6 +51,11 @@ int	body_vmnumber;
 
 char	body_swapdirname[MAXCHARS] = BODY_DEFSWAPDIR;
 
+PROBE_REGION(probe_readio, "read_body:read");
+PROBE_REGION(probe_readconv, "read_body:convert");
+PROBE_REGION(probe_writeconv, "write_body:convert");
+PROBE_REGION(probe_writeio, "write_body:write");
+
 /******* alloc_body ***********************************************************
 PROTO	PIXTYPE *alloc_body(tabstruct *tab,
 		void (*func)(PIXTYPE *ptr, int npix))
@@ -302,14 +307,14 @@ INPUT	A pointer to the tab structure,
 	a pointer to the array in memory,
 	the number of elements to be read.
 OUTPUT	-.
-NOTES	.
+NOTES	Raw data are checksummed on the fly if init_readsum() was called.
 AUTHOR	E. Bertin (IAP)
-VERSION	28/03/2013
+VERSION	19/10/2026
  ***/
 void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
   {
   catstruct		*cat;
-  static double		bufdata0[DATA_BUFSIZE/sizeof(double)];
+  double		*bufdata0;
   unsigned char		cuval, cublank;
   char			*bufdata,
 			cval, cblank;
@@ -323,6 +328,7 @@ void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
   int			curval, dval, blankflag, ival, iblank;
   
   size_t	i, bowl, spoonful, npix;
+  OFF_T		sumpos;
   PIXTYPE	bs,bz;
 
 /* a NULL cat structure indicates that no data can be read */
@@ -332,6 +338,7 @@ void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
   bs = (PIXTYPE)tab->bscale;
   bz = (PIXTYPE)tab->bzero;
   blankflag = tab->blankflag;
+  sumpos = 0;
 
   switch(tab->compress_type)
     {
@@ -339,12 +346,30 @@ void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
     case COMPRESS_NONE:
       bowl = DATA_BUFSIZE/tab->bytepix;
       spoonful = size<bowl?size:bowl;
+/*---- The conversion buffer is private to each call, for concurrent jobs */
+      QMALLOC(bufdata0, double, spoonful*tab->bytepix/sizeof(double)+1);
       for(; size>0; size -= spoonful)
         {
         if (spoonful>size)
           spoonful = size;
         bufdata = (char *)bufdata0;
+        PROBE_START(probe_readio, clockio);
+        if (tab->sumflag)
+          QFTELL(cat->file, sumpos, cat->filename);
         QFREAD(bufdata, spoonful*tab->bytepix, cat->file, cat->filename);
+/*------ Checksum the raw data on the fly */
+        if (tab->sumflag)
+          update_readsum(tab, bufdata, spoonful*tab->bytepix,
+		sumpos - tab->bodypos);
+        PROBE_STOP(probe_readio, clockio, spoonful);
+        PROBE_START(probe_readconv, clockconv);
+/*------ Vectorized conversion, if available for this BITPIX */
+        if (convert_simdbody(tab, bufdata, ptr, spoonful) == RETURN_OK)
+          {
+          ptr += spoonful;
+          PROBE_STOP(probe_readconv, clockconv, spoonful);
+          continue;
+          }
         switch(tab->bitpix)
           {
           case BP_BYTE:
@@ -519,7 +544,9 @@ void	read_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
                                 "read_body()");
             break;
           }
+        PROBE_STOP(probe_readconv, clockconv, spoonful);
         }
+      free(bufdata0);
       break;
 
 /*-- Compressed image */
@@ -630,12 +657,12 @@ INPUT	A pointer to the tab structure,
 OUTPUT	-.
 NOTES	.
 AUTHOR	E. Bertin (IAP)
-VERSION	28/03/2013
+VERSION	19/10/2026
  ***/
 void	read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
   {
    catstruct	*cat;
-   static int	bufdata0[DATA_BUFSIZE/sizeof(int)];
+   int		*bufdata0;
    char		*bufdata;
    short	val16;
    int		i, bowl, spoonful, npix, curval, dval;
@@ -650,6 +677,7 @@ void	read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
     case COMPRESS_NONE:
       bowl = DATA_BUFSIZE/tab->bytepix;
       spoonful = size<bowl?size:bowl;
+      QMALLOC(bufdata0, int, spoonful*tab->bytepix/sizeof(int)+1);
       for(; size>0; size -= spoonful)
         {
         if (spoonful>size)
@@ -700,6 +728,7 @@ void	read_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
             break;
           }
         }
+      free(bufdata0);
       break;
 
 /*-- Compressed image */
@@ -810,11 +839,11 @@ INPUT	A pointer to the tab structure,
 OUTPUT	-.
 NOTES	.
 AUTHOR	E. Bertin (IAP)
-VERSION	28/03/2013
+VERSION	19/10/2026
  ***/
 void	write_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
   {
-  static double	bufdata0[DATA_BUFSIZE/sizeof(double)];
+  double	*bufdata0;
   catstruct	*cat;
   char		*cbufdata0;
   size_t	i, bowl, spoonful;
@@ -827,18 +856,19 @@ void	write_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
     error(EXIT_FAILURE, "*Internal Error*: no parent cat structure for table ",
 		tab->extname);
 
-  cbufdata0 = (char *)bufdata0;	/* A trick to remove gcc aliasing warnings */
- 
   switch(tab->compress_type)
     {
 /*-- Uncompressed image */
     case COMPRESS_NONE:
       bowl = DATA_BUFSIZE/tab->bytepix;
       spoonful = size<bowl?size:bowl;
+      QMALLOC(bufdata0, double, spoonful*tab->bytepix/sizeof(double)+1);
+      cbufdata0 = (char *)bufdata0;	/* A trick to remove gcc aliasing warnings */
       for(; size>0; size -= spoonful)
         {
         if (spoonful>size)
           spoonful = size;
+        PROBE_START(probe_writeconv, clockconv);
         switch(tab->bitpix)
           {
           case BP_BYTE:
@@ -943,8 +973,12 @@ void	write_body(tabstruct *tab, PIXTYPE *ptr, size_t size)
                                 "read_body()");
             break;
           }
+        PROBE_STOP(probe_writeconv, clockconv, spoonful);
+        PROBE_START(probe_writeio, clockio);
         QFWRITE(cbufdata0, spoonful*tab->bytepix, cat->file, cat->filename);
+        PROBE_STOP(probe_writeio, clockio, spoonful);
         }
+      free(bufdata0);
       break;
 
 /*-- Compressed image */
@@ -972,11 +1006,11 @@ INPUT	A pointer to the tab structure,
 OUTPUT	-.
 NOTES	.
 AUTHOR	E. Bertin (IAP)
-VERSION	28/03/2013
+VERSION	19/10/2026
  ***/
 void	write_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
   {
-   static FLAGTYPE	bufdata0[DATA_BUFSIZE/sizeof(FLAGTYPE)];
+   FLAGTYPE		*bufdata0;
    catstruct		*cat;
    char			*cbufdata0;
    size_t		i, bowl, spoonful;
@@ -989,14 +1023,14 @@ void	write_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
     error(EXIT_FAILURE, "*Internal Error*: no parent cat structure for table ",
 		tab->extname);
 
-  cbufdata0 = (char *)bufdata0;	/* A trick to remove gcc aliasing warnings */
- 
   switch(tab->compress_type)
     {
 /*-- Uncompressed image */
     case COMPRESS_NONE:
       bowl = DATA_BUFSIZE/tab->bytepix;
       spoonful = size<bowl?size:bowl;
+      QMALLOC(bufdata0, FLAGTYPE, spoonful*tab->bytepix/sizeof(FLAGTYPE)+1);
+      cbufdata0 = (char *)bufdata0;	/* A trick to remove gcc aliasing warnings */
       for(; size>0; size -= spoonful)
         {
         if (spoonful>size)
@@ -1107,6 +1141,7 @@ void	write_ibody(tabstruct *tab, FLAGTYPE *ptr, size_t size)
           }
         QFWRITE(cbufdata0, spoonful*tab->bytepix, cat->file, cat->filename);
         }
+      free(bufdata0);
       break;
 
 /*-- Compressed image */
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		29/08/2012
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -392,8 +392,9 @@ INPUT	catalog structure,
 	access type (can be WRITE_ONLY or READ_ONLY).
 OUTPUT	RETURN_OK if the cat is found, RETURN_ERROR otherwise.
 NOTES	If the file was already opened by this catalog, nothing is done.
+	In-memory catalogs (see read_memcat()) are opened as memory streams.
 AUTHOR	E. Bertin (IAP & Leiden observatory)
-VERSION	29/08/2012
+VERSION	19/10/2026
  ***/
 int	open_cat(catstruct *cat, access_type_t at)
 
@@ -405,7 +406,14 @@ int	open_cat(catstruct *cat, access_type_t at)
 
   if (!cat->file)
     {
-    if ((cat->file = fopen(cat->filename, at==WRITE_ONLY?"wb":"rb")) == NULL)
+    if (cat->membuf)
+      {
+      if (at == WRITE_ONLY
+	|| !(cat->file = fmemopen(cat->membuf, cat->memsize, "rb")))
+        return RETURN_ERROR;
+      }
+    else if ((cat->file = fopen(cat->filename, at==WRITE_ONLY?"wb":"rb"))
+		== NULL)
       return RETURN_ERROR;
     cat->access_type = at;
     }
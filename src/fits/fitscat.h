@@ -23,13 +23,14 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		29/08/2012
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
 #ifndef _FITSCAT_H_
 #define _FITSCAT_H_
 
+#include <setjmp.h>
 #include <stdio.h>
 
 #ifdef HAVE_SYS_TYPES_H
@@ -150,6 +151,8 @@ typedef struct structcat
   struct structtab *tab;		/* pointer to the first table */
   int		ntab;			/* number of tables included */
   access_type_t	access_type;		/* READ_ONLY or WRITE_ONLY */
+  void		*membuf;		/* in-memory content (or NULL) */
+  size_t	memsize;		/* size of the in-memory content */
   }		catstruct;
 
 /*-------------------------------- table  ----------------------------------*/
@@ -191,13 +194,63 @@ typedef struct structtab
   int		swapflag;		/* mapped to a swap file ? */
   char		swapname[MAXCHARS];	/* name of the swapfile */
   unsigned int	bodysum;		/* Checksum of the FITS body */
+  int		sumflag;		/* Checksum body while reading? */
+  KINGSIZE_T	sumstart, sumend;	/* Body interval checksummed so far */
+  unsigned int	readsum;		/* Checksum of the body read so far */
   }		tabstruct;
 
+/*------------------------------ vector code -------------------------------*/
+
+#define	SIMD_NONE	0	/* scalar code only */
+#define	SIMD_SSSE3	1	/* 128-bit vectors with byte shuffles */
+#define	SIMD_AVX2	2	/* 256-bit vectors */
+#define	SIMD_AVX512	3	/* 512-bit vectors with mask registers */
+
+/*------------------------------- probes -----------------------------------*/
+
+#define	PROBE_NBIN	48	/* number of log2 bins in duration histograms */
+#define	PROBE_NMAX	64	/* max. number of probed code regions */
+#define	PROBE_SAMPLE	16	/* cache misses are counted every N calls */
+
+typedef struct structprobeclock
+  {
+  unsigned long long	t0;		/* start time (cycles or ns) */
+  unsigned long long	m0;		/* start cache-miss count */
+  int			sampleflag;	/* cache misses counted? */
+  }		probeclockstruct;
+
+typedef struct structprobe
+  {
+  const char		*name;		/* name of the code region */
+  int			regflag;	/* registered? */
+  unsigned long long	ncall;		/* number of calls */
+  unsigned long long	nitem;		/* number of items processed */
+  unsigned long long	ticks;		/* total duration (cycles or ns) */
+  unsigned long long	nsample;	/* number of calls with miss counts */
+  unsigned long long	misses;		/* cache misses in sampled calls */
+  unsigned long long	hist[PROBE_NBIN];	/* durations per call */
+  }		probestruct;
+
+/* Probes cost nothing unless configured with --enable-probes */
+#ifdef USE_PROBES
+#define	PROBE_REGION(probe, name) \
+		static probestruct probe = {name}
+#define	PROBE_START(probe, clock) \
+		probeclockstruct clock; start_probe(&probe, &clock)
+#define	PROBE_STOP(probe, clock, n) \
+		stop_probe(&probe, &clock, (unsigned long long)(n))
+#else
+#define	PROBE_REGION(probe, name)	extern probestruct probe
+#define	PROBE_START(probe, clock)
+#define	PROBE_STOP(probe, clock, n)
+#endif
+
 
 /*------------------------------- functions ---------------------------------*/
 
 extern catstruct	*new_cat(int ncat),
 			*read_cat(char *filename),
+			*read_memcat(char *filename, void *buf, size_t size),
 			*read_cats(char **filenames, int ncat);
 
 extern tabstruct	*asc2bin_tab(catstruct *catin, char *tabinname, 
@@ -241,9 +294,14 @@ extern void	add_cleanupfilename(char *filename),
 			int nkeys, unsigned char *mask, FILE *stream,
 			int strflag,int banflag, int leadflag,
                         output_type o_type),
+		start_probe(probestruct *probe, probeclockstruct *clock),
+		stop_probe(probestruct *probe, probeclockstruct *clock,
+			unsigned long long nitem),
 		swapbytes(void *, int, int),
 		ttypeconv(void *ptrin, void *ptrout,
 			t_type ttypein, t_type ttypeout),
+		update_readsum(tabstruct *tab, char *buf, size_t nbyte,
+			OFF_T pos),
 		voprint_obj(FILE *stream, tabstruct *tab),
 		warning(char *, char *),
 		write_body(tabstruct *tab, PIXTYPE *ptr, size_t size),
@@ -259,9 +317,13 @@ extern char	*tdisptoprintf(char *tdisp, char *str),
 
 extern unsigned int
 		compute_blocksum(char *buf, unsigned int sum),
+		compute_bufsum(char *buf, size_t nbyte, unsigned int sum),
 		compute_bodysum(tabstruct *tab, unsigned int sum),
 		decode_checksum(char *str);
 
+extern size_t	sum_simdwords(char *buf, size_t nword, unsigned int *hi,
+			unsigned int *lo);
+
 extern int	about_cat(catstruct *cat, FILE *stream),
 		about_tab(catstruct *cat, char *tabname, FILE *stream),
 		addhistoryto_cat(catstruct *cat, char *str),
@@ -271,6 +333,8 @@ extern int	about_cat(catstruct *cat, FILE *stream),
 		add_tab(tabstruct *tab, catstruct *cat, int pos),
 		blank_keys(tabstruct *tab),
 		close_cat(catstruct *cat),
+		convert_simdbody(tabstruct *tab, char *buf, PIXTYPE *ptr,
+			size_t n),
 		copy_key(tabstruct *tabin, char *keyname, tabstruct *tabout,
 			int pos),
 		copy_tab(catstruct *catin, char *tabname, int seg,
@@ -290,8 +354,10 @@ extern int	about_cat(catstruct *cat, FILE *stream),
 		fitswrite(char *fitsbuf, char *keyword, void *ptr,
 			h_type htype, t_type ttype),
 		get_head(tabstruct *tab),
+		get_simdlevel(void),
 		inherit_cat(catstruct *catin, catstruct *catout),
 		init_cat(catstruct *cat),
+		init_readsum(tabstruct *tab),
 		map_cat(catstruct *cat),
 		open_cat(catstruct *cat, access_type_t at),
 		pad_tab(catstruct *cat, KINGSIZE_T size),
@@ -311,13 +377,16 @@ extern int	about_cat(catstruct *cat, FILE *stream),
 		set_maxram(size_t maxram),
 		set_maxvram(size_t maxvram),
 		set_swapdir(char *dirname),
+		swap_simdbytes(void *ptr, int nb, int n),
 		tab_row_len(char *, char *),
 		tformof(char *str, t_type ttype, int n),
 		tsizeof(char *str),
 		update_head(tabstruct *tab),
 		update_tab(tabstruct *tab),
 		verify_checksum(tabstruct *tab),
+		verify_readsum(tabstruct *tab),
 		write_obj(tabstruct *tab, char *buf),
+		write_probes(char *filename),
 		wstrncmp(char *, char *, int);
 
 extern PIXTYPE	*alloc_body(tabstruct *tab,
@@ -328,6 +397,11 @@ extern FLAGTYPE	*alloc_ibody(tabstruct *tab,
 
 extern t_type	ttypeof(char *str);
 
+extern jmp_buf	*error_settrap(jmp_buf *trap);
+extern void	error_holdtrap(int delta);
+
+extern char	*error_trapmsg(void);
+
 extern  void	error(int, char *, char *),
 		swapbytes(void *ptr, int nb, int n),
 		warning(char *msg1, char *msg2);
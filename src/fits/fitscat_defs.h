@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		15/02/2013
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -86,7 +86,15 @@ typedef	unsigned char	BYTE;			/* a byte */
 typedef	int		LONG;			/* for DEC-Alpha... */
 	
 /*----------------------------- Internal constants --------------------------*/
-char		gstr[MAXCHAR];
+#ifndef THREAD_LOCAL
+#ifdef USE_THREADS
+#define	THREAD_LOCAL	__thread	/* Thread-local storage class */
+#else
+#define	THREAD_LOCAL
+#endif
+#endif
+
+extern THREAD_LOCAL char	gstr[MAXCHAR];
 
 /*----------------------------- External constants --------------------------*/
 
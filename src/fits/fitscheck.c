@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		09/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -39,9 +39,12 @@
 #include "fitscat.h"
 
 #define	ENCODE_OFFSET	0x30
+#define	CHECKSUM_NWORD	16384	/* words summed before folding carries */
 unsigned int	exclude[13] = {0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40,
 				0x5b, 0x5c, 0x5d, 0x5e, 0x5f, 0x60};
 
+static unsigned int	fold_checksum(unsigned int hi, unsigned int lo);
+
 /****** encode_checksum *****************************************************
 PROTO	void encode_checksum(unsigned int sum, char *str)
 PURPOSE	Encode a checksum to ASCII
@@ -148,39 +151,82 @@ PURPOSE	Compute the checksum of a FITS block (2880 bytes)
 INPUT	Pointer to the block,
 	The previous checksum.
 OUTPUT	The new computed checksum.
-NOTES	From Seaman & Pence 1995 (ftp://iraf.noao.edu/misc/checksum/). But
-	contrarily to what is stated by the authors, the original algorithm
-	depends on the endianity of the machine. The routine below adds
-	support for ix386-like processors (non-IEEE).
+NOTES	From Seaman & Pence 1995 (ftp://iraf.noao.edu/misc/checksum/).
+	See compute_bufsum().
 AUTHOR	E. Bertin (IAP)
-VERSION	08/05/2001
+VERSION	19/10/2026
  ***/
 unsigned int	compute_blocksum(char *buf, unsigned int sum)
   {
-   unsigned short	*sbuf,
-			his,los;
-   unsigned int		hi,lo, hicarry,locarry;
-   int			i;
+  return compute_bufsum(buf, FBSIZE, sum);
+  }
+
+
+/****** compute_bufsum *******************************************************
+PROTO	unsigned int compute_bufsum(char *buf, size_t nbyte, unsigned int sum)
+PURPOSE	Compute the checksum of a buffer of arbitrary length.
+INPUT	Pointer to the buffer,
+	number of bytes,
+	the previous checksum.
+OUTPUT	The new computed checksum.
+NOTES	From Seaman & Pence 1995 (ftp://iraf.noao.edu/misc/checksum/). The
+	buffer is read as big-endian 32-bit words, whatever the endianity of
+	the machine; the last word is padded with zeros if nbyte is not a
+	multiple of 4. The bulk of the data is processed with vector
+	instructions when available.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+unsigned int	compute_bufsum(char *buf, size_t nbyte, unsigned int sum)
+  {
+   unsigned char	*ubuf, word[4];
+   unsigned int		hi,lo;
+   size_t		i, n, nword;
 
-  sbuf = (unsigned short *)buf;
   hi = (sum >> 16);
   lo = (sum << 16) >> 16;
-  if (bswapflag)
-     for (i=FBSIZE/4; i--;)
+  for (nword=nbyte/4; nword; nword-=n, buf+=4*n)
+    {
+/*-- Carries are folded after every chunk to avoid overflows */
+    n = nword<CHECKSUM_NWORD? nword : CHECKSUM_NWORD;
+    i = sum_simdwords(buf, n, &hi, &lo);
+    for (ubuf=(unsigned char *)buf+4*i; i<n; i++, ubuf+=4)
       {
-      his = *(sbuf++);
-      los = *(sbuf++);
-      hi += (*((unsigned char *)&his)<<8) + *((unsigned char *)&his+1);
-      lo += (*((unsigned char *)&los)<<8) + *((unsigned char *)&los+1);
-      }
-  else
-    for (i=FBSIZE/4; i--;)
-      {
-      hi += *(sbuf++);
-      lo += *(sbuf++);
+      hi += (ubuf[0]<<8) + ubuf[1];
+      lo += (ubuf[2]<<8) + ubuf[3];
       }
+    sum = fold_checksum(hi, lo);
+    hi = sum >> 16;
+    lo = sum & 0xFFFF;
+    }
+
+  if ((n = nbyte%4))
+    {
+    memset(word, 0, 4);
+    memcpy(word, buf, n);
+    hi += (word[0]<<8) + word[1];
+    lo += (word[2]<<8) + word[3];
+    }
 
-  hicarry = hi>>16;     /* fold carry bits in */
+  return fold_checksum(hi, lo);
+  }
+
+
+/****** fold_checksum ********************************************************
+PROTO	unsigned int fold_checksum(unsigned int hi, unsigned int lo)
+PURPOSE	Fold carry bits of the 16-bit checksum halves.
+INPUT	Sum of most significant halves,
+	sum of least significant halves.
+OUTPUT	The 32-bit 1's complement checksum.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static unsigned int	fold_checksum(unsigned int hi, unsigned int lo)
+  {
+   unsigned int	hicarry,locarry;
+
+  hicarry = hi>>16;
   locarry = lo>>16;
   while (hicarry || locarry)
     {
@@ -335,3 +381,160 @@ int	verify_checksum(tabstruct *tab)
   return sum? RETURN_ERROR : RETURN_OK;
   }
 
+
+/****** init_readsum ********************************************************
+PROTO	int init_readsum(tabstruct *tab)
+PURPOSE	Prepare the verification of checksums while the data are read.
+INPUT	Pointer to the tab.
+OUTPUT	RETURN_OK if the header contains CHECKSUM or DATASUM keywords,
+	RETURN_ERROR otherwise (no verification).
+NOTES	The data read by read_body() are then checksummed on the fly, as long
+	as they are read sequentially, forward or backward.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	init_readsum(tabstruct *tab)
+  {
+  tab->sumstart = tab->sumend = 0;
+  tab->readsum = 0;
+  tab->sumflag = tab->headbuf
+	&& (fitsfind(tab->headbuf, "CHECKSUM")!=RETURN_ERROR
+		|| fitsfind(tab->headbuf, "DATASUM ")!=RETURN_ERROR);
+
+  return tab->sumflag? RETURN_OK : RETURN_ERROR;
+  }
+
+
+/****** update_readsum ******************************************************
+PROTO	void update_readsum(tabstruct *tab, char *buf, size_t nbyte,
+			OFF_T pos)
+PURPOSE	Add data just read to the running checksum of a FITS body.
+INPUT	Pointer to the tab,
+	pointer to the raw (not byte-swapped) data,
+	number of bytes,
+	position of the data relative to the beginning of the body.
+OUTPUT	-.
+NOTES	Only data adjacent to those already checksummed are added, so that
+	the checksummed interval remains contiguous; the sum does not depend
+	on the order of the chunks. Chunks starting in the middle of a 32-bit
+	word are accounted for by rotating their checksum.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	update_readsum(tabstruct *tab, char *buf, size_t nbyte, OFF_T pos)
+  {
+   unsigned int	sum;
+   int		shift;
+
+  if (!nbyte)
+    return;
+  if (tab->sumstart == tab->sumend)
+    tab->sumstart = tab->sumend = (KINGSIZE_T)pos;
+  if (pos == (OFF_T)tab->sumend)
+    tab->sumend += nbyte;
+  else if (pos + (OFF_T)nbyte == (OFF_T)tab->sumstart)
+    tab->sumstart = (KINGSIZE_T)pos;
+  else
+    return;
+
+  sum = compute_bufsum(buf, nbyte, 0);
+/* Multiplying by 2^-8 modulo 2^32-1 is a right rotation by 8 bits */
+  if ((shift = 8*(int)(pos%4)))
+    sum = (sum >> shift) | (sum << (32-shift));
+  tab->readsum = fold_checksum((tab->readsum>>16) + (sum>>16),
+		(tab->readsum&0xFFFF) + (sum&0xFFFF));
+
+  return;
+  }
+
+
+/****** verify_readsum ******************************************************
+PROTO	int verify_readsum(tabstruct *tab)
+PURPOSE	Check the checksums of a FITS table from the data read so far.
+INPUT	Pointer to the tab.
+OUTPUT	RETURN_OK if the checksums are correct, RETURN_ERROR if they are
+	incorrect (or if the file is truncated), or RETURN_FATAL_ERROR if no
+	checksum keyword was found.
+NOTES	init_readsum() must have been called before the data were read. Data
+	(including padding) that have not been checksummed while being read
+	are read here, and the file position is restored.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	verify_readsum(tabstruct *tab)
+  {
+   catstruct	*cat;
+   char		str[82],
+		*buf;
+   KINGSIZE_T	size;
+   OFF_T	pos, filepos;
+   size_t	n;
+   unsigned int	sum;
+   int		i, closeflag, status;
+
+  if (!tab->sumflag)
+    return RETURN_FATAL_ERROR;
+
+  status = RETURN_OK;
+/* Complete the data sum with what has not been read yet */
+  size = tab->tabsize? PADTOTAL(tab->tabsize) : 0;
+  if (tab->sumstart > 0 || tab->sumend < size)
+    {
+    if (!(cat=tab->cat))
+      return RETURN_ERROR;
+    closeflag = !cat->file;
+    if (open_cat(cat, READ_ONLY) != RETURN_OK)
+      return RETURN_ERROR;
+    filepos = 0;
+    if (!closeflag)
+      QFTELL(cat->file, filepos, cat->filename);
+    QMALLOC(buf, char, DATA_BUFSIZE);
+    while (status == RETURN_OK && (tab->sumstart > 0 || tab->sumend < size))
+      {
+/*---- Extend the checksummed interval backward first, then forward */
+      if (tab->sumstart > 0)
+        {
+        n = tab->sumstart < DATA_BUFSIZE? (size_t)tab->sumstart : DATA_BUFSIZE;
+        pos = (OFF_T)(tab->sumstart - n);
+        }
+      else
+        {
+        n = size - tab->sumend < DATA_BUFSIZE?
+		(size_t)(size - tab->sumend) : DATA_BUFSIZE;
+        pos = (OFF_T)tab->sumend;
+        }
+      QFSEEK(cat->file, tab->bodypos + pos, SEEK_SET, cat->filename);
+/*---- A truncated file is reported as a checksum error */
+      if (fread(buf, 1, n, cat->file) != n)
+        status = RETURN_ERROR;
+      else
+        update_readsum(tab, buf, n, pos);
+      }
+    free(buf);
+    if (closeflag)
+      close_cat(cat);
+    else
+      QFSEEK(cat->file, filepos, SEEK_SET, cat->filename);
+    if (status != RETURN_OK)
+      return status;
+    }
+
+/* DATASUM is a decimal string */
+  if (fitsread(tab->headbuf, "DATASUM ", str, H_STRING, T_STRING)==RETURN_OK
+	&& (unsigned int)strtoul(str, NULL, 10) != tab->readsum)
+    return RETURN_ERROR;
+
+/* The data and header checksums should sum to 0 */
+  if (fitsfind(tab->headbuf, "CHECKSUM")!=RETURN_ERROR)
+    {
+    sum = tab->readsum;
+    buf = tab->headbuf;
+    for (i=tab->headnblock; i--; buf+=FBSIZE)
+      sum = compute_blocksum(buf, sum);
+    if (~sum)
+      return RETURN_ERROR;
+    }
+
+  return RETURN_OK;
+  }
+
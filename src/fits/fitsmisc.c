@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		09/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -32,6 +32,7 @@
 #endif
 
 #include	<ctype.h>
+#include	<setjmp.h>
 #include	<stdio.h>
 #include	<stdlib.h>
 #include	<string.h>
@@ -40,17 +41,33 @@
 #include	"fitscat_defs.h"
 #include	"fitscat.h"
 
+THREAD_LOCAL char	gstr[MAXCHAR];
+
 static void	(*errorfunc)(char *msg1, char *msg2) = NULL;
 static char	warning_historystr[WARNING_NMAX][192]={""};
 static int	nwarning = 0, nwarning_history = 0, nerror = 0;
 
+/* Error traps are set per thread */
+static THREAD_LOCAL jmp_buf	*error_trap = NULL;
+static THREAD_LOCAL char	error_trapstr[MAXCHAR];
+static THREAD_LOCAL int		error_nhold = 0;
+
 /********************************* error ************************************/
 /*
 I hope it will never be used!
 */
 void	error(int num, char *msg1, char *msg2)
   {
+   jmp_buf	*trap;
+
   fprintf(stderr, "\n> %s%s\n\n",msg1,msg2);
+/* Jump back to the trap set by the calling thread, if any */
+  if (num && !error_nhold && (trap = error_trap))
+    {
+    snprintf(error_trapstr, MAXCHAR, "%s%s", msg1, msg2);
+    error_trap = NULL;
+    longjmp(*trap, 1);
+    }
   if (num && errorfunc && !nerror)
     {
     nerror = 1;
@@ -73,6 +90,63 @@ void	error_installfunc(void (*func)(char *msg1, char *msg2))
   }
 
 
+/****** error_settrap *********************************************************
+PROTO	jmp_buf *error_settrap(jmp_buf *trap)
+PURPOSE	Make error() jump back to the caller instead of exiting.
+INPUT	Pointer to a jmp_buf initialized with setjmp(), or NULL to restore
+	the default behaviour.
+OUTPUT	Pointer to the previous trap (NULL if none).
+NOTES	Traps are set per thread and apply only to errors raised in the
+	calling thread. A trap is removed when it is triggered; the message
+	is available through error_trapmsg().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+jmp_buf	*error_settrap(jmp_buf *trap)
+  {
+   jmp_buf	*oldtrap;
+
+  oldtrap = error_trap;
+  error_trap = trap;
+
+  return oldtrap;
+  }
+
+
+/****** error_holdtrap ******************************************************
+PROTO	void error_holdtrap(int delta)
+PURPOSE	Suspend (delta>0) or resume (delta<0) the error trap of the calling
+	thread.
+INPUT	Increment of the hold counter.
+OUTPUT	-.
+NOTES	Used around critical sections: an error raised while a mutex is held
+	cannot be recovered from, and remains fatal.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	error_holdtrap(int delta)
+  {
+  error_nhold += delta;
+
+  return;
+  }
+
+
+/****** error_trapmsg *********************************************************
+PROTO	char *error_trapmsg(void)
+PURPOSE	Return the message of the last error trapped in the calling thread.
+INPUT	-.
+OUTPUT	Pointer to the error message.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+char	*error_trapmsg(void)
+  {
+  return error_trapstr;
+  }
+
+
 /********************************* warning **********************************/
 /*
 Print a warning message on screen.
@@ -80,10 +154,10 @@ Print a warning message on screen.
 void    warning(char *msg1, char *msg2)
   {
    time_t	warntime;
-   struct tm	*tm;
+   struct tm	tmbuf, *tm;
 
   warntime = time(NULL);
-  tm = localtime(&warntime);
+  tm = localtime_r(&warntime, &tmbuf);
  
   fprintf(stderr, "\n> WARNING: %s%s\n\n",msg1,msg2);
   sprintf(warning_historystr[(nwarning++)%WARNING_NMAX],
@@ -132,6 +206,13 @@ void    swapbytes(void *ptr, int nb, int n)
 
   cp = (char *)ptr;
 
+/* Vector instructions take care of the bulk of the data */
+  if ((j = swap_simdbytes(ptr, nb, n)))
+    {
+    cp += (size_t)j*nb;
+    n -= j;
+    }
+
   if (nb&4)
     {
     for (j=n; j--; cp+=4)
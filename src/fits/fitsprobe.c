@@ -0,0 +1,336 @@
+/*
+*				fitsprobe.c
+*
+* Low-overhead timing probes around hot loops.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	AstrOmatic FITS/LDAC library
+*
+*	Copyright:		(C) 2026 Emmanuel Bertin -- IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	AstrOmatic software is free software: you can redistribute it and/or
+*	modify it under the terms of the GNU General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*	AstrOmatic software is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with AstrOmatic software.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<time.h>
+#include	<unistd.h>
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include	<linux/perf_event.h>
+#include	<sys/syscall.h>
+#endif
+#if defined(HAVE_X86INTRIN_H) && (defined(__x86_64__) || defined(__i386__))
+#include	<x86intrin.h>
+#define		PROBE_RDTSC
+#endif
+#ifdef USE_THREADS
+#include	<pthread.h>
+#endif
+
+#include	"fitscat_defs.h"
+#include	"fitscat.h"
+
+#ifdef USE_PROBES
+
+static probestruct	*probe_list[PROBE_NMAX];
+static int		probe_n, probe_missflag;
+
+static unsigned long long	probe_misses(void),
+				probe_ticks(void);
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#ifdef USE_THREADS
+static pthread_key_t	probe_key;
+static pthread_once_t	probe_once = PTHREAD_ONCE_INIT;
+
+static void		probe_closekey(void *fdp),
+			probe_initkey(void);
+#else
+static int		probe_fd = -2;
+#endif
+static int		probe_openfd(void);
+#endif
+
+/****** start_probe **********************************************************
+PROTO	void start_probe(probestruct *probe, probeclockstruct *clock)
+PURPOSE	Start timing a probed code region.
+INPUT	Pointer to the probe of the region,
+	pointer to the clock of the current call.
+OUTPUT	-.
+NOTES	Called through the PROBE_START() macro. Cache misses are counted only
+	every PROBE_SAMPLE calls, to limit the overhead of the system calls.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	start_probe(probestruct *probe, probeclockstruct *clock)
+  {
+  if ((clock->sampleflag = !(probe->ncall & (PROBE_SAMPLE-1))))
+    clock->m0 = probe_misses();
+  clock->t0 = probe_ticks();
+
+  return;
+  }
+
+
+/****** stop_probe ***********************************************************
+PROTO	void stop_probe(probestruct *probe, probeclockstruct *clock,
+			unsigned long long nitem)
+PURPOSE	Stop timing a probed code region and accumulate the results.
+INPUT	Pointer to the probe of the region,
+	pointer to the clock of the current call,
+	number of items (e.g. pixels) processed during the call.
+OUTPUT	-.
+NOTES	Called through the PROBE_STOP() macro. Counters are updated with
+	atomic operations, so that regions may be probed in several threads.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	stop_probe(probestruct *probe, probeclockstruct *clock,
+		unsigned long long nitem)
+  {
+   unsigned long long	dt, misses;
+   int			b, n;
+
+  dt = probe_ticks() - clock->t0;
+  if (clock->sampleflag)
+    {
+    misses = probe_misses() - clock->m0;
+    __sync_fetch_and_add(&probe->nsample, 1ULL);
+    __sync_fetch_and_add(&probe->misses, misses);
+    }
+
+/* Register the region at its first call */
+  if (!probe->regflag && __sync_bool_compare_and_swap(&probe->regflag, 0, 1))
+    {
+    if ((n = __sync_fetch_and_add(&probe_n, 1)) < PROBE_NMAX)
+      probe_list[n] = probe;
+    }
+
+/* Durations are binned in powers of 2 */
+  for (b=0; b<PROBE_NBIN-1 && (dt>>(b+1)); b++);
+  __sync_fetch_and_add(&probe->hist[b], 1ULL);
+  __sync_fetch_and_add(&probe->ncall, 1ULL);
+  __sync_fetch_and_add(&probe->nitem, nitem);
+  __sync_fetch_and_add(&probe->ticks, dt);
+
+  return;
+  }
+
+
+/****** write_probes *********************************************************
+PROTO	int write_probes(char *filename)
+PURPOSE	Write the counters and duration histograms of all probed regions.
+INPUT	File name ("STDOUT" for the standard output).
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	JSON format. Durations are in CPU cycles (time-stamp counter) on x86
+	processors and in ns elsewhere. Histogram bin b counts the calls that
+	lasted between 2^b and 2^(b+1) units; empty bins are not written.
+	Counters accumulate over the life of the process.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	write_probes(char *filename)
+  {
+   FILE			*file;
+   probestruct		*probe;
+   int			b,n, nprobe, flag;
+
+  if (!strcmp(filename, "STDOUT"))
+    file = stdout;
+  else if (!(file = fopen(filename, "w")))
+    return RETURN_ERROR;
+
+  nprobe = probe_n<PROBE_NMAX? probe_n : PROBE_NMAX;
+#ifdef PROBE_RDTSC
+  fprintf(file, "{\n \"unit\": \"cycles\",\n");
+#else
+  fprintf(file, "{\n \"unit\": \"ns\",\n");
+#endif
+  fprintf(file, " \"cache_misses\": %s,\n \"regions\": [",
+	probe_missflag>0? "true" : "false");
+  for (n=0; n<nprobe; n++)
+    {
+    probe = probe_list[n];
+    fprintf(file, "%s\n  {\"name\": \"%s\", \"calls\": %llu, \"items\": %llu,"
+	" \"ticks\": %llu, \"ticks_per_call\": %.1f, \"ticks_per_item\": %.3f",
+	n? "," : "", probe->name, probe->ncall, probe->nitem, probe->ticks,
+	probe->ncall? (double)probe->ticks/probe->ncall : 0.0,
+	probe->nitem? (double)probe->ticks/probe->nitem : 0.0);
+    if (probe_missflag>0 && probe->nsample)
+      fprintf(file, ", \"sampled_calls\": %llu, \"misses_per_call\": %.1f",
+	probe->nsample, (double)probe->misses/probe->nsample);
+    fprintf(file, ",\n   \"histogram\": {");
+    for (b=flag=0; b<PROBE_NBIN; b++)
+      if (probe->hist[b])
+        {
+        fprintf(file, "%s\"%d\": %llu", flag? ", " : "", b, probe->hist[b]);
+        flag = 1;
+        }
+    fprintf(file, "}}");
+    }
+  fprintf(file, "\n ]\n}\n");
+
+  if (file != stdout)
+    fclose(file);
+
+  return RETURN_OK;
+  }
+
+
+/****** probe_ticks **********************************************************
+PROTO	unsigned long long probe_ticks(void)
+PURPOSE	Read a fine-grained counter of elapsed time.
+INPUT	-.
+OUTPUT	Time-stamp counter on x86 processors, monotonic clock in ns elsewhere.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static unsigned long long	probe_ticks(void)
+  {
+#ifdef PROBE_RDTSC
+  return (unsigned long long)__rdtsc();
+#else
+   struct timespec	ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec*1000000000ULL
+	+ (unsigned long long)ts.tv_nsec;
+#endif
+  }
+
+
+/****** probe_misses *********************************************************
+PROTO	unsigned long long probe_misses(void)
+PURPOSE	Read the cache-miss counter of the current thread.
+INPUT	-.
+OUTPUT	Number of cache misses since the counter was opened (0 if not
+	available).
+NOTES	Counters are opened through perf_event_open() on first use in every
+	thread. They may be unavailable because of the kernel settings (see
+	/proc/sys/kernel/perf_event_paranoid) or in virtual machines.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static unsigned long long	probe_misses(void)
+  {
+#ifdef HAVE_LINUX_PERF_EVENT_H
+   unsigned long long	count;
+   int			fd;
+
+#ifdef USE_THREADS
+   int			*fdp;
+
+  pthread_once(&probe_once, probe_initkey);
+  if (!(fdp = (int *)pthread_getspecific(probe_key)))
+    {
+    QMALLOC(fdp, int, 1);
+    *fdp = probe_openfd();
+    pthread_setspecific(probe_key, fdp);
+    }
+  fd = *fdp;
+#else
+  if (probe_fd == -2)
+    probe_fd = probe_openfd();
+  fd = probe_fd;
+#endif
+  if (fd>=0 && read(fd, &count, sizeof(count)) == sizeof(count))
+    return count;
+#endif
+
+  return 0ULL;
+  }
+
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+/****** probe_openfd *********************************************************
+PROTO	int probe_openfd(void)
+PURPOSE	Open a cache-miss counter for the current thread.
+INPUT	-.
+OUTPUT	File descriptor of the counter, or -1 if not available.
+NOTES	Only user-space misses are counted.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	probe_openfd(void)
+  {
+   struct perf_event_attr	attr;
+   int				fd;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+/* Misses are reported if counters could be opened in at least one thread */
+  if (fd>=0)
+    probe_missflag = 1;
+
+  return fd<0? -1 : fd;
+  }
+
+
+#ifdef USE_THREADS
+/****** probe_initkey ********************************************************
+PROTO	void probe_initkey(void)
+PURPOSE	Create the key of thread-specific cache-miss counters.
+INPUT	-.
+OUTPUT	-.
+NOTES	Called once through pthread_once().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	probe_initkey(void)
+  {
+  pthread_key_create(&probe_key, probe_closekey);
+
+  return;
+  }
+
+
+/****** probe_closekey *******************************************************
+PROTO	void probe_closekey(void *fdp)
+PURPOSE	Close the cache-miss counter of a terminating thread.
+INPUT	Pointer to the file descriptor of the counter.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	probe_closekey(void *fdp)
+  {
+  if (*(int *)fdp >= 0)
+    close(*(int *)fdp);
+  free(fdp);
+
+  return;
+  }
+#endif
+#endif
+
+#endif
+
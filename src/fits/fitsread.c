@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		09/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -74,6 +74,45 @@ catstruct	*read_cat(char *filename)
   }
 
 
+/****** read_memcat ************************************************************
+PROTO	catstruct read_memcat(char *filename, void *buf, size_t size)
+PURPOSE	``Read'' a FITS catalog held in memory.
+INPUT	Name given to the catalog,
+	pointer to the FITS content,
+	size of the FITS content in bytes.
+OUTPUT	catstruct pointer.
+NOTES	Returns NULL if the buffer does not contain FITS data. The buffer
+	must remain available until the catalog is freed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+catstruct	*read_memcat(char *filename, void *buf, size_t size)
+
+  {
+   catstruct *cat;
+
+  if (!(cat = new_cat(1)))
+    error (EXIT_FAILURE, "Not enough memory to read ", filename);
+
+  strncpy(cat->filename, filename, MAXCHARS-1);
+  cat->membuf = buf;
+  cat->memsize = size;
+  if (open_cat(cat, READ_ONLY) != RETURN_OK)
+    {
+    free_cat(&cat, 1);
+    return NULL;
+    }
+
+  if (map_cat(cat) != RETURN_OK)
+    {
+    free_cat(&cat, 1);
+    return NULL;
+    }
+
+  return cat;
+  }
+
+
 /****** read_cats **************************************************************
 PROTO	read_cats(char **filenames, int ncat)
 PURPOSE	``Read'' several FITS catalogs.
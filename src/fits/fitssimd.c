@@ -0,0 +1,940 @@
+/*
+*				fitssimd.c
+*
+* Vectorized byte-swapping, conversion and checksums of FITS data.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	AstrOmatic FITS/LDAC library
+*
+*	Copyright:		(C) 2026 Emmanuel Bertin -- IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	AstrOmatic software is free software: you can redistribute it and/or
+*	modify it under the terms of the GNU General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*	AstrOmatic software is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with AstrOmatic software.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+
+#if defined(__GNUC__) && !defined(__INTEL_COMPILER) \
+	&& (defined(__x86_64__) || defined(__i386__))
+#include	<immintrin.h>
+#define		SIMD_X86
+#endif
+
+#include	"fitscat_defs.h"
+#include	"fitscat.h"
+
+/* AVX-512 implies FMA: explicit rounding keeps the compiler from fusing */
+#define	SIMD512_ROUND		(_MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC)
+#define	SIMD512_MADD(x, a, b)	_mm512_add_round_ps(_mm512_mul_round_ps(x, \
+					a, SIMD512_ROUND), b, SIMD512_ROUND)
+
+static int	simd_level = -1;
+
+static void	simd_convtail(char *buf, PIXTYPE *ptr, size_t n, int bitpix,
+			int sgnflag, int blankflag, int blank,
+			PIXTYPE bs, PIXTYPE bz);
+
+#ifdef SIMD_X86
+static size_t	conv8_ssse3(char *buf, PIXTYPE *ptr, size_t n, int sgnflag,
+			int blankflag, int blank, float bs, float bz),
+		conv8_avx2(char *buf, PIXTYPE *ptr, size_t n, int sgnflag,
+			int blankflag, int blank, float bs, float bz),
+		conv16_ssse3(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz),
+		conv16_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz),
+		conv16_avx512(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz),
+		conv32_ssse3(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz),
+		conv32_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz),
+		conv32_avx512(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz),
+		convf32_ssse3(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz),
+		convf32_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz),
+		convf32_avx512(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz),
+		convf64_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz),
+		swap_ssse3(char *buf, int nb, size_t n),
+		swap_avx2(char *buf, int nb, size_t n),
+		sum_ssse3(char *buf, size_t nword, unsigned int *hi,
+			unsigned int *lo),
+		sum_avx2(char *buf, size_t nword, unsigned int *hi,
+			unsigned int *lo);
+#endif
+
+/****** convert_simdbody ******************************************************
+PROTO	int convert_simdbody(tabstruct *tab, char *buf, PIXTYPE *ptr, size_t n)
+PURPOSE	Byte-swap (if needed), convert, scale and flag FITS pixel values
+	with vector instructions.
+INPUT	Pointer to the tab structure,
+	pointer to the raw FITS data (modified in place),
+	pointer to the output array,
+	number of elements to be converted.
+OUTPUT	RETURN_OK if the data were converted, RETURN_ERROR if no vector
+	kernel is available (the caller must then convert the data itself).
+NOTES	Byte-swapping, conversion to float, scaling and the detection of
+	BLANK integers or NaN/Inf floats are done in registers, in a single
+	pass. The kernel is selected at run time from the capabilities of the
+	CPU. BITPIX 64 is not vectorized, nor BITPIX -64 below AVX2. Results
+	are identical to those of read_body() as long as the compiler does not
+	contract multiply-adds.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	convert_simdbody(tabstruct *tab, char *buf, PIXTYPE *ptr, size_t n)
+  {
+#ifdef SIMD_X86
+   PIXTYPE	bs,bz;
+   size_t	i;
+   int		level, blank, blankflag, sgnflag;
+
+  if ((level = get_simdlevel()) == SIMD_NONE)
+    return RETURN_ERROR;
+
+  bs = (PIXTYPE)tab->bscale;
+  bz = (PIXTYPE)tab->bzero;
+  sgnflag = tab->bitsgn;
+  blankflag = tab->blankflag;
+/* BLANK values are compared after extension to 32 bits */
+  switch(tab->bitpix)
+    {
+    case BP_BYTE:
+      blank = sgnflag? (int)(signed char)tab->blank
+			: (int)(unsigned char)tab->blank;
+      i = level>=SIMD_AVX2?
+		conv8_avx2(buf, ptr, n, sgnflag, blankflag, blank, bs, bz)
+		: conv8_ssse3(buf, ptr, n, sgnflag, blankflag, blank, bs, bz);
+      break;
+    case BP_SHORT:
+      blank = sgnflag? (int)(short)tab->blank
+			: (int)(unsigned short)tab->blank;
+      i = level>=SIMD_AVX512?
+		conv16_avx512(buf, ptr, n, bswapflag, sgnflag, blankflag,
+			blank, bs, bz)
+	: (level>=SIMD_AVX2?
+		conv16_avx2(buf, ptr, n, bswapflag, sgnflag, blankflag,
+			blank, bs, bz)
+		: conv16_ssse3(buf, ptr, n, bswapflag, sgnflag, blankflag,
+			blank, bs, bz));
+      break;
+    case BP_LONG:
+      blank = tab->blank;
+      i = level>=SIMD_AVX512?
+		conv32_avx512(buf, ptr, n, bswapflag, sgnflag, blankflag,
+			blank, bs, bz)
+	: (level>=SIMD_AVX2?
+		conv32_avx2(buf, ptr, n, bswapflag, sgnflag, blankflag,
+			blank, bs, bz)
+		: conv32_ssse3(buf, ptr, n, bswapflag, sgnflag, blankflag,
+			blank, bs, bz));
+      break;
+    case BP_FLOAT:
+      blank = 0;
+      i = level>=SIMD_AVX512? convf32_avx512(buf, ptr, n, bswapflag, bs, bz)
+	: (level>=SIMD_AVX2? convf32_avx2(buf, ptr, n, bswapflag, bs, bz)
+		: convf32_ssse3(buf, ptr, n, bswapflag, bs, bz));
+      break;
+    case BP_DOUBLE:
+      if (level<SIMD_AVX2)
+        return RETURN_ERROR;
+      blank = 0;
+      i = convf64_avx2(buf, ptr, n, bswapflag, bs, bz);
+      break;
+    default:
+      return RETURN_ERROR;
+    }
+
+/* Leftovers */
+  if (i<n)
+    simd_convtail(buf+i*tab->bytepix, ptr+i, n-i, tab->bitpix, sgnflag,
+	blankflag, blank, bs, bz);
+
+  return RETURN_OK;
+#else
+  return RETURN_ERROR;
+#endif
+  }
+
+
+/****** swap_simdbytes ********************************************************
+PROTO	int swap_simdbytes(void *ptr, int nb, int n)
+PURPOSE	Swap bytes of 2, 4 or 8-byte elements with vector instructions.
+INPUT	Pointer to the array of elements,
+	element size in bytes,
+	number of elements.
+OUTPUT	Number of leading elements that have been swapped (the caller must
+	swap the others).
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	swap_simdbytes(void *ptr, int nb, int n)
+  {
+#ifdef SIMD_X86
+   int	level;
+
+  if (n<=0 || (nb!=2 && nb!=4 && nb!=8)
+	|| (level = get_simdlevel()) == SIMD_NONE)
+    return 0;
+
+  return (int)(level>=SIMD_AVX2? swap_avx2((char *)ptr, nb, (size_t)n)
+		: swap_ssse3((char *)ptr, nb, (size_t)n));
+#else
+  return 0;
+#endif
+  }
+
+
+/****** sum_simdwords ********************************************************
+PROTO	size_t sum_simdwords(char *buf, size_t nword, unsigned int *hi,
+			unsigned int *lo)
+PURPOSE	Add the 16-bit halves of big-endian 32-bit words with vector
+	instructions, for FITS checksums.
+INPUT	Pointer to the data,
+	number of 32-bit words,
+	pointer to the sum of most significant halves (updated),
+	pointer to the sum of least significant halves (updated).
+OUTPUT	Number of leading words that have been added (the caller must add
+	the others).
+NOTES	Carries are not folded: nword must not exceed 65536 to avoid overflows
+	of the 32-bit accumulators.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+size_t	sum_simdwords(char *buf, size_t nword, unsigned int *hi,
+			unsigned int *lo)
+  {
+#ifdef SIMD_X86
+   int	level;
+
+  if (!nword || (level = get_simdlevel()) == SIMD_NONE)
+    return 0;
+
+  return level>=SIMD_AVX2? sum_avx2(buf, nword, hi, lo)
+			: sum_ssse3(buf, nword, hi, lo);
+#else
+  return 0;
+#endif
+  }
+
+
+/****** get_simdlevel *********************************************************
+PROTO	int get_simdlevel(void)
+PURPOSE	Find out the vector instruction set to be used.
+INPUT	-.
+OUTPUT	SIMD_NONE, SIMD_SSSE3, SIMD_AVX2 or SIMD_AVX512.
+NOTES	The CPU is probed only once. Concurrent first calls are harmless.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	get_simdlevel(void)
+  {
+  if (simd_level < 0)
+    {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+      simd_level = SIMD_AVX512;
+    else if (__builtin_cpu_supports("avx2"))
+      simd_level = SIMD_AVX2;
+    else if (__builtin_cpu_supports("ssse3"))
+      simd_level = SIMD_SSSE3;
+    else
+#endif
+      simd_level = SIMD_NONE;
+    }
+
+  return simd_level;
+  }
+
+
+/****** simd_convtail *********************************************************
+PROTO	void simd_convtail(char *buf, PIXTYPE *ptr, size_t n, int bitpix,
+			int sgnflag, int blankflag, int blank,
+			PIXTYPE bs, PIXTYPE bz)
+PURPOSE	Convert the elements left over by a vector kernel.
+INPUT	Pointer to the raw FITS data (modified in place),
+	pointer to the output array,
+	number of elements to be converted,
+	FITS BITPIX,
+	signed integer flag,
+	BLANK flag,
+	BLANK value (extended to 32 bits),
+	scaling factor,
+	offset.
+OUTPUT	-.
+NOTES	Same expressions as in read_body().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	simd_convtail(char *buf, PIXTYPE *ptr, size_t n, int bitpix,
+			int sgnflag, int blankflag, int blank,
+			PIXTYPE bs, PIXTYPE bz)
+  {
+   double	dval;
+   float	fval;
+   unsigned int	iuval;
+   int		ival;
+   short	sval;
+   unsigned short	suval;
+   size_t	i;
+
+  switch(bitpix)
+    {
+    case BP_BYTE:
+      for (i=n; i--; buf++)
+        {
+        ival = sgnflag? (int)*(signed char *)buf : (int)*(unsigned char *)buf;
+        *(ptr++) = (blankflag && ival==blank)? -BIG : ival*bs + bz;
+        }
+      break;
+    case BP_SHORT:
+      if (bswapflag)
+        swapbytes(buf, 2, (int)n);
+      for (i=n; i--; buf += 2)
+        {
+        if (sgnflag)
+          {
+          memcpy(&sval, buf, 2);
+          *(ptr++) = (blankflag && sval==blank)? -BIG : sval*bs + bz;
+          }
+        else
+          {
+          memcpy(&suval, buf, 2);
+          *(ptr++) = (blankflag && suval==blank)? -BIG : suval*bs + bz;
+          }
+        }
+      break;
+    case BP_LONG:
+      if (bswapflag)
+        swapbytes(buf, 4, (int)n);
+      for (i=n; i--; buf += 4)
+        {
+        memcpy(&iuval, buf, 4);
+        ival = (int)iuval;
+        *(ptr++) = (blankflag && ival==blank)? -BIG
+			: (sgnflag? ival*bs : iuval*bs) + bz;
+        }
+      break;
+    case BP_FLOAT:
+      if (bswapflag)
+        swapbytes(buf, 4, (int)n);
+      for (i=n; i--; buf += 4)
+        {
+        memcpy(&iuval, buf, 4);
+        memcpy(&fval, buf, 4);
+        *(ptr++) = ((0x7f800000&iuval) == 0x7f800000)? -BIG : fval*bs + bz;
+        }
+      break;
+    case BP_DOUBLE:
+      if (bswapflag)
+        swapbytes(buf, 8, (int)n);
+      for (i=n; i--; buf += 8)
+        {
+        memcpy(&dval, buf, 8);
+        memcpy(&iuval, buf + (bswapflag? 4 : 0), 4);
+        *(ptr++) = ((0x7ff00000 & iuval) == 0x7ff00000)? -BIG : dval*bs + bz;
+        }
+      break;
+    default:
+      break;
+    }
+
+  return;
+  }
+
+
+#ifdef SIMD_X86
+/*------------------------------- SSSE3 kernels ----------------------------*/
+
+/****** conv8_ssse3 ***********************************************************
+PROTO	size_t conv8_ssse3(char *buf, PIXTYPE *ptr, size_t n, int sgnflag,
+			int blankflag, int blank, float bs, float bz)
+PURPOSE	Convert and scale 8-bit FITS data with SSSE3 instructions.
+INPUT	Pointer to the raw data,
+	pointer to the output array,
+	number of elements,
+	signed integer flag,
+	BLANK flag,
+	BLANK value (extended to 32 bits),
+	scaling factor,
+	offset.
+OUTPUT	Number of elements converted.
+NOTES	The vector kernels below all follow the same conventions.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("ssse3")))
+static size_t	conv8_ssse3(char *buf, PIXTYPE *ptr, size_t n, int sgnflag,
+			int blankflag, int blank, float bs, float bz)
+  {
+   __m128i	v, w, x[4], vzero, vblank;
+   __m128	f, m, vbs, vbz, vbig;
+   size_t	i;
+   int		k;
+
+  vzero = _mm_setzero_si128();
+  vblank = _mm_set1_epi32(blank);
+  vbs = _mm_set1_ps(bs);
+  vbz = _mm_set1_ps(bz);
+  vbig = _mm_set1_ps((float)-BIG);
+  for (i=0; i+16<=n; i+=16, buf+=16, ptr+=16)
+    {
+    v = _mm_loadu_si128((__m128i *)buf);
+    if (sgnflag)
+      {
+/*---- Sign extension: replicate bytes, then shift them back down */
+      w = _mm_unpacklo_epi8(v, v);
+      x[0] = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 24);
+      x[1] = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 24);
+      w = _mm_unpackhi_epi8(v, v);
+      x[2] = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 24);
+      x[3] = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 24);
+      }
+    else
+      {
+      w = _mm_unpacklo_epi8(v, vzero);
+      x[0] = _mm_unpacklo_epi16(w, vzero);
+      x[1] = _mm_unpackhi_epi16(w, vzero);
+      w = _mm_unpackhi_epi8(v, vzero);
+      x[2] = _mm_unpacklo_epi16(w, vzero);
+      x[3] = _mm_unpackhi_epi16(w, vzero);
+      }
+    for (k=0; k<4; k++)
+      {
+      f = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(x[k]), vbs), vbz);
+      if (blankflag)
+        {
+        m = _mm_castsi128_ps(_mm_cmpeq_epi32(x[k], vblank));
+        f = _mm_or_ps(_mm_and_ps(m, vbig), _mm_andnot_ps(m, f));
+        }
+      _mm_storeu_ps(ptr+4*k, f);
+      }
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("ssse3")))
+static size_t	conv16_ssse3(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz)
+  {
+   __m128i	v, x[2], vswap, vzero, vblank;
+   __m128	f, m, vbs, vbz, vbig;
+   size_t	i;
+   int		k;
+
+  vswap = _mm_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14);
+  vzero = _mm_setzero_si128();
+  vblank = _mm_set1_epi32(blank);
+  vbs = _mm_set1_ps(bs);
+  vbz = _mm_set1_ps(bz);
+  vbig = _mm_set1_ps((float)-BIG);
+  for (i=0; i+8<=n; i+=8, buf+=16, ptr+=8)
+    {
+    v = _mm_loadu_si128((__m128i *)buf);
+    if (swapflag)
+      v = _mm_shuffle_epi8(v, vswap);
+    if (sgnflag)
+      {
+      x[0] = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      x[1] = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+      }
+    else
+      {
+      x[0] = _mm_unpacklo_epi16(v, vzero);
+      x[1] = _mm_unpackhi_epi16(v, vzero);
+      }
+    for (k=0; k<2; k++)
+      {
+      f = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(x[k]), vbs), vbz);
+      if (blankflag)
+        {
+        m = _mm_castsi128_ps(_mm_cmpeq_epi32(x[k], vblank));
+        f = _mm_or_ps(_mm_and_ps(m, vbig), _mm_andnot_ps(m, f));
+        }
+      _mm_storeu_ps(ptr+4*k, f);
+      }
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("ssse3")))
+static size_t	conv32_ssse3(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz)
+  {
+   __m128i	v, vswap, vblank, vmask16;
+   __m128	f, m, vbs, vbz, vbig, v65536;
+   size_t	i;
+
+  vswap = _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+  vblank = _mm_set1_epi32(blank);
+  vmask16 = _mm_set1_epi32(0xffff);
+  vbs = _mm_set1_ps(bs);
+  vbz = _mm_set1_ps(bz);
+  vbig = _mm_set1_ps((float)-BIG);
+  v65536 = _mm_set1_ps(65536.0f);
+  for (i=0; i+4<=n; i+=4, buf+=16, ptr+=4)
+    {
+    v = _mm_loadu_si128((__m128i *)buf);
+    if (swapflag)
+      v = _mm_shuffle_epi8(v, vswap);
+/*-- Unsigned values are converted in two exact 16-bit halves */
+    f = sgnflag? _mm_cvtepi32_ps(v)
+	: _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 16)),
+		v65536), _mm_cvtepi32_ps(_mm_and_si128(v, vmask16)));
+    f = _mm_add_ps(_mm_mul_ps(f, vbs), vbz);
+    if (blankflag)
+      {
+      m = _mm_castsi128_ps(_mm_cmpeq_epi32(v, vblank));
+      f = _mm_or_ps(_mm_and_ps(m, vbig), _mm_andnot_ps(m, f));
+      }
+    _mm_storeu_ps(ptr, f);
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("ssse3")))
+static size_t	convf32_ssse3(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz)
+  {
+   __m128i	v, vswap, vexp;
+   __m128	f, m, vbs, vbz, vbig;
+   size_t	i;
+
+  vswap = _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+  vexp = _mm_set1_epi32(0x7f800000);
+  vbs = _mm_set1_ps(bs);
+  vbz = _mm_set1_ps(bz);
+  vbig = _mm_set1_ps((float)-BIG);
+  for (i=0; i+4<=n; i+=4, buf+=16, ptr+=4)
+    {
+    v = _mm_loadu_si128((__m128i *)buf);
+    if (swapflag)
+      v = _mm_shuffle_epi8(v, vswap);
+    m = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(v, vexp), vexp));
+    f = _mm_add_ps(_mm_mul_ps(_mm_castsi128_ps(v), vbs), vbz);
+    _mm_storeu_ps(ptr, _mm_or_ps(_mm_and_ps(m, vbig), _mm_andnot_ps(m, f)));
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("ssse3")))
+static size_t	swap_ssse3(char *buf, int nb, size_t n)
+  {
+   __m128i	vswap;
+   size_t	i, nbyte;
+
+  vswap = nb==2? _mm_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14)
+	: (nb==4? _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12)
+		: _mm_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8));
+  nbyte = n*nb;
+  for (i=0; i+16<=nbyte; i+=16)
+    _mm_storeu_si128((__m128i *)(buf+i),
+	_mm_shuffle_epi8(_mm_loadu_si128((__m128i *)(buf+i)), vswap));
+
+  return i/nb;
+  }
+
+
+__attribute__((target("ssse3")))
+static size_t	sum_ssse3(char *buf, size_t nword, unsigned int *hi,
+			unsigned int *lo)
+  {
+   __m128i	v, vswap, vmask16, vhi, vlo;
+   unsigned int	s[4];
+   size_t	i;
+
+/* Big-endian 16-bit halves to host order: MSBs in even, LSBs in odd shorts */
+  vswap = _mm_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14);
+  vmask16 = _mm_set1_epi32(0xffff);
+  vhi = vlo = _mm_setzero_si128();
+  for (i=0; i+4<=nword; i+=4, buf+=16)
+    {
+    v = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)buf), vswap);
+    vhi = _mm_add_epi32(vhi, _mm_and_si128(v, vmask16));
+    vlo = _mm_add_epi32(vlo, _mm_srli_epi32(v, 16));
+    }
+  _mm_storeu_si128((__m128i *)s, vhi);
+  *hi += s[0] + s[1] + s[2] + s[3];
+  _mm_storeu_si128((__m128i *)s, vlo);
+  *lo += s[0] + s[1] + s[2] + s[3];
+
+  return i;
+  }
+
+
+/*-------------------------------- AVX2 kernels ----------------------------*/
+
+__attribute__((target("avx2")))
+static size_t	conv8_avx2(char *buf, PIXTYPE *ptr, size_t n, int sgnflag,
+			int blankflag, int blank, float bs, float bz)
+  {
+   __m256i	x, vblank;
+   __m256	f, vbs, vbz, vbig;
+   __m128i	v;
+   size_t	i;
+
+  vblank = _mm256_set1_epi32(blank);
+  vbs = _mm256_set1_ps(bs);
+  vbz = _mm256_set1_ps(bz);
+  vbig = _mm256_set1_ps((float)-BIG);
+  for (i=0; i+8<=n; i+=8, buf+=8, ptr+=8)
+    {
+    v = _mm_loadl_epi64((__m128i *)buf);
+    x = sgnflag? _mm256_cvtepi8_epi32(v) : _mm256_cvtepu8_epi32(v);
+    f = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(x), vbs), vbz);
+    if (blankflag)
+      f = _mm256_blendv_ps(f, vbig,
+		_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, vblank)));
+    _mm256_storeu_ps(ptr, f);
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("avx2")))
+static size_t	conv16_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz)
+  {
+   __m256i	v, x[2], vswap, vblank;
+   __m256	f, vbs, vbz, vbig;
+   size_t	i;
+   int		k;
+
+  vswap = _mm256_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14,
+			1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14);
+  vblank = _mm256_set1_epi32(blank);
+  vbs = _mm256_set1_ps(bs);
+  vbz = _mm256_set1_ps(bz);
+  vbig = _mm256_set1_ps((float)-BIG);
+  for (i=0; i+16<=n; i+=16, buf+=32, ptr+=16)
+    {
+    v = _mm256_loadu_si256((__m256i *)buf);
+    if (swapflag)
+      v = _mm256_shuffle_epi8(v, vswap);
+    if (sgnflag)
+      {
+      x[0] = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+      x[1] = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+      }
+    else
+      {
+      x[0] = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v));
+      x[1] = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1));
+      }
+    for (k=0; k<2; k++)
+      {
+      f = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(x[k]), vbs), vbz);
+      if (blankflag)
+        f = _mm256_blendv_ps(f, vbig,
+		_mm256_castsi256_ps(_mm256_cmpeq_epi32(x[k], vblank)));
+      _mm256_storeu_ps(ptr+8*k, f);
+      }
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("avx2")))
+static size_t	conv32_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz)
+  {
+   __m256i	v, vswap, vblank, vmask16;
+   __m256	f, vbs, vbz, vbig, v65536;
+   size_t	i;
+
+  vswap = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+			3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+  vblank = _mm256_set1_epi32(blank);
+  vmask16 = _mm256_set1_epi32(0xffff);
+  vbs = _mm256_set1_ps(bs);
+  vbz = _mm256_set1_ps(bz);
+  vbig = _mm256_set1_ps((float)-BIG);
+  v65536 = _mm256_set1_ps(65536.0f);
+  for (i=0; i+8<=n; i+=8, buf+=32, ptr+=8)
+    {
+    v = _mm256_loadu_si256((__m256i *)buf);
+    if (swapflag)
+      v = _mm256_shuffle_epi8(v, vswap);
+    f = sgnflag? _mm256_cvtepi32_ps(v)
+	: _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(
+		_mm256_srli_epi32(v, 16)), v65536),
+		_mm256_cvtepi32_ps(_mm256_and_si256(v, vmask16)));
+    f = _mm256_add_ps(_mm256_mul_ps(f, vbs), vbz);
+    if (blankflag)
+      f = _mm256_blendv_ps(f, vbig,
+		_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, vblank)));
+    _mm256_storeu_ps(ptr, f);
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("avx2")))
+static size_t	convf32_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz)
+  {
+   __m256i	v, vswap, vexp;
+   __m256	f, vbs, vbz, vbig;
+   size_t	i;
+
+  vswap = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+			3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+  vexp = _mm256_set1_epi32(0x7f800000);
+  vbs = _mm256_set1_ps(bs);
+  vbz = _mm256_set1_ps(bz);
+  vbig = _mm256_set1_ps((float)-BIG);
+  for (i=0; i+8<=n; i+=8, buf+=32, ptr+=8)
+    {
+    v = _mm256_loadu_si256((__m256i *)buf);
+    if (swapflag)
+      v = _mm256_shuffle_epi8(v, vswap);
+    f = _mm256_add_ps(_mm256_mul_ps(_mm256_castsi256_ps(v), vbs), vbz);
+    _mm256_storeu_ps(ptr, _mm256_blendv_ps(f, vbig, _mm256_castsi256_ps(
+		_mm256_cmpeq_epi32(_mm256_and_si256(v, vexp), vexp))));
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("avx2")))
+static size_t	convf64_avx2(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz)
+  {
+   __m256i	v, m, vswap, vexp, vpack;
+   __m256d	vbs, vbz;
+   __m128	f, vbig;
+   size_t	i;
+
+  vswap = _mm256_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8,
+			7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8);
+  vexp = _mm256_set1_epi64x(0x7ff0000000000000LL);
+  vpack = _mm256_setr_epi32(0,2,4,6, 1,3,5,7);
+/* Scaling is done in double precision, as in read_body() */
+  vbs = _mm256_set1_pd((double)bs);
+  vbz = _mm256_set1_pd((double)bz);
+  vbig = _mm_set1_ps((float)-BIG);
+  for (i=0; i+4<=n; i+=4, buf+=32, ptr+=4)
+    {
+    v = _mm256_loadu_si256((__m256i *)buf);
+    if (swapflag)
+      v = _mm256_shuffle_epi8(v, vswap);
+    m = _mm256_cmpeq_epi64(_mm256_and_si256(v, vexp), vexp);
+    f = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_mul_pd(_mm256_castsi256_pd(v),
+		vbs), vbz));
+/*-- Pack the 64-bit masks to 32 bits */
+    m = _mm256_permutevar8x32_epi32(m, vpack);
+    _mm_storeu_ps(ptr, _mm_blendv_ps(f, vbig,
+		_mm_castsi128_ps(_mm256_castsi256_si128(m))));
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("avx2")))
+static size_t	swap_avx2(char *buf, int nb, size_t n)
+  {
+   __m256i	vswap;
+   size_t	i, nbyte;
+
+  vswap = nb==2? _mm256_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14,
+			1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14)
+	: (nb==4? _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+			3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12)
+		: _mm256_setr_epi8(7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8,
+			7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8));
+  nbyte = n*nb;
+  for (i=0; i+32<=nbyte; i+=32)
+    _mm256_storeu_si256((__m256i *)(buf+i),
+	_mm256_shuffle_epi8(_mm256_loadu_si256((__m256i *)(buf+i)), vswap));
+
+  return i/nb;
+  }
+
+
+__attribute__((target("avx2")))
+static size_t	sum_avx2(char *buf, size_t nword, unsigned int *hi,
+			unsigned int *lo)
+  {
+   __m256i	v, vswap, vmask16, vhi, vlo;
+   unsigned int	s[8];
+   size_t	i;
+   int		k;
+
+  vswap = _mm256_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14,
+			1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14);
+  vmask16 = _mm256_set1_epi32(0xffff);
+  vhi = vlo = _mm256_setzero_si256();
+  for (i=0; i+8<=nword; i+=8, buf+=32)
+    {
+    v = _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i *)buf), vswap);
+    vhi = _mm256_add_epi32(vhi, _mm256_and_si256(v, vmask16));
+    vlo = _mm256_add_epi32(vlo, _mm256_srli_epi32(v, 16));
+    }
+  _mm256_storeu_si256((__m256i *)s, vhi);
+  for (k=0; k<8; k++)
+    *hi += s[k];
+  _mm256_storeu_si256((__m256i *)s, vlo);
+  for (k=0; k<8; k++)
+    *lo += s[k];
+
+  return i;
+  }
+
+
+/*------------------------------- AVX-512 kernels --------------------------*/
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t	conv16_avx512(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz)
+  {
+   __m512i	v, x[2], vswap, vblank;
+   __m512	f, vbs, vbz, vbig;
+   size_t	i;
+   int		k;
+
+  vswap = _mm512_broadcast_i32x4(
+		_mm_setr_epi8(1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14));
+  vblank = _mm512_set1_epi32(blank);
+  vbs = _mm512_set1_ps(bs);
+  vbz = _mm512_set1_ps(bz);
+  vbig = _mm512_set1_ps((float)-BIG);
+  for (i=0; i+32<=n; i+=32, buf+=64, ptr+=32)
+    {
+    v = _mm512_loadu_si512((void *)buf);
+    if (swapflag)
+      v = _mm512_shuffle_epi8(v, vswap);
+    if (sgnflag)
+      {
+      x[0] = _mm512_cvtepi16_epi32(_mm512_castsi512_si256(v));
+      x[1] = _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(v, 1));
+      }
+    else
+      {
+      x[0] = _mm512_cvtepu16_epi32(_mm512_castsi512_si256(v));
+      x[1] = _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(v, 1));
+      }
+    for (k=0; k<2; k++)
+      {
+      f = SIMD512_MADD(_mm512_cvtepi32_ps(x[k]), vbs, vbz);
+      if (blankflag)
+        f = _mm512_mask_blend_ps(_mm512_cmpeq_epi32_mask(x[k], vblank),
+		f, vbig);
+      _mm512_storeu_ps(ptr+16*k, f);
+      }
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t	conv32_avx512(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			int sgnflag, int blankflag, int blank, float bs,
+			float bz)
+  {
+   __m512i	v, vswap, vblank;
+   __m512	f, vbs, vbz, vbig;
+   size_t	i;
+
+  vswap = _mm512_broadcast_i32x4(
+		_mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12));
+  vblank = _mm512_set1_epi32(blank);
+  vbs = _mm512_set1_ps(bs);
+  vbz = _mm512_set1_ps(bz);
+  vbig = _mm512_set1_ps((float)-BIG);
+  for (i=0; i+16<=n; i+=16, buf+=64, ptr+=16)
+    {
+    v = _mm512_loadu_si512((void *)buf);
+    if (swapflag)
+      v = _mm512_shuffle_epi8(v, vswap);
+    f = sgnflag? _mm512_cvtepi32_ps(v) : _mm512_cvtepu32_ps(v);
+    f = SIMD512_MADD(f, vbs, vbz);
+    if (blankflag)
+      f = _mm512_mask_blend_ps(_mm512_cmpeq_epi32_mask(v, vblank), f, vbig);
+    _mm512_storeu_ps(ptr, f);
+    }
+
+  return i;
+  }
+
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t	convf32_avx512(char *buf, PIXTYPE *ptr, size_t n, int swapflag,
+			float bs, float bz)
+  {
+   __m512i	v, vswap, vexp;
+   __m512	f, vbs, vbz, vbig;
+   size_t	i;
+
+  vswap = _mm512_broadcast_i32x4(
+		_mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12));
+  vexp = _mm512_set1_epi32(0x7f800000);
+  vbs = _mm512_set1_ps(bs);
+  vbz = _mm512_set1_ps(bz);
+  vbig = _mm512_set1_ps((float)-BIG);
+  for (i=0; i+16<=n; i+=16, buf+=64, ptr+=16)
+    {
+    v = _mm512_loadu_si512((void *)buf);
+    if (swapflag)
+      v = _mm512_shuffle_epi8(v, vswap);
+    f = SIMD512_MADD(_mm512_castsi512_ps(v), vbs, vbz);
+    _mm512_storeu_ps(ptr, _mm512_mask_blend_ps(
+	_mm512_cmpeq_epi32_mask(_mm512_and_si512(v, vexp), vexp), f, vbig));
+    }
+
+  return i;
+  }
+
+#endif
+
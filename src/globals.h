@@ -22,18 +22,20 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		13/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
 #include	"types.h"
 
 /*----------------------- miscellaneous variables ---------------------------*/
-char		gstr[MAXCHAR];
+extern THREAD_LOCAL char	gstr[MAXCHAR];
 
 /*------------------------------- functions ---------------------------------*/
 extern double	counter_seconds();
 
-extern void	makeit(void),
+extern int	makeit(void);
+
+extern void	set_datetime(char *sdate, char *stime),
 		write_error(char *msg1, char *msg2);
 
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -40,44 +40,95 @@
 #include "datamem.h"
 #include "field.h"
 #include "image.h"
+#include "mosaic.h"
 #include "prefs.h"
+#include "progress.h"
+#include "quantile.h"
 #include "fits/fitscat.h"
 #include "tiff.h"
+#include "quicklook.h"
+#include "raster.h"
+#include "tiletree.h"
+#include "timing.h"
 #ifdef USE_THREADS
 #include "threads.h"
 
+/* Multithreading context of a single conversion */
+typedef struct structconvthread
+  {
+  pthread_t		*thread,		/* Conversion threads */
+			wthread,		/* Writing thread */
+			master;			/* Thread running conversion */
+  struct structconvproc	*proc;			/* Conversion thread arguments */
+  pthread_mutex_t	mutex;			/* Buffer line counter lock */
+  threads_gate_t	*startgate, *stopgate,	/* Conversion thread gates */
+			*startwgate, *stopwgate;/* Writing thread gates */
+  fieldstruct		**field;		/* Input fields */
+  imagestruct		*image;			/* Output image */
+  size_t		imoffset;		/* Buffer offset of current line */
+  float			**data,			/* Input data buffers */
+			**fsbuf,		/* Per-thread scratch buffers */
+			*touchbuf;		/* Buffer to be first-touched */
+  unsigned char		*pix;			/* Output pixel buffer */
+  int			nbuflines,		/* Number of lines in buffer */
+			bufline,		/* Next line to be processed */
+			width, nchan, bypp, fflag,
+			format_type,		/* Output format */
+			nproc,			/* Number of conversion threads */
+			pinbase,		/* First core of pinned threads */
+			staticflag,		/* Static line assignment? */
+			wbusyflag,		/* Writing thread busy? */
+			werrflag,		/* Writing error flag */
+			endflag;		/* Shutdown flag */
+  struct structconvthread *prev;		/* Previous active context */
+  }	convthreadstruct;
+
+typedef struct structconvproc
+  {
+  convthreadstruct	*conv;			/* Parent context */
+  int			proc;			/* Thread index */
+  }	convprocstruct;
+
    void			pthread_cancel_threads(void);
-   static void		*pthread_data_to_pix(void *arg),
+   static convthreadstruct *init_convthreads(fieldstruct **field,
+				imagestruct *image, float **data, int nchan,
+				int bypp, void *(*writer)(void *arg));
+   static void		end_convthreads(convthreadstruct *conv),
+			start_convwriter(convthreadstruct *conv),
+			sync_convwriter(convthreadstruct *conv),
+			touch_convthreads(convthreadstruct *conv, float *buf,
+				int width, int nlines),
+			*pthread_data_to_pix(void *arg),
 			*pthread_write_lines(void *arg),
 			*pthread_write_tiles(void *arg);
-   pthread_t		*thread, tthread;
-   pthread_mutex_t	tiffmutex;
-   threads_gate_t	*pthread_startgate, *pthread_stopgate,
-			*pthread_startwgate, *pthread_stopwgate;
-
-   fieldstruct		**pthread_field;
-   imagestruct		*pthread_image;
-   size_t		pthread_imoffset;
-   float		**pthread_data,
-			**pthread_fsbuf;
-   unsigned char	*pthread_pix;
-   int			*proc,
-			pthread_nbuflines, pthread_bufline, pthread_width,
-			pthread_nchan, pthread_bypp, pthread_fflag,
-			pthread_nproc, pthread_endflag;
+   static convthreadstruct *convthread_active = NULL;
+   static pthread_mutex_t convthread_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+#else
+   static void		write_pyramidtiles(imagestruct *image, char *filename);
 #endif
 
+/* Output image of the conversion run by the current thread */
+static THREAD_LOCAL imagestruct	*image_active;
+static THREAD_LOCAL int		image_activetype;
+
+PROBE_REGION(probe_singlebin, "image_convert_single:bin");
+PROBE_REGION(probe_pyramidbin, "image_convert_pyramid:bin");
+PROBE_REGION(probe_datatopix, "data_to_pix");
+PROBE_REGION(probe_rastertotiles, "raster_to_tiles");
+PROBE_REGION(probe_imastats, "make_imastats:select");
+
 /****** image_convert_single **************************************************
 PROTO	void image_convert_single(char *filename, fieldstruct **field,int nchan)
-PURPOSE	Read FITS files, rebin, and convert them to TIFF format.
+PURPOSE	Read FITS files, rebin, and convert them to TIFF, JPEG or PNG format,
+	or to an in-memory raster.
 INPUT	Output filename,
 	array of pointers to the tabstructs of input FITS extensions,
 	number of input FITS files.
 OUTPUT	-.
 NOTES	Uses the global preferences.
 AUTHOR	E. Bertin (IAP)
-VERSION	07/06/2016
+VERSION	19/10/2026
  ***/
 void	image_convert_single(char *filename, fieldstruct **field, int nchan)
   {
@@ -95,12 +146,11 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
    PIXTYPE		*ibuf,*ibuft,
 			fpix;
    long			offset;
-   size_t		imoffset;
    int			a, x,y, bx,by, width,height, fwidth,fheight,
 			binsizex0,binsizey0,binsizexmax,binsizeymax,
 			binsizex,binsizey,
-			owidth, my, flipxflag, flipyflag, dyflag, dy,
-			nlines, ntlines;
+			owidth, my,ry, flipxflag, flipyflag, dyflag, dy,
+			nlines, ntlines, rowseekflag;
 
   QMALLOC(cat, catstruct *, nchan);
   QMALLOC(tab, tabstruct *, nchan);
@@ -120,20 +170,20 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
       error(EXIT_FAILURE, "*Error*: not a 2D image in ", cat[a]->filename);
     if (fwidth)
       {
-      if (tab[a]->naxisn[0] != fwidth)
+      if (field[a]->size[0] != fwidth)
         error(EXIT_FAILURE, "*Error*: Image width doesn't match in ",
 		cat[a]->filename);
       }
     else
-      fwidth = tab[a]->naxisn[0];
+      fwidth = field[a]->size[0];
     if (fheight)
       {
-      if (tab[a]->naxisn[1] != fheight)
+      if (field[a]->size[1] != fheight)
         error(EXIT_FAILURE, "*Error*: Image height doesn't match in ",
 		cat[a]->filename);
       }
     else
-      fheight = tab[a]->naxisn[1];
+      fheight = field[a]->size[1];
     minvalue[a] = field[a]->min;
     maxvalue[a] = field[a]->max;
     }
@@ -172,14 +222,26 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
 		prefs.copyright,
 		prefs.header_flag? (description
 			= fitshead_to_desc(destab->headbuf, destab->headnblock,
-			width,height, binsizex0, binsizey0,
-			flipxflag, flipyflag))
+			width,height, field[0]->origin[0], field[0]->origin[1],
+			binsizex0, binsizey0, flipxflag, flipyflag))
 			: prefs.description);
       break;
+    case FORMAT_JPEG:
+    case FORMAT_PNG:
+      image = create_quicklook(filename,
+		prefs.format_type2==FORMAT_JPEG? QUICKLOOK_JPEG : QUICKLOOK_PNG,
+		width, height, nchan, prefs.bpp, prefs.compress_quality,
+		prefs.nthreads);
+      break;
+    case FORMAT_RASTER:
+      image = create_raster(filename, width, height, nchan, prefs.bpp);
+      break;
    default:
      image = NULL; /* To avoid gcc -Wall warnings */
      error(EXIT_FAILURE, "This should not happen!", "");
    }
+  image_active = image;
+  image_activetype = prefs.format_type2;
 
   if (!(binsizexmax = fwidth%binsizex0))
     binsizexmax = binsizex0;
@@ -189,65 +251,43 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
   nlines = image->nlines;
   for (a=0; a<nchan; a++)
     {
-    QMALLOC(fbuf[a], float, (size_t)width*nlines);
+    QSCRATCH(fbuf[a], float, (size_t)width*nlines);
     }
 
 #ifdef USE_THREADS
-   static pthread_attr_t	pthread_attr;
-   int				p, nproc;
-
-/* Number of active threads */
-  nproc = prefs.nthreads;
-  if (nproc>1)
-    nproc--;		/* Leave one proc free for non-blocking TIFF I/O's */
-  pthread_nproc = nproc;
-/* Set up multi-threading stuff */
-  QPTHREAD_MUTEX_INIT(&tiffmutex, NULL);
-  QPTHREAD_ATTR_INIT(&pthread_attr);
-  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
-  pthread_startgate = threads_gate_init(nproc+1, NULL);
-  pthread_startwgate = threads_gate_init(2, NULL);
-  pthread_stopgate = threads_gate_init(nproc+1, NULL);
-  pthread_stopwgate = threads_gate_init(2, NULL);
-  QMALLOC(proc, int, nproc);
-  QMALLOC(pthread_fsbuf, float *, nproc);
-  QMALLOC(thread, pthread_t, nproc);
-  QMALLOC(fsbuf, float, (size_t)width*nproc);
-  QMALLOC(extrapix, unsigned char, width*nlines*image->bypp*image->nchan);
-  pthread_field = field;
-  pthread_image = image;
-  pthread_data = fbuf;
-  pthread_pix = extrapix;
-  pthread_width = width;
-  pthread_nchan = nchan;
-  pthread_bypp = image->bypp;
-  pthread_fflag = image->fflag;
-  pthread_endflag = 0;
-/* Install the signal-catching routines for temporary file cleanup */
-  install_cleanup(pthread_cancel_threads);
-/* Start the data conversion / tiling threads */
-  for (p=0; p<nproc; p++)
-    {
-    proc[p] = p;
-    pthread_fsbuf[p] = &fsbuf[p*(size_t)pthread_width];
-    QPTHREAD_CREATE(&thread[p], &pthread_attr, &pthread_data_to_pix, &proc[p]);
-    }
-  p = 0;
-  QPTHREAD_CREATE(&tthread, &pthread_attr, &pthread_write_lines, &p);
+   convthreadstruct	*conv;
+   int			p;
+
+/* Set up multi-threading stuff and start the conversion / writing threads */
+  conv = init_convthreads(field, image, fbuf, nchan, image->bypp,
+	&pthread_write_lines);
+  QSCRATCH(fsbuf, float, (size_t)width*conv->nproc);
+  QSCRATCH(extrapix, unsigned char,
+	(size_t)width*nlines*image->bypp*image->nchan);
+  conv->pix = extrapix;
+  conv->width = width;
+  for (p=0; p<conv->nproc; p++)
+    conv->fsbuf[p] = &fsbuf[p*(size_t)width];
+/* Let the workers place the pages of the input buffers (NUMA first touch) */
+  if (conv->staticflag)
+    for (a=0; a<nchan; a++)
+      touch_convthreads(conv, fbuf[a], width, nlines);
 #else
-  QMALLOC(fsbuf, float, (size_t)width*nlines);
+  QSCRATCH(fsbuf, float, (size_t)width*nlines);
 /* Install the signal-catching routines for temporary file cleanup */
   install_cleanup(NULL);
 #endif
 
 /* Position the input file(s) at the beginning of image */
   for (a=0; a<nchan; a++)
-    QFSEEK(cat[a]->file, tab[a]->bodypos, SEEK_SET, cat[a]->filename);
+    seek_fieldrow(field[a], 0);
 
 /* Prepare the output file and position the pointer at the last line */
 /* We are going reverse (1st pixel is at top in TIFF, and at bottom in FITS) */
 
 /* OK now we are ready to go! */
+  set_progresstotal((double)width*height);
+  set_progressstage("converting", -1, (double)width*height);
   my = fheight;
   ntlines = nlines;
   for (y=0; y<height; y++)
@@ -263,7 +303,7 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
       if (ntlines > height - y)
         ntlines = height - y;
 #ifdef USE_THREADS
-      memset(fsbuf, 0, (size_t)width*nproc*sizeof(float));
+      memset(fsbuf, 0, (size_t)width*conv->nproc*sizeof(float));
 #else
       memset(fsbuf, 0, (size_t)width*nlines*sizeof(float));
 #endif
@@ -271,18 +311,21 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
     dyflag = (dy == ntlines - 1);
     for (a=0; a<nchan; a++)
       {
+      start_timing(TIMING_BIN);
+      PROBE_START(probe_singlebin, clock);
       fbuft0 = fbuf[a] + dy*(size_t)width;
-      if (!flipyflag)
-        {
-        imoffset = tab[a]->bodypos + (size_t)fwidth * my * tab[a]->bytepix;
-        QFSEEK(cat[a]->file, imoffset, SEEK_SET, cat[a]->filename);
-        }
+      ry = flipyflag? y*binsizey0 : my;
+      rowseekflag = (fwidth < tab[a]->naxisn[0]);
+      if (!flipyflag || rowseekflag)
+        seek_fieldrow(field[a], ry);
       if (!dy)
         memset(fbuft0, 0, (size_t)width * ntlines * sizeof(float));
 /*---- Bin the pixels */
       for (by=binsizey; by--;)
         {
-        read_body(tab[a], ibuf, fwidth);
+        if (rowseekflag && by<binsizey-1)
+          seek_fieldrow(field[a], ry + binsizey-1-by);
+        read_fieldrow(field[a], ibuf);
         ibuft = ibuf;
         if (flipxflag)
           {
@@ -309,29 +352,44 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
 	    }
           }
         }
+      PROBE_STOP(probe_singlebin, clock, width);
+      stop_timing(TIMING_BIN, (double)width, 0.0);
       }
+    add_progress((double)width, (double)width);
     if (dyflag)
       {
 #ifdef USE_THREADS
-      pthread_bufline = 0;
-      pthread_nbuflines = ntlines;
-      threads_gate_sync(pthread_startgate);
+      conv->bufline = 0;
+      conv->nbuflines = ntlines;
+      threads_gate_sync(conv->startgate);
 /*---- ( Slave threads process the current buffer data here ) */
-      threads_gate_sync(pthread_stopgate);
+      threads_gate_sync(conv->stopgate);
       if (y != ntlines-1)
-        threads_gate_sync(pthread_stopwgate);
+        sync_convwriter(conv);
       image->y = y-ntlines+1;
       image->nlines = ntlines;
       memcpy(image->buf, extrapix, (size_t)width*ntlines*image->bypp*nchan);
-      threads_gate_sync(pthread_startwgate);
+      start_convwriter(conv);
 /*---- ( Writing thread starts processing the current buffer data here ) */
 #else
+      image->y = y-ntlines+1;
+      image->nlines = ntlines;
       data_to_pix(field, fbuf, 0, image->buf, (size_t)width*ntlines,
 		nchan, image->bypp, image->fflag, fsbuf);
       switch(prefs.format_type2)
         {
         case FORMAT_TIFF:
-          write_tifflines(image);
+          if (write_tifflines(image) != RETURN_OK)
+            error(EXIT_FAILURE, "*Error*: cannot write ", filename);
+          break;
+        case FORMAT_JPEG:
+        case FORMAT_PNG:
+          if (write_quicklooklines(image) != RETURN_OK)
+            error(EXIT_FAILURE, "*Error*: cannot encode ", filename);
+          break;
+        case FORMAT_RASTER:
+          if (write_rasterlines(image) != RETURN_OK)
+            error(EXIT_FAILURE, "*Error*: cannot copy lines to ", filename);
           break;
         default:
           error(EXIT_FAILURE, "This should not happen!", "");
@@ -341,34 +399,26 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
     }
 
 #ifdef USE_THREADS
-    threads_gate_sync(pthread_stopwgate);
+  sync_convwriter(conv);
 
 /* Clean up multi-threading stuff */
-  pthread_endflag = 1;
-/* (Re-)activate existing threads... */
-  threads_gate_sync(pthread_startgate);
-  threads_gate_sync(pthread_startwgate);
-/* ... and shutdown all threads */
-  for (p=0; p<nproc; p++)
-    QPTHREAD_JOIN(thread[p], NULL);
-  QPTHREAD_JOIN(tthread, NULL);
-  threads_gate_end(pthread_startgate);
-  threads_gate_end(pthread_startwgate);
-  threads_gate_end(pthread_stopgate);
-  threads_gate_end(pthread_stopwgate);
-  QPTHREAD_MUTEX_DESTROY(&tiffmutex);
-  QPTHREAD_ATTR_DESTROY(&pthread_attr);
-  free(pthread_fsbuf);
-  free(extrapix);
-  free(proc);
-  free(thread);
+  end_convthreads(conv);
+  free_scratch(extrapix);
 #endif
 
+  image_active = NULL;
   switch(prefs.format_type2)
     {
     case FORMAT_TIFF:
       end_tiff(image);
       break;
+    case FORMAT_JPEG:
+    case FORMAT_PNG:
+      end_quicklook(image);
+      break;
+    case FORMAT_RASTER:
+      end_raster(image);
+      break;
     default:
       error(EXIT_FAILURE, "This should not happen!", "");
     }
@@ -376,8 +426,8 @@ void	image_convert_single(char *filename, fieldstruct **field, int nchan)
 /* Close file and free memory */
   free(ibuf);
   for (a=0; a<nchan; a++)
-    free(fbuf[a]);
-  free(fsbuf);
+    free_scratch(fbuf[a]);
+  free_scratch(fsbuf);
   free(cat);
   free(tab);
   if (prefs.header_flag) {
@@ -396,9 +446,15 @@ INPUT	File name,
 	array of pointers to the tabstructs of input FITS extensions,
 	number of input FITS files.
 OUTPUT	Number of pyramid levels.
-NOTES	Uses the global preferences.
+NOTES	Uses the global preferences. Tile trees (DeepZoom, XYZ, Zarr) round
+	level sizes up instead of down. With 16-bit PYRAMID_STORAGE, all the
+	levels are binned from float rows in a single pass, with the same
+	arithmetic as level after level; the first level is tiled on the fly
+	and only the converted pixels of the others are stored, so that
+	integer output is identical. Floating-point output pixels of levels
+	below the first are stored as 16-bit values.
 AUTHOR	E. Bertin (IAP)
-VERSION	07/06/2016
+VERSION	19/10/2026
  ***/
 int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
   {
@@ -408,22 +464,23 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
    tabstruct		**tab,
 			*destab;
    float		*data[MAXFILE],
-			*datat,*datatt, *datao, *fbuf, *fbuft,*fbuftt, *fsbuf,
-			fpix, fac;
-   double		*minvalue, *maxvalue;
-   size_t		imoffset;
-   size_t		ndata,ndatao;
+			**lbuf, *datat,*datatt, *fbuf, *fbuft,*fbuftt, *fsbuf,
+			fpix, fac, zero, range;
+   datastorestruct	*store[MAXFILE], **lstore, *storeo;
+   double		*minvalue, *maxvalue, npixout, npixbin;
    unsigned char	*pix;
-   char			keyword[80], *swapname[MAXFILE],
-			*swapnameo, *description;
-   int			a,i,l, w,h, x,y,my,ny,bx,by, nlevels, width,height,
-			fwidth,fheight, binsizex0,binsizey0, binsizex,binsizey,
-			binsizexmax,binsizeymax, minsizex, minsizey, binx,biny,
-			tilesize,tilesizey, flipxflag, flipyflag, bypp;
-
-  swapnameo = NULL;	/* to avoid gcc -Wall warnings */
-  ndatao = ndata = 0;
-  fbuft = datao = NULL;
+   char			keyword[80], *description;
+   size_t		linesize;
+   int			*lwidth, *lheight, *lbinxmax, *lbinymax, *lny,
+			a,j,k,l,r, w,h, x,y,my,ry,ro,ny,ny0,ty,bx,by, nlevels,
+			width,height, fwidth,fheight, binsizex0,binsizey0,
+			binsizex,binsizey, binsizexmax,binsizeymax, binx,biny,
+			tilesize,tilesizey, nlines, flipxflag, flipyflag, bypp,
+			ceilflag, rowseekflag, datatype, packflag;
+
+  storeo = NULL;	/* to avoid gcc -Wall warnings */
+  fbuft = NULL;
+  ro = 0;
   image = NULL;
   description = NULL;
   QMALLOC(cat, catstruct *, nchan);
@@ -435,7 +492,6 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
 
   for (a=0; a<nchan; a++)
     {
-    swapname[a] = NULL;
     if (!(cat[a]=field[a]->cat))
       error(EXIT_FAILURE, "*Internal error* with ", cat[a]->filename);
     if (!(tab[a]=field[a]->tab))
@@ -444,21 +500,21 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
       error(EXIT_FAILURE, "*Error*: not a 2D image in ", cat[a]->filename);
     if (fwidth)
       {
-      if (tab[a]->naxisn[0] != fwidth)
+      if (field[a]->size[0] != fwidth)
         error(EXIT_FAILURE, "*Error*: Image width doesn't match in ",
 		cat[a]->filename);
       }
     else
-      fwidth = tab[a]->naxisn[0];
+      fwidth = field[a]->size[0];
     if (fheight)
       {
-      if (tab[a]->naxisn[1] != fheight)
+      if (field[a]->size[1] != fheight)
         error(EXIT_FAILURE, "*Error*: Image height doesn't match in ",
 		cat[a]->filename);
       }
     else
-      fheight = tab[a]->naxisn[1];
-    QFSEEK(cat[a]->file, tab[a]->bodypos, SEEK_SET, cat[a]->filename);
+      fheight = field[a]->size[1];
+    seek_fieldrow(field[a], 0);
     minvalue[a] = field[a]->min;
     maxvalue[a] = field[a]->max;
     }
@@ -477,76 +533,125 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
     }
   }
 
-  set_maxdataram(prefs.mem_max);
-  set_maxdatavram(prefs.vmem_max);
-  set_dataswapdir(prefs.swapdir_name);
-
-
 /* Compute the number of pyramid levels */
   flipxflag = (prefs.flip_type == FLIP_X) || (prefs.flip_type == FLIP_XY);
   flipyflag = (prefs.flip_type == FLIP_Y) || (prefs.flip_type == FLIP_XY);
   binsizex0 = prefs.bin_size[0];
-  minsizex = prefs.min_size[0];
-  minsizey = prefs.min_size[1];
   tilesize = prefs.tile_size;
   w = width = binsizex0>1? (fwidth+binsizex0-1)/binsizex0 : fwidth;
   binsizey0 = prefs.bin_size[1];
   h = height = binsizey0>1? (fheight+binsizey0-1)/binsizey0 : fheight;
   QMALLOC(fbuf, PIXTYPE, fwidth);
   binx = biny = 1;
+  nlevels = pyramid_nlevels(w, h) + 1;
+  ceilflag = 0;
 
-  image = create_tiff(filename, width, height, nchan, prefs.bpp, tilesize,
-	minvalue, maxvalue, prefs.bigtiff_type, prefs.compress_type, prefs.compress_quality,
-	prefs.copyright,
-	prefs.header_flag? (description
-		= fitshead_to_desc(destab->headbuf, destab->headnblock,
-		width,height, binx *= binsizex0, biny *= binsizey0,
+  switch(prefs.format_type2)
+    {
+    case FORMAT_TIFF_PYRAMID:
+      image = create_tiff(filename, width, height, nchan, prefs.bpp, tilesize,
+		minvalue, maxvalue, prefs.bigtiff_type, prefs.compress_type,
+		prefs.compress_quality, prefs.copyright,
+		prefs.header_flag? (description
+			= fitshead_to_desc(destab->headbuf, destab->headnblock,
+			width,height, field[0]->origin[0], field[0]->origin[1],
+			binx *= binsizex0, biny *= binsizey0,
 			flipxflag, flipyflag))
 		: prefs.description);
+      break;
+    case FORMAT_DEEPZOOM:
+    case FORMAT_XYZ:
+    case FORMAT_ZARR:
+      image = create_tiletree(filename,
+		prefs.format_type2==FORMAT_DEEPZOOM? TILETREE_DEEPZOOM
+		: (prefs.format_type2==FORMAT_XYZ? TILETREE_XYZ
+		: TILETREE_ZARR),
+		width, height, nchan, prefs.bpp, tilesize, nlevels-1,
+		prefs.tilefile_type, prefs.compress_quality, prefs.nthreads);
+      ceilflag = 1;
+      break;
+    default:
+      error(EXIT_FAILURE, "This should not happen!", "");
+    }
+  image_active = image;
+  image_activetype = prefs.format_type2;
 
   bypp = image->bypp;
 
-#ifdef USE_THREADS
-   static pthread_attr_t	pthread_attr;
-   int				p, nproc;
-/* Number of active threads */
-  nproc = prefs.nthreads;
-  if (nproc>1)
-    nproc--;		/* Leave one proc free for non-blocking TIFF I/O's */
-  pthread_nproc = nproc;
-/* Set up multi-threading stuff */
-  QPTHREAD_MUTEX_INIT(&tiffmutex, NULL);
-  QPTHREAD_ATTR_INIT(&pthread_attr);
-  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
-  pthread_startgate = threads_gate_init(nproc+1, NULL);
-  pthread_startwgate = threads_gate_init(2, NULL);
-  pthread_stopgate = threads_gate_init(nproc+1, NULL);
-  pthread_stopwgate = threads_gate_init(2, NULL);
-  QMALLOC(proc, int, nproc);
-  QMALLOC(pthread_fsbuf, float *, nproc);
-  QMALLOC(thread, pthread_t, nproc);
-  pthread_field = field;
-  pthread_image = image;
-  pthread_data = data;
-  pthread_nchan = nchan;
-  pthread_bypp = bypp;
-  pthread_fflag = image->fflag;
-  pthread_endflag = 0;
-/* Install the signal-catching routines for temporary file cleanup */
-  install_cleanup(pthread_cancel_threads);
-/* Start the data conversion / tiling threads */
-  for (p=0; p<nproc; p++)
+/* Total number of output pixels, for progress reports */
+  npixout = 0.0;
+  for (l=1; l<nlevels; l++)
     {
-    proc[p] = p;
-    QPTHREAD_CREATE(&thread[p], &pthread_attr, &pthread_data_to_pix, &proc[p]);
+    npixout += (double)w*h;
+    w = ceilflag? (w+1)/2 : w/2;
+    h = ceilflag? (h+1)/2 : h/2;
     }
-  p = 0;
-  QPTHREAD_CREATE(&tthread, &pthread_attr, &pthread_write_tiles, &p);
+  set_progresstotal(npixout);
+
+/* Storage of the pyramid levels */
+  switch(prefs.pyrstorage_type)
+    {
+    case PYRSTORAGE_FLOAT16:
+      datatype = DATA_FLOAT16;
+      break;
+    case PYRSTORAGE_UINT16:
+      datatype = DATA_UINT16;
+      break;
+    default:
+      datatype = DATA_FLOAT32;
+    }
+  packflag = (datatype != DATA_FLOAT32);
+  lbuf = NULL;
+  lstore = NULL;
+  lwidth = lheight = lbinxmax = lbinymax = lny = NULL;
+  zero = range = 0.0;
+  if (packflag)
+    {
+/*-- 16-bit storage: all levels are binned in a single pass (see below) */
+    QCALLOC(lbuf, float *, nlevels);
+    QCALLOC(lstore, datastorestruct *, nlevels);
+    QMALLOC(lwidth, int, nlevels);
+    QMALLOC(lheight, int, nlevels);
+    QMALLOC(lbinxmax, int, nlevels);
+    QMALLOC(lbinymax, int, nlevels);
+    QCALLOC(lny, int, nlevels);
+    lwidth[1] = width;
+    lheight[1] = height;
+    for (l=2; l<nlevels; l++)
+      {
+      w = lwidth[l-1];
+      h = lheight[l-1];
+      lwidth[l] = ceilflag? (w+1)/2 : w/2;
+      lheight[l] = ceilflag? (h+1)/2 : h/2;
+      lbinxmax[l] = (ceilflag && (w&1))? 1 : 2;
+      lbinymax[l] = (ceilflag && (h&1))? 1 : 2;
+      }
+/*-- Normalization of stored floating-point output pixels */
+    zero = field[0]->min;
+    range = field[0]->max;
+    for (a=1; a<nchan; a++)
+      {
+      if (field[a]->min < zero)
+        zero = field[a]->min;
+      if (field[a]->max > range)
+        range = field[a]->max;
+      }
+    range -= zero;
+    }
+
+#ifdef USE_THREADS
+   convthreadstruct	*conv;
+   int			p, tgroup;
+
+/* Set up multi-threading stuff and start the conversion / tiling threads */
+  conv = init_convthreads(field, image, data, nchan, bypp,
+	&pthread_write_tiles);
+/* Rows of tiles are converted in lines of tgroup image rows */
+  for (tgroup=8; --tgroup>1 && tilesize%tgroup;);
 #else
   install_cleanup(NULL);
 #endif
 
-  for (nlevels = 1; w>=minsizex || h>=minsizey ; nlevels++, w/=2, h/=2);
   for (l=1; l<nlevels; l++)
     {
     if (l>1)
@@ -554,21 +659,44 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
       binsizexmax = binsizeymax = binsizex0 = binsizey0 = 2;
       fwidth = width;
       fheight = height;
-      width = fwidth/binsizex0;
-      height = fheight/binsizey0;
-      ndatao = ndata;
+      if (ceilflag)
+        {
+/*------ Round level sizes up: odd edges are binned by 1 */
+        width = (fwidth+1)/binsizex0;
+        height = (fheight+1)/binsizey0;
+        binsizexmax = (fwidth&1)? 1 : 2;
+        binsizeymax = (fheight&1)? 1 : 2;
+        }
+      else
+        {
+        width = fwidth/binsizex0;
+        height = fheight/binsizey0;
+        }
 
-      if (prefs.header_flag) {
-        free(description);
-      }
-      create_tiffdir(image, width, height, nchan, prefs.bpp, tilesize,
+      switch(prefs.format_type2)
+        {
+        case FORMAT_TIFF_PYRAMID:
+          if (prefs.header_flag) {
+            free(description);
+          }
+          create_tiffdir(image, width, height, nchan, prefs.bpp, tilesize,
 		minvalue, maxvalue, prefs.compress_type, prefs.compress_quality,
 		prefs.copyright,
 		prefs.header_flag? (description
 			= fitshead_to_desc(destab->headbuf, destab->headnblock,
-			width,height, binx *= binsizex0, biny *= binsizey0,
+			width,height, field[0]->origin[0], field[0]->origin[1],
+			binx *= binsizex0, biny *= binsizey0,
 			flipxflag, flipyflag))
 			: prefs.description);
+          break;
+        case FORMAT_DEEPZOOM:
+        case FORMAT_XYZ:
+        case FORMAT_ZARR:
+          create_tiletreelevel(image, width, height);
+          break;
+        default:
+          error(EXIT_FAILURE, "This should not happen!", "");
+        }
       }
     else
       {
@@ -581,20 +709,250 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
       height = binsizey0>1? (fheight+binsizey0-1)/binsizey0 : fheight;
       }
 
-    ndata = (size_t)width*(size_t)height;
+    if (packflag && l==1)
+      {
+/*---- Single pass: every level is binned from the float rows of the level
+	above, and only converted pixels are stored. Level 1 is never stored */
+      linesize = (size_t)width*nchan*bypp;
+      QSCRATCH(pix, unsigned char, tilesize*linesize);
+#ifdef USE_THREADS
+      conv->pix = pix;
+      QSCRATCH(fsbuf, float, conv->nproc*(size_t)width*tgroup);
+      for (p=0; p<conv->nproc; p++)
+        conv->fsbuf[p] = &fsbuf[p*(size_t)width*tgroup];
+#else
+      QSCRATCH(fsbuf, float, tilesize*(size_t)width);
+#endif
+      npixbin = 0.0;
+      for (k=1; k<nlevels; k++)
+        {
+        QSCRATCH(lbuf[k], float, tilesize*(size_t)lwidth[k]*nchan);
+        npixbin += (double)lwidth[k]*lheight[k]*nchan;
+/*------ Rows of output pixels, as 32-bit words or as 16-bit floats */
+        if (k>1 && !(lstore[k] = new_datastore(prefs.arena,
+		(lwidth[k]*(size_t)nchan*bypp+3)/4, lheight[k], tilesize,
+		image->fflag? datatype : DATA_FLOAT32, zero, range)))
+          error(EXIT_FAILURE, "*Error*: not enough (virtual) memory for ",
+		"pyramid levels");
+        }
+      set_progressstage("reducing", -1, npixbin);
+      my = fheight;
+      for (y=0; y<height; y++)
+        {
+        if (!y || !((y+1)%100))
+        NPRINTF(OUTPUT,
+		"\33[1M> Pyramid levels %2d-%-2d: Reducing line %7d/%-7d\n\33[1A",
+		1, nlevels-1, y+1, height);
+        binsizey = ((y+1)<height? binsizey0:binsizeymax);
+        my -= binsizey;
+        ry = flipyflag? y*binsizey0 : my;
+        start_timing(TIMING_BIN);
+        PROBE_START(probe_pyramidbin, clock);
+        for (a=0; a<nchan; a++)
+          {
+          rowseekflag = (fwidth < tab[a]->naxisn[0]);
+          if (!flipyflag || rowseekflag)
+            seek_fieldrow(field[a], ry);
+          datat = lbuf[1] + ((size_t)a*tilesize + y%tilesize)*width;
+          memset(datat, 0, (size_t)width*sizeof(float));
+          for (by=binsizey; by--;)
+            {
+            if (rowseekflag && by<binsizey-1)
+              seek_fieldrow(field[a], ry + binsizey-1-by);
+            read_fieldrow(field[a], fbuf);
+            fbuftt = fbuf;
+            if (flipxflag)
+              {
+              datatt = datat + width;
+              for (x=width; x--;)
+                {
+                fpix = 0;
+                binsizex = x>0? binsizex0 : binsizexmax;
+                fac = 1.0/(binsizex*binsizey);
+                for (bx=binsizex; bx--;)
+                  fpix += *(fbuftt++);
+                *(--datatt) += fac*fpix;
+                }
+              }
+            else
+              {
+              datatt = datat;
+              for (x=width; x--;)
+                {
+                fpix = 0;
+                binsizex = x>0? binsizex0 : binsizexmax;
+                fac = 1.0/(binsizex*binsizey);
+                for (bx=binsizex; bx--;)
+                  fpix += *(fbuftt++);
+                *(datatt++) += fac*fpix;
+                }
+              }
+            }
+          }
+        PROBE_STOP(probe_pyramidbin, clock, width*nchan);
+        stop_timing(TIMING_BIN, (double)width*nchan, 0.0);
+        add_progress((double)width*nchan, 0.0);
+        lny[1] = y+1;
+        if (lny[1]%tilesize && lny[1]<height)
+          continue;
+/*------ Convert the completed rows of tiles, level after level */
+        for (k=1; k<nlevels; k++)
+          {
+          ty = (lny[k]-1)/tilesize;
+          nlines = lny[k] - ty*tilesize;
+          for (a=0; a<nchan; a++)
+            data[a] = lbuf[k] + (size_t)a*tilesize*lwidth[k];
+#ifdef USE_THREADS
+          conv->width = nlines==tilesize? lwidth[k]*tgroup : lwidth[k];
+          conv->nbuflines = nlines==tilesize? tilesize/tgroup : nlines;
+          conv->bufline = 0;
+          conv->imoffset = 0;
+          threads_gate_sync(conv->startgate);
+/*-------- ( Slave threads process the current buffer data here ) */
+          threads_gate_sync(conv->stopgate);
+#else
+          data_to_pix(field, data, 0, pix, nlines*(size_t)lwidth[k],
+		nchan,bypp,image->fflag,fsbuf);
+#endif
+          if (k==1)
+            {
+/*---------- Level 1 is tiled right away */
+#ifdef USE_THREADS
+            if (ty)
+              sync_convwriter(conv);
+            raster_to_tiles(pix, image->buf, width, nlines, tilesize,
+		nchan*bypp);
+            image->tiley = ty;
+            start_convwriter(conv);
+#else
+            raster_to_tiles(pix, image->buf, width, nlines, tilesize,
+		nchan*bypp);
+            image->tiley = ty;
+            write_pyramidtiles(image, filename);
+#endif
+            add_progress(0.0, (double)nlines*width);
+            }
+          else
+            {
+/*---------- Deeper levels are tiled once level 1 is done */
+            linesize = lwidth[k]*(size_t)nchan*bypp;
+            for (r=0; r<nlines; r++)
+              {
+              memcpy(get_datarows(lstore[k], ty*tilesize+r, 1),
+		pix + r*linesize, linesize);
+              release_datarows(lstore[k], ty*tilesize+r);
+              }
+            }
+          if (k==nlevels-1)
+            break;
+/*-------- Bin the rows (with bad pixels replaced by data_to_pix()) down */
+          ny0 = lny[k+1];
+          start_timing(TIMING_BIN);
+          for (a=0; a<nchan; a++)
+            for (r=ty*tilesize; r<lny[k] && (j=r/2)<lheight[k+1]; r++)
+              {
+              binsizey = (j+1)<lheight[k+1]? 2 : lbinymax[k+1];
+              datat = lbuf[k+1]
+		+ ((size_t)a*tilesize + j%tilesize)*lwidth[k+1];
+              if (!(r&1))
+                memset(datat, 0, (size_t)lwidth[k+1]*sizeof(float));
+              fbuftt = lbuf[k] + ((size_t)a*tilesize + r%tilesize)*lwidth[k];
+              for (x=lwidth[k+1]; x--;)
+                {
+                fpix = 0;
+                binsizex = x>0? 2 : lbinxmax[k+1];
+                fac = 1.0/(binsizex*binsizey);
+                for (bx=binsizex; bx--;)
+                  fpix += *(fbuftt++);
+                *(datat++) += fac*fpix;
+                }
+              if (r == 2*j+binsizey-1)
+                lny[k+1] = j+1;
+              }
+          stop_timing(TIMING_BIN, (double)(lny[k+1]-ny0)*lwidth[k+1]*nchan,
+		0.0);
+          add_progress((double)(lny[k+1]-ny0)*lwidth[k+1]*nchan, 0.0);
+/*-------- Stop unless a row of tiles of the next level was completed */
+          if (lny[k+1]==ny0 || (lny[k+1]%tilesize && lny[k+1]<lheight[k+1]))
+            break;
+          }
+        }
+#ifdef USE_THREADS
+      sync_convwriter(conv);
+#endif
+      for (k=nlevels; --k>0;)
+        free_scratch(lbuf[k]);
+      free_scratch(fsbuf);
+      free_scratch(pix);
+      continue;
+      }
+    else if (packflag)
+      {
+/*---- Levels below the first one: tile the stored pixels */
+      linesize = (size_t)width*nchan*bypp;
+      QSCRATCH(pix, unsigned char, tilesize*linesize);
+      ny = image->ntilesy;
+      tilesizey = tilesize;
+      set_progressstage("tiling", l-1, (double)width*height);
+      for (y=0; y<ny; y++)
+        {
+        NPRINTF(OUTPUT,
+		"\33[1M> Pyramid level %2d/%-2d: Tiling row %3d/%-3d\n\33[1A",
+		l, nlevels-1, y+1, ny);
+        if (y==ny-1)
+          tilesizey = height - y*tilesize;
+        for (r=0; r<tilesizey; r++)
+          {
+          memcpy(pix + r*linesize, get_datarows(lstore[l], y*tilesize+r, 0),
+		linesize);
+          release_datarows(lstore[l], y*tilesize+r);
+          }
+#ifdef USE_THREADS
+        if (y)
+          sync_convwriter(conv);
+        raster_to_tiles(pix, image->buf, width, tilesizey, tilesize,
+		nchan*bypp);
+        image->tiley = y;
+        start_convwriter(conv);
+#else
+        raster_to_tiles(pix, image->buf, width, tilesizey, tilesize,
+		nchan*bypp);
+        image->tiley = y;
+        write_pyramidtiles(image, filename);
+#endif
+        add_progress((double)tilesizey*width, (double)tilesizey*width);
+        }
+#ifdef USE_THREADS
+      sync_convwriter(conv);
+#endif
+      free_scratch(pix);
+      free_datastore(lstore[l]);
+      lstore[l] = NULL;
+      continue;
+      }
 
+    set_progressstage("reducing", l-1, (double)width*height*nchan);
     for (a=0; a<nchan; a++)
       {
       my = fheight;
       if (l>1)
         {
-        fbuft = datao = data[a];
-        swapnameo = swapname[a];
+        storeo = store[a];
+        ro = 0;
         }
-      datat = data[a] = alloc_data(ndata, &swapname[a]);
-      if (!datat)
+/*---- Blocks of stored rows match the rows of tiles */
+      if (!(store[a] = new_datastore(prefs.arena, width, height, tilesize,
+		datatype, field[a]->min, field[a]->max - field[a]->min)))
         error(EXIT_FAILURE, "*Error*: not enough (virtual) memory for loading ",
 		field[a]->rfilename);
+#ifdef USE_THREADS
+/*---- Let the workers place the pages of the level (NUMA first touch) */
+      if (conv->staticflag && store[a]->data && !store[a]->swapname)
+        for (y=0; y<height; y+=tilesize)
+          touch_convthreads(conv, store[a]->data + (size_t)y*width,
+		y+tilesize<height? width*tgroup : width,
+		y+tilesize<height? tilesize/tgroup : height-y);
+#endif
 
       for (y=0; y<height; y++)
         {
@@ -605,20 +963,26 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
 		l, nlevels-1, a+1, nchan, y+1, height);
         binsizey = ((y+1)<height? binsizey0:binsizeymax);
         my -= binsizey;
-        if (!flipyflag && l==1)
-          {
-          imoffset = tab[a]->bodypos + (size_t)fwidth * my * tab[a]->bytepix;
-          QFSEEK(cat[a]->file, imoffset, SEEK_SET, cat[a]->filename);
-          }
+        ry = flipyflag? y*binsizey0 : my;
+        rowseekflag = (l==1 && fwidth < tab[a]->naxisn[0]);
+        if ((!flipyflag || rowseekflag) && l==1)
+          seek_fieldrow(field[a], ry);
+        start_timing(TIMING_BIN);
+        PROBE_START(probe_pyramidbin, clock);
+        datat = get_datarows(store[a], y, 1);
         memset(datat, 0, (size_t)width*sizeof(float));
 /*------ Bin the pixels */
         for (by=binsizey; by--;)
           {
           if (l==1)
             {
-            read_body(tab[a], fbuf, (size_t)fwidth);
+            if (rowseekflag && by<binsizey-1)
+              seek_fieldrow(field[a], ry + binsizey-1-by);
+            read_fieldrow(field[a], fbuf);
             fbuft = fbuf;
             }
+          else
+            fbuft = get_datarows(storeo, ro++, 0);
           fbuftt = fbuft;
           if (flipxflag && l==1)
             {
@@ -646,36 +1010,33 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
               *(datatt++) += fac*fpix;
 	      }
             }
-          fbuft += fwidth;
+          if (l>1)
+            release_datarows(storeo, ro-1);
           }
-        datat += width;
+        release_datarows(store[a], y);
+        PROBE_STOP(probe_pyramidbin, clock, width);
+        stop_timing(TIMING_BIN, (double)width, 0.0);
+        add_progress((double)width, 0.0);
         }
       if (l>1)
-        free_data(datao, ndatao, swapnameo);
+        free_datastore(storeo);
       }
 
     ny = image->ntilesy;
-    QMALLOC(pix, unsigned char, tilesize*(size_t)width*nchan*bypp);
+    QSCRATCH(pix, unsigned char, tilesize*(size_t)width*nchan*bypp);
     tilesizey = tilesize;
-    imoffset = 0;
 #ifdef USE_THREADS
-    pthread_pix = pix;
-    pthread_width = width;
-    pthread_nbuflines = tilesizey;
-/*-- Try to increase the number of pixels per threads */
-    for (i=8; i--;)
-      if (!(tilesize%i))
-        {
-        pthread_width *= i;
-        pthread_nbuflines /= i;
-        break;
-        }
-    QMALLOC(fsbuf, float, nproc*(size_t)pthread_width);
-    for (p=0; p<nproc; p++)
-      pthread_fsbuf[p] = &fsbuf[p*(size_t)pthread_width];
+    conv->pix = pix;
+/*-- Increase the number of pixels per thread */
+    conv->width = width*tgroup;
+    conv->nbuflines = tilesizey/tgroup;
+    QSCRATCH(fsbuf, float, conv->nproc*(size_t)conv->width);
+    for (p=0; p<conv->nproc; p++)
+      conv->fsbuf[p] = &fsbuf[p*(size_t)conv->width];
 #else
-    QMALLOC(fsbuf, float, tilesize*(size_t)width);
+    QSCRATCH(fsbuf, float, tilesize*(size_t)width);
 #endif
+    set_progressstage("tiling", l-1, (double)width*height);
     for (y=0; y<ny; y++)
       {
       NPRINTF(OUTPUT,
@@ -686,65 +1047,81 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
         {
         tilesizey = height - y*tilesize;
 #ifdef USE_THREADS
-        pthread_width = width;
-        pthread_nbuflines = tilesizey;
+        conv->width = width;
+        conv->nbuflines = tilesizey;
 #endif
         }
+/*---- The current row of tiles is a single block of stored rows */
+      for (a=0; a<nchan; a++)
+        data[a] = get_datarows(store[a], y*tilesize, 0);
 #ifdef USE_THREADS
-      pthread_bufline = 0;
-      pthread_imoffset = imoffset;
-      threads_gate_sync(pthread_startgate);
+      conv->bufline = 0;
+      conv->imoffset = 0;
+      threads_gate_sync(conv->startgate);
 /*---- ( Slave threads process the current buffer data here ) */
-      threads_gate_sync(pthread_stopgate);
+      threads_gate_sync(conv->stopgate);
+      for (a=0; a<nchan; a++)
+        release_datarows(store[a], y*tilesize);
       if (y)
-        threads_gate_sync(pthread_stopwgate);
+        sync_convwriter(conv);
       raster_to_tiles(pix, image->buf, width, tilesizey, tilesize, nchan*bypp);
       image->tiley = y;
-      threads_gate_sync(pthread_startwgate);
+      start_convwriter(conv);
 /*---- ( Writing thread starts processing the current buffer data here ) */
 #else
-      data_to_pix(field, data, imoffset, pix, tilesizey*(size_t)width,
+      data_to_pix(field, data, 0, pix, tilesizey*(size_t)width,
 		nchan,bypp,image->fflag,fsbuf);
+      for (a=0; a<nchan; a++)
+        release_datarows(store[a], y*tilesize);
       raster_to_tiles(pix, image->buf, width, tilesizey, tilesize, nchan*bypp);
-      write_tifftiles(image);
+      image->tiley = y;
+      write_pyramidtiles(image, filename);
 #endif
-      imoffset += tilesize * (size_t)width;
+      add_progress((double)tilesizey*width, (double)tilesizey*width);
       }
 #ifdef USE_THREADS
-    threads_gate_sync(pthread_stopwgate);
+    sync_convwriter(conv);
 #endif
-    free(fsbuf);
-    free(pix);
+    free_scratch(fsbuf);
+    free_scratch(pix);
     }
 
 /* Close file and free memory */
-  end_tiff(image);
+  image_active = NULL;
+  switch(prefs.format_type2)
+    {
+    case FORMAT_TIFF_PYRAMID:
+      end_tiff(image);
+      break;
+    case FORMAT_DEEPZOOM:
+    case FORMAT_XYZ:
+    case FORMAT_ZARR:
+      end_tiletree(image);
+      break;
+    default:
+      error(EXIT_FAILURE, "This should not happen!", "");
+    }
   free(fbuf);
 
 #ifdef USE_THREADS
 /* Clean up multi-threading stuff */
-  pthread_endflag = 1;
-/* (Re-)activate existing threads... */
-  threads_gate_sync(pthread_startgate);
-  threads_gate_sync(pthread_startwgate);
-/* ... and shutdown all threads */
-  for (p=0; p<nproc; p++)
-    QPTHREAD_JOIN(thread[p], NULL);
-  QPTHREAD_JOIN(tthread, NULL);
-  threads_gate_end(pthread_startgate);
-  threads_gate_end(pthread_startwgate);
-  threads_gate_end(pthread_stopgate);
-  threads_gate_end(pthread_stopwgate);
-  QPTHREAD_MUTEX_DESTROY(&tiffmutex);
-  QPTHREAD_ATTR_DESTROY(&pthread_attr);
-  free(pthread_fsbuf);
-  free(proc);
-  free(thread);
+  end_convthreads(conv);
 #endif
 
-  for (a=0; a<nchan; a++)
-    free_data(data[a], ndata, swapname[a]);
-  cleanup_files();
+/* Stores delete their own spill files; those of other jobs are still in use */
+  if (packflag)
+    {
+    free(lbuf);
+    free(lstore);
+    free(lwidth);
+    free(lheight);
+    free(lbinxmax);
+    free(lbinymax);
+    free(lny);
+    }
+  else
+    for (a=0; a<nchan; a++)
+      free_datastore(store[a]);
   free(cat);
   free(tab);
   if (prefs.header_flag) {
@@ -756,6 +1133,82 @@ int	image_convert_pyramid(char *filename, fieldstruct **field, int nchan)
   }
 
 
+#ifndef USE_THREADS
+/****** write_pyramidtiles ****************************************************
+PROTO	void write_pyramidtiles(imagestruct *image, char *filename)
+PURPOSE	Write the current row of tiles of a pyramid level.
+INPUT	Pointer to the output image,
+	output file name.
+OUTPUT	-.
+NOTES	Writing errors are fatal.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	write_pyramidtiles(imagestruct *image, char *filename)
+  {
+  switch(prefs.format_type2)
+    {
+    case FORMAT_TIFF_PYRAMID:
+      if (write_tifftiles(image) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: cannot write ", filename);
+      break;
+    case FORMAT_DEEPZOOM:
+    case FORMAT_XYZ:
+    case FORMAT_ZARR:
+      if (write_tiletreetiles(image) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: cannot write tiles in ", image->dirname);
+      break;
+    default:
+      error(EXIT_FAILURE, "This should not happen!", "");
+    }
+
+  return;
+  }
+#endif
+
+
+/****** pyramid_nlevels *******************************************************
+PROTO	int pyramid_nlevels(int width, int height)
+PURPOSE	Compute the number of resolution levels in the output pyramid.
+INPUT	Width of the full resolution level,
+	height of the full resolution level.
+OUTPUT	Number of pyramid levels.
+NOTES	Uses the global preferences. DeepZoom pyramids go down to 1x1 pixel,
+	and XYZ and Zarr pyramids down to a single tile. TIFF pyramids have
+	at least the full resolution level, even if it is smaller than
+	PYRAMID_MINSIZE.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	pyramid_nlevels(int width, int height)
+  {
+   int	n;
+
+  switch(prefs.format_type2)
+    {
+    case FORMAT_TIFF_PYRAMID:
+      for (n=0; width>=prefs.min_size[0] || height>=prefs.min_size[1];
+		n++, width/=2, height/=2);
+      if (!n)
+        n = 1;
+      break;
+    case FORMAT_DEEPZOOM:
+      for (n=1; width>1 || height>1;
+		n++, width=(width+1)/2, height=(height+1)/2);
+      break;
+    case FORMAT_XYZ:
+    case FORMAT_ZARR:
+      for (n=1; width>prefs.tile_size || height>prefs.tile_size;
+		n++, width=(width+1)/2, height=(height+1)/2);
+      break;
+    default:
+      n = 1;
+    }
+
+  return n;
+  }
+
+
 /****** data_to_pix ***********************************************************
 PROTO	void data_to_pix(fieldstruct **field, float **data, size_t offset,
 		unsigned char *outpix, size_t npix, int nchan, int bypp,
@@ -773,7 +1226,7 @@ INPUT	Array of field pointers,
 OUTPUT	-..
 NOTES	Uses the global preferences.
 AUTHOR	E. Bertin (IAP)
-VERSION	19/01/2016
+VERSION	19/10/2026
  ***/
 void	data_to_pix(fieldstruct **field, float **data, size_t offset,
 		unsigned char *outpix, size_t npix, int nchan, int bypp,
@@ -791,6 +1244,8 @@ void	data_to_pix(fieldstruct **field, float **data, size_t offset,
    long			p, pnpix;
    int			a,b, colflag, negflag, /*iflag,*/ sflag;
 
+  start_timing(TIMING_CONVERT);
+  PROBE_START(probe_datatopix, clock);
   colflag = (nchan>1);
   coloursat = prefs.colour_sat / nchan;
 
@@ -949,6 +1404,9 @@ void	data_to_pix(fieldstruct **field, float **data, size_t offset,
         }
       }
     }
+  PROBE_STOP(probe_datatopix, clock, npix);
+  stop_timing(TIMING_CONVERT, (double)npix, 0.0);
+
   return;
   }
 
@@ -967,7 +1425,7 @@ INPUT	Input array of pixels,
 OUTPUT	Number of tiles along the x axis.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	26/03/2015
+VERSION	19/10/2026
  ***/
 int raster_to_tiles(unsigned char *inpix, unsigned char *outpix,
 			int width, int tilesizey, int tilesize, int nbytes)
@@ -976,6 +1434,8 @@ int raster_to_tiles(unsigned char *inpix, unsigned char *outpix,
    size_t		swidth;
    int			x,y, nx, tilesizex,tilesizef;
 
+  start_timing(TIMING_TILE);
+  PROBE_START(probe_rastertotiles, clock);
   nx = (width+tilesize-1)/tilesize;
 /* Everything is multiplied by the number of channels */
   swidth = (size_t)width*nbytes;
@@ -995,6 +1455,8 @@ int raster_to_tiles(unsigned char *inpix, unsigned char *outpix,
     for (y=tilesizey; y--; inpixt += swidth, outpixt += tilesizef)
       memcpy(outpixt, inpixt, tilesizex);
     }
+  PROBE_STOP(probe_rastertotiles, clock, (size_t)width*tilesizey);
+  stop_timing(TIMING_TILE, (double)width*tilesizey, 0.0);
 
   return nx;
   }
@@ -1002,48 +1464,277 @@ int raster_to_tiles(unsigned char *inpix, unsigned char *outpix,
 
 #ifdef USE_THREADS
 
+/****** init_convthreads ******************************************************
+PROTO	convthreadstruct *init_convthreads(fieldstruct **field,
+			imagestruct *image, float **data, int nchan, int bypp,
+			void *(*writer)(void *arg))
+PURPOSE	Set up the multithreading context of a conversion and start the
+	conversion and writing threads.
+INPUT	Pointer to an array of input fields,
+	pointer to the output image,
+	pointer to the input data buffers,
+	number of channels,
+	number of bytes per output pixel and channel,
+	writing thread function.
+OUTPUT	Pointer to the new multithreading context.
+NOTES	Threads wait at the start gates until the caller has filled in the
+	buffer-dependent members (pix, width, fsbuf, ...) of the context.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static convthreadstruct	*init_convthreads(fieldstruct **field,
+			imagestruct *image, float **data, int nchan, int bypp,
+			void *(*writer)(void *arg))
+  {
+   convthreadstruct	*conv;
+   pthread_attr_t	pthread_attr;
+   int			p, nproc, pinerrflag;
+
+  QCALLOC(conv, convthreadstruct, 1);
+/* Number of active threads */
+  nproc = prefs.nthreads;
+  if (nproc>1)
+    nproc--;		/* Leave one proc free for non-blocking TIFF I/O's */
+  conv->nproc = nproc;
+  QPTHREAD_MUTEX_INIT(&conv->mutex, NULL);
+  QPTHREAD_ATTR_INIT(&pthread_attr);
+  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
+  conv->startgate = threads_gate_init(nproc+1, NULL);
+  conv->startwgate = threads_gate_init(2, NULL);
+  conv->stopgate = threads_gate_init(nproc+1, NULL);
+  conv->stopwgate = threads_gate_init(2, NULL);
+  QMALLOC(conv->proc, convprocstruct, nproc);
+  QCALLOC(conv->fsbuf, float *, nproc);
+  QMALLOC(conv->thread, pthread_t, nproc);
+  conv->field = field;
+  conv->image = image;
+  conv->data = data;
+  conv->nchan = nchan;
+  conv->bypp = bypp;
+  conv->fflag = image->fflag;
+  conv->format_type = prefs.format_type2;
+  conv->master = pthread_self();
+  conv->endflag = 0;
+/* Register the context for cancellation on signals */
+  QPTHREAD_MUTEX_LOCK(&convthread_mutex);
+  conv->prev = convthread_active;
+  convthread_active = conv;
+  QPTHREAD_MUTEX_UNLOCK(&convthread_mutex);
+/* Install the signal-catching routines for temporary file cleanup */
+  install_cleanup(pthread_cancel_threads);
+/* Pages are placed by the worker processing them: lines go to fixed threads */
+  conv->staticflag = (prefs.numa_type == NUMA_FIRSTTOUCH);
+/* Start the data conversion threads, on cores not used by other pools */
+  pinerrflag = 0;
+  if (prefs.pinning_flag)
+    conv->pinbase = threads_pinreserve(nproc);
+  for (p=0; p<nproc; p++)
+    {
+    conv->proc[p].conv = conv;
+    conv->proc[p].proc = p;
+    QPTHREAD_CREATE(&conv->thread[p], &pthread_attr, &pthread_data_to_pix,
+	&conv->proc[p]);
+    if (prefs.pinning_flag
+	&& threads_pin(conv->thread[p], conv->pinbase+p) != RETURN_OK)
+      pinerrflag = 1;
+    }
+  if (pinerrflag)
+    warning("Cannot pin conversion threads to CPU cores", "");
+/* Start the writing thread */
+  QPTHREAD_CREATE(&conv->wthread, &pthread_attr, writer, conv);
+  QPTHREAD_ATTR_DESTROY(&pthread_attr);
+
+  return conv;
+  }
+
+
+/****** end_convthreads *******************************************************
+PROTO	void end_convthreads(convthreadstruct *conv)
+PURPOSE	Shut down the threads of a conversion and free its multithreading
+	context.
+INPUT	Pointer to the multithreading context.
+OUTPUT	-.
+NOTES	Buffers set by the caller (pix, fsbuf content) are not freed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	end_convthreads(convthreadstruct *conv)
+  {
+   convthreadstruct	**pconv;
+   int			p;
+
+  conv->endflag = 1;
+/* (Re-)activate existing threads... */
+  threads_gate_sync(conv->startgate);
+  threads_gate_sync(conv->startwgate);
+/* ... and shutdown all threads */
+  for (p=0; p<conv->nproc; p++)
+    QPTHREAD_JOIN(conv->thread[p], NULL);
+  QPTHREAD_JOIN(conv->wthread, NULL);
+  if (prefs.pinning_flag)
+    threads_pinrelease(conv->pinbase, conv->nproc);
+/* Unregister the context */
+  QPTHREAD_MUTEX_LOCK(&convthread_mutex);
+  for (pconv=&convthread_active; *pconv; pconv=&(*pconv)->prev)
+    if (*pconv == conv)
+      {
+      *pconv = conv->prev;
+      break;
+      }
+  QPTHREAD_MUTEX_UNLOCK(&convthread_mutex);
+  threads_gate_end(conv->startgate);
+  threads_gate_end(conv->startwgate);
+  threads_gate_end(conv->stopgate);
+  threads_gate_end(conv->stopwgate);
+  QPTHREAD_MUTEX_DESTROY(&conv->mutex);
+  free(conv->fsbuf);
+  free(conv->proc);
+  free(conv->thread);
+  free(conv);
+
+  return;
+  }
+
+
+/****** start_convwriter ******************************************************
+PROTO	void start_convwriter(convthreadstruct *conv)
+PURPOSE	Let the writing thread of a conversion process the output buffer.
+INPUT	Pointer to the multithreading context.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	start_convwriter(convthreadstruct *conv)
+  {
+  threads_gate_sync(conv->startwgate);
+  conv->wbusyflag = 1;
+
+  return;
+  }
+
+
+/****** sync_convwriter *******************************************************
+PROTO	void sync_convwriter(convthreadstruct *conv)
+PURPOSE	Wait for the writing thread of a conversion to be done with the
+	output buffer, and report writing errors.
+INPUT	Pointer to the multithreading context.
+OUTPUT	-.
+NOTES	Writing errors are raised here, in the thread running the
+	conversion.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	sync_convwriter(convthreadstruct *conv)
+  {
+  threads_gate_sync(conv->stopwgate);
+  conv->wbusyflag = 0;
+  if (conv->werrflag)
+    error(EXIT_FAILURE, "*Error*: cannot write ", conv->image->filename);
+
+  return;
+  }
+
+
+/****** touch_convthreads *****************************************************
+PROTO	void touch_convthreads(convthreadstruct *conv, float *buf, int width,
+			int nlines)
+PURPOSE	Have the conversion threads write a buffer first, so that its pages
+	are placed on their NUMA nodes.
+INPUT	Pointer to the multithreading context,
+	pointer to the buffer,
+	line length (in pixels),
+	number of lines.
+OUTPUT	-.
+NOTES	Lines are set to 0 by the thread that converts them later (static
+	line assignment), with the same line length and number of lines as
+	the conversion. Only pages that have never been touched are placed:
+	reused scratch buffers keep their placement.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	touch_convthreads(convthreadstruct *conv, float *buf, int width,
+			int nlines)
+  {
+   int	width0, nlines0;
+
+  width0 = conv->width;
+  nlines0 = conv->nbuflines;
+  conv->touchbuf = buf;
+  conv->width = width;
+  conv->nbuflines = nlines;
+  conv->bufline = 0;
+  threads_gate_sync(conv->startgate);
+/* ( Slave threads touch the buffer here ) */
+  threads_gate_sync(conv->stopgate);
+  conv->touchbuf = NULL;
+  conv->width = width0;
+  conv->nbuflines = nlines0;
+
+  return;
+  }
+
+
 /****** pthread_data_to_pix ***************************************************
 PROTO   void *pthread_data_to_pix(void *arg)
 PURPOSE thread that takes care of converting FITS pixels to TIFF pixels.
-INPUT   Pointer to the thread number.
+INPUT   Pointer to the thread argument structure.
 OUTPUT  -.
 NOTES   -.
 AUTHOR  E. Bertin (IAP)
-VERSION 26/03/2015
+VERSION 19/10/2026
  ***/
-void    *pthread_data_to_pix(void *arg)
+static void	*pthread_data_to_pix(void *arg)
   {
-   int  bufline, proc;
-
-  bufline = -1;
-  proc = *((int *)arg);
-  threads_gate_sync(pthread_startgate);
-  while (!pthread_endflag)
+   convthreadstruct	*conv;
+   int			bufline, proc;
+
+  conv = ((convprocstruct *)arg)->conv;
+  proc = ((convprocstruct *)arg)->proc;
+  set_timingthread("convert");
+  threads_gate_sync(conv->startgate);
+  bufline = proc;
+  while (!conv->endflag)
     {
-    QPTHREAD_MUTEX_LOCK(&tiffmutex);
-    if (pthread_bufline<pthread_nbuflines)
+/*-- Lines go to fixed threads, or to the first thread available */
+    if (conv->staticflag)
       {
-      bufline = pthread_bufline++;
-      QPTHREAD_MUTEX_UNLOCK(&tiffmutex);
-      data_to_pix(pthread_field,
-		pthread_data,
-		pthread_imoffset + bufline * (size_t)pthread_width,
-		pthread_pix + bufline * (size_t)pthread_width
-			* pthread_nchan * pthread_bypp,
-		pthread_width,
-		pthread_nchan,
-		pthread_bypp,
-                pthread_fflag,
-		pthread_fsbuf[proc]);
+      if (bufline>=conv->nbuflines)
+        bufline = -1;
       }
     else
       {
-      QPTHREAD_MUTEX_UNLOCK(&tiffmutex);
+      QPTHREAD_MUTEX_LOCK(&conv->mutex);
+      bufline = conv->bufline<conv->nbuflines? conv->bufline++ : -1;
+      QPTHREAD_MUTEX_UNLOCK(&conv->mutex);
+      }
+    if (bufline<0)
+      {
 /*---- Wait for the input buffer to be updated */
-      threads_gate_sync(pthread_stopgate);
+      threads_gate_sync(conv->stopgate);
 /* ( Master thread process loads and saves new data here ) */
-      threads_gate_sync(pthread_startgate);
+      threads_gate_sync(conv->startgate);
+      bufline = proc;
+      continue;
       }
+    if (conv->touchbuf)
+      {
+/*---- First touch: place the pages on the NUMA node of the thread */
+      memset(conv->touchbuf + bufline * (size_t)conv->width, 0,
+		conv->width*sizeof(float));
+      }
+    else
+      data_to_pix(conv->field,
+		conv->data,
+		conv->imoffset + bufline * (size_t)conv->width,
+		conv->pix + bufline * (size_t)conv->width
+			* conv->nchan * conv->bypp,
+		conv->width,
+		conv->nchan,
+		conv->bypp,
+                conv->fflag,
+		conv->fsbuf[proc]);
+    bufline += conv->nproc;
     }
 
   pthread_exit(NULL);
@@ -1054,27 +1745,34 @@ void    *pthread_data_to_pix(void *arg)
 
 /****** pthread_write_lines ***************************************************
 PROTO   void *pthread_write_lines(void *arg)
-PURPOSE thread that takes care of writing TIFF lines (non-blocking).
-INPUT   Pointer to the thread number.
+PURPOSE thread that takes care of writing TIFF, JPEG or PNG lines
+	(non-blocking).
+INPUT   Pointer to the multithreading context.
 OUTPUT  -.
-NOTES   -.
+NOTES   Failures are flagged in the context and reported by
+	sync_convwriter().
 AUTHOR  E. Bertin (IAP)
-VERSION 04/01/2010
+VERSION 19/10/2026
  ***/
-void    *pthread_write_lines(void *arg)
+static void	*pthread_write_lines(void *arg)
   {
-   int  bufline, proc;
+   convthreadstruct	*conv;
 
-  bufline = -1;
-  proc = *((int *)arg);
-  threads_gate_sync(pthread_startwgate);
-  while (!pthread_endflag)
+  conv = (convthreadstruct *)arg;
+  set_timingthread("write");
+  threads_gate_sync(conv->startwgate);
+  while (!conv->endflag)
     {
-    write_tifflines(pthread_image);
+    if ((conv->format_type == FORMAT_TIFF?
+		write_tifflines(conv->image)
+	: (conv->format_type == FORMAT_RASTER?
+		write_rasterlines(conv->image)
+		: write_quicklooklines(conv->image))) != RETURN_OK)
+      conv->werrflag = 1;
 /*-- Wait for the input buffer to be updated */
-    threads_gate_sync(pthread_stopwgate);
+    threads_gate_sync(conv->stopwgate);
 /*-- ( Master thread process loads and saves new data here ) */
-    threads_gate_sync(pthread_startwgate);
+    threads_gate_sync(conv->startwgate);
     }
 
   pthread_exit(NULL);
@@ -1085,27 +1783,32 @@ void    *pthread_write_lines(void *arg)
 
 /****** pthread_write_tiles ***************************************************
 PROTO   void *pthread_write_tiles(void *arg)
-PURPOSE thread that takes care of writing TIFF tiles (non-blocking).
-INPUT   Pointer to the thread number.
+PURPOSE thread that takes care of writing TIFF or tile tree tiles
+	(non-blocking).
+INPUT   Pointer to the multithreading context.
 OUTPUT  -.
-NOTES   -.
+NOTES   Failures are flagged in the context and reported by
+	sync_convwriter().
 AUTHOR  E. Bertin (IAP)
-VERSION 03/01/2010
+VERSION 19/10/2026
  ***/
-void    *pthread_write_tiles(void *arg)
+static void	*pthread_write_tiles(void *arg)
   {
-   int  bufline, proc;
+   convthreadstruct	*conv;
 
-  bufline = -1;
-  proc = *((int *)arg);
-  threads_gate_sync(pthread_startwgate);
-  while (!pthread_endflag)
+  conv = (convthreadstruct *)arg;
+  set_timingthread("write");
+  threads_gate_sync(conv->startwgate);
+  while (!conv->endflag)
     {
-    write_tifftiles(pthread_image);
+    if ((conv->format_type == FORMAT_TIFF_PYRAMID?
+		write_tifftiles(conv->image)
+		: write_tiletreetiles(conv->image)) != RETURN_OK)
+      conv->werrflag = 1;
 /*-- Wait for the input buffer to be updated */
-    threads_gate_sync(pthread_stopwgate);
+    threads_gate_sync(conv->stopwgate);
 /*-- ( Master thread process loads and saves new data here ) */
-    threads_gate_sync(pthread_startwgate);
+    threads_gate_sync(conv->startwgate);
     }
 
   pthread_exit(NULL);
@@ -1118,32 +1821,100 @@ PROTO	void pthread_cancel_threads(void)
 PURPOSE	Cancel remaining active threads
 INPUT   -.
 OUTPUT  -.
-NOTES   -.
+NOTES   Threads of all conversions running in the process are cancelled.
 AUTHOR  E. Bertin (IAP)
-VERSION 04/01/2010
+VERSION 19/10/2026
  ***/
 void    pthread_cancel_threads(void)
   {
-   int  p;
+   convthreadstruct	*conv;
+   int			p;
 
-  for (p=0; p<pthread_nproc; p++)
-    QPTHREAD_CANCEL(thread[p]);
-    QPTHREAD_CANCEL(tthread);
+  for (conv=convthread_active; conv; conv=conv->prev)
+    {
+    for (p=0; p<conv->nproc; p++)
+      QPTHREAD_CANCEL(conv->thread[p]);
+    QPTHREAD_CANCEL(conv->wthread);
+    }
 
   return;
   }
 
 #endif
 
+/****** abort_conversion ******************************************************
+PROTO	void abort_conversion(void)
+PURPOSE	Stop the conversion interrupted by an error in the current thread,
+	and release its output image.
+INPUT	-.
+OUTPUT	-.
+NOTES	Must be called from the thread that ran the conversion, once the
+	error has been trapped. Incomplete output files are closed as they
+	are; intermediate buffers of the conversion are not reclaimed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	abort_conversion(void)
+  {
+   imagestruct		*image;
+
+#ifdef USE_THREADS
+   convthreadstruct	*conv;
+
+/* Find the threads started by the current thread */
+  QPTHREAD_MUTEX_LOCK(&convthread_mutex);
+  for (conv=convthread_active; conv && !pthread_equal(conv->master,
+	pthread_self()); conv=conv->prev);
+  QPTHREAD_MUTEX_UNLOCK(&convthread_mutex);
+  if (conv)
+    {
+/*-- Conversion threads are idle: only the writing thread may be busy */
+    if (conv->wbusyflag)
+      threads_gate_sync(conv->stopwgate);
+    end_convthreads(conv);
+    }
+#endif
+
+  if (!(image = image_active))
+    return;
+  image_active = NULL;
+  switch(image_activetype)
+    {
+    case FORMAT_TIFF:
+    case FORMAT_TIFF_PYRAMID:
+      end_tiff(image);
+      break;
+    case FORMAT_JPEG:
+    case FORMAT_PNG:
+      abort_quicklook(image);
+      break;
+    case FORMAT_RASTER:
+      end_raster(image);
+      break;
+    case FORMAT_DEEPZOOM:
+    case FORMAT_XYZ:
+    case FORMAT_ZARR:
+      abort_tiletree(image);
+      break;
+    default:
+      break;
+    }
+
+  return;
+  }
+
+
 /****** fitshead_to_desc ******************************************************
 PROTO	char	*fitshead_to_desc(char *fitshead, int nheadblock,
-		int sizex, int sizey, int binx, int biny,
-		int flipxflag, int flipyflag)
+		int sizex, int sizey, int originx, int originy,
+		int binx, int biny, int flipxflag, int flipyflag)
 PURPOSE	Convert FITS header to CDS-like description field.
 INPUT	Pointer to FITS header,
 	number of FITS blocks,
 	image size in x,
 	image size in y,
+	x origin of the cutout region (0 for the full image),
+	y origin of the cutout region (0 for the full image),
 	binning factor in x,
 	binning factor in y,
 	x-flipping flag,
@@ -1151,11 +1922,11 @@ INPUT	Pointer to FITS header,
 OUTPUT	-.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	08/02/2010
+VERSION	19/10/2026
  ***/
 char	*fitshead_to_desc(char *fitshead, int nheadblock,
-		int sizex, int sizey, int binx, int biny,
-		int flipxflag, int flipyflag)
+		int sizex, int sizey, int originx, int originy,
+		int binx, int biny, int flipxflag, int flipyflag)
   {
     char	*description;
     double	dval;
@@ -1169,14 +1940,14 @@ char	*fitshead_to_desc(char *fitshead, int nheadblock,
 /*---- Scale the WCS information if present */
   if (fitsread(description, "CRPIX1  ", &dval, H_EXPO, T_DOUBLE)==RETURN_OK)
     {
-    dval = (dval - 0.5)/binx + 0.5;
+    dval = (dval - originx - 0.5)/binx + 0.5;
     if (flipxflag)
       dval = sizex+1 - dval;
     fitswrite(description, "CRPIX1  ", &dval, H_EXPO, T_DOUBLE);
     }
   if (fitsread(description, "CRPIX2  ", &dval, H_EXPO, T_DOUBLE)==RETURN_OK)
     {
-    dval = (dval - 0.5)/biny + 0.5;
+    dval = (dval - originy - 0.5)/biny + 0.5;
     if (flipyflag)
       dval = sizey+1 - dval;
     fitswrite(description, "CRPIX2  ", &dval, H_EXPO, T_DOUBLE);
@@ -1224,56 +1995,159 @@ char	*fitshead_to_desc(char *fitshead, int nheadblock,
   }
 
 
+/****** set_fieldlevels ******************************************************
+PROTO	void set_fieldlevels(fieldstruct *field, PIXTYPE *data, long npix)
+PURPOSE	Set the background, min. and max. levels of a field.
+INPUT	Field structure of the image,
+	pointer to in-memory pixel values (or NULL to read the image),
+	number of in-memory pixel values.
+OUTPUT	-.
+NOTES	Uses the global preferences.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_fieldlevels(fieldstruct *field, PIXTYPE *data, long npix)
+  {
+   PIXTYPE	grey;
+   int		i;
+
+  i = field->index;
+  field->back = prefs.back_val[i];
+  field->max = prefs.max_val[i];
+  field->min = prefs.min_val[i];
+  if (prefs.back_type[i]!=BACK_MANUAL || prefs.max_type[i]==MAX_QUANTILE
+	 ||  prefs.min_type[i]==MIN_QUANTILE)
+    make_imastats(field, data, npix,
+	prefs.back_type[i]!=BACK_MANUAL, prefs.min_type[i]==MIN_QUANTILE,
+	prefs.max_type[i]==MAX_QUANTILE);
+  if (field->max > prefs.sat_val[i])
+    warning("MAX_LEVEL exceeds SATUR_LEVEL in ", field->rfilename);
+
+  if (prefs.min_type[i] == MIN_GREYLEVEL)
+    {
+    grey = pow(prefs.min_val[i], prefs.gamma_fac);
+    field->min = (field->max*grey - field->back) / (grey - 1.0);
+    }
+
+  return;
+  }
+
+
 /****** make_imastats *********************************************************
-PROTO	void make_imastats(fieldstruct *field,
+PROTO	void make_imastats(fieldstruct *field, PIXTYPE *data, long ndata,
 		int backflag, int minflag, int maxflag)
 PURPOSE	Compute image statistics
 INPUT	Field structure of the image,
+	pointer to in-memory pixel values (or NULL to read the image),
+	number of in-memory pixel values,
 	flag to trigger median background computation,
 	flag to trigger min. level quantile computation,
 	flag to trigger max. level quantile computation.
 OUTPUT	-.
-NOTES	Uses the global preferences.
+NOTES	Uses the global preferences. Results are taken from, and stored in
+	the field cache when it is active. Statistics of cutouts are computed
+	from the region pixels, unless REGION_STATS is set to FULL.
+	In-memory pixel values are not modified. The statistics of mosaics
+	are computed from the pixels of all their tiles. Selections in
+	on-disk data are multithreaded.
 AUTHOR	E. Bertin (IAP)
-VERSION	22/06/2012
+VERSION	19/10/2026
  ***/
-void	make_imastats(fieldstruct *field,
+void	make_imastats(fieldstruct *field, PIXTYPE *data, long ndata,
 		int backflag, int minflag, int maxflag)
   {
    catstruct	*cat;
    tabstruct	*tab;
+   double	nstatpix;
    long		n,npix, nsample;
    char		*rfilename;
    float	*med, *min, *max;
-   PIXTYPE	*pixbuf;
-   int		size;
+   PIXTYPE	*pixbuf,*pixbuft, minfrac, maxfrac;
+   int		size, m,nr, x,y, regionflag, nthreads;
 
 
-  if (!((cat=field->cat) && open_cat(cat, READ_ONLY)==RETURN_OK))
+/* Statistics of a cutout are computed from the cutout pixels only */
+  regionflag = data || (is_fieldregion(field)
+		&& prefs.regionstats_type == REGIONSTATS_REGION);
+/* Statistics may be available from a previous conversion */
+  if (!regionflag
+	&& load_fieldstats(field, backflag, minflag, maxflag) == RETURN_OK)
     return;
+  minfrac = field->min;
+  maxfrac = field->max;
   rfilename = field->rfilename;
   tab = field->tab;
-  QFSEEK(cat->file, tab->bodypos, SEEK_SET, cat->filename);
+  cat = field->cat;
+  if (!data && !field->mosaic)
+    {
+    if (!(cat && open_cat(cat, READ_ONLY)==RETURN_OK))
+      return;
+    QFSEEK(cat->file, tab->bodypos, SEEK_SET, cat->filename);
+    }
+  start_timing(TIMING_STATS);
+/* In-memory (cutout) data are processed concurrently by the caller */
+  nthreads = data? 1 : prefs.nthreads;
   size = IMAGE_BUFSIZE/sizeof(PIXTYPE);
   QMALLOC(pixbuf, PIXTYPE, size);
-  npix = tab->tabsize/tab->bytepix;
+  if (data)
+    npix = ndata;
+  else if (field->mosaic)
+    {
+    npix = field->mosaic->npix;
+    rewind_mosaicbody(field->mosaic);
+    }
+  else if (regionflag)
+    {
+    npix = (long)field->size[0]*field->size[1];
+    seek_fieldrow(field, 0);
+    }
+  else
+    npix = tab->tabsize/tab->bytepix;
+  nstatpix = (double)npix;
+  if (!data)
+    set_progressstage("statistics", -1, nstatpix);
+  x = y = 0;
   nsample = (npix+size-1) / size;
   QMALLOC(med, float, nsample);
   QMALLOC(min, float, nsample);
   QMALLOC(max, float, nsample);
   for (n=0; n<nsample; npix -= size, n++)
     {
-    NPRINTF(OUTPUT, "\33[1M> %s: Computing Image stats: %2.0f%%\n\33[1A",
+    if (!data)
+      NPRINTF(OUTPUT, "\33[1M> %s: Computing Image stats: %2.0f%%\n\33[1A",
 	rfilename,
 	(100.0*((double)n+0.49))/(double)nsample);
     if (size>npix)
       size = npix;
-    read_body(tab, pixbuf, size);
-    med[n] = fast_median(pixbuf, size);
+    if (data)
+      memcpy(pixbuf, data + n*(IMAGE_BUFSIZE/sizeof(PIXTYPE)),
+		size*sizeof(PIXTYPE));
+    else if (regionflag)
+/*---- Gather the region pixels row segment by row segment */
+      for (pixbuft=pixbuf, m=size; m>0; m-=nr, pixbuft+=nr, x+=nr)
+        {
+        if (x == field->size[0])
+          {
+          x = 0;
+          seek_fieldrow(field, ++y);
+          }
+        if ((nr = field->size[0] - x) > m)
+          nr = m;
+        read_body(tab, pixbuft, nr);
+        }
+    else if (field->mosaic)
+      read_mosaicbody(field->mosaic, pixbuf, size);
+    else
+      read_body(tab, pixbuf, size);
+    if (!data)
+      add_progress((double)size, 0.0);
+    PROBE_START(probe_imastats, clock);
+    med[n] = select_median(pixbuf, size, nthreads);
     if (minflag)
-      min[n] = fast_quantile(pixbuf, size/2, field->min);
+      min[n] = select_quantile(pixbuf, size/2, field->min, nthreads);
     if (maxflag)
-      max[n] = fast_quantile(pixbuf+size/2, size/2, field->max);
+      max[n] = select_quantile(pixbuf+size/2, size/2, field->max, nthreads);
+    PROBE_STOP(probe_imastats, clock, size);
     }
   free(pixbuf);
   if (backflag)
@@ -1285,8 +2159,12 @@ void	make_imastats(fieldstruct *field,
   free(med);
   free(min);
   free(max);
+  if (!regionflag)
+    save_fieldstats(field, backflag, minflag, maxflag, minfrac, maxfrac);
+  stop_timing(TIMING_STATS, nstatpix, data? 0.0 : nstatpix*tab->bytepix);
 
-  QFSEEK(cat->file, tab->bodypos, SEEK_SET, cat->filename);
+  if (!data && !field->mosaic)
+    QFSEEK(cat->file, tab->bodypos, SEEK_SET, cat->filename);
 
   return;
   }
@@ -1294,171 +2172,36 @@ void	make_imastats(fieldstruct *field,
 
 /******* fast_median **********************************************************
 PROTO   float fast_median(float *arr, int n)
-PURPOSE Fast median from an input array, optimized version based on the
-        select() routine (Numerical Recipes, 2nd ed. Section 8.5 and
-        http://www.eso.org/~ndevilla/median/). If n is even, then the result
-        is the average of the 2 "central" values.
+PURPOSE Fast median from an input array. If n is even, then the result is the
+        average of the 2 "central" values.
 INPUT   Input pixel array ptr,
         number of input pixels,
 OUTPUT  Value of the median.
-NOTES   n must be >0. Warning: changes the order of data (but does not sort
-        them)!
-AUTHOR  E. Bertin (IAP), optimized from N.Devillard's code
-VERSION 26/03/2015
+NOTES   Warning: changes the order of data (but does not sort them)!
+        Single-threaded version of select_median().
+AUTHOR  E. Bertin (IAP)
+VERSION 19/10/2026
  ***/
-#define MEDIAN_SWAP(a,b) { float t=(a);(a)=(b);(b)=t; }
-
 float fast_median(float *arr, long n)
   {
-   float	*alow, *ahigh, *amedian, *amiddle, *all, *ahh,
-		val, valmax, valmax2;
-   long		i, nless;
-
-  if (!n)
-    return 0.0;
-  else if (n==1)
-    return *arr;
-  else if (n==2)
-    return 0.5*(*arr+*(arr+1));
-
-  alow = arr;
-  ahigh = arr + n - 1;
-  amedian = arr + n/2;
-  while (ahigh > (all=alow + 1))
-    {
-/*-- Find median of low, middle and high items; swap into position low */
-    amiddle = alow + (ahigh-alow)/2;
-    if (*amiddle > *ahigh)
-      MEDIAN_SWAP(*amiddle, *ahigh);
-    if (*alow > *ahigh)
-      MEDIAN_SWAP(*alow, *ahigh);
-    if (*amiddle > *alow)
-      MEDIAN_SWAP(*amiddle, *alow);
-
-/*-- Swap low item (now in position middle) into position (low+1) */
-    MEDIAN_SWAP(*amiddle, *all);
-
-/*-- Nibble from each end towards middle, swapping items when stuck */
-    ahh = ahigh;
-    for (;;)
-      {
-      while (*alow > *(++all));
-      while (*(--ahh) > *alow);
-
-      if (ahh < all)
-        break;
-
-      MEDIAN_SWAP(*all, *ahh);
-      }
-
-/*-- Swap middle item (in position low) back into correct position */
-    MEDIAN_SWAP(*alow, *ahh) ;
-
-/*-- Re-set active partition */
-    if (ahh <= amedian)
-      alow = all;
-    if (ahh >= amedian)
-      ahigh = ahh - 1;
-    }
-
-/* One or two elements left */
-  if (ahigh == all && *alow > *ahigh)
-    MEDIAN_SWAP(*alow, *ahigh);
-
-  if (n&1)
-/*-- Odd case */
-    return *amedian;
-  else
-    {
-/*-- Even case */
-    valmax2 = *amedian;
-    valmax = -BIG;
-    alow = arr;
-    nless = 0;
-    for (i=n/2;i--;)
-      if ((val=*(alow++))<valmax2)
-        {
-        nless++;
-        if (val > valmax)
-          valmax = val;
-        }
-    return nless<n/2? *amedian : (*amedian+valmax)/2.0;
-    }
-
+  return select_median(arr, n, 1);
   }
 
-#undef MEDIAN_SWAP
-
 
 /******* fast_quantile ********************************************************
 PROTO   float fast_quantile(float *arr, int n, float frac)
-PURPOSE Fast median from an input array, optimized version based on the
-        select() routine (Numerical Recipes, 2nd ed. Section 8.5.
+PURPOSE Fast quantile from an input array.
 INPUT   Input pixel array ptr,
         number of input pixels,
 	quantile fraction (>=0 & <1)
 OUTPUT  Value of the quantile.
 NOTES   n must be >0. Warning: changes the order of data (but does not sort
-        them)!
-AUTHOR  E. Bertin (IAP), optimized from Num.Rec. code
-VERSION 26/03/2015
+        them)! Single-threaded version of select_quantile().
+AUTHOR  E. Bertin (IAP)
+VERSION 19/10/2026
  ***/
-#define QUANTILE_SWAP(a,b) { register float t=(a);(a)=(b);(b)=t; }
-
 float fast_quantile(float *arr, long n, float frac)
   {
-   float      *alow, *ahigh, *amedian, *amiddle, *all, *ahh;
-
-  if (frac>1.0)
-    frac = 1.0;
-  else if (frac<0.0)
-    frac = 0.0; 
-  alow = arr;
-  ahigh = arr + n - 1;
-  amedian = arr + (long)(frac*(n-0.5001));
-  while (ahigh > (all=alow + 1))
-    {
-/*-- Find median of low, middle and high items; swap into position low */
-    amiddle = alow + (ahigh-alow)/2;
-    if (*amiddle > *ahigh)
-      QUANTILE_SWAP(*amiddle, *ahigh);
-    if (*alow > *ahigh)
-      QUANTILE_SWAP(*alow, *ahigh);
-    if (*amiddle > *alow)
-      QUANTILE_SWAP(*amiddle, *alow);
-
-/*-- Swap low item (now in position middle) into position (low+1) */
-    QUANTILE_SWAP(*amiddle, *all);
-
-/*-- Nibble from each end towards middle, swapping items when stuck */
-    ahh = ahigh;
-    for (;;)
-      {
-      while (*alow > *(++all));
-      while (*(--ahh) > *alow);
-
-      if (ahh < all)
-        break;
-
-      QUANTILE_SWAP(*all, *ahh);
-      }
-
-/*-- Swap middle item (in position low) back into correct position */
-    QUANTILE_SWAP(*alow, *ahh) ;
-
-/*-- Re-set active partition */
-    if (ahh <= amedian)
-      alow = all;
-    if (ahh >= amedian)
-      ahigh = ahh - 1;
-    }
-
-/* One or two elements left */
-  if (ahigh == all && *alow > *ahigh)
-    QUANTILE_SWAP(*alow, *ahigh);
-
-  return *amedian;
+  return select_quantile(arr, n, frac, 1);
   }
 
-#undef QUANTILE_SWAP
-
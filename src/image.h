@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		26/03/2015
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -67,24 +67,42 @@ typedef struct structimage
    int			tiley;			/* Current tile row */
    int			y;			/* Current line index */
    int			nlines;			/* Number of lines in buffer */
+   char			dirname[MAXCHAR];	/* Tile tree directory */
+   int			treetype;		/* Tile tree layout */
+   int			filetype;		/* Tile or quick-look format */
+   int			quality;		/* Compression quality */
+   int			level;			/* Current tile tree level */
+   int			nlevels;		/* Number of tile tree levels */
+   int			levwidth;		/* Current level width */
+   int			levheight;		/* Current level height */
+   FILE			*file;			/* Quick-look file pointer */
+   unsigned char	*prevline;		/* Last line written (PNG) */
+   unsigned int		adler;			/* Running Adler-32 (PNG) */
+   int			rst;			/* Next restart marker (JPEG)*/
+   unsigned char	*raster;		/* In-memory output raster */
+   void			*encoder;		/* Tile/band encoder context */
    unsigned char	*buf;
   }	imagestruct;
 
 /*------------------------------- functions ---------------------------------*/
-extern void	data_to_pix(fieldstruct **field, float **data, size_t offset,
+extern void	abort_conversion(void),
+		data_to_pix(fieldstruct **field, float **data, size_t offset,
 			unsigned char *outpix, size_t npix, int nchan, int bypp,
 			int fflag, float *buffer),
 		image_convert_single(char *filename, fieldstruct **field,
 			int nchan),
-		make_imastats(fieldstruct *field,
-			int backflag, int minflag, int maxflag);
+		make_imastats(fieldstruct *field, PIXTYPE *data, long ndata,
+			int backflag, int minflag, int maxflag),
+		set_fieldlevels(fieldstruct *field, PIXTYPE *data,
+			long npix);
 
 extern char	*fitshead_to_desc(char *fitshead, int nheadblock,
-			int sizex, int sizey, int binx, int biny,
-			int flipxflag, int flipyflag);
+			int sizex, int sizey, int originx, int originy,
+			int binx, int biny, int flipxflag, int flipyflag);
 
 extern int	image_convert_pyramid(char *filename, fieldstruct **field,
 			int nchan),
+		pyramid_nlevels(int width, int height),
 		raster_to_tiles(unsigned char *inpix, unsigned char *outpix,
 			int width, int tilesizey, int tilesize, int nbytes);
 
@@ -0,0 +1,205 @@
+/*
+*				jpeg.c
+*
+* Encode JPEG images in memory.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jpeglib.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "jpeg.h"
+
+static void	jpeg_error_exit(j_common_ptr cinfo);
+
+/****** encode_jpeg ***********************************************************
+PROTO	int encode_jpeg(unsigned char *pix, int width, int height,
+			size_t stride, int nchan, int quality, int restartrows,
+			unsigned char **outbuf, size_t *outsize)
+PURPOSE	Compress a raster of 8-bit pixels to a JPEG stream in memory.
+INPUT	Pointer to the first pixel,
+	raster width in pixels,
+	raster height in pixels,
+	raster line step in bytes,
+	number of channels (1 or 3),
+	JPEG quality index (0-100),
+	number of MCU rows between restart markers (0 for none),
+	pointer to the output buffer pointer (allocated here),
+	pointer to the output size in bytes.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	The output buffer must be freed with free() by the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	encode_jpeg(unsigned char *pix, int width, int height,
+			size_t stride, int nchan, int quality, int restartrows,
+			unsigned char **outbuf, size_t *outsize)
+  {
+   struct jpeg_compress_struct	cinfo;
+   struct jpeg_error_mgr	jerr;
+   JSAMPROW			row;
+   unsigned long		size;
+
+  if (nchan!=1 && nchan!=3)
+    return RETURN_ERROR;
+
+  cinfo.err = jpeg_std_error(&jerr);
+  jerr.error_exit = jpeg_error_exit;
+  jpeg_create_compress(&cinfo);
+  *outbuf = NULL;
+  size = 0;
+  jpeg_mem_dest(&cinfo, outbuf, &size);
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = nchan;
+  cinfo.in_color_space = nchan==3? JCS_RGB : JCS_GRAYSCALE;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  cinfo.restart_in_rows = restartrows;
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height)
+    {
+    row = (JSAMPROW)(pix + cinfo.next_scanline*stride);
+    jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  *outsize = (size_t)size;
+
+  return RETURN_OK;
+  }
+
+
+/****** jpeg_headersize *******************************************************
+PROTO	size_t jpeg_headersize(unsigned char *buf, size_t size)
+PURPOSE	Find the start of the entropy-coded data in a JPEG stream.
+INPUT	Pointer to the JPEG stream,
+	stream size in bytes.
+OUTPUT	Offset of the first byte following the SOS segment, or 0 if not found.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+size_t	jpeg_headersize(unsigned char *buf, size_t size)
+  {
+   size_t	pos;
+   int		marker;
+
+  if (size<4 || buf[0]!=0xff || buf[1]!=0xd8)
+    return 0;
+  for (pos=2; pos+4<=size;)
+    {
+    if (buf[pos]!=0xff)
+      return 0;
+    marker = buf[pos+1];
+    pos += 2 + ((buf[pos+2]<<8) | buf[pos+3]);
+    if (marker == 0xda)			/* SOS */
+      return pos<=size? pos : 0;
+    }
+
+  return 0;
+  }
+
+
+/****** jpeg_setheight ********************************************************
+PROTO	void jpeg_setheight(unsigned char *buf, size_t hsize, int height)
+PURPOSE	Change the image height recorded in the SOF segment of a JPEG header.
+INPUT	Pointer to the JPEG stream,
+	header size in bytes (as returned by jpeg_headersize()),
+	new image height in pixels.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	jpeg_setheight(unsigned char *buf, size_t hsize, int height)
+  {
+   size_t	pos;
+   int		marker;
+
+  for (pos=2; pos+7<=hsize; pos += 2 + ((buf[pos+2]<<8) | buf[pos+3]))
+    {
+    marker = buf[pos+1];
+    if (marker>=0xc0 && marker<=0xc2)	/* SOF0-2 */
+      {
+      buf[pos+5] = (height>>8)&0xff;
+      buf[pos+6] = height&0xff;
+      return;
+      }
+    }
+
+  return;
+  }
+
+
+/****** jpeg_renumberrst ******************************************************
+PROTO	int jpeg_renumberrst(unsigned char *data, size_t size, int rst)
+PURPOSE	Renumber the restart markers found in JPEG entropy-coded data.
+INPUT	Pointer to the entropy-coded data,
+	data size in bytes,
+	index of the first restart marker.
+OUTPUT	Index of the next restart marker.
+NOTES	Marker numbers are taken modulo 8, as RST0-RST7.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	jpeg_renumberrst(unsigned char *data, size_t size, int rst)
+  {
+   unsigned char	*end;
+
+  end = data + size - 1;
+  for (; data<end; data++)
+    if (*data==0xff && (data[1]&0xf8)==0xd0)
+      *(++data) = 0xd0 + (rst++&7);
+
+  return rst;
+  }
+
+
+/****** jpeg_error_exit *******************************************************
+PROTO	void jpeg_error_exit(j_common_ptr cinfo)
+PURPOSE	Replacement for the libjpeg fatal error handler.
+INPUT	Pointer to the libjpeg common structure.
+OUTPUT	-.
+NOTES	Does not return.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	jpeg_error_exit(j_common_ptr cinfo)
+  {
+   char	msg[JMSG_LENGTH_MAX];
+
+  (*cinfo->err->format_message)(cinfo, msg);
+  error(EXIT_FAILURE, "*Error*: JPEG encoding failed: ", msg);
+  }
+
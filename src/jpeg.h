@@ -0,0 +1,46 @@
+/*
+*				jpeg.h
+*
+* Include file for jpeg.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _JPEG_H_
+#define _JPEG_H_
+
+/*------------------------------- functions ---------------------------------*/
+extern int		encode_jpeg(unsigned char *pix, int width, int height,
+				size_t stride, int nchan, int quality,
+				int restartrows, unsigned char **outbuf,
+				size_t *outsize),
+			jpeg_renumberrst(unsigned char *data, size_t size,
+				int rst);
+
+extern size_t		jpeg_headersize(unsigned char *buf, size_t size);
+
+extern void		jpeg_setheight(unsigned char *buf, size_t hsize,
+				int height);
+
+#endif
+
@@ -0,0 +1,539 @@
+/*
+*				libstiff.c
+*
+* Entry points of the STIFF conversion library (libstiff).
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "batch.h"
+#include "datamem.h"
+#include "prefs.h"
+#include "stiff.h"
+
+/* Conversion context */
+struct structstiff
+  {
+  prefstruct		config;		/* Base configuration */
+  dataarenastruct	*arena;		/* Allocator of image data */
+  };
+
+/* Outcome of the last call, per thread */
+static THREAD_LOCAL char	stiff_errorstr[MAXCHAR];
+static THREAD_LOCAL double	stiff_time, stiff_nlines, stiff_npix;
+
+static char	**stiff_setargs(char *outfilename, char **argkey,
+			char **argval, int narg, int *narg2);
+
+static int	stiff_run(stiffstruct *stiff, char **filename, void **buf,
+			size_t *bufsize, int nfile, char *outfilename,
+			char **argkey, char **argval, int narg,
+			unsigned char **pix, int *width, int *height,
+			int *nchan, int *bpp);
+
+static void	stiff_freeconfig(prefstruct *config);
+
+/****** stiff_new *************************************************************
+PROTO	stiffstruct *stiff_new(char *configname, char **argkey, char **argval,
+			int narg)
+PURPOSE	Create a new conversion context from a configuration file.
+INPUT	Configuration file name (NULL for "stiff.conf"),
+	array of keywords to override,
+	array of override values,
+	number of overrides.
+OUTPUT	Pointer to the new conversion context, or NULL in case of error.
+NOTES	Missing configuration files result in internal defaults being used.
+	Image data of the conversions are allocated within the MEM_MAX and
+	VMEM_MAX budgets of the context (see stiff_convert()). The reason of a
+	failure is returned by stiff_errormsg().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+stiffstruct	*stiff_new(char *configname, char **argkey, char **argval,
+			int narg)
+  {
+   stiffstruct		*stiff;
+   prefstruct		*oldprefs;
+   jmp_buf		trap, *oldtrap;
+   int			status;
+
+  *stiff_errorstr = '\0';
+  if (!(stiff = calloc(1, sizeof(stiffstruct))))
+    {
+    strcpy(stiff_errorstr, "*Error*: Not enough memory for a new context");
+    return NULL;
+    }
+  if (!configname)
+    configname = "stiff.conf";
+/* The configuration is read into the context; the command line (if any) */
+/* is inherited from the caller for the XML metadata */
+  stiff->config.command_line = prefs.command_line;
+  stiff->config.ncommand_line = prefs.ncommand_line;
+  oldprefs = bindprefs(&stiff->config);
+  oldtrap = error_settrap(&trap);
+  if (!setjmp(trap))
+    {
+    strncpy(prefs.prefs_name, configname, MAXCHAR-1);
+    readprefs(prefs.prefs_name, argkey, argval, narg);
+    preprefs();
+    memprefs();
+    status = RETURN_OK;
+    }
+  else
+    {
+    strncpy(stiff_errorstr, error_trapmsg(), MAXCHAR-1);
+    status = RETURN_ERROR;
+    }
+  error_settrap(oldtrap);
+  bindprefs(oldprefs);
+  if (status != RETURN_OK)
+    {
+    stiff_freeconfig(&stiff->config);
+    free(stiff);
+    return NULL;
+    }
+  stiff->arena = new_dataarena(stiff->config.mem_max, stiff->config.vmem_max,
+	stiff->config.swapdir_name,
+	stiff->config.vmem_type == VMEM_COMPRESSED);
+
+  return stiff;
+  }
+
+
+/****** stiff_convert *********************************************************
+PROTO	int stiff_convert(stiffstruct *stiff, char **filename, int nfile,
+			char *outfilename, char **argkey, char **argval,
+			int narg)
+PURPOSE	Convert one or several FITS files to an output image file.
+INPUT	Pointer to the conversion context,
+	array of input FITS file names (one per channel),
+	number of input files,
+	output file name (NULL for the configured OUTFILE_NAME),
+	array of keywords to override for this conversion only,
+	array of override values,
+	number of overrides.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	The output format follows the context configuration and overrides.
+	Calls may run concurrently from different threads, including with the
+	same context: each call works on its own copy of the configuration.
+	Calls share the RAM and swap space budgets of the context, unless
+	they override MEM_MAX, VMEM_MAX, VMEM_DIR or VMEM_TYPE with different
+	values: they then get budgets of their own.
+	The reason of a failure is returned by stiff_errormsg().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	stiff_convert(stiffstruct *stiff, char **filename, int nfile,
+			char *outfilename, char **argkey, char **argval,
+			int narg)
+  {
+  return stiff_run(stiff, filename, NULL, NULL, nfile, outfilename,
+		argkey, argval, narg, NULL, NULL, NULL, NULL, NULL);
+  }
+
+
+/****** stiff_convertbuf ******************************************************
+PROTO	int stiff_convertbuf(stiffstruct *stiff, void **buf, size_t *bufsize,
+			int nbuf, char *outfilename, char **argkey,
+			char **argval, int narg)
+PURPOSE	Convert one or several in-memory FITS files to an output image file.
+INPUT	Pointer to the conversion context,
+	array of pointers to the FITS contents (one per channel),
+	array of FITS content sizes in bytes,
+	number of input buffers,
+	output file name (NULL for the configured OUTFILE_NAME),
+	array of keywords to override for this conversion only,
+	array of override values,
+	number of overrides.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Same as stiff_convert(). Buffers are read only; mosaics cannot be
+	built from in-memory inputs.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	stiff_convertbuf(stiffstruct *stiff, void **buf, size_t *bufsize,
+			int nbuf, char *outfilename, char **argkey,
+			char **argval, int narg)
+  {
+  return stiff_run(stiff, NULL, buf, bufsize, nbuf, outfilename,
+		argkey, argval, narg, NULL, NULL, NULL, NULL, NULL);
+  }
+
+
+/****** stiff_render **********************************************************
+PROTO	int stiff_render(stiffstruct *stiff, char **filename, int nfile,
+			char **argkey, char **argval, int narg,
+			unsigned char **pix, int *width, int *height,
+			int *nchan, int *bpp)
+PURPOSE	Convert one or several FITS files to an in-memory raster.
+INPUT	Pointer to the conversion context,
+	array of input FITS file names (one per channel),
+	number of input files,
+	array of keywords to override for this conversion only,
+	array of override values,
+	number of overrides,
+	pointer to the output raster pointer (allocated here),
+	pointer to the raster width in pixels,
+	pointer to the raster height in pixels,
+	pointer to the number of channels,
+	pointer to the number of bits per channel (negative for floats).
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	The raster is stored top line first with interleaved channels, in
+	native byte order; it must be freed with free() by the caller.
+	IMAGE_TYPE is ignored: no file is written. See also stiff_convert().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	stiff_render(stiffstruct *stiff, char **filename, int nfile,
+			char **argkey, char **argval, int narg,
+			unsigned char **pix, int *width, int *height,
+			int *nchan, int *bpp)
+  {
+  return stiff_run(stiff, filename, NULL, NULL, nfile, NULL,
+		argkey, argval, narg, pix, width, height, nchan, bpp);
+  }
+
+
+/****** stiff_renderbuf *******************************************************
+PROTO	int stiff_renderbuf(stiffstruct *stiff, void **buf, size_t *bufsize,
+			int nbuf, char **argkey, char **argval, int narg,
+			unsigned char **pix, int *width, int *height,
+			int *nchan, int *bpp)
+PURPOSE	Convert one or several in-memory FITS files to an in-memory raster.
+INPUT	Pointer to the conversion context,
+	array of pointers to the FITS contents (one per channel),
+	array of FITS content sizes in bytes,
+	number of input buffers,
+	array of keywords to override for this conversion only,
+	array of override values,
+	number of overrides,
+	pointer to the output raster pointer (allocated here),
+	pointer to the raster width in pixels,
+	pointer to the raster height in pixels,
+	pointer to the number of channels,
+	pointer to the number of bits per channel (negative for floats).
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	See stiff_convertbuf() and stiff_render().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	stiff_renderbuf(stiffstruct *stiff, void **buf, size_t *bufsize,
+			int nbuf, char **argkey, char **argval, int narg,
+			unsigned char **pix, int *width, int *height,
+			int *nchan, int *bpp)
+  {
+  return stiff_run(stiff, NULL, buf, bufsize, nbuf, NULL,
+		argkey, argval, narg, pix, width, height, nchan, bpp);
+  }
+
+
+/****** stiff_errormsg ********************************************************
+PROTO	const char *stiff_errormsg(void)
+PURPOSE	Return the error message of the last failed call.
+INPUT	-.
+OUTPUT	Pointer to the error message (empty if the last call succeeded).
+NOTES	Messages are kept per thread.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+const char	*stiff_errormsg(void)
+  {
+  return stiff_errorstr;
+  }
+
+
+/****** stiff_stats ***********************************************************
+PROTO	void stiff_stats(double *time, double *nlines, double *npix)
+PURPOSE	Return processing statistics of the last conversion.
+INPUT	Pointer to the elapsed time in seconds (or NULL),
+	pointer to the number of lines processed (or NULL),
+	pointer to the number of pixels processed (or NULL).
+OUTPUT	-.
+NOTES	Statistics are kept per thread.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	stiff_stats(double *time, double *nlines, double *npix)
+  {
+  if (time)
+    *time = stiff_time;
+  if (nlines)
+    *nlines = stiff_nlines;
+  if (npix)
+    *npix = stiff_npix;
+
+  return;
+  }
+
+
+/****** stiff_config **********************************************************
+PROTO	prefstruct *stiff_config(stiffstruct *stiff)
+PURPOSE	Return the base configuration of a conversion context.
+INPUT	Pointer to the conversion context.
+OUTPUT	Pointer to the configuration.
+NOTES	Not part of the public API: used by the stiff executable to report on
+	the conversions it runs. The configuration must not be modified.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+prefstruct	*stiff_config(stiffstruct *stiff)
+  {
+  return &stiff->config;
+  }
+
+
+/****** stiff_free ************************************************************
+PROTO	void stiff_free(stiffstruct *stiff)
+PURPOSE	Free a conversion context.
+INPUT	Pointer to the conversion context.
+OUTPUT	-.
+NOTES	No conversion may be running with the context.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	stiff_free(stiffstruct *stiff)
+  {
+  if (!stiff)
+    return;
+
+  stiff_freeconfig(&stiff->config);
+  end_dataarena(stiff->arena);
+  free(stiff);
+
+  return;
+  }
+
+
+/****** stiff_run *************************************************************
+PROTO	int stiff_run(stiffstruct *stiff, char **filename, void **buf,
+			size_t *bufsize, int nfile, char *outfilename,
+			char **argkey, char **argval, int narg,
+			unsigned char **pix, int *width, int *height,
+			int *nchan, int *bpp)
+PURPOSE	Run a conversion job with its own copy of the configuration.
+INPUT	Pointer to the conversion context,
+	array of input FITS file names (or NULL),
+	array of pointers to in-memory FITS contents (or NULL),
+	array of in-memory FITS content sizes,
+	number of inputs,
+	output file name (or NULL),
+	array of keywords to override,
+	array of override values,
+	number of overrides,
+	pointer to the output raster pointer (NULL for file output),
+	pointer to the raster width in pixels,
+	pointer to the raster height in pixels,
+	pointer to the number of channels,
+	pointer to the number of bits per channel.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	The job configuration is bound to the calling thread for the
+	duration of the job (see bindprefs()), and errors are trapped (see
+	error_settrap()).
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	stiff_run(stiffstruct *stiff, char **filename, void **buf,
+			size_t *bufsize, int nfile, char *outfilename,
+			char **argkey, char **argval, int narg,
+			unsigned char **pix, int *width, int *height,
+			int *nchan, int *bpp)
+  {
+   prefstruct		*job, *oldprefs;
+   jmp_buf		trap, *oldtrap;
+   char			** volatile bufname,
+			**args;
+   int			f, narg2, status;
+
+  *stiff_errorstr = '\0';
+  stiff_time = stiff_nlines = stiff_npix = 0.0;
+  if (pix)
+    *pix = NULL;
+  if (!stiff || nfile<1 || nfile>MAXFILE || (!filename && !buf))
+    {
+    strcpy(stiff_errorstr, "*Error*: invalid conversion request");
+    return RETURN_ERROR;
+    }
+
+/* The job configuration is too large for the stack */
+  if (!(job = calloc(1, sizeof(prefstruct))))
+    {
+    strcpy(stiff_errorstr, "*Error*: Not enough memory for a new job");
+    return RETURN_ERROR;
+    }
+  bufname = NULL;
+  args = stiff_setargs(outfilename, argkey, argval, narg, &narg2);
+  oldprefs = bindprefs(job);
+  oldtrap = error_settrap(&trap);
+  if (!setjmp(trap))
+    {
+/*-- In-memory inputs are given names for the logs and metadata */
+    if (buf)
+      {
+      QCALLOC(bufname, char *, nfile);
+      QMALLOC(bufname[0], char, nfile*32);
+      for (f=0; f<nfile; f++)
+        sprintf(bufname[f] = bufname[0]+f*32, "buffer#%d", f+1);
+      filename = bufname;
+      }
+    setjob(&stiff->config, filename, nfile, args, args+narg2, narg2);
+/*-- Conversions with the memory settings of the context share its budgets */
+    if (prefs.mem_max == stiff->config.mem_max
+	&& prefs.vmem_max == stiff->config.vmem_max
+	&& prefs.vmem_type == stiff->config.vmem_type
+	&& !strcmp(prefs.swapdir_name, stiff->config.swapdir_name))
+      {
+      prefs.arena = stiff->arena;
+      strcpy(prefs.mem_source, stiff->config.mem_source);
+      strcpy(prefs.vmem_source, stiff->config.vmem_source);
+      }
+    if (buf && prefs.mosaic_type != MOSAIC_NONE)
+      error(EXIT_FAILURE, "*Error*: cannot build a mosaic from ",
+		"in-memory inputs");
+    prefs.file_buf = buf;
+    prefs.file_bufsize = bufsize;
+    if (pix)
+      {
+      prefs.format_type2 = FORMAT_RASTER;
+      prefs.raster_pix = NULL;
+      }
+    error_settrap(oldtrap);
+    status = makeit();
+    if (status != RETURN_OK)
+      strcpy(stiff_errorstr, prefs.error_msg);
+    }
+  else
+    {
+/*-- Error while setting up the job */
+    strncpy(stiff_errorstr, error_trapmsg(), MAXCHAR-1);
+    error_settrap(oldtrap);
+    status = RETURN_ERROR;
+    }
+
+  if (status == RETURN_OK)
+    {
+    stiff_time = prefs.time_diff;
+    stiff_nlines = prefs.nlines;
+    stiff_npix = prefs.npix;
+    }
+  if (pix)
+    {
+    if (status == RETURN_OK && prefs.raster_pix)
+      {
+      *pix = prefs.raster_pix;
+      *width = prefs.raster_width;
+      *height = prefs.raster_height;
+      *nchan = prefs.raster_nchan;
+      *bpp = prefs.raster_bpp;
+      }
+    else
+      {
+      free(prefs.raster_pix);
+      status = RETURN_ERROR;
+      }
+    prefs.raster_pix = NULL;
+    }
+  freejob();
+  bindprefs(oldprefs);
+  free(job);
+  if (bufname)
+    {
+    free(bufname[0]);
+    free(bufname);
+    }
+  free(args);
+
+  return status;
+  }
+
+
+/****** stiff_freeconfig ******************************************************
+PROTO	void stiff_freeconfig(prefstruct *config)
+PURPOSE	Free the string lists of a base configuration.
+INPUT	Pointer to the configuration.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	stiff_freeconfig(prefstruct *config)
+  {
+   int	t;
+
+  for (t=0; t<MAXTAG; t++)
+    free(config->channel_tags[t]);
+  for (t=0; t<2; t++)
+    free(config->mosaic_key[t]);
+
+  return;
+  }
+
+
+/****** stiff_setargs *********************************************************
+PROTO	char **stiff_setargs(char *outfilename, char **argkey, char **argval,
+			int narg, int *narg2)
+PURPOSE	Build the keyword and value arrays of a conversion job.
+INPUT	Output file name (or NULL),
+	array of keywords to override,
+	array of override values,
+	number of overrides,
+	pointer to the total number of overrides.
+OUTPUT	Pointer to the keywords, immediately followed by the values.
+NOTES	The returned array must be freed with free() by the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static char	**stiff_setargs(char *outfilename, char **argkey,
+			char **argval, int narg, int *narg2)
+  {
+   char	**args;
+   int	n;
+
+  n = narg + (outfilename? 1 : 0);
+  QMALLOC(args, char *, 2*n+1);
+  if (narg)
+    {
+    memcpy(args, argkey, narg*sizeof(char *));
+    memcpy(args+n, argval, narg*sizeof(char *));
+    }
+  if (outfilename)
+    {
+    args[narg] = "OUTFILE_NAME";
+    args[n+narg] = outfilename;
+    }
+  *narg2 = n;
+
+  return args;
+  }
+
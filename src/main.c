@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		08/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -40,26 +40,37 @@
 #include	"define.h"
 #include	"globals.h"
 #include	"fits/fitscat.h"
+#include	"batch.h"
+#include	"datamem.h"
 #include	"prefs.h"
+#include	"quantile.h"
+#include	"server.h"
+#include	"stiff.h"
 
 #define		SYNTAX \
 EXECUTABLE " [<fits_file1>] [<fits_file2> <fits_file3>]\n"\
 "      [-c <configuration_file>] [-<keyword> <value>]\n"\
+"> to run a batch of jobs: " EXECUTABLE " -b <manifest_file>\n" \
+"> to serve requests on a local socket: " EXECUTABLE " -s <socket_path>\n" \
+"> to only plan the conversion (dry run): " EXECUTABLE " -plan [...]\n" \
 "> to dump a default configuration file: " EXECUTABLE " -d \n" \
 "> to dump a default extended configuration file: " EXECUTABLE " -dd \n"
 
 extern const char	notokstr[];
+extern prefstruct	*stiff_config(stiffstruct *stiff);
 
 /********************************** main ************************************/
 int	main(int argc, char *argv[])
 
   {
+   stiffstruct	*stiff;
    double	tdiff, lines,mpix;
    float	ver;
    char		verstr[MAXCHAR],liststr[MAXCHAR],
-			**argkey, **argval,
-			*str,*listname,*listbuf;
-   int		a, narg, nim, opt,opt2, bufpos, bufsize;
+			**argkey, **argval, *filename[MAXFILE],
+			*str,*listname,*listbuf, *batchname, *sockname,
+			*prefsname;
+   int		a, narg, nim, opt,opt2, bufpos, bufsize, planflag;
 
 #ifdef HAVE_SETLINEBUF
 /* flush output buffer at each line */
@@ -86,10 +97,9 @@ int	main(int argc, char *argv[])
 /* Default parameters */
   prefs.command_line = argv;
   prefs.ncommand_line = argc;
-  prefs.nfile = 1;
-  prefs.file_name[0] = "image";
-  strcpy(prefs.prefs_name, "stiff.conf");
-  narg = nim = 0;
+  prefsname = "stiff.conf";
+  narg = nim = planflag = 0;
+  batchname = sockname = NULL;
   listbuf = (char *)NULL;
   bufpos = 0;
   bufsize = MAXCHAR*1000;
@@ -109,9 +119,20 @@ int	main(int argc, char *argv[])
           }
         switch(opt)
           {
+          case 'b':
+            if (a<(argc-1))
+              batchname = argv[++a];
+            break;
+          case 's':
+            if (a<(argc-1))
+              sockname = argv[++a];
+            break;
           case 'c':
             if (a<(argc-1))
-              strcpy(prefs.prefs_name, argv[++a]);
+              prefsname = argv[++a];
+            break;
+          case 'p':
+            planflag = 1;
             break;
           case 'd':
             dumpprefs(opt2=='d' ? 1 : 0);
@@ -126,6 +147,8 @@ int	main(int argc, char *argv[])
             error(EXIT_SUCCESS,"SYNTAX: ", SYNTAX);
           }
         }
+      else if (!strcmp(argv[a], "-plan"))
+        planflag = 1;
       else
         {
         argkey[narg] = &argv[a][1];
@@ -138,31 +161,69 @@ int	main(int argc, char *argv[])
       for(; (a<argc) && (*argv[a]!='-'); a++)
         for (str=NULL;(str=strtok(str?NULL:argv[a], notokstr)); nim++)
           if (nim<MAXFILE)
-            prefs.file_name[nim] = str;
+            filename[nim] = str;
           else
             error(EXIT_FAILURE, "*Error*: Too many input images: ", str);
-      prefs.nfile = nim;
       a--;
       }
     }
 
-  readprefs(prefs.prefs_name, argkey, argval, narg);
-  preprefs();
-  useprefs();
+/* -plan is a shortcut for a leading -PLAN_TYPE JSON override */
+  if (planflag)
+    {
+    memmove(argkey+1, argkey, narg*sizeof(char *));
+    memmove(argval+1, argval, narg*sizeof(char *));
+    argkey[0] = "PLAN_TYPE";
+    argval[0] = "JSON";
+    narg++;
+    }
+
+  if (batchname || sockname)
+    {
+    strcpy(prefs.prefs_name, prefsname);
+    readprefs(prefs.prefs_name, argkey, argval, narg);
+    preprefs();
+    if (prefs.plan_type != PLAN_NONE)
+      planflag = 1;
+    if (batchname)
+      makebatch(batchname);
+    else
+      makeserver(sockname);
+    }
+  else
+    {
+    if (!nim)
+      filename[nim++] = "image";
+    if (!(stiff = stiff_new(prefsname, argkey, argval, narg))
+	|| stiff_convert(stiff, filename, nim, NULL, NULL, NULL, 0)
+		!= STIFF_OK)
+      exit(EXIT_FAILURE);
+    stiff_stats(&prefs.time_diff, &prefs.nlines, &prefs.npix);
+/*-- Final report with the verbosity of the conversion; PLAN_TYPE may */
+/*-- also come from the configuration file */
+    prefs.verbose_type = stiff_config(stiff)->verbose_type;
+    if (stiff_config(stiff)->plan_type != PLAN_NONE)
+      planflag = 1;
+    stiff_free(stiff);
+    }
 
   free(argkey);
   free(argval);
-
-
-  makeit();
+/* Selection threads are re-used by all the jobs of a run */
+  end_scratch();
+  end_quantile();
 
   NFPRINTF(OUTPUT, "");
-  tdiff = prefs.time_diff>0.0? prefs.time_diff : 0.001;
-  lines = prefs.nlines/tdiff;
-  mpix = prefs.npix/tdiff/1e6;
-  NPRINTF(OUTPUT,
+/* There is no throughput to report for a dry run */
+  if (!planflag)
+    {
+    tdiff = prefs.time_diff>0.0? prefs.time_diff : 0.001;
+    lines = prefs.nlines/tdiff;
+    mpix = prefs.npix/tdiff/1e6;
+    NPRINTF(OUTPUT,
         "> All done (in %.1f s: %.1f line%s/s , %.1f Mpixel%s/s)\n",
         prefs.time_diff, lines, lines>1.0? "s":"", mpix, mpix>1.0? "s":"");
+    }
 
   exit(EXIT_SUCCESS);
   }
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -31,6 +31,7 @@
 #endif
 
 #include <math.h>
+#include <setjmp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,40 +42,122 @@
 #include "define.h"
 #include "globals.h"
 #include "fits/fitscat.h"
+#include "cutout.h"
+#include "datamem.h"
 #include "field.h"
 #include "image.h"
 #include "key.h"
+#include "mosaic.h"
+#include "plan.h"
 #include "prefs.h"
+#include "progress.h"
+#include "tiletree.h"
+#include "timing.h"
+#include "update.h"
 #include "xml.h"
 
 
 extern pkeystruct	key[];
 extern char		keylist[][32];
-time_t			thetime, thetime2;
-double			dtime;
 
-/********************************** makeit ***********************************/
-void	makeit(void)
+static void	abort_job(fieldstruct **fields, int nfield),
+		run_job(fieldstruct **fields, int nfield);
+
+/****** makeit ****************************************************************
+PROTO	int makeit(void)
+PURPOSE	Run the conversion job described by the current preferences.
+INPUT	-.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Errors raised in the calling thread during the job are trapped: the
+	job is cleaned up, an XML error report is written if requested, and
+	the message is left in prefs.error_msg. Jobs may run concurrently in
+	different threads, each with its own preferences (see bindprefs()).
+	Image data are allocated from prefs.arena if set (libstiff contexts),
+	or from an allocator of the job's own otherwise. Peak uses are left in
+	prefs.mem_peak and prefs.vmem_peak. Idle scratch buffers are released
+	at the end of the job.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	makeit(void)
   {
-   struct tm		*tm;
+   dataarenastruct	*arena;
+   jmp_buf		trap, *oldtrap;
    fieldstruct		**fields;
-   PIXTYPE		grey;
+   int			f, nfield, status;
+
+  *prefs.error_msg = '\0';
+  arena = NULL;
+  if (!prefs.arena)
+    prefs.arena = arena = new_dataarena(prefs.mem_max, prefs.vmem_max,
+		prefs.swapdir_name, prefs.vmem_type == VMEM_COMPRESSED);
+/* A mosaic is converted as a single field */
+  nfield = prefs.mosaic_type==MOSAIC_NONE? prefs.nfile : 1;
+  QCALLOC(fields, fieldstruct *, nfield);
+  oldtrap = error_settrap(&trap);
+  if (!setjmp(trap))
+    {
+    run_job(fields, nfield);
+    status = RETURN_OK;
+    }
+  else
+    {
+    strncpy(prefs.error_msg, error_trapmsg(), MAXCHAR-1);
+    prefs.error_msg[MAXCHAR-1] = '\0';
+/*-- Errors while cleaning up leave the remaining resources behind */
+    if (!setjmp(trap))
+      {
+      error_settrap(&trap);
+      abort_job(fields, nfield);
+      }
+    status = RETURN_ERROR;
+    }
+  error_settrap(oldtrap);
+
+/* Free memory */
+  for (f=0; f<nfield; f++)
+    if (fields[f])
+      end_field(fields[f]);
+  free(fields);
+  get_datapeaks(prefs.arena, &prefs.mem_peak, &prefs.vmem_peak);
+  if (arena)
+    {
+    end_dataarena(arena);
+    prefs.arena = NULL;
+    }
+  release_scratch();
+
+  return status;
+  }
+
+
+/****** run_job ***************************************************************
+PROTO	void run_job(fieldstruct **fields, int nfield)
+PURPOSE	Load the input fields and run the conversion.
+INPUT	Array of (NULL) field pointers,
+	number of fields.
+OUTPUT	-.
+NOTES	Loaded fields are left in the array, for the caller to free.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	run_job(fieldstruct **fields, int nfield)
+  {
    float		ver;
-   char			verstr[MAXCHAR], imtype[MAXCHAR],
+   char			verstr[MAXCHAR], imtype[MAXCHAR], compstr[MAXCHAR],
 			*rfilename;
-   int			f,i, w,h, nfield, nbit, level;
+   int			f, w,h, nbit, level, nlevels, ntiles;
 
-/* Install error logging */
-//  error_installfunc(write_error);
+/* Dry run */
+  if (prefs.plan_type != PLAN_NONE)
+    {
+    makeplan();
+    return;
+    }
 
 /* Processing start date and time */
-  dtime = counter_seconds();
-  thetime = time(NULL);
-  tm = localtime(&thetime);
-  sprintf(prefs.sdate_start,"%04d-%02d-%02d",
-	tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday);
-  sprintf(prefs.stime_start,"%02d:%02d:%02d",
-	tm->tm_hour, tm->tm_min, tm->tm_sec);
+  prefs.time_start = counter_seconds();
+  set_datetime(prefs.sdate_start, prefs.stime_start);
 
   NFPRINTF(OUTPUT, "");
   QPRINTF(OUTPUT,
@@ -93,8 +176,6 @@ void	makeit(void)
     NPRINTF(OUTPUT, "> BigTIFF support is: OFF (libTIFF V%3.1f)\n\n", ver);
 
 /* Load input images */
-  nfield = prefs.nfile;
-  QMALLOC(fields, fieldstruct *, nfield);
 /* Go argument by argument */
   NFPRINTF(OUTPUT, "Examining input data...");
   NFPRINTF(OUTPUT, "");
@@ -103,34 +184,42 @@ void	makeit(void)
   if (prefs.xml_flag)
     init_xml(nfield);
 
+/* Start recording a trace */
+  if (prefs.trace_flag)
+    init_trace();
+  start_tracejob(prefs.tiff_name);
+
+/* Start reporting progress */
+  if (prefs.progress_flag)
+    init_progress(prefs.progress_name, prefs.progress_interval,
+	prefs.tiff_name, prefs.arena);
+
 /* Read the FITS files */
   QPRINTF(OUTPUT, "----- Inputs:\n");
-  for (f=0; f<nfield; f++)
-    fields[f] = load_field(prefs.file_name[f]);
+  if (prefs.mosaic_type == MOSAIC_NONE)
+    for (f=0; f<nfield; f++)
+      fields[f] = load_field(prefs.file_name[f],
+		prefs.file_buf? prefs.file_buf[f] : NULL,
+		prefs.file_buf? prefs.file_bufsize[f] : 0);
+  else
+    fields[0] = load_mosaic(prefs.file_name, prefs.nfile);
 
 /* Tag fields */
   tag_fields(fields, nfield);
 
+/* Pyramid updates keep the levels of the original conversion */
+  if (prefs.pyrupdate_flag
+	&& read_xmllevels(prefs.xml_name, fields, nfield) != RETURN_OK)
+    error(EXIT_FAILURE, "*Error*: cannot read the original levels from ",
+	prefs.xml_name);
+
 /* Compute/set flux rescaling */
   for (f=0; f<nfield; f++)
     {
-    i = fields[f]->index;
-    fields[f]->back = prefs.back_val[i];
-    fields[f]->max = prefs.max_val[i];
-    fields[f]->min = prefs.min_val[i];
-    if (prefs.back_type[i]!=BACK_MANUAL || prefs.max_type[i]==MAX_QUANTILE
-	 ||  prefs.min_type[i]==MIN_QUANTILE)
-      make_imastats(fields[f],
-	prefs.back_type[i]!=BACK_MANUAL, prefs.min_type[i]==MIN_QUANTILE,
-	prefs.max_type[i]==MAX_QUANTILE);
-    if (fields[f]->max > prefs.sat_val[i])
-      warning("MAX_LEVEL exceeds SATUR_LEVEL in ", fields[f]->rfilename);
-
-    if (prefs.min_type[i] == MIN_GREYLEVEL)
-      {
-      grey = pow(prefs.min_val[i], prefs.gamma_fac);
-      fields[f]->min = (fields[f]->max*grey - fields[f]->back) / (grey - 1.0);
-      }
+/*-- Multiple cutouts may have their own levels, measured at conversion */
+    if (!prefs.pyrupdate_flag
+	&& (prefs.nregion<=4 || prefs.regionstats_type==REGIONSTATS_FULL))
+      set_fieldlevels(fields[f], NULL, 0);
     print_fieldinfo(fields[f]);
     }
 
@@ -142,11 +231,11 @@ void	makeit(void)
     rfilename++;
 
   w = prefs.bin_size[0]>1?
-	  (fields[0]->tab->naxisn[0]+prefs.bin_size[0]-1)/prefs.bin_size[0]
-	: fields[0]->tab->naxisn[0];
+	  (fields[0]->size[0]+prefs.bin_size[0]-1)/prefs.bin_size[0]
+	: fields[0]->size[0];
   h = prefs.bin_size[1]>1?
-	  (fields[0]->tab->naxisn[1]+prefs.bin_size[1]-1)/prefs.bin_size[1]
-	: fields[0]->tab->naxisn[1];
+	  (fields[0]->size[1]+prefs.bin_size[1]-1)/prefs.bin_size[1]
+	: fields[0]->size[1];
 
   prefs.nlines = (double)h;
   prefs.npix = (double)w*(double)h;
@@ -156,12 +245,45 @@ void	makeit(void)
     sprintf(imtype,"integers");
   else
     sprintf(imtype,"floats");
+/* Codec of the output: COMPRESSION_TYPE only applies to TIFF */
+  switch(prefs.format_type2)
+    {
+    case FORMAT_JPEG:
+      sprintf(compstr, "JPEG (quality %d)", prefs.compress_quality);
+      break;
+    case FORMAT_PNG:
+      sprintf(compstr, "PNG deflate (level %d)", prefs.compress_quality*9/100);
+      break;
+    case FORMAT_DEEPZOOM:
+    case FORMAT_XYZ:
+      if (prefs.tilefile_type == TILEFILE_PNG)
+        sprintf(compstr, "PNG deflate (level %d)",
+		prefs.compress_quality*9/100);
+      else
+        sprintf(compstr, "JPEG (quality %d)", prefs.compress_quality);
+      break;
+    case FORMAT_ZARR:
+      sprintf(compstr, "zlib (level %d)", prefs.compress_quality*9/100);
+      break;
+    case FORMAT_RASTER:
+      strcpy(compstr, "NONE");
+      break;
+    default:
+      strcpy(compstr, key[findkeys("COMPRESSION_TYPE", keylist,
+		FIND_STRICT)].keylist[prefs.compress_type]);
+    }
+
   QPRINTF(OUTPUT, "\n----- Output:\n");
-  for (level = 1;
-	((prefs.format_type2 == FORMAT_TIFF_PYRAMID)
-		&& (w>=prefs.min_size[0] || h>=prefs.min_size[1]))
-	|| level<2;
-	level++, w/=2,h/=2)
+  if (prefs.nregion>4)
+    {
+    QPRINTF(OUTPUT, "%s: %d cutouts   %4dx%-2d bits (%s)\n",
+        rfilename, prefs.nregion/4, nfield, nbit, imtype);
+    nlevels = 0;
+    }
+  else
+    nlevels = pyramid_nlevels(w, h);
+  for (level = 0; level<nlevels || (!level && prefs.nregion<=4); level++)
+    {
     QPRINTF(OUTPUT, "%s: %7dx%-7d  %4dx%-2d bits (%s) gamma: x%4.2f  compression: %s \n",
         rfilename,
 	w,
@@ -170,30 +292,67 @@ void	makeit(void)
 	nbit,
         imtype,
 	prefs.gamma_fac,
-	key[findkeys("COMPRESSION_TYPE", keylist,
-		FIND_STRICT)].keylist[prefs.compress_type]);
+	compstr);
+    if (prefs.format_type2 == FORMAT_TIFF_PYRAMID)
+      {
+      w /= 2;
+      h /= 2;
+      }
+    else
+      {
+      w = (w+1)/2;
+      h = (h+1)/2;
+      }
+    }
 
   QPRINTF(OUTPUT, "\n");
 
 /* Do the conversion */
-  if (prefs.format_type2 == FORMAT_TIFF_PYRAMID)
+  if (prefs.pyrupdate_flag)
+    {
+    ntiles = image_update_pyramid(prefs.tiff_name, fields, nfield);
+    QPRINTF(OUTPUT, "%s: %d tile%s updated\n", rfilename, ntiles,
+	ntiles>1? "s":"");
+    }
+  else if (prefs.nregion>4)
+    image_convert_cutouts(prefs.tiff_name, fields, nfield);
+  else if (prefs.format_type2 == FORMAT_TIFF_PYRAMID
+	|| prefs.format_type2 == FORMAT_DEEPZOOM
+	|| prefs.format_type2 == FORMAT_XYZ
+	|| prefs.format_type2 == FORMAT_ZARR)
     image_convert_pyramid(prefs.tiff_name, fields, nfield);
   else
     image_convert_single(prefs.tiff_name, fields, nfield);
 
+/* Verify input checksums from the data read during the conversion */
+  if (prefs.checksum_flag)
+    for (f=0; f<nfield; f++)
+      verify_fieldsum(fields[f]);
+
 /* Update the output field meta-data */
   for (f=0; f<nfield; f++)
     if (prefs.xml_flag)
       update_xml(fields[f]);
 
 /* Processing end date and time */
-  thetime2 = time(NULL);
-  tm = localtime(&thetime2);
-  sprintf(prefs.sdate_end,"%04d-%02d-%02d",
-	tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday);
-  sprintf(prefs.stime_end,"%02d:%02d:%02d",
-	tm->tm_hour, tm->tm_min, tm->tm_sec);
-  prefs.time_diff = counter_seconds() - dtime;
+  set_datetime(prefs.sdate_end, prefs.stime_end);
+  prefs.time_diff = counter_seconds() - prefs.time_start;
+  stop_tracejob();
+  end_progress();
+
+/* Write trace */
+  if (prefs.trace_flag)
+    {
+    if (write_trace(prefs.trace_name) != RETURN_OK)
+      warning("cannot write trace file ", prefs.trace_name);
+    end_trace();
+    }
+
+#ifdef USE_PROBES
+/* Write timing probes (counts accumulate over batch jobs) */
+  if (write_probes(prefs.probe_name) != RETURN_OK)
+    warning("cannot write timing probes to ", prefs.probe_name);
+#endif
 
 /* Write XML */
   if (prefs.xml_flag)
@@ -202,10 +361,31 @@ void	makeit(void)
     end_xml();
     }
 
-/* Free memory */
- for (f=0; f<nfield; f++)
-    end_field(fields[f]);
-  free(fields);
+  return;
+  }
+
+
+/****** abort_job *************************************************************
+PROTO	void abort_job(fieldstruct **fields, int nfield)
+PURPOSE	Clean up after an error trapped during a job.
+INPUT	Array of field pointers,
+	number of fields.
+OUTPUT	-.
+NOTES	The error message is taken from prefs.error_msg. Loaded fields are
+	left to the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	abort_job(fieldstruct **fields, int nfield)
+  {
+  abort_conversion();
+  set_datetime(prefs.sdate_end, prefs.stime_end);
+  prefs.time_diff = counter_seconds() - prefs.time_start;
+  stop_tracejob();
+  end_progress();
+  if (prefs.trace_flag)
+    end_trace();
+  write_error(prefs.error_msg, "");
 
   return;
   }
@@ -219,13 +399,13 @@ INPUT	a character string,
 OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	26/07/2006
+VERSION	19/10/2026
  ***/
 void	write_error(char *msg1, char *msg2)
   {
    char	error[MAXCHAR];
 
-  sprintf(error, "%s%s", msg1,msg2);
+  snprintf(error, MAXCHAR, "%s%s", msg1,msg2);
   if (prefs.xml_flag)
     write_xmlerror(prefs.xml_name, error);
   end_xml();
@@ -234,6 +414,30 @@ void	write_error(char *msg1, char *msg2)
   }
 
 
+/****** set_datetime **********************************************************
+PROTO	void set_datetime(char *sdate, char *stime)
+PURPOSE	Write the current local date and time as strings.
+INPUT	Date string (at least 11 bytes), as YYYY-MM-DD,
+	time string (at least 9 bytes), as hh:mm:ss.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_datetime(char *sdate, char *stime)
+  {
+   struct tm	tm;
+   time_t	thetime;
+
+  thetime = time(NULL);
+  localtime_r(&thetime, &tm);
+  strftime(sdate, 11, "%Y-%m-%d", &tm);
+  strftime(stime, 9, "%H:%M:%S", &tm);
+
+  return;
+  }
+
+
 /****** counter_seconds *******************************************************
 PROTO	static	double counter_seconds(void)
 PURPOSE	Count the number of seconds (with an arbitrary offset).
@@ -0,0 +1,466 @@
+/*
+*				mosaic.c
+*
+* Assemble input FITS tiles into a single mosaic image.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "field.h"
+#include "mosaic.h"
+#include "prefs.h"
+
+#define	MOSAIC_NTILEINC	64		/* Tile array allocation increment */
+
+static int	compare_mosaictiles(const void *tile1, const void *tile2),
+		get_mosaicpos(fieldstruct *reffield, tabstruct *tab,
+			char *filename, double *pos);
+
+static void	close_mosaictile(mosaicstruct *mosaic, mosaictilestruct *tile);
+
+/****** load_mosaic ***********************************************************
+PROTO	fieldstruct *load_mosaic(char **filename, int nfile)
+PURPOSE	Load all the 2D image extensions of a list of FITS files as the tiles
+	of a single mosaic field.
+INPUT	Array of file names (an extension may be specified between []),
+	number of files.
+OUTPUT	A pointer to the created field structure.
+NOTES	Uses the global preferences. Tiles are placed on the pixel grid of the
+	first tile, either from offset keywords (IRAF LTVn convention) or by
+	projecting their CRVALs. The field origin is the opposite of the
+	position of the first tile, so that its WCS is shifted to the mosaic
+	grid. Files are closed once their headers have been read.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+fieldstruct	*load_mosaic(char **filename, int nfile)
+  {
+   fieldstruct		*field;
+   mosaicstruct		*mosaic;
+   mosaictilestruct	*tile, *reftile;
+   catstruct		*cat;
+   tabstruct		*tab, *exttab;
+   double		pos[2];
+   char			fname[MAXCHAR],
+			*rfilename, *str, *str2;
+   int			f,i,t, ntilemax, posmin[2];
+
+  QCALLOC(field, fieldstruct, 1);
+  QCALLOC(mosaic, mosaicstruct, 1);
+  field->mosaic = mosaic;
+  QMALLOC(mosaic->cat, catstruct *, nfile);
+  ntilemax = 0;
+  for (f=0; f<nfile; f++)
+    {
+    strncpy(fname, filename[f], MAXCHAR-1);
+    fname[MAXCHAR-1] = '\0';
+    if ((str = strrchr(fname, '[')))
+      {
+      *str = '\0';
+      if ((str2 = strrchr(str+1, ']')))
+        *str2 = '\0';
+      }
+    if (!(rfilename = strrchr(fname, '/')))
+      rfilename = fname;
+    else
+      rfilename++;
+    snprintf(gstr, MAXCHAR, "Examining File %.*s", MAXCHAR-16, rfilename);
+    NFPRINTF(OUTPUT, gstr);
+    if (!(cat = read_cat(fname)))
+      error(EXIT_FAILURE, "*Error*: no FITS data in ", fname);
+    mosaic->cat[mosaic->ncat++] = cat;
+    exttab = NULL;
+    if (str && !(exttab = name_to_tab(cat, str+1, 0)))
+      exttab = pos_to_tab(cat, atoi(str+1), 0);
+    for (tab=cat->tab, t=0; t<cat->ntab; t++, tab=tab->nexttab)
+      {
+      if ((exttab && tab!=exttab) || tab->naxis<2)
+        continue;
+      if (tab->compress_type != COMPRESS_NONE)
+        error(EXIT_FAILURE, "*Error*: compressed mosaic tiles are not "
+		"supported in ", fname);
+      if (tab->bitsgn && prefs.fitsunsigned_flag)
+        tab->bitsgn = 0;
+      if (prefs.checksum_flag)
+        init_readsum(tab);
+      if (mosaic->ntile >= ntilemax)
+        {
+        ntilemax += MOSAIC_NTILEINC;
+        QREALLOC(mosaic->tile, mosaictilestruct, ntilemax);
+        }
+      tile = &mosaic->tile[mosaic->ntile];
+      memset(tile, 0, sizeof(mosaictilestruct));
+      tile->cat = cat;
+      tile->tab = tab;
+      tile->index = mosaic->ntile++;
+      tile->size[0] = tab->naxisn[0];
+      tile->size[1] = tab->naxisn[1];
+      if (tile->index)
+        get_mosaicpos(field, tab, fname, pos);
+      else
+        {
+/*------ The first tile defines the mosaic pixel grid */
+        field->cat = cat;
+        field->tab = tab;
+/*------ A short, "relative" version of the filename (for messages) */
+        if (!(field->rfilename = strrchr(cat->filename, '/')))
+          field->rfilename = cat->filename;
+        else
+          field->rfilename++;
+        pos[0] = pos[1] = 0.0;
+        if (prefs.mosaic_type == MOSAIC_OFFSET)
+          get_mosaicpos(field, tab, fname, pos);
+        }
+      for (i=0; i<2; i++)
+        tile->origin[i] = (int)floor(pos[i]+0.5);
+      }
+    close_cat(cat);
+    }
+
+  if (!mosaic->ntile)
+    error(EXIT_FAILURE, "*Error*: no 2D FITS data in ", "mosaic");
+
+/* Shift the mosaic grid to the lower left tile corner */
+  posmin[0] = posmin[1] = 0x7fffffff;
+  for (t=0; t<mosaic->ntile; t++)
+    for (i=0; i<2; i++)
+      if (mosaic->tile[t].origin[i] < posmin[i])
+        posmin[i] = mosaic->tile[t].origin[i];
+  reftile = mosaic->tile;
+  for (t=0; t<mosaic->ntile; t++)
+    {
+    tile = &mosaic->tile[t];
+    for (i=0; i<2; i++)
+      {
+      tile->origin[i] -= posmin[i];
+      if (tile->origin[i]+tile->size[i] > mosaic->size[i])
+        mosaic->size[i] = tile->origin[i]+tile->size[i];
+      }
+    if (tile->size[1] > mosaic->maxheight)
+      mosaic->maxheight = tile->size[1];
+    mosaic->npix += (size_t)tile->size[0]*tile->size[1];
+    }
+  for (i=0; i<2; i++)
+    {
+    field->size[i] = mosaic->size[i];
+    field->origin[i] = -reftile->origin[i];
+    }
+  qsort(mosaic->tile, mosaic->ntile, sizeof(mosaictilestruct),
+	compare_mosaictiles);
+  QMALLOC(mosaic->active, mosaictilestruct *, mosaic->ntile);
+  QMALLOC(mosaic->row, mosaictilestruct *, mosaic->ntile);
+  mosaic->margin = prefs.bin_size[1];
+
+  if (!field->tab->headbuf || fitsread(field->tab->headbuf, "OBJECT  ",
+	field->ident, H_STRING,T_STRING)!= RETURN_OK)
+    strcpy(field->ident, "no ident");
+
+  return field;
+  }
+
+
+/****** end_mosaic ************************************************************
+PROTO	void end_mosaic(mosaicstruct *mosaic)
+PURPOSE	Close all the mosaic tiles and free memory.
+INPUT	Pointer to the mosaic.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_mosaic(mosaicstruct *mosaic)
+  {
+  free_cat(mosaic->cat, mosaic->ncat);
+  free(mosaic->tile);
+  free(mosaic->active);
+  free(mosaic->row);
+  free(mosaic);
+
+  return;
+  }
+
+
+/****** read_mosaicrow ********************************************************
+PROTO	void read_mosaicrow(mosaicstruct *mosaic, PIXTYPE *buf)
+PURPOSE	Assemble the current mosaic row and move to the next one.
+INPUT	Pointer to the mosaic,
+	pointer to the output buffer (mosaic->size[0] pixels).
+OUTPUT	-.
+NOTES	Pixels not covered by any tile are flagged as bad (-BIG). Only the
+	tiles that overlap the band of rows being read (the current row plus
+	a margin of mosaic->margin rows) are kept open. Overlapping tiles are
+	drawn in input order, the last one on top.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	read_mosaicrow(mosaicstruct *mosaic, PIXTYPE *buf)
+  {
+   mosaictilestruct	*tile;
+   tabstruct		*tab;
+   PIXTYPE		*buft;
+   int			a,n,t, y,ty, tmin,tmax;
+
+  y = mosaic->y++;
+  for (buft=buf, a=mosaic->size[0]; a--;)
+    *(buft++) = -BIG;
+
+/* Close the tiles that have left the current band */
+  for (a=0; a<mosaic->nactive;)
+    {
+    tile = mosaic->active[a];
+    ty = y - tile->origin[1];
+    if (ty < -mosaic->margin || ty >= tile->size[1]+mosaic->margin)
+      {
+      mosaic->active[a] = mosaic->active[--mosaic->nactive];
+      close_mosaictile(mosaic, tile);
+      }
+    else
+      a++;
+    }
+
+/* Find the first tile that may overlap the current row */
+  tmin = 0;
+  tmax = mosaic->ntile;
+  while (tmin<tmax)
+    {
+    t = (tmin+tmax)/2;
+    if (mosaic->tile[t].origin[1] <= y - mosaic->maxheight)
+      tmin = t+1;
+    else
+      tmax = t;
+    }
+
+/* Tiles are sorted by first row: put those covering the row in input order */
+  n = 0;
+  for (t=tmin, tile=mosaic->tile+t; t<mosaic->ntile && tile->origin[1]<=y;
+	t++, tile++)
+    {
+    if (y - tile->origin[1] >= tile->size[1])
+      continue;
+    for (a=n++; a>0 && mosaic->row[a-1]->index > tile->index; a--)
+      mosaic->row[a] = mosaic->row[a-1];
+    mosaic->row[a] = tile;
+    }
+
+  for (a=0; a<n; a++)
+    {
+    tile = mosaic->row[a];
+    ty = y - tile->origin[1];
+    tab = tile->tab;
+    if (!tile->activeflag)
+      {
+      if (open_cat(tile->cat, READ_ONLY) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: cannot re-open ", tile->cat->filename);
+      tile->activeflag = 1;
+      mosaic->active[mosaic->nactive++] = tile;
+      }
+    QFSEEK(tile->cat->file,
+	tab->bodypos + (OFF_T)ty*tab->naxisn[0]*tab->bytepix,
+	SEEK_SET, tile->cat->filename);
+    read_body(tab, buf + tile->origin[0], (size_t)tile->size[0]);
+    }
+
+  return;
+  }
+
+
+/****** rewind_mosaicbody *****************************************************
+PROTO	void rewind_mosaicbody(mosaicstruct *mosaic)
+PURPOSE	Prepare sequential reading of all the mosaic tile pixels.
+INPUT	Pointer to the mosaic.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	rewind_mosaicbody(mosaicstruct *mosaic)
+  {
+  mosaic->bodytile = 0;
+  mosaic->bodypos = 0;
+
+  return;
+  }
+
+
+/****** read_mosaicbody *******************************************************
+PROTO	void read_mosaicbody(mosaicstruct *mosaic, PIXTYPE *buf, size_t npix)
+PURPOSE	Read the next pixels of the sequence of all the mosaic tiles.
+INPUT	Pointer to the mosaic,
+	pointer to the output buffer,
+	number of pixels to be read.
+OUTPUT	-.
+NOTES	Meant for image statistics: gaps between tiles are skipped and
+	overlaps are counted twice. Tiles are opened one at a time.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	read_mosaicbody(mosaicstruct *mosaic, PIXTYPE *buf, size_t npix)
+  {
+   mosaictilestruct	*tile;
+   size_t		ntpix, n;
+
+  while (npix && mosaic->bodytile<mosaic->ntile)
+    {
+    tile = &mosaic->tile[mosaic->bodytile];
+    ntpix = (size_t)tile->size[0]*tile->size[1];
+    if (!mosaic->bodypos)
+      {
+      if (open_cat(tile->cat, READ_ONLY) != RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: cannot re-open ", tile->cat->filename);
+      QFSEEK(tile->cat->file, tile->tab->bodypos, SEEK_SET,
+		tile->cat->filename);
+      }
+    if ((n = ntpix - mosaic->bodypos) > npix)
+      n = npix;
+    read_body(tile->tab, buf, n);
+    buf += n;
+    npix -= n;
+    if ((mosaic->bodypos += n) == ntpix)
+      {
+      close_cat(tile->cat);
+      mosaic->bodytile++;
+      mosaic->bodypos = 0;
+      }
+    }
+
+  return;
+  }
+
+
+/****** close_mosaictile ******************************************************
+PROTO	void close_mosaictile(mosaicstruct *mosaic, mosaictilestruct *tile)
+PURPOSE	Flag a tile as inactive, and close its file if no other opened tile
+	shares it.
+INPUT	Pointer to the mosaic,
+	pointer to the tile (already removed from the list of active tiles).
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	close_mosaictile(mosaicstruct *mosaic, mosaictilestruct *tile)
+  {
+   int	a;
+
+  tile->activeflag = 0;
+  for (a=0; a<mosaic->nactive; a++)
+    if (mosaic->active[a]->cat == tile->cat)
+      return;
+  close_cat(tile->cat);
+
+  return;
+  }
+
+
+/****** get_mosaicpos *********************************************************
+PROTO	int get_mosaicpos(fieldstruct *reffield, tabstruct *tab,
+			char *filename, double *pos)
+PURPOSE	Compute the position of a tile on the mosaic pixel grid.
+INPUT	Pointer to the reference (first tile) field,
+	pointer to the tile image extension,
+	tile file name (for error messages),
+	pointer to the output position (0-based, of the first tile pixel).
+OUTPUT	RETURN_OK if OK (exits with an error otherwise).
+NOTES	Uses the global preferences. In WCS mode, tile and reference must share
+	the same pixel scale and orientation.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	get_mosaicpos(fieldstruct *reffield, tabstruct *tab,
+			char *filename, double *pos)
+  {
+   double	wcspos[2], crpix[2];
+   char		key[16];
+   int		i;
+
+  if (!tab->headbuf)
+    error(EXIT_FAILURE, "*Error*: no FITS header in ", filename);
+  if (prefs.mosaic_type == MOSAIC_OFFSET)
+    {
+    for (i=0; i<2; i++)
+      {
+      sprintf(key, "%-8.8s", prefs.mosaic_key[i]);
+      if (fitsread(tab->headbuf, key, &pos[i], H_EXPO, T_DOUBLE)
+		!= RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: mosaic offset keyword not found in ",
+		filename);
+      pos[i] = -pos[i];
+      }
+    }
+  else
+    {
+/*-- Project the tile CRVAL on the pixel grid of the reference tile */
+    for (i=0; i<2; i++)
+      {
+      sprintf(key, "CRVAL%1d  ", i+1);
+      if (fitsread(tab->headbuf, key, &wcspos[i], H_EXPO, T_DOUBLE)
+		!= RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: no WCS in ", filename);
+      sprintf(key, "CRPIX%1d  ", i+1);
+      if (fitsread(tab->headbuf, key, &crpix[i], H_EXPO, T_DOUBLE)
+		!= RETURN_OK)
+        error(EXIT_FAILURE, "*Error*: no WCS in ", filename);
+      }
+    if (wcs_to_fieldpix(reffield, wcspos, pos) != RETURN_OK)
+      error(EXIT_FAILURE, "*Error*: cannot align on the mosaic grid ",
+		filename);
+    for (i=0; i<2; i++)
+      pos[i] -= crpix[i];
+    }
+
+  return RETURN_OK;
+  }
+
+
+/****** compare_mosaictiles ***************************************************
+PROTO	int compare_mosaictiles(const void *tile1, const void *tile2)
+PURPOSE	Provide a tile sorting criterion (first row, then input order).
+INPUT	Pointer to the first tile,
+	pointer to the second tile.
+OUTPUT	<0 if tile1 comes first, >0 otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	compare_mosaictiles(const void *tile1, const void *tile2)
+  {
+   const mosaictilestruct	*t1 = tile1, *t2 = tile2;
+
+  if (t1->origin[1] != t2->origin[1])
+    return t1->origin[1] - t2->origin[1];
+
+  return t1->index - t2->index;
+  }
+
@@ -0,0 +1,79 @@
+/*
+*				mosaic.h
+*
+* Include file for mosaic.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _MOSAIC_H_
+#define _MOSAIC_H_
+
+#ifndef _FITSCAT_H_
+#include "fits/fitscat.h"
+#endif
+
+#ifndef _FIELD_H_
+#include "field.h"
+#endif
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct mosaictile
+  {
+  catstruct	*cat;			/* Input catalog (shared by extensions)*/
+  tabstruct	*tab;			/* Image extension */
+  int		index;			/* Input order (for overlaps) */
+  int		origin[2];		/* Position in the mosaic */
+  int		size[2];		/* Tile size */
+  int		activeflag;		/* Tile opened for the current band? */
+  }	mosaictilestruct;
+
+typedef struct mosaic
+  {
+  mosaictilestruct *tile;		/* Tiles (sorted by origin[1]) */
+  int		ntile;			/* Number of tiles */
+  catstruct	**cat;			/* Input catalogs */
+  int		ncat;			/* Number of input catalogs */
+  mosaictilestruct **active;		/* Tiles opened for the current band */
+  int		nactive;		/* Number of opened tiles */
+  mosaictilestruct **row;		/* Tiles covering the current row */
+  int		size[2];		/* Mosaic size */
+  int		maxheight;		/* Height of the tallest tile */
+  int		margin;			/* Band margin (rows) */
+  int		y;			/* Next row to be read */
+  int		bodytile;		/* Current tile for sequential reads */
+  size_t	bodypos;		/* Pixels already read in the tile */
+  size_t	npix;			/* Total number of tile pixels */
+  }	mosaicstruct;
+
+/*------------------------------- functions ---------------------------------*/
+extern fieldstruct	*load_mosaic(char **filename, int nfile);
+
+extern void		end_mosaic(mosaicstruct *mosaic),
+			read_mosaicbody(mosaicstruct *mosaic, PIXTYPE *buf,
+				size_t npix),
+			read_mosaicrow(mosaicstruct *mosaic, PIXTYPE *buf),
+			rewind_mosaicbody(mosaicstruct *mosaic);
+
+#endif
+
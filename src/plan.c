@@ -0,0 +1,822 @@
+/*
+*				plan.c
+*
+* Dry-run planning of conversions from image headers.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include	<math.h>
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	LIBTIFF_H
+
+#include	"define.h"
+#include	"globals.h"
+#include	"fits/fitscat.h"
+#include	"datamem.h"
+#include	"field.h"
+#include	"image.h"
+#include	"key.h"
+#include	"mosaic.h"
+#include	"plan.h"
+#include	"prefs.h"
+#include	"quicklook.h"
+#include	"tiff.h"
+#include	"xml.h"
+
+extern pkeystruct	key[];
+extern char		keylist[][32];
+
+static int	plan_readcalib(char *filename, char *mode, int nthreads,
+			double *mpix_s, int *calnthreads),
+		write_planjson(char *filename, planstruct *plan,
+			fieldstruct **field),
+		write_planxml(char *filename, planstruct *plan,
+			fieldstruct **field);
+
+static void	plan_levels(planstruct *plan, fieldstruct **field, int nfield),
+		plan_memory(planstruct *plan, fieldstruct **field),
+		plan_sizes(planstruct *plan),
+		plan_time(planstruct *plan),
+		write_planstring(FILE *file, char *str);
+
+static const char	*plan_keyname(char *keyword, int val);
+
+/****** makeplan **************************************************************
+PROTO	void makeplan(void)
+PURPOSE	Plan a conversion without reading pixels, and write the predicted
+	resource needs to a JSON or XML file.
+INPUT	-.
+OUTPUT	-.
+NOTES	Uses the global preferences. Only FITS headers are read. Memory needs
+	are obtained by replaying the allocation decisions of the data stores
+	under MEM_MAX and VMEM_MAX, output sizes are estimated with typical
+	compression ratios, and the conversion time is scaled from the
+	throughputs measured by stiff-bench (see PLAN_BENCH_NAME).
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	makeplan(void)
+  {
+   fieldstruct		**fields;
+   planstruct		plan;
+   int			f, nfield, status;
+
+/* Read the FITS headers */
+  nfield = prefs.mosaic_type==MOSAIC_NONE? prefs.nfile : 1;
+  QMALLOC(fields, fieldstruct *, nfield);
+  NFPRINTF(OUTPUT, "Examining input data...");
+  if (prefs.mosaic_type == MOSAIC_NONE)
+    for (f=0; f<nfield; f++)
+      fields[f] = load_field(prefs.file_name[f], NULL, 0);
+  else
+    fields[0] = load_mosaic(prefs.file_name, prefs.nfile);
+  for (f=1; f<nfield; f++)
+    if (fields[f]->size[0] != fields[0]->size[0]
+	|| fields[f]->size[1] != fields[0]->size[1])
+      error(EXIT_FAILURE, "*Error*: Image size doesn't match in ",
+		fields[f]->cat->filename);
+
+  memset(&plan, 0, sizeof(plan));
+  plan_levels(&plan, fields, nfield);
+  plan_memory(&plan, fields);
+  plan_sizes(&plan);
+  plan_time(&plan);
+
+  NFPRINTF(OUTPUT, "Writing plan...");
+  status = prefs.plan_type==PLAN_XML?
+	write_planxml(prefs.plan_name, &plan, fields)
+	: write_planjson(prefs.plan_name, &plan, fields);
+  if (status != RETURN_OK)
+    error(EXIT_FAILURE, "*Error*: cannot write plan file ", prefs.plan_name);
+  NFPRINTF(OUTPUT, "");
+
+  prefs.nlines = (double)plan.height;
+  prefs.npix = (double)plan.width*plan.height;
+  free(plan.level);
+  for (f=0; f<nfield; f++)
+    end_field(fields[f]);
+  free(fields);
+
+  return;
+  }
+
+
+/****** plan_levels ***********************************************************
+PROTO	void plan_levels(planstruct *plan, fieldstruct **field, int nfield)
+PURPOSE	Compute the dimensions and uncompressed sizes of the output levels.
+INPUT	Pointer to the plan,
+	array of pointers to input fields,
+	number of input fields.
+OUTPUT	-.
+NOTES	Follows the level sizes of image_convert_pyramid(): TIFF pyramids
+	round level sizes down and pad edge tiles, tile trees round sizes up.
+	With 16-bit storage, the first level is not stored.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	plan_levels(planstruct *plan, fieldstruct **field, int nfield)
+  {
+   planlevelstruct	*level;
+   double		bytes;
+   int			f, l, w,h, bypp, tilesize, pyrflag;
+
+  plan->nfield = nfield;
+  for (f=0; f<nfield; f++)
+    {
+    plan->inpix += (double)field[f]->size[0]*field[f]->size[1];
+    plan->inbytes += (double)field[f]->size[0]*field[f]->size[1]
+		*(abs(field[f]->tab->bitpix)/8);
+    }
+  w = prefs.bin_size[0]>1?
+	(field[0]->size[0]+prefs.bin_size[0]-1)/prefs.bin_size[0]
+	: field[0]->size[0];
+  h = prefs.bin_size[1]>1?
+	(field[0]->size[1]+prefs.bin_size[1]-1)/prefs.bin_size[1]
+	: field[0]->size[1];
+  plan->width = w;
+  plan->height = h;
+  plan->nchan = nfield;
+  bypp = prefs.bpp>0? prefs.bpp/8 : (int)sizeof(float);
+  pyrflag = (prefs.format_type2 == FORMAT_TIFF_PYRAMID
+	|| prefs.format_type2 == FORMAT_DEEPZOOM
+	|| prefs.format_type2 == FORMAT_XYZ
+	|| prefs.format_type2 == FORMAT_ZARR);
+
+/* Multiple cutouts: sizes depend on the WCS of every field */
+  if (prefs.nregion>4)
+    {
+    plan->ncutout = prefs.nregion/4;
+    return;
+    }
+
+  if (!pyrflag)
+    {
+    plan->nlevel = 1;
+    QCALLOC(plan->level, planlevelstruct, 1);
+    plan->level->width = w;
+    plan->level->height = h;
+    plan->level->bytes = (double)w*h*nfield*bypp;
+    }
+  else
+    {
+    tilesize = plan->tilesize = prefs.tile_size;
+    plan->nlevel = pyramid_nlevels(w, h);
+    QCALLOC(plan->level, planlevelstruct, plan->nlevel? plan->nlevel : 1);
+    for (level=plan->level, l=0; l<plan->nlevel; l++, level++)
+      {
+      if (l)
+        {
+        w = prefs.format_type2==FORMAT_TIFF_PYRAMID? w/2 : (w+1)/2;
+        h = prefs.format_type2==FORMAT_TIFF_PYRAMID? h/2 : (h+1)/2;
+        }
+      level->width = w;
+      level->height = h;
+      level->ntiles = ((w+tilesize-1)/tilesize)*((h+tilesize-1)/tilesize);
+      level->bytes = (prefs.format_type2==FORMAT_DEEPZOOM?
+		(double)w*h : (double)level->ntiles*tilesize*tilesize)
+		*nfield*bypp;
+/*---- 16-bit storage: only the output pixels of reduced levels are stored */
+      if (prefs.pyrstorage_type==PYRSTORAGE_FLOAT32)
+        level->storebytes = (double)w*h*nfield*sizeof(float);
+      else
+        level->storebytes = l? (double)w*h*nfield
+		*(prefs.bpp>0? bypp : (int)sizeof(unsigned short)) : 0.0;
+      }
+    }
+
+/* Same BigTIFF switch as create_tiff() */
+  if (prefs.format_type2 == FORMAT_TIFF
+	|| prefs.format_type2 == FORMAT_TIFF_PYRAMID)
+    {
+    bytes = (double)plan->width*plan->height*nfield*bypp;
+    plan->bigtiffflag = atof(TIFFGetVersion() + 16) >= 4.0
+	&& (prefs.bigtiff_type==BIGTIFF_ALWAYS
+		|| (prefs.bigtiff_type==BIGTIFF_AUTO
+			&& bytes/16.0 >= 134217728.0));
+    }
+
+  return;
+  }
+
+
+/****** plan_memory ***********************************************************
+PROTO	void plan_memory(planstruct *plan, fieldstruct **field)
+PURPOSE	Predict the peak use of RAM and of the swap directory.
+INPUT	Pointer to the plan,
+	array of pointers to input fields.
+OUTPUT	-.
+NOTES	Replays the decisions of new_datastore() and alloc_data() for
+	every stored pyramid level under MEM_MAX and VMEM_MAX: a level is
+	released once the next one has been built, except with 16-bit
+	storage, where all the reduced levels are built in a single pass.
+	Compressed block sizes are assumed to be PLAN_RATIOSTORE times their
+	raw size.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	plan_memory(planstruct *plan, fieldstruct **field)
+  {
+   planlevelstruct	*level;
+   double		ramleft, vramleft, size, zsize, ram, spill,
+			prevram, prevspill, levram, levspill;
+   int			a, b, l, w, nlines, nblock, nstore, bypp, nthreads,
+			compressflag, packflag, blockflag;
+
+  bypp = prefs.bpp>0? prefs.bpp/8 : (int)sizeof(float);
+  nthreads = prefs.nthreads>0? prefs.nthreads : 1;
+  w = plan->width;
+
+/* Row buffers of image_convert_single() */
+  if (!plan->tilesize)
+    {
+    nlines = (prefs.format_type2 == FORMAT_JPEG
+	|| prefs.format_type2 == FORMAT_PNG)?
+		nthreads*QUICKLOOK_BANDLINES : IMAGE_NLINES;
+    plan->scratch = (double)w*nlines*plan->nchan*sizeof(float)
+		+ (double)w*nthreads*sizeof(float)
+		+ 2.0*w*nlines*plan->nchan*bypp
+		+ (double)field[0]->size[0]*sizeof(PIXTYPE);
+    plan->ram = plan->scratch;
+    return;
+    }
+
+/* Rows of tiles of image_convert_pyramid() */
+  plan->scratch = 2.0*plan->tilesize*w*plan->nchan*bypp
+		+ (double)nthreads*plan->tilesize*w*sizeof(float)
+		+ (double)field[0]->size[0]*sizeof(PIXTYPE);
+
+/* Stored levels */
+  ramleft = prefs.mem_max*1048576.0;
+  vramleft = prefs.vmem_max*1048576.0;
+  compressflag = (prefs.vmem_type == VMEM_COMPRESSED);
+  packflag = (prefs.pyrstorage_type != PYRSTORAGE_FLOAT32);
+  ram = spill = prevram = prevspill = 0.0;
+  blockflag = 0;
+  for (level=plan->level, l=0; l<plan->nlevel; l++, level++)
+    {
+    levram = levspill = 0.0;
+/*-- 16-bit storage: rows of float tiles of every level, one store of output
+	pixels per reduced level */
+    if (packflag)
+      plan->scratch += (double)plan->tilesize*level->width*plan->nchan
+		*sizeof(float);
+    nstore = packflag? (l? 1 : 0) : plan->nchan;
+    for (a=0; a<nstore; a++)
+      {
+      size = packflag? level->storebytes
+		: (double)level->width*level->height*sizeof(float);
+      if (!(packflag && prefs.bpp<0) && (!compressflag || size < ramleft))
+        {
+/*------ Contiguous storage, in RAM or in a swap file */
+        if (size < ramleft)
+          {
+          ramleft -= size;
+          levram += size;
+          }
+        else if (size < vramleft)
+          {
+          vramleft -= size;
+          levspill += size;
+          }
+        else
+          plan->overflowflag = 1;
+        continue;
+        }
+/*---- Blocks of rows, compressed when evicted from the block cache */
+      blockflag = 1;
+      nblock = (level->height+plan->tilesize-1)/plan->tilesize;
+      for (b=0; b<nblock; b++)
+        {
+        zsize = size*(b<nblock-1? plan->tilesize
+		: level->height-b*plan->tilesize)/level->height;
+        if (compressflag)
+          zsize *= PLAN_RATIOSTORE;
+        if (zsize < ramleft)
+          {
+          ramleft -= zsize;
+          levram += zsize;
+          }
+        else if (zsize < vramleft)
+          {
+          vramleft -= zsize;
+          levspill += zsize;
+          }
+        else
+          plan->overflowflag = 1;
+        }
+      }
+    if (ram + levram > plan->storeram)
+      plan->storeram = ram + levram;
+    if (spill + levspill > plan->spill)
+      plan->spill = spill + levspill;
+/*-- The previous level is released once the current one is built */
+    if (!packflag)
+      {
+      ramleft += prevram;
+      vramleft += prevspill;
+      ram = spill = 0.0;
+      }
+    ram += levram;
+    spill += levspill;
+    prevram = levram;
+    prevspill = levspill;
+    }
+
+/* Decompressed blocks in the cache */
+  plan->ram = plan->scratch + plan->storeram;
+  if (blockflag)
+    plan->ram += DATA_NCACHEBLOCK*plan->tilesize*(double)w*sizeof(float);
+
+  return;
+  }
+
+
+/****** plan_sizes ************************************************************
+PROTO	void plan_sizes(planstruct *plan)
+PURPOSE	Estimate the output size for every applicable compression type.
+INPUT	Pointer to the plan.
+OUTPUT	-.
+NOTES	Lossless ratios are typical values for astronomical images with
+	the default dynamic range settings (see plan.h); JPEG ratios scale
+	with COMPRESSION_QUALITY.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	plan_sizes(planstruct *plan)
+  {
+   double	raw, ratio, jratio, q;
+   int		l, n;
+
+  for (raw=0.0, l=0; l<plan->nlevel; l++)
+    raw += plan->level[l].bytes;
+  ratio = prefs.bpp==8? PLAN_RATIO8
+	: (prefs.bpp==16? PLAN_RATIO16 : PLAN_RATIOFLOAT);
+  q = prefs.compress_quality/100.0;
+  jratio = PLAN_JPEGRATIO0 + PLAN_JPEGRATIO1*q*q;
+
+  n = 0;
+  switch(prefs.format_type2)
+    {
+    case FORMAT_TIFF:
+    case FORMAT_TIFF_PYRAMID:
+      plan->sizename[n] = "NONE";
+      plan->size[n++] = raw;
+      plan->sizename[n] = "LZW";
+      plan->size[n++] = raw*(ratio*PLAN_RATIOLZW<1.0? ratio*PLAN_RATIOLZW
+							: 1.0);
+      if (prefs.bpp==8)
+        {
+        plan->sizename[n] = "JPEG";
+        plan->size[n++] = raw*jratio;
+        }
+      plan->sizename[n] = "DEFLATE";
+      plan->size[n++] = raw*ratio;
+      plan->sizename[n] = "ADOBE-DEFLATE";
+      plan->size[n++] = raw*ratio;
+      break;
+    case FORMAT_DEEPZOOM:
+    case FORMAT_XYZ:
+      plan->sizename[n] = "JPEG";
+      plan->size[n++] = raw*jratio;
+      plan->sizename[n] = "PNG";
+      plan->size[n++] = raw*ratio;
+      break;
+    case FORMAT_ZARR:
+      plan->sizename[n] = "DEFLATE";
+      plan->size[n++] = raw*ratio;
+      break;
+    case FORMAT_JPEG:
+      plan->sizename[n] = "JPEG";
+      plan->size[n++] = raw*jratio;
+      break;
+    case FORMAT_PNG:
+      plan->sizename[n] = "PNG";
+      plan->size[n++] = raw*ratio;
+      break;
+    default:
+      plan->sizename[n] = "NONE";
+      plan->size[n++] = raw;
+    }
+  plan->nsize = n;
+
+  return;
+  }
+
+
+/****** plan_time *************************************************************
+PROTO	void plan_time(planstruct *plan)
+PURPOSE	Estimate the conversion time.
+INPUT	Pointer to the plan.
+OUTPUT	-.
+NOTES	The throughput is taken from the stiff-bench run that matches best
+	the conversion mode and the number of threads, and scaled by the
+	number of channels. PLAN_DEFMPIXS per thread is assumed without
+	calibration.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	plan_time(planstruct *plan)
+  {
+   int	nthreads;
+
+  nthreads = prefs.nthreads>0? prefs.nthreads : 1;
+  if (plan->tilesize)
+    strcpy(plan->mode, "pyramid");
+  else if (prefs.bin_size[0]>1 || prefs.bin_size[1]>1)
+    strcpy(plan->mode, "binned");
+  else
+    strcpy(plan->mode, "single");
+
+  if (plan_readcalib(prefs.planbench_name, plan->mode, nthreads,
+	&plan->mpix_s, &plan->calnthreads) == RETURN_OK)
+    strcpy(plan->calibname, prefs.planbench_name);
+  else
+    {
+    strcpy(plan->calibname, "NONE");
+    plan->mpix_s = PLAN_DEFMPIXS*nthreads;
+    plan->calnthreads = nthreads;
+    }
+
+  plan->time = plan->inpix/(plan->mpix_s*1e6);
+
+  return;
+  }
+
+
+/****** plan_readcalib ********************************************************
+PROTO	int plan_readcalib(char *filename, char *mode, int nthreads,
+			double *mpix_s, int *calnthreads)
+PURPOSE	Read the throughput of a conversion mode from a stiff-bench output.
+INPUT	stiff-bench JSON file name,
+	conversion mode ("single", "binned" or "pyramid"),
+	number of threads,
+	pointer to the throughput (Mpix/s, counting every channel),
+	pointer to the number of threads of the selected run.
+OUTPUT	RETURN_OK if a matching run was found, RETURN_ERROR otherwise.
+NOTES	The run with the largest number of threads not exceeding nthreads
+	is selected, or the one with the fewest threads otherwise.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	plan_readcalib(char *filename, char *mode, int nthreads,
+			double *mpix_s, int *calnthreads)
+  {
+   FILE		*file;
+   char		str[4*MAXCHAR], cmode[16],
+		*pstr;
+   double	time, mpix, bestmpix;
+   int		bitpix, nchan, binning, nt, bestnt;
+
+  if (!(file = fopen(filename, "r")))
+    return RETURN_ERROR;
+  bestnt = 0;
+  bestmpix = 0.0;
+  while (fgets(str, 4*MAXCHAR, file))
+    {
+    if (!(pstr = strstr(str, "{\"mode\":")))
+      continue;
+    if (sscanf(pstr, "{\"mode\": \"%15[^\"]\", \"bitpix\": %d, \"nchan\": %d,"
+	" \"binning\": %d, \"nthreads\": %d, \"time\": %lf, \"mpix_s\": %lf",
+	cmode, &bitpix, &nchan, &binning, &nt, &time, &mpix) != 7
+	|| strcmp(cmode, mode) || nt<1 || mpix<=0.0)
+      continue;
+    if (!bestnt
+	|| (nt<=nthreads && (bestnt>nthreads || nt>bestnt))
+	|| (nt>nthreads && bestnt>nthreads && nt<bestnt))
+      {
+      bestnt = nt;
+      bestmpix = mpix*nchan;
+      }
+    }
+  fclose(file);
+
+  if (!bestnt)
+    return RETURN_ERROR;
+  *mpix_s = bestmpix;
+  *calnthreads = bestnt;
+
+  return RETURN_OK;
+  }
+
+
+/****** plan_keyname **********************************************************
+PROTO	const char *plan_keyname(char *keyword, int val)
+PURPOSE	Return the name of the value of a keyword of the configuration.
+INPUT	Configuration keyword,
+	keyword value.
+OUTPUT	Pointer to the value name.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static const char	*plan_keyname(char *keyword, int val)
+  {
+  if (!strcmp(keyword, "IMAGE_TYPE") && val == FORMAT_RASTER)
+    return "RASTER";
+
+  return key[findkeys(keyword, keylist, FIND_STRICT)].keylist[val];
+  }
+
+
+/****** write_planstring ******************************************************
+PROTO	void write_planstring(FILE *file, char *str)
+PURPOSE	Write a string as a quoted JSON string.
+INPUT	File pointer,
+	string.
+OUTPUT	-.
+NOTES	Quotes, backslashes and control characters are escaped.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	write_planstring(FILE *file, char *str)
+  {
+  putc('"', file);
+  for (; *str; str++)
+    if (*str == '"' || *str == '\\')
+      fprintf(file, "\\%c", *str);
+    else if ((unsigned char)*str < 0x20)
+      fprintf(file, "\\u%04x", (unsigned char)*str);
+    else
+      putc(*str, file);
+  putc('"', file);
+
+  return;
+  }
+
+
+/****** write_planjson ********************************************************
+PROTO	int write_planjson(char *filename, planstruct *plan,
+			fieldstruct **field)
+PURPOSE	Write a plan as a JSON file.
+INPUT	File name ("STDOUT" for the standard output),
+	pointer to the plan,
+	array of pointers to input fields.
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	Sizes are in bytes and times in seconds.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	write_planjson(char *filename, planstruct *plan,
+			fieldstruct **field)
+  {
+   FILE			*file;
+   planlevelstruct	*level;
+   int			f, l, n;
+
+  if (!strcmp(filename, "STDOUT"))
+    file = stdout;
+  else if (!(file = fopen(filename, "w")))
+    return RETURN_ERROR;
+
+  fprintf(file, "{\n \"software\": \"%s\",\n \"version\": \"%s\",\n",
+	BANNER, MYVERSION);
+  fprintf(file, " \"inputs\": [");
+  for (f=0; f<plan->nfield; f++)
+    {
+    fprintf(file, "%s\n  {\"file\": ", f? ",":"");
+    write_planstring(file, field[f]->cat->filename);
+    fprintf(file, ", \"width\": %d, \"height\": %d, \"bitpix\": %d}",
+	field[f]->size[0], field[f]->size[1], field[f]->tab->bitpix);
+    }
+  fprintf(file, "\n ],\n \"input_bytes\": %.0f,\n", plan->inbytes);
+
+  fprintf(file, " \"output\": {\"file\": ");
+  write_planstring(file, prefs.tiff_name);
+  fprintf(file, ", \"format\": \"%s\", \"width\": %d, \"height\": %d,"
+	" \"nchan\": %d, \"bits\": %d, \"tile_size\": %d,"
+	" \"compression\": \"%s\", \"bigtiff\": %s, \"cutouts\": %d},\n",
+	plan_keyname("IMAGE_TYPE", prefs.format_type2),
+	plan->width, plan->height, plan->nchan, prefs.bpp, plan->tilesize,
+	plan_keyname("COMPRESSION_TYPE", prefs.compress_type),
+	plan->bigtiffflag? "true":"false", plan->ncutout);
+
+  fprintf(file, " \"levels\": [");
+  for (level=plan->level, l=0; l<plan->nlevel; l++, level++)
+    fprintf(file, "%s\n  {\"level\": %d, \"width\": %d, \"height\": %d,"
+	" \"ntiles\": %d, \"bytes\": %.0f, \"store_bytes\": %.0f}",
+	l? ",":"", l, level->width, level->height, level->ntiles,
+	level->bytes, level->storebytes);
+  fprintf(file, "\n ],\n");
+
+  fprintf(file, " \"memory\": {\"mem_max\": %.0f, \"mem_source\": ",
+	prefs.mem_max*1048576.0);
+  write_planstring(file, prefs.mem_source);
+  fprintf(file, ", \"vmem_max\": %.0f, \"vmem_source\": ",
+	prefs.vmem_max*1048576.0);
+  write_planstring(file, prefs.vmem_source);
+  fprintf(file, ", \"vmem_dir\": ");
+  write_planstring(file, prefs.swapdir_name);
+  fprintf(file, ", \"vmem_type\": \"%s\",\n  \"scratch_bytes\": %.0f,"
+	" \"store_ram_bytes\": %.0f, \"ram_bytes\": %.0f,"
+	" \"spill_bytes\": %.0f, \"spill\": %s, \"fits\": %s},\n",
+	plan_keyname("VMEM_TYPE", prefs.vmem_type),
+	plan->scratch, plan->storeram, plan->ram, plan->spill,
+	plan->spill>0.0? "true":"false", plan->overflowflag? "false":"true");
+
+  fprintf(file, " \"size_estimates\": [");
+  for (n=0; n<plan->nsize; n++)
+    fprintf(file, "%s\n  {\"compression\": \"%s\", \"bytes\": %.0f}",
+	n? ",":"", plan->sizename[n], plan->size[n]);
+  fprintf(file, "\n ],\n");
+
+  fprintf(file, " \"time\": {\"calibration\": ");
+  write_planstring(file, plan->calibname);
+  fprintf(file, ", \"mode\": \"%s\", \"nthreads\": %d,"
+	" \"calibration_nthreads\": %d, \"mpix_s\": %.3f, \"seconds\": %.3f}\n"
+	"}\n",
+	plan->mode, prefs.nthreads, plan->calnthreads, plan->mpix_s,
+	plan->time);
+
+  if (file != stdout)
+    return fclose(file)? RETURN_ERROR : RETURN_OK;
+
+  return fflush(file)? RETURN_ERROR : RETURN_OK;
+  }
+
+
+/****** write_planxml *********************************************************
+PROTO	int write_planxml(char *filename, planstruct *plan,
+			fieldstruct **field)
+PURPOSE	Write a plan as an XML-VOTable file.
+INPUT	File name ("STDOUT" for the standard output),
+	pointer to the plan,
+	array of pointers to input fields.
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	Same content as write_planjson().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	write_planxml(char *filename, planstruct *plan,
+			fieldstruct **field)
+  {
+   FILE			*file;
+   planlevelstruct	*level;
+   int			f, l, n;
+
+  if (!strcmp(filename, "STDOUT"))
+    file = stdout;
+  else if (!(file = fopen(filename, "w")))
+    return RETURN_ERROR;
+
+  write_xml_header(file);
+  fprintf(file, " <RESOURCE ID=\"Plan\" name=\"Plan\">\n");
+  fprintf(file, "  <DESCRIPTION>%s conversion plan (dry run)</DESCRIPTION>\n",
+	BANNER);
+  fprintf(file, "  <PARAM name=\"Software\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.title;meta.software\" value=\"%s\"/>\n", BANNER);
+  fprintf(file, "  <PARAM name=\"Version\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.version;meta.software\" value=\"%s\"/>\n", MYVERSION);
+  fprintf(file, "  <PARAM name=\"Input_Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\" value=\"%.0f\"/>\n",
+	plan->inbytes);
+  fprintf(file, "  <PARAM name=\"Output_File\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.id;meta.file\" value=\"%s\"/>\n",
+	prefs.tiff_name);
+  fprintf(file, "  <PARAM name=\"Image_Type\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code\" value=\"%s\"/>\n",
+	plan_keyname("IMAGE_TYPE", prefs.format_type2));
+  fprintf(file, "  <PARAM name=\"Image_Size\" datatype=\"int\""
+	" arraysize=\"2\" ucd=\"meta.number;obs.image\" unit=\"pix\""
+	" value=\"%d %d\"/>\n", plan->width, plan->height);
+  fprintf(file, "  <PARAM name=\"NChannels\" datatype=\"int\""
+	" ucd=\"meta.number\" value=\"%d\"/>\n", plan->nchan);
+  fprintf(file, "  <PARAM name=\"Bits_Per_Channel\" datatype=\"int\""
+	" ucd=\"meta.number\" value=\"%d\"/>\n", prefs.bpp);
+  fprintf(file, "  <PARAM name=\"Tile_Size\" datatype=\"int\""
+	" ucd=\"meta.number\" unit=\"pix\" value=\"%d\"/>\n", plan->tilesize);
+  fprintf(file, "  <PARAM name=\"Compression_Type\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code\" value=\"%s\"/>\n",
+	plan_keyname("COMPRESSION_TYPE", prefs.compress_type));
+  fprintf(file, "  <PARAM name=\"BigTIFF\" datatype=\"boolean\""
+	" ucd=\"meta.code\" value=\"%c\"/>\n", plan->bigtiffflag? 'T':'F');
+  fprintf(file, "  <PARAM name=\"NCutouts\" datatype=\"int\""
+	" ucd=\"meta.number\" value=\"%d\"/>\n", plan->ncutout);
+  fprintf(file, "  <PARAM name=\"Mem_Max\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\" value=\"%.0f\"/>\n",
+	prefs.mem_max*1048576.0);
+  fprintf(file, "  <PARAM name=\"VMem_Max\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\" value=\"%.0f\"/>\n",
+	prefs.vmem_max*1048576.0);
+  fprintf(file, "  <PARAM name=\"VMem_Dir\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.id;meta.file\" value=\"%s\"/>\n",
+	prefs.swapdir_name);
+  fprintf(file, "  <PARAM name=\"VMem_Type\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code\" value=\"%s\"/>\n",
+	plan_keyname("VMEM_TYPE", prefs.vmem_type));
+  fprintf(file, "  <PARAM name=\"Scratch_Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\" value=\"%.0f\"/>\n",
+	plan->scratch);
+  fprintf(file, "  <PARAM name=\"Store_RAM_Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\" value=\"%.0f\"/>\n",
+	plan->storeram);
+  fprintf(file, "  <PARAM name=\"RAM_Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\" value=\"%.0f\"/>\n", plan->ram);
+  fprintf(file, "  <PARAM name=\"Spill_Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\" value=\"%.0f\"/>\n", plan->spill);
+  fprintf(file, "  <PARAM name=\"Fits_VMem\" datatype=\"boolean\""
+	" ucd=\"meta.code\" value=\"%c\"/>\n", plan->overflowflag? 'F':'T');
+  fprintf(file, "  <PARAM name=\"Calibration\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.id;meta.file\" value=\"%s\"/>\n",
+	plan->calibname);
+  fprintf(file, "  <PARAM name=\"Calibration_Mode\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code\" value=\"%s\"/>\n", plan->mode);
+  fprintf(file, "  <PARAM name=\"NThreads\" datatype=\"int\""
+	" ucd=\"meta.number\" value=\"%d\"/>\n", prefs.nthreads);
+  fprintf(file, "  <PARAM name=\"Calibration_NThreads\" datatype=\"int\""
+	" ucd=\"meta.number\" value=\"%d\"/>\n", plan->calnthreads);
+  fprintf(file, "  <PARAM name=\"Throughput\" datatype=\"float\""
+	" ucd=\"arith.rate\" unit=\"Mpix/s\" value=\"%.3f\"/>\n",
+	plan->mpix_s);
+  fprintf(file, "  <PARAM name=\"Time_Estimate\" datatype=\"float\""
+	" ucd=\"time.duration\" unit=\"s\" value=\"%.3f\"/>\n", plan->time);
+
+/* Inputs */
+  fprintf(file, "  <TABLE ID=\"Plan_Inputs\" name=\"Plan_Inputs\">\n");
+  fprintf(file, "   <DESCRIPTION>Input images</DESCRIPTION>\n");
+  fprintf(file, "   <FIELD name=\"Image_Name\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"obs.image;meta.fits\"/>\n");
+  fprintf(file, "   <FIELD name=\"Image_Size\" datatype=\"int\""
+	" arraysize=\"2\" ucd=\"meta.number;obs.image\" unit=\"pix\"/>\n");
+  fprintf(file, "   <FIELD name=\"BITPIX\" datatype=\"int\""
+	" ucd=\"meta.code\"/>\n");
+  fprintf(file, "   <DATA><TABLEDATA>\n");
+  for (f=0; f<plan->nfield; f++)
+    fprintf(file, "    <TR><TD>%s</TD><TD>%d %d</TD><TD>%d</TD></TR>\n",
+	field[f]->cat->filename, field[f]->size[0], field[f]->size[1],
+	field[f]->tab->bitpix);
+  fprintf(file, "   </TABLEDATA></DATA>\n");
+  fprintf(file, "  </TABLE>\n");
+
+/* Levels */
+  fprintf(file, "  <TABLE ID=\"Plan_Levels\" name=\"Plan_Levels\">\n");
+  fprintf(file, "   <DESCRIPTION>Output levels</DESCRIPTION>\n");
+  fprintf(file, "   <FIELD name=\"Level\" datatype=\"int\""
+	" ucd=\"meta.record\"/>\n");
+  fprintf(file, "   <FIELD name=\"Image_Size\" datatype=\"int\""
+	" arraysize=\"2\" ucd=\"meta.number;obs.image\" unit=\"pix\"/>\n");
+  fprintf(file, "   <FIELD name=\"NTiles\" datatype=\"int\""
+	" ucd=\"meta.number\"/>\n");
+  fprintf(file, "   <FIELD name=\"Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\"/>\n");
+  fprintf(file, "   <FIELD name=\"Store_Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\"/>\n");
+  fprintf(file, "   <DATA><TABLEDATA>\n");
+  for (level=plan->level, l=0; l<plan->nlevel; l++, level++)
+    fprintf(file, "    <TR><TD>%d</TD><TD>%d %d</TD><TD>%d</TD>"
+	"<TD>%.0f</TD><TD>%.0f</TD></TR>\n",
+	l, level->width, level->height, level->ntiles,
+	level->bytes, level->storebytes);
+  fprintf(file, "   </TABLEDATA></DATA>\n");
+  fprintf(file, "  </TABLE>\n");
+
+/* Size estimates */
+  fprintf(file, "  <TABLE ID=\"Plan_Sizes\" name=\"Plan_Sizes\">\n");
+  fprintf(file, "   <DESCRIPTION>Estimated output sizes</DESCRIPTION>\n");
+  fprintf(file, "   <FIELD name=\"Compression_Type\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code\"/>\n");
+  fprintf(file, "   <FIELD name=\"Bytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\"/>\n");
+  fprintf(file, "   <DATA><TABLEDATA>\n");
+  for (n=0; n<plan->nsize; n++)
+    fprintf(file, "    <TR><TD>%s</TD><TD>%.0f</TD></TR>\n",
+	plan->sizename[n], plan->size[n]);
+  fprintf(file, "   </TABLEDATA></DATA>\n");
+  fprintf(file, "  </TABLE>\n");
+
+  fprintf(file, " </RESOURCE>\n");
+  fprintf(file, "</RESOURCE>\n");
+  fprintf(file, "</VOTABLE>\n");
+
+  if (file != stdout)
+    return fclose(file)? RETURN_ERROR : RETURN_OK;
+
+  return fflush(file)? RETURN_ERROR : RETURN_OK;
+  }
+
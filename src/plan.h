@@ -0,0 +1,88 @@
+/*
+*				plan.h
+*
+* Include file for plan.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _PLAN_H_
+#define _PLAN_H_
+
+#ifndef _FIELD_H_
+#include "field.h"
+#endif
+
+/*----------------------------- Internal constants --------------------------*/
+#define	PLAN_DEFMPIXS		15.0	/* Uncalibrated throughput per thread */
+					/* (Mpix/s, counting every channel) */
+#define	PLAN_RATIO8		0.6	/* Lossless compression ratio, 8 bits */
+#define	PLAN_RATIO16		0.75	/* Same for 16 bits */
+#define	PLAN_RATIOFLOAT		0.9	/* Same for floating point */
+#define	PLAN_RATIOLZW		1.15	/* LZW versus deflate output size */
+#define	PLAN_JPEGRATIO0		0.02	/* JPEG ratio at quality 0 */
+#define	PLAN_JPEGRATIO1		0.18	/* JPEG ratio increase at quality 100 */
+#define	PLAN_RATIOSTORE		0.6	/* Compressed pyramid level storage */
+#define	PLAN_NSIZE		5	/* Max. number of size estimates */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct planlevel
+  {
+  int		width, height;		/* Level dimensions */
+  int		ntiles;			/* Number of tiles */
+  double	bytes;			/* Uncompressed output size */
+  double	storebytes;		/* Size of the stored level */
+  }	planlevelstruct;
+
+typedef struct plan
+  {
+  int		nfield;			/* Number of input fields */
+  double	inbytes;		/* Input pixel data size */
+  double	inpix;			/* Number of input pixels (all channels) */
+  int		width, height;		/* Output dimensions */
+  int		nchan;			/* Number of channels */
+  int		tilesize;		/* Tile size (0 for strips) */
+  int		ncutout;		/* Number of cutouts */
+  planlevelstruct *level;		/* Pyramid levels */
+  int		nlevel;			/* Number of pyramid levels */
+  int		bigtiffflag;		/* BigTIFF output? */
+  double	scratch;		/* Scratch buffers */
+  double	ram;			/* Peak RAM use */
+  double	storeram;		/* Peak RAM use by stored levels */
+  double	spill;			/* Peak use of VMEM_DIR */
+  int		overflowflag;		/* VMEM_MAX exceeded? */
+  const char	*sizename[PLAN_NSIZE];	/* Compression types */
+  double	size[PLAN_NSIZE];	/* Estimated output sizes */
+  int		nsize;			/* Number of size estimates */
+  char		calibname[MAXCHAR];	/* Calibration file (or "NONE") */
+  char		mode[16];		/* Calibration mode */
+  int		calnthreads;		/* Calibration number of threads */
+  double	mpix_s;			/* Throughput (all channels) */
+  double	time;			/* Estimated conversion time */
+  }	planstruct;
+
+/*------------------------------- functions ---------------------------------*/
+extern void	makeplan(void);
+
+#endif
+
@@ -0,0 +1,347 @@
+/*
+*				png.c
+*
+* Encode PNG images in memory.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "png.h"
+
+static unsigned char	*put_pngchunk(unsigned char *buf, char *type,
+				unsigned char *data, size_t size),
+			*put_pnguint(unsigned char *buf, unsigned int val);
+
+/* PNG colour types as a function of the number of channels */
+static const int	png_colortype[] = {0, 0, 4, 2, 6};
+
+/****** encode_png ************************************************************
+PROTO	int encode_png(unsigned char *pix, int width, int height,
+			size_t stride, int nchan, int bypp, int level,
+			unsigned char **outbuf, size_t *outsize)
+PURPOSE	Compress a raster of 8- or 16-bit pixels to a PNG stream in memory.
+INPUT	Pointer to the first pixel,
+	raster width in pixels,
+	raster height in pixels,
+	raster line step in bytes,
+	number of channels (1 to 4),
+	number of bytes per channel (1 or 2),
+	zlib compression level (0-9),
+	pointer to the output buffer pointer (allocated here),
+	pointer to the output size in bytes.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	16-bit input is expected in native byte order. Lines are "Up"-filtered.
+	The output buffer must be freed with free() by the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	encode_png(unsigned char *pix, int width, int height,
+			size_t stride, int nchan, int bypp, int level,
+			unsigned char **outbuf, size_t *outsize)
+  {
+   unsigned char	*raw, *zbuf, *buf;
+   uLongf		zsize;
+   size_t		rawsize;
+
+  if (nchan<1 || nchan>4 || bypp<1 || bypp>2)
+    return RETURN_ERROR;
+
+  rawsize = ((size_t)width*nchan*bypp+1)*height;
+  QMALLOC(raw, unsigned char, rawsize);
+  filter_pnglines(pix, NULL, width, height, stride, nchan, bypp, raw);
+
+/* Compress */
+  zsize = compressBound((uLong)rawsize);
+  QMALLOC(zbuf, unsigned char, zsize);
+  if (compress2(zbuf, &zsize, raw, (uLong)rawsize, level) != Z_OK)
+    {
+    free(raw);
+    free(zbuf);
+    return RETURN_ERROR;
+    }
+  free(raw);
+
+/* Assemble the PNG stream */
+  QMALLOC(*outbuf, unsigned char, PNG_HEADERSIZE + zsize + 12 + 12);
+  buf = put_pngheader(*outbuf, width, height, nchan, bypp);
+  buf = put_pngchunk(buf, "IDAT", zbuf, zsize);
+  buf = put_pngchunk(buf, "IEND", NULL, 0);
+  *outsize = buf - *outbuf;
+  free(zbuf);
+
+  return RETURN_OK;
+  }
+
+
+/****** encode_pngband ********************************************************
+PROTO	int encode_pngband(unsigned char *pix, unsigned char *prevline,
+			int width, int height, size_t stride, int nchan,
+			int bypp, int level, int lastflag,
+			unsigned char **outbuf, size_t *outsize,
+			unsigned int *adler)
+PURPOSE	Filter and compress a band of lines as a raw deflate segment that can
+	be concatenated with the segments of the other bands of an image.
+INPUT	Pointer to the first pixel,
+	pointer to the line preceding the band (or NULL for the first band),
+	raster width in pixels,
+	band height in pixels,
+	raster line step in bytes,
+	number of channels (1 to 4),
+	number of bytes per channel (1 or 2),
+	zlib compression level (0-9),
+	flag set if this is the last band of the image,
+	pointer to the output buffer pointer (allocated here),
+	pointer to the output size in bytes,
+	pointer to the Adler-32 checksum of the filtered band (output).
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Segments end with a sync flush (byte aligned, no final block) except
+	the last one; checksums must be merged with adler32_combine().
+	The output buffer must be freed with free() by the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	encode_pngband(unsigned char *pix, unsigned char *prevline,
+			int width, int height, size_t stride, int nchan,
+			int bypp, int level, int lastflag,
+			unsigned char **outbuf, size_t *outsize,
+			unsigned int *adler)
+  {
+   z_stream		zs;
+   unsigned char	*raw;
+   size_t		rawsize, zsize;
+   int			status;
+
+  if (nchan<1 || nchan>4 || bypp<1 || bypp>2)
+    return RETURN_ERROR;
+
+  rawsize = ((size_t)width*nchan*bypp+1)*height;
+  QMALLOC(raw, unsigned char, rawsize);
+  filter_pnglines(pix, prevline, width, height, stride, nchan, bypp, raw);
+  *adler = (unsigned int)adler32(adler32(0L, Z_NULL, 0), raw, (uInt)rawsize);
+
+  memset(&zs, 0, sizeof(zs));
+  if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8,
+	Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    free(raw);
+    return RETURN_ERROR;
+    }
+/* Leave room for the sync flush marker */
+  zsize = deflateBound(&zs, (uLong)rawsize) + 16;
+  QMALLOC(*outbuf, unsigned char, zsize);
+  zs.next_in = raw;
+  zs.avail_in = (uInt)rawsize;
+  zs.next_out = *outbuf;
+  zs.avail_out = (uInt)zsize;
+  status = deflate(&zs, lastflag? Z_FINISH : Z_SYNC_FLUSH);
+  *outsize = zsize - zs.avail_out;
+  deflateEnd(&zs);
+  free(raw);
+  if (status != (lastflag? Z_STREAM_END : Z_OK) || zs.avail_in)
+    {
+    free(*outbuf);
+    return RETURN_ERROR;
+    }
+
+  return RETURN_OK;
+  }
+
+
+/****** filter_pnglines *******************************************************
+PROTO	void filter_pnglines(unsigned char *pix, unsigned char *prevline,
+			int width, int height, size_t stride, int nchan,
+			int bypp, unsigned char *raw)
+PURPOSE	Convert lines of pixels to "Up"-filtered PNG lines.
+INPUT	Pointer to the first pixel,
+	pointer to the line preceding the first one (or NULL if none),
+	raster width in pixels,
+	number of lines,
+	raster line step in bytes,
+	number of channels,
+	number of bytes per channel,
+	pointer to the output buffer ((width*nchan*bypp+1)*height bytes).
+OUTPUT	-.
+NOTES	16-bit input is expected in native byte order. The first line of the
+	image (no preceding line) is left unfiltered.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	filter_pnglines(unsigned char *pix, unsigned char *prevline,
+			int width, int height, size_t stride, int nchan,
+			int bypp, unsigned char *raw)
+  {
+   unsigned char	*pixt, *prevt;
+   size_t		rowsize, i;
+   int			y, o;
+
+  rowsize = (size_t)width*nchan*bypp;
+/* Byte offset that converts native 16-bit values to network byte order */
+  o = (bypp==2 && bswapflag)? 1 : 0;
+  for (y=0; y<height; y++)
+    {
+    pixt = pix + y*stride;
+    prevt = y? pixt - stride : prevline;
+    if (prevt)
+      {
+      *(raw++) = 2;			/* "Up" filter type */
+      for (i=0; i<rowsize; i++)
+        *(raw++) = pixt[i^o] - prevt[i^o];
+      }
+    else
+      {
+      *(raw++) = 0;			/* No filter */
+      for (i=0; i<rowsize; i++)
+        *(raw++) = pixt[i^o];
+      }
+    }
+
+  return;
+  }
+
+
+/****** put_pngheader *********************************************************
+PROTO	unsigned char *put_pngheader(unsigned char *buf, int width,
+			int height, int nchan, int bypp)
+PURPOSE	Write the PNG signature and IHDR chunk to a memory buffer.
+INPUT	Pointer to the output buffer (at least PNG_HEADERSIZE bytes),
+	image width in pixels,
+	image height in pixels,
+	number of channels (1 to 4),
+	number of bytes per channel (1 or 2).
+OUTPUT	Pointer to the byte following the header.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+unsigned char	*put_pngheader(unsigned char *buf, int width, int height,
+			int nchan, int bypp)
+  {
+   unsigned char	ihdr[13];
+
+  memcpy(buf, "\211PNG\r\n\032\n", 8);
+  put_pnguint(ihdr, (unsigned int)width);
+  put_pnguint(ihdr+4, (unsigned int)height);
+  ihdr[8] = bypp*8;
+  ihdr[9] = png_colortype[nchan];
+  ihdr[10] = ihdr[11] = ihdr[12] = 0;
+
+  return put_pngchunk(buf+8, "IHDR", ihdr, 13);
+  }
+
+
+/****** write_pngchunk ********************************************************
+PROTO	int write_pngchunk(FILE *file, char *type, unsigned char *data,
+			size_t size)
+PURPOSE	Write a PNG chunk (length, type, data and CRC) to a file.
+INPUT	Output file pointer,
+	4-character chunk type,
+	pointer to the chunk data (can be NULL if size is 0),
+	chunk data size in bytes.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	write_pngchunk(FILE *file, char *type, unsigned char *data,
+			size_t size)
+  {
+   unsigned char	buf[8];
+   uLong		crc;
+
+  put_pnguint(buf, (unsigned int)size);
+  memcpy(buf+4, type, 4);
+  crc = crc32(crc32(0L, Z_NULL, 0), buf+4, 4);
+  if (size)
+    crc = crc32(crc, data, (uInt)size);
+  if (fwrite(buf, 8, 1, file) != 1
+	|| (size && fwrite(data, size, 1, file) != 1))
+    return RETURN_ERROR;
+  put_pnguint(buf, (unsigned int)crc);
+  if (fwrite(buf, 4, 1, file) != 1)
+    return RETURN_ERROR;
+
+  return RETURN_OK;
+  }
+
+
+/****** put_pngchunk **********************************************************
+PROTO	unsigned char *put_pngchunk(unsigned char *buf, char *type,
+			unsigned char *data, size_t size)
+PURPOSE	Write a PNG chunk (length, type, data and CRC) to a memory buffer.
+INPUT	Pointer to the output buffer,
+	4-character chunk type,
+	pointer to the chunk data (can be NULL if size is 0),
+	chunk data size in bytes.
+OUTPUT	Pointer to the byte following the chunk.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static unsigned char	*put_pngchunk(unsigned char *buf, char *type,
+				unsigned char *data, size_t size)
+  {
+   uLong	crc;
+
+  buf = put_pnguint(buf, (unsigned int)size);
+  memcpy(buf, type, 4);
+  if (size)
+    memcpy(buf+4, data, size);
+  crc = crc32(crc32(0L, Z_NULL, 0), buf, (uInt)(size+4));
+  buf += size+4;
+
+  return put_pnguint(buf, (unsigned int)crc);
+  }
+
+
+/****** put_pnguint ***********************************************************
+PROTO	unsigned char *put_pnguint(unsigned char *buf, unsigned int val)
+PURPOSE	Write a 32-bit unsigned integer in network byte order.
+INPUT	Pointer to the output buffer,
+	value.
+OUTPUT	Pointer to the byte following the integer.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static unsigned char	*put_pnguint(unsigned char *buf, unsigned int val)
+  {
+  *(buf++) = (val>>24)&0xff;
+  *(buf++) = (val>>16)&0xff;
+  *(buf++) = (val>>8)&0xff;
+  *(buf++) = val&0xff;
+
+  return buf;
+  }
+
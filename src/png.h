@@ -0,0 +1,56 @@
+/*
+*				png.h
+*
+* Include file for png.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _PNG_H_
+#define _PNG_H_
+
+/*---------------------------------- defines --------------------------------*/
+#define	PNG_HEADERSIZE	33	/* Signature + IHDR chunk */
+
+/*------------------------------- functions ---------------------------------*/
+extern unsigned char	*put_pngheader(unsigned char *buf, int width,
+				int height, int nchan, int bypp);
+
+extern int		encode_png(unsigned char *pix, int width, int height,
+				size_t stride, int nchan, int bypp, int level,
+				unsigned char **outbuf, size_t *outsize),
+			encode_pngband(unsigned char *pix,
+				unsigned char *prevline, int width, int height,
+				size_t stride, int nchan, int bypp, int level,
+				int lastflag, unsigned char **outbuf,
+				size_t *outsize, unsigned int *adler),
+			write_pngchunk(FILE *file, char *type,
+				unsigned char *data, size_t size);
+
+extern void		filter_pnglines(unsigned char *pix,
+				unsigned char *prevline, int width, int height,
+				size_t stride, int nchan, int bypp,
+				unsigned char *raw);
+
+#endif
+
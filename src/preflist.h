@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -54,66 +54,103 @@ int idummy;
 
 pkeystruct key[] =
  {
-  {"BADPIXEL_REPLACEMENT", P_FLOATLIST, prefs.badpixel_replacement,0,0,-BIG,BIG,
-    {""}, 1, MAXFILE, &prefs.nbadpixel_replacement},
-  {"BIGTIFF_TYPE", P_KEY, &prefs.bigtiff_type, 0,0, 0.0,0.0,
+  {"BADPIXEL_REPLACEMENT", P_FLOATLIST, prefs_key.badpixel_replacement,0,0,-BIG,BIG,
+    {""}, 1, MAXFILE, &prefs_key.nbadpixel_replacement},
+  {"BATCH_NJOBS", P_INT, &prefs_key.batch_njobs, 0, THREADS_PREFMAX},
+  {"BIGTIFF_TYPE", P_KEY, &prefs_key.bigtiff_type, 0,0, 0.0,0.0,
    {"AUTO","NEVER","ALWAYS",""}},
-  {"BINNING", P_INTLIST, prefs.bin_size, 1, 32768, 0.0,0.0,
-   {""}, 1, 2, &prefs.nbin_size},
-  {"BITS_PER_CHANNEL", P_INT, &prefs.bpp, -32, 16},
-  {"CHANNELTAG_TYPE", P_KEY, &prefs.channeltag_type, 0,0, 0.0,0.0,
+  {"BINNING", P_INTLIST, prefs_key.bin_size, 1, 32768, 0.0,0.0,
+   {""}, 1, 2, &prefs_key.nbin_size},
+  {"BITS_PER_CHANNEL", P_INT, &prefs_key.bpp, -32, 16},
+  {"CHANNELTAG_TYPE", P_KEY, &prefs_key.channeltag_type, 0,0, 0.0,0.0,
    {"FITS_KEYWORD", "MANUAL", "MATCH", ""}},
-  {"CHANNELTAG_KEY", P_STRING, &prefs.channeltag_key, 0,0, 0.0,0.0},
-  {"CHANNEL_TAGS", P_STRINGLIST, prefs.channel_tags, 0,0, 0.0,0.0,
-   {""}, 0, MAXTAG, &prefs.nchannel_tags},
-  {"COMPRESSION_QUALITY", P_INT, &prefs.compress_quality, 0,100},
-  {"COMPRESSION_TYPE", P_KEY, &prefs.compress_type, 0,0, 0.0,0.0,
+  {"CHANNELTAG_KEY", P_STRING, &prefs_key.channeltag_key, 0,0, 0.0,0.0},
+  {"CHANNEL_TAGS", P_STRINGLIST, prefs_key.channel_tags, 0,0, 0.0,0.0,
+   {""}, 0, MAXTAG, &prefs_key.nchannel_tags},
+  {"COMPRESSION_QUALITY", P_INT, &prefs_key.compress_quality, 0,100},
+  {"COMPRESSION_TYPE", P_KEY, &prefs_key.compress_type, 0,0, 0.0,0.0,
    {"NONE", "LZW", "JPEG", "DEFLATE", "ADOBE-DEFLATE", ""}},
-  {"COLOUR_SAT", P_FLOAT, &prefs.colour_sat, 0,0, 0.0,10.0},
-  {"COPY_HEADER", P_BOOL, &prefs.header_flag},
-  {"COPYRIGHT", P_STRING, prefs.copyright},
-  {"DESCRIPTION", P_STRING, prefs.description},
+  {"COLOUR_SAT", P_FLOAT, &prefs_key.colour_sat, 0,0, 0.0,10.0},
+  {"COPY_HEADER", P_BOOL, &prefs_key.header_flag},
+  {"COPYRIGHT", P_STRING, prefs_key.copyright},
+  {"DESCRIPTION", P_STRING, prefs_key.description},
 /*
-  {"DOWNSAMPLING_TYPE", P_KEY, &prefs.downsamp_type, 0,0, 0.0,0.0,
+  {"DOWNSAMPLING_TYPE", P_KEY, &prefs_key.downsamp_type, 0,0, 0.0,0.0,
    {"4:4:4", "4:2:2", "4:2:0", ""}},
 */
-  {"FITS_UNSIGNED", P_BOOL, &prefs.fitsunsigned_flag},
-  {"FLIP_TYPE", P_KEY, &prefs.flip_type, 0,0, 0.0,0.0,
+  {"FITS_UNSIGNED", P_BOOL, &prefs_key.fitsunsigned_flag},
+  {"FLIP_TYPE", P_KEY, &prefs_key.flip_type, 0,0, 0.0,0.0,
    {"NONE", "X", "Y", "XY", ""}},
-  {"GAMMA", P_FLOAT, &prefs.gamma, 0,0, 1e-3,10.0},
-  {"GAMMA_FAC", P_FLOAT, &prefs.gamma_fac, 0,0, 1e-3,10.0},
-  {"GAMMA_TYPE", P_KEY, &prefs.gamma_type, 0,0, 0.0,0.0,
+  {"GAMMA", P_FLOAT, &prefs_key.gamma, 0,0, 1e-3,10.0},
+  {"GAMMA_FAC", P_FLOAT, &prefs_key.gamma_fac, 0,0, 1e-3,10.0},
+  {"GAMMA_TYPE", P_KEY, &prefs_key.gamma_type, 0,0, 0.0,0.0,
    {"POWER-LAW", "SRGB", "REC.709", ""}},
-  {"IMAGE_TYPE", P_KEY, &prefs.format_type, 0,0, 0.0,0.0,
-   {"AUTO", "TIFF", "TIFF-PYRAMID", ""}},
-  {"MIN_TYPE",  P_KEYLIST, prefs.min_type, 0,0, 0.0,0.0,
-   {"QUANTILE", "MANUAL", "GREYLEVEL"}, 1, MAXFILE, &prefs.nmin_type},
-  {"MIN_LEVEL",  P_FLOATLIST, prefs.min_val, 0,0, -1e31,1e31,
-   {""}, 1, MAXFILE, &prefs.nmin_val},
-  {"MAX_TYPE",  P_KEYLIST, prefs.max_type, 0,0, 0.0,0.0,
-   {"QUANTILE", "MANUAL"}, 1, MAXFILE, &prefs.nmax_type},
-  {"MAX_LEVEL",  P_FLOATLIST, prefs.max_val, 0,0, -1e31,1e31,
-   {""}, 1, MAXFILE, &prefs.nmax_val},
-  {"MEM_MAX", P_INT, &prefs.mem_max, 1, 1000000000},
-  {"NEGATIVE", P_BOOL, &prefs.neg_flag},
-  {"NTHREADS", P_INT, &prefs.nthreads, 0, THREADS_PREFMAX},
-  {"OUTFILE_NAME", P_STRING, prefs.tiff_name},
-  {"PYRAMID_MINSIZE", P_INTLIST, prefs.min_size, 1, 32768, 0.0,0.0,
-   {""}, 1, 2, &prefs.nmin_size},
-  {"SATUR_LEVEL", P_FLOATLIST, prefs.sat_val, 0,0, -1e31,1e31,
-   {""}, 1, MAXFILE, &prefs.nsat_val},
-  {"SKY_LEVEL",  P_FLOATLIST, prefs.back_val, 0,0, -1e31,1e31,
-   {""}, 1, MAXFILE, &prefs.nback_val},
-  {"SKY_TYPE", P_KEYLIST, prefs.back_type, 0,0, 0.0,0.0,
-   {"AUTO", "MANUAL", ""}, 1, MAXFILE, &prefs.nback_type},
-  {"TILE_SIZE", P_INT, &prefs.tile_size, 16, 32768},
-  {"VERBOSE_TYPE", P_KEY, &prefs.verbose_type, 0,0, 0.0,0.0,
+  {"IMAGE_TYPE", P_KEY, &prefs_key.format_type, 0,0, 0.0,0.0,
+   {"AUTO", "TIFF", "TIFF-PYRAMID", "DEEPZOOM", "XYZ",
+	"ZARR", "JPEG", "PNG", ""}},
+  {"MIN_TYPE",  P_KEYLIST, prefs_key.min_type, 0,0, 0.0,0.0,
+   {"QUANTILE", "MANUAL", "GREYLEVEL"}, 1, MAXFILE, &prefs_key.nmin_type},
+  {"MIN_LEVEL",  P_FLOATLIST, prefs_key.min_val, 0,0, -1e31,1e31,
+   {""}, 1, MAXFILE, &prefs_key.nmin_val},
+  {"MAX_TYPE",  P_KEYLIST, prefs_key.max_type, 0,0, 0.0,0.0,
+   {"QUANTILE", "MANUAL"}, 1, MAXFILE, &prefs_key.nmax_type},
+  {"MAX_LEVEL",  P_FLOATLIST, prefs_key.max_val, 0,0, -1e31,1e31,
+   {""}, 1, MAXFILE, &prefs_key.nmax_val},
+  {"MEM_HUGEPAGES", P_KEY, &prefs_key.hugepage_type, 0,0, 0.0,0.0,
+   {"NONE", "TRANSPARENT", "EXPLICIT", ""}},
+  {"MEM_MAX", P_INT, &prefs_key.mem_max, 0, 1000000000},
+  {"MEM_NUMA", P_KEY, &prefs_key.numa_type, 0,0, 0.0,0.0,
+   {"DEFAULT", "INTERLEAVE", "FIRST_TOUCH", ""}},
+  {"MOSAIC_KEYS", P_STRINGLIST, prefs_key.mosaic_key, 0,0, 0.0,0.0,
+   {""}, 2, 2, &prefs_key.nmosaic_key},
+  {"MOSAIC_TYPE", P_KEY, &prefs_key.mosaic_type, 0,0, 0.0,0.0,
+   {"NONE", "OFFSET", "WCS", ""}},
+  {"NEGATIVE", P_BOOL, &prefs_key.neg_flag},
+  {"NTHREADS", P_INT, &prefs_key.nthreads, 0, THREADS_PREFMAX},
+  {"OUTFILE_NAME", P_STRING, prefs_key.tiff_name},
+  {"PLAN_BENCH_NAME", P_STRING, prefs_key.planbench_name},
+  {"PLAN_NAME", P_STRING, prefs_key.plan_name},
+  {"PLAN_TYPE", P_KEY, &prefs_key.plan_type, 0,0, 0.0,0.0,
+   {"NONE", "JSON", "XML", ""}},
+#ifdef USE_PROBES
+  {"PROBE_NAME", P_STRING, prefs_key.probe_name},
+#endif
+  {"PROGRESS_INTERVAL", P_FLOAT, &prefs_key.progress_interval, 0,0, 0.0,3600.0},
+  {"PROGRESS_NAME", P_STRING, prefs_key.progress_name},
+  {"PYRAMID_MINSIZE", P_INTLIST, prefs_key.min_size, 1, 32768, 0.0,0.0,
+   {""}, 1, 2, &prefs_key.nmin_size},
+  {"PYRAMID_STORAGE", P_KEY, &prefs_key.pyrstorage_type, 0,0, 0.0,0.0,
+   {"FLOAT32", "FLOAT16", "UINT16", ""}},
+  {"PYRAMID_UPDATE", P_BOOL, &prefs_key.pyrupdate_flag},
+  {"REGION", P_FLOATLIST, prefs_key.region, 0,0, -1e31,1e31,
+   {""}, 4, MAXLIST, &prefs_key.nregion},
+  {"REGION_STATS", P_KEY, &prefs_key.regionstats_type, 0,0, 0.0,0.0,
+   {"REGION", "FULL", ""}},
+  {"REGION_TYPE", P_KEY, &prefs_key.region_type, 0,0, 0.0,0.0,
+   {"NONE", "PIXEL", "WORLD", ""}},
+  {"SATUR_LEVEL", P_FLOATLIST, prefs_key.sat_val, 0,0, -1e31,1e31,
+   {""}, 1, MAXFILE, &prefs_key.nsat_val},
+  {"SKY_LEVEL",  P_FLOATLIST, prefs_key.back_val, 0,0, -1e31,1e31,
+   {""}, 1, MAXFILE, &prefs_key.nback_val},
+  {"SKY_TYPE", P_KEYLIST, prefs_key.back_type, 0,0, 0.0,0.0,
+   {"AUTO", "MANUAL", ""}, 1, MAXFILE, &prefs_key.nback_type},
+  {"THREAD_PINNING", P_BOOL, &prefs_key.pinning_flag},
+  {"TILEFILE_TYPE", P_KEY, &prefs_key.tilefile_type, 0,0, 0.0,0.0,
+   {"JPEG", "PNG", ""}},
+  {"TILE_SIZE", P_INT, &prefs_key.tile_size, 16, 32768},
+  {"TRACE_NAME", P_STRING, prefs_key.trace_name},
+  {"VERBOSE_TYPE", P_KEY, &prefs_key.verbose_type, 0,0, 0.0,0.0,
    {"QUIET", "NORMAL", "FULL",""}},
-  {"VMEM_DIR", P_STRING, prefs.swapdir_name},
-  {"VMEM_MAX", P_INT, &prefs.vmem_max, 1, 1000000000},
-  {"WRITE_XML", P_BOOL, &prefs.xml_flag},
-  {"XML_NAME", P_STRING, prefs.xml_name},
-  {"XSL_URL", P_STRING, prefs.xsl_name},
+  {"VERIFY_CHECKSUM", P_BOOL, &prefs_key.checksum_flag},
+  {"VMEM_DIR", P_STRING, prefs_key.swapdir_name},
+  {"VMEM_MAX", P_INT, &prefs_key.vmem_max, 0, 1000000000},
+  {"VMEM_TYPE", P_KEY, &prefs_key.vmem_type, 0,0, 0.0,0.0,
+   {"FILE","COMPRESSED",""}},
+  {"WRITE_PROGRESS", P_BOOL, &prefs_key.progress_flag},
+  {"WRITE_TRACE", P_BOOL, &prefs_key.trace_flag},
+  {"WRITE_XML", P_BOOL, &prefs_key.xml_flag},
+  {"XML_NAME", P_STRING, prefs_key.xml_name},
+  {"XSL_URL", P_STRING, prefs_key.xsl_name},
   {""}
  };
 
@@ -127,20 +164,44 @@ char *default_prefs[] =
 "#",
 "OUTFILE_NAME           stiff.tif       # Name of the output file",
 "IMAGE_TYPE             AUTO            # Output image format: AUTO, TIFF,",
-"                                       # or TIFF-PYRAMID",
+"                                       # TIFF-PYRAMID, DEEPZOOM, XYZ, ZARR,",
+"                                       # JPEG or PNG",
 "BITS_PER_CHANNEL       8               # 8, 16 for int, -32 for float",
 "*BIGTIFF_TYPE           AUTO            # Use BigTIFF? NEVER,ALWAYS or AUTO",
 "*COMPRESSION_TYPE       LZW             # NONE,LZW,JPEG,DEFLATE or ADOBE-DEFLATE",
-"*COMPRESSION_QUALITY    90              # JPEG compression quality (%)",
+"*COMPRESSION_QUALITY    90              # JPEG quality, or deflate effort for",
+"*                                       # PNG and ZARR (%)",
 /*
 "*DOWNSAMPLING_TYPE      4:4:4           # Chrominance downsampling for JPEG:",
 "*                                       # 4:4:4, 4:2:2 or 4:2:0",
 */
 "*TILE_SIZE              256             # TIFF tile-size",
+"*TILEFILE_TYPE          JPEG            # DEEPZOOM/XYZ tile format: JPEG or PNG",
 "*PYRAMID_MINSIZE        256             # Minimum plane size in TIFF pyramid",
+"*PYRAMID_STORAGE        FLOAT32         # Pyramid level storage: FLOAT32,",
+"*                                       # FLOAT16 or UINT16 (quantized); 16-bit",
+"*                                       # modes bin all levels in one pass and",
+"*                                       # store output pixels: integer output",
+"*                                       # is unchanged, float output of reduced",
+"*                                       # levels is rounded to 16 bits",
+"*PYRAMID_UPDATE         N               # Update only the REGION of an existing",
+"*                                       # TIFF pyramid (levels read from XML)?",
 "BINNING                1               # Binning factor for the data",
 "*FLIP_TYPE              NONE            # NONE, or flip about X, Y or XY",
 "*FITS_UNSIGNED          N               # Treat FITS integers as unsigned",
+"*VERIFY_CHECKSUM        N               # Verify input CHECKSUM/DATASUM",
+"*                                       # keywords while reading?",
+"*REGION_TYPE            NONE            # Cutout: NONE, PIXEL or WORLD",
+"*REGION                 0,0,0,0         # Cutout corners xmin,ymin,xmax,ymax",
+"*                                       # (pixels) or ra1,dec1,ra2,dec2 (deg);",
+"*                                       # several cutouts are extracted in",
+"*                                       # one pass, as OUTFILE_NAME_<n>.<ext>",
+"*REGION_STATS           REGION          # Levels from the cutout REGION or",
+"*                                       # from the FULL image",
+"*MOSAIC_TYPE            NONE            # Assemble all inputs as tiles of a",
+"*                                       # single image: NONE, OFFSET or WCS",
+"*MOSAIC_KEYS            LTV1,LTV2       # Tile offset keywords for OFFSET",
+"*                                       # (IRAF LTVn convention)",
 " ",
 "*#------------------------------- Channel tagging ----------------------------",
 "*CHANNELTAG_TYPE        FITS_KEYWORD    # FITS_KEYWORD, MANUAL, or MATCH",
@@ -169,7 +230,17 @@ char *default_prefs[] =
 "*",
 "*VMEM_DIR               .               # Directory path for swap files",
 "*VMEM_MAX               1048576         # Maximum amount of virtual memory (MB)",
+"*                                       # 0 or AUTO = automatic (from VMEM_DIR",
+"*                                       # free space)",
+"*VMEM_TYPE              FILE            # Beyond MEM_MAX: FILE (swap files) or",
+"*                                       # COMPRESSED (in RAM, then in VMEM_DIR)",
 "*MEM_MAX                1024            # Maximum amount of usable RAM (MB)",
+"*                                       # 0 or AUTO = automatic (from cgroup",
+"*                                       # limits and available memory)",
+"*MEM_HUGEPAGES          NONE            # Huge pages for pixel buffers: NONE,",
+"*                                       # TRANSPARENT or EXPLICIT",
+"*MEM_NUMA               DEFAULT         # NUMA placement of pixel buffers:",
+"*                                       # DEFAULT, INTERLEAVE or FIRST_TOUCH",
 "*",
 "#------------------------------ Miscellaneous ---------------------------------",
 " ",
@@ -181,10 +252,28 @@ char *default_prefs[] =
 "XML_NAME               stiff.xml       # Filename for XML output",
 "*XSL_URL                " XSL_URL,
 "*                                       # Filename for XSL style-sheet",
+"*WRITE_TRACE            N               # Write a trace of processing stages?",
+"*TRACE_NAME             stiff_trace.json # Filename for trace output",
+"*                                       # (Chrome trace event format)",
+"*WRITE_PROGRESS         N               # Maintain a progress status file?",
+"*PROGRESS_NAME          stiff_progress.json # Filename for progress status",
+"*                                       # (JSON, or STDOUT for a JSON stream)",
+"*PROGRESS_INTERVAL      1.0             # Min. time between updates (s)",
+"*PLAN_TYPE              NONE            # Dry run: only write a plan of the",
+"*                                       # conversion (NONE, JSON or XML)",
+"*PLAN_NAME              STDOUT          # Filename for plan output",
+"*PLAN_BENCH_NAME        stiff_bench.json # stiff-bench output used to",
+"*                                       # calibrate time estimates",
+#ifdef USE_PROBES
+"*PROBE_NAME             stiff_probes.json # Filename for timing probe output",
+#endif
 #ifdef USE_THREADS
 "NTHREADS               0               # Number of simultaneous threads for",
 "                                       # the SMP version of " BANNER,
 "                                       # 0 = automatic",
+"*THREAD_PINNING         N               # Pin conversion threads to CPU cores?",
+"*BATCH_NJOBS            0               # Number of batch or server jobs run",
+"*                                       # at the same time (0 = automatic)",
 #else
 "NTHREADS              1                # 1 single thread",
 #endif
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		08/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -31,6 +31,7 @@
 #endif
 
 #include	<ctype.h>
+#include	<limits.h>
 #include	<math.h>
 #include	<stdio.h>
 #include	<stdlib.h>
@@ -47,8 +48,25 @@
 #include	"define.h"
 #include	"globals.h"
 #include	"fits/fitscat.h"
+#include	"datamem.h"
 #include 	"prefs.h"
 #include	"preflist.h"
+#ifdef USE_THREADS
+#include	"threads.h"
+#endif
+
+/* key[] points to the members of prefs_key, a template for all preferences */
+prefstruct		prefs_key;
+static prefstruct	prefs_default;
+THREAD_LOCAL prefstruct	*prefs_thread = &prefs_default;
+#ifdef USE_THREADS
+static pthread_once_t	prefs_once = PTHREAD_ONCE_INIT;
+#endif
+
+static int	getprefint(int nkey, char *value, int *ival),
+		setprefline(char *str, char *filename, int *warn);
+
+static void	init_keylist(void);
 
 /********************************* dumpprefs ********************************/
 /*
@@ -80,13 +98,8 @@ void    readprefs(char *filename, char **argkey, char **argval, int narg)
   {
    FILE			*infile;
    char			str[MAXCHARL],
-			**dp, *cp,  *keyword, *value, *listbuf;
-   int			i, ival, nkey, warn, argi, flagc, flagd, flage, flagz;
-   double		dval;
-#ifdef	HAVE_GETENV
-   static char	value2[MAXCHARL],envname[MAXCHAR];
-   char			*dolpos;
-#endif
+			**dp, *keyflag;
+   int			i, warn, argi, flagc, flagd, flage, nkey;
 
 
   if ((infile = fopen(filename,"r")) == NULL)
@@ -98,15 +111,18 @@ void    readprefs(char *filename, char **argkey, char **argval, int narg)
     flage = 0;
 
 /*Build the keyword-list from pkeystruct-array */
-
-  for (i=0; key[i].name[0]; i++)
-    strcpy(keylist[i], key[i].name);
-  keylist[i][0] = '\0';
-
+#ifdef USE_THREADS
+  pthread_once(&prefs_once, init_keylist);
+#else
+  init_keylist();
+#endif
+  nkey = 0;
+  while (key[nkey].name[0])
+    nkey++;
+  QCALLOC(keyflag, char, nkey);
 
 /*Scan the configuration file*/
 
-  listbuf = NULL;
   argi=0;
   flagc = 0;
   flagd = 1;
@@ -140,241 +156,477 @@ void    readprefs(char *filename, char **argkey, char **argval, int narg)
         break;
       }
 
-    keyword = mystrtok(str, notokstr);
-    if (keyword && keyword[0]!=0 && keyword[0]!=(char)'#')
+    if ((i = setprefline(str, filename, &warn)) != RETURN_ERROR)
+      keyflag[i] = 1;
+    }
+
+  for (i=0; i<nkey; i++)
+    if (!keyflag[i])
+      error(EXIT_FAILURE, key[i].name, " configuration keyword missing");
+  free(keyflag);
+  if (!flage)
+    fclose(infile);
+
+  return;
+  }
+
+
+/******************************** init_keylist *******************************/
+/*
+Build the keyword-list from pkeystruct-array (once per process).
+*/
+static void	init_keylist(void)
+
+  {
+   int	i;
+
+  for (i=0; key[i].name[0]; i++)
+    strcpy(keylist[i], key[i].name);
+  keylist[i][0] = '\0';
+
+  return;
+  }
+
+
+/********************************* bindprefs *********************************/
+/*
+Make the calling thread work on the given preferences. Returns the previous
+ones. Threads started with QPTHREAD_CREATE() inherit the preferences of their
+creator.
+*/
+prefstruct	*bindprefs(prefstruct *newprefs)
+
+  {
+   prefstruct	*oldprefs;
+
+  oldprefs = prefs_thread;
+  prefs_thread = newprefs? newprefs : &prefs_default;
+
+  return oldprefs;
+  }
+
+
+/********************************* prefs_ptr *********************************/
+/*
+Convert a key[] pointer to the matching member of the current preferences.
+*/
+void	*prefs_ptr(void *keyptr)
+
+  {
+  if ((char *)keyptr >= (char *)&prefs_key
+	&& (char *)keyptr < (char *)(&prefs_key + 1))
+    return (char *)&prefs + ((char *)keyptr - (char *)&prefs_key);
+
+  return keyptr;
+  }
+
+
+/******************************** setprefline ********************************/
+/*
+Parse a ``keyword value'' line and update the matching preference parameter.
+Returns the index of the keyword, or RETURN_ERROR if the line sets nothing.
+*/
+static int	setprefline(char *str, char *filename, int *warn)
+
+  {
+   void			*keyptr;
+   char			*cp,  *keyword, *value, *listbuf;
+   int			i, ival, nkey, flagz, *nlistptr;
+   double		dval;
+#ifdef	HAVE_GETENV
+   char			value2[MAXCHARL],envname[MAXCHAR],
+			*dolpos;
+#endif
+
+  listbuf = NULL;
+  nkey = RETURN_ERROR;
+  keyword = mystrtok(str, notokstr);
+  if (keyword && keyword[0]!=0 && keyword[0]!=(char)'#')
+    {
+    if (*warn>=10)
+      error(EXIT_FAILURE, "*Error*: No valid keyword found in ", filename);
+    nkey = findkeys(keyword, keylist, FIND_STRICT);
+    if (nkey!=RETURN_ERROR)
       {
-      if (warn>=10)
-        error(EXIT_FAILURE, "*Error*: No valid keyword found in ", filename);
-      nkey = findkeys(keyword, keylist, FIND_STRICT);
-      if (nkey!=RETURN_ERROR)
-        {
-        value = mystrtok((char *)NULL, notokstr);
+/*---- Values go to the preferences of the current thread */
+      keyptr = prefs_ptr(key[nkey].ptr);
+      nlistptr = (int *)prefs_ptr(key[nkey].nlistptr);
+      value = mystrtok((char *)NULL, notokstr);
 #ifdef	HAVE_GETENV
 /*------ Expansion of environment variables (preceded by '$') */
-        if (value && (dolpos=strchr(value, '$')))
-          {
-           int	nc;
-           char	*valuet,*value2t, *envval;
+      if (value && (dolpos=strchr(value, '$')))
+        {
+         int	nc;
+         char	*valuet,*value2t, *envval;
 
-          value2t = value2;
-          valuet = value;
-          while (dolpos)
-            {
-            while (valuet<dolpos)
-              *(value2t++) = *(valuet++);	/* verbatim copy before '$' */
-            if (*(++valuet) == (char)'{')
-              valuet++;
-            strncpy(envname, valuet, nc=strcspn(valuet,"}/:\"\'\\"));
-            *(envname+nc) = (char)'\0';
-            if (*(valuet+=nc) == (char)'}')
-              valuet++;
-            if (!(envval=getenv(envname)))
-              error(EXIT_FAILURE, "Environment variable not found: ",
+        value2t = value2;
+        valuet = value;
+        while (dolpos)
+          {
+          while (valuet<dolpos)
+            *(value2t++) = *(valuet++);	/* verbatim copy before '$' */
+          if (*(++valuet) == (char)'{')
+            valuet++;
+          strncpy(envname, valuet, nc=strcspn(valuet,"}/:\"\'\\"));
+          *(envname+nc) = (char)'\0';
+          if (*(valuet+=nc) == (char)'}')
+            valuet++;
+          if (!(envval=getenv(envname)))
+            error(EXIT_FAILURE, "Environment variable not found: ",
 				envname);
-            while(*envval)			/* Copy the ENV content */
-              *(value2t++) = *(envval++);
-            while(*valuet && *valuet!=(char)'$')/* Continue verbatim copy */
-              *(value2t++) = *(valuet++);
-            if (*valuet)
-              dolpos = valuet;
-            else
-              {
-              dolpos = NULL;
-              *value2t = (char)'\0';
-              }
-	    }
-
-          value = mystrtok(value2, notokstr);
+          while(*envval)			/* Copy the ENV content */
+            *(value2t++) = *(envval++);
+          while(*valuet && *valuet!=(char)'$')/* Continue verbatim copy */
+            *(value2t++) = *(valuet++);
+          if (*valuet)
+            dolpos = valuet;
+          else
+            {
+            dolpos = NULL;
+            *value2t = (char)'\0';
+            }
           }
+
+        value = mystrtok(value2, notokstr);
+        }
 #endif
-        switch(key[nkey].type)
-          {
-          case P_FLOAT:
-            if (!value || value[0]==(char)'#')
-              error(EXIT_FAILURE, keyword," keyword has no value!");
-            if (*value=='@')
-              value = listbuf = list_to_str(value+1);
-            dval = atof(value);
-            if (dval>=key[nkey].dmin && dval<=key[nkey].dmax)
-              *(double *)(key[nkey].ptr) = dval;
+      switch(key[nkey].type)
+        {
+        case P_FLOAT:
+          if (!value || value[0]==(char)'#')
+            error(EXIT_FAILURE, keyword," keyword has no value!");
+          if (*value=='@')
+            value = listbuf = list_to_str(value+1);
+          dval = atof(value);
+          if (dval>=key[nkey].dmin && dval<=key[nkey].dmax)
+            *(double *)keyptr = dval;
+          else
+            error(EXIT_FAILURE, keyword," keyword out of range");
+          break;
+
+        case P_INT:
+          if (!value || value[0]==(char)'#')
+            error(EXIT_FAILURE, keyword," keyword has no value!");
+          if (*value=='@')
+            value = listbuf = list_to_str(value+1);
+          if (getprefint(nkey, value, &ival) != RETURN_OK)
+            error(EXIT_FAILURE, keyword, " keyword has an invalid value");
+          if (ival>=key[nkey].imin && ival<=key[nkey].imax)
+            *(int *)keyptr = ival;
+          else
+            error(EXIT_FAILURE, keyword, " keyword out of range");
+          break;
+
+        case P_STRING:
+          if (!value || value[0]==(char)'#')
+            error(EXIT_FAILURE, keyword," string is empty!");
+          if (*value=='@')
+            value = listbuf = list_to_str(value+1);
+          strcpy((char *)keyptr, value);
+          break;
+
+        case P_BOOL:
+          if (!value || value[0]==(char)'#')
+            error(EXIT_FAILURE, keyword," keyword has no value!");
+          if (*value=='@')
+            value = listbuf = list_to_str(value+1);
+          if ((cp = strchr("yYnN", (int)value[0])))
+            *(int *)keyptr = (tolower((int)*cp)=='y')?1:0;
+          else
+            error(EXIT_FAILURE, keyword, " value must be Y or N");
+          break;
+
+        case P_KEY:
+          if (!value || value[0]==(char)'#')
+            error(EXIT_FAILURE, keyword," keyword has no value!");
+          if (*value=='@')
+            value = listbuf = list_to_str(value+1);
+          if ((ival = findkeys(value, key[nkey].keylist,FIND_STRICT))
+			!= RETURN_ERROR)
+            *(int *)keyptr = ival;
+          else
+            error(EXIT_FAILURE, keyword, " set to an unknown keyword");
+          break;
+
+        case P_BOOLLIST:
+          if (value && *value=='@')
+            value = mystrtok(listbuf = list_to_str(value+1), notokstr);
+          for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
+            {
+            if (i>=key[nkey].nlistmax)
+              error(EXIT_FAILURE, keyword, " has too many members");
+            if ((cp = strchr("yYnN", (int)value[0])))
+              ((int *)keyptr)[i] = (tolower((int)*cp)=='y')?1:0;
             else
-              error(EXIT_FAILURE, keyword," keyword out of range");
-            break;
-
-          case P_INT:
-            if (!value || value[0]==(char)'#')
-              error(EXIT_FAILURE, keyword," keyword has no value!");
-            if (*value=='@')
-              value = listbuf = list_to_str(value+1);
-            ival = (int)strtol(value, (char **)NULL, 0);
+              error(EXIT_FAILURE, keyword, " value must be Y or N");
+            value = mystrtok((char *)NULL, notokstr);
+            }
+          if (i<key[nkey].nlistmin)
+            error(EXIT_FAILURE, keyword, " list has not enough members");
+          *nlistptr = i;
+          break;
+
+        case P_INTLIST:
+          if (value && *value=='@')
+            value = mystrtok(listbuf = list_to_str(value+1), notokstr);
+          for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
+            {
+            if (i>=key[nkey].nlistmax)
+              error(EXIT_FAILURE, keyword, " has too many members");
+            if (getprefint(nkey, value, &ival) != RETURN_OK)
+              error(EXIT_FAILURE, keyword, " keyword has an invalid value");
             if (ival>=key[nkey].imin && ival<=key[nkey].imax)
-              *(int *)(key[nkey].ptr) = ival;
+              ((int *)keyptr)[i] = ival;
             else
               error(EXIT_FAILURE, keyword, " keyword out of range");
-            break;
-
-          case P_STRING:
-            if (!value || value[0]==(char)'#')
-              error(EXIT_FAILURE, keyword," string is empty!");
-            if (*value=='@')
-              value = listbuf = list_to_str(value+1);
-            strcpy((char *)key[nkey].ptr, value);
-            break;
-
-          case P_BOOL:
-            if (!value || value[0]==(char)'#')
-              error(EXIT_FAILURE, keyword," keyword has no value!");
-            if (*value=='@')
-              value = listbuf = list_to_str(value+1);
-            if ((cp = strchr("yYnN", (int)value[0])))
-              *(int *)(key[nkey].ptr) = (tolower((int)*cp)=='y')?1:0;
+            value = mystrtok((char *)NULL, notokstr);
+            }
+          if (i<key[nkey].nlistmin)
+            error(EXIT_FAILURE, keyword, " list has not enough members");
+          *nlistptr = i;
+          break;
+
+        case P_FLOATLIST:
+          if (value && *value=='@')
+            value = mystrtok(listbuf = list_to_str(value+1), notokstr);
+          for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
+            {
+            if (i>=key[nkey].nlistmax)
+              error(EXIT_FAILURE, keyword, " has too many members");
+            dval = atof(value);
+            if (dval>=key[nkey].dmin && dval<=key[nkey].dmax)
+              ((double *)keyptr)[i] = dval;
             else
-              error(EXIT_FAILURE, keyword, " value must be Y or N");
-            break;
-
-          case P_KEY:
-            if (!value || value[0]==(char)'#')
-              error(EXIT_FAILURE, keyword," keyword has no value!");
-            if (*value=='@')
-              value = listbuf = list_to_str(value+1);
-            if ((ival = findkeys(value, key[nkey].keylist,FIND_STRICT))
+              error(EXIT_FAILURE, keyword, " keyword out of range");
+            value = mystrtok((char *)NULL, notokstr);
+            }
+          if (i<key[nkey].nlistmin)
+            error(EXIT_FAILURE, keyword, " list has not enough members");
+          *nlistptr = i;
+          break;
+
+        case P_KEYLIST:
+          if (value && *value=='@')
+            value = mystrtok(listbuf = list_to_str(value+1), notokstr);
+          for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
+            {
+            if (i>=key[nkey].nlistmax)
+              error(EXIT_FAILURE, keyword, " has too many members");
+            if ((ival = findkeys(value, key[nkey].keylist, FIND_STRICT))
 			!= RETURN_ERROR)
-              *(int *)(key[nkey].ptr) = ival;
+              ((int *)keyptr)[i] = ival;
             else
               error(EXIT_FAILURE, keyword, " set to an unknown keyword");
-            break;
-
-          case P_BOOLLIST:
-            if (value && *value=='@')
-              value = mystrtok(listbuf = list_to_str(value+1), notokstr);
-            for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
-              {
-              if (i>=key[nkey].nlistmax)
-                error(EXIT_FAILURE, keyword, " has too many members");
-              if ((cp = strchr("yYnN", (int)value[0])))
-                ((int *)(key[nkey].ptr))[i] = (tolower((int)*cp)=='y')?1:0;
-              else
-                error(EXIT_FAILURE, keyword, " value must be Y or N");
-              value = mystrtok((char *)NULL, notokstr);
-              }
-            if (i<key[nkey].nlistmin)
-              error(EXIT_FAILURE, keyword, " list has not enough members");
-            *(key[nkey].nlistptr) = i;
-            break;
-
-          case P_INTLIST:
-            if (value && *value=='@')
-              value = mystrtok(listbuf = list_to_str(value+1), notokstr);
-            for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
-              {
-              if (i>=key[nkey].nlistmax)
-                error(EXIT_FAILURE, keyword, " has too many members");
-              ival = (int)strtol(value, (char **)NULL, 0);
-              if (ival>=key[nkey].imin && ival<=key[nkey].imax)
-                ((int *)key[nkey].ptr)[i] = ival;
-              else
-                error(EXIT_FAILURE, keyword, " keyword out of range");
-              value = mystrtok((char *)NULL, notokstr);
-              }
-            if (i<key[nkey].nlistmin)
-              error(EXIT_FAILURE, keyword, " list has not enough members");
-            *(key[nkey].nlistptr) = i;
-            break;
-
-          case P_FLOATLIST:
-            if (value && *value=='@')
-              value = mystrtok(listbuf = list_to_str(value+1), notokstr);
-            for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
-              {
-              if (i>=key[nkey].nlistmax)
-                error(EXIT_FAILURE, keyword, " has too many members");
-              dval = atof(value);
-              if (dval>=key[nkey].dmin && dval<=key[nkey].dmax)
-                ((double *)key[nkey].ptr)[i] = dval;
-              else
-                error(EXIT_FAILURE, keyword, " keyword out of range");
-              value = mystrtok((char *)NULL, notokstr);
-              }
-            if (i<key[nkey].nlistmin)
-              error(EXIT_FAILURE, keyword, " list has not enough members");
-            *(key[nkey].nlistptr) = i;
-            break;
-
-          case P_KEYLIST:
-            if (value && *value=='@')
-              value = mystrtok(listbuf = list_to_str(value+1), notokstr);
-            for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
-              {
-              if (i>=key[nkey].nlistmax)
-                error(EXIT_FAILURE, keyword, " has too many members");
-	      if ((ival = findkeys(value, key[nkey].keylist, FIND_STRICT))
-			!= RETURN_ERROR)
-                ((int *)(key[nkey].ptr))[i] = ival;
-              else
-                error(EXIT_FAILURE, keyword, " set to an unknown keyword");
-              value = mystrtok((char *)NULL, notokstr);
-              }
-            if (i<key[nkey].nlistmin)
-              error(EXIT_FAILURE, keyword, " list has not enough members");
-            *(key[nkey].nlistptr) = i;
-            break;
-
-          case P_STRINGLIST:
-            if (value && *value=='@')
-              value = mystrtok(listbuf = list_to_str(value+1), notokstr);
-            if (!value || value[0]==(char)'#')
-              {
-              value = "";
-              flagz = 1;
-              }
-            else
-              flagz = 0;
-            for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
-              {
-              if (i>=key[nkey].nlistmax)
-                error(EXIT_FAILURE, keyword, " has too many members");
-              free(((char **)key[nkey].ptr)[i]);
-              QMALLOC(((char **)key[nkey].ptr)[i], char, MAXCHAR);
-              strcpy(((char **)key[nkey].ptr)[i], value);
-              value = mystrtok((char *)NULL, notokstr);
-              if (flagz)
-                break;
-              }
-            if (i<key[nkey].nlistmin)
-              error(EXIT_FAILURE, keyword, " list has not enough members");
-            *(key[nkey].nlistptr) = flagz?0:i;
-            break;
-
-          default:
-            error(EXIT_FAILURE, "*Internal ERROR*: Type Unknown",
+            value = mystrtok((char *)NULL, notokstr);
+            }
+          if (i<key[nkey].nlistmin)
+            error(EXIT_FAILURE, keyword, " list has not enough members");
+          *nlistptr = i;
+          break;
+
+        case P_STRINGLIST:
+          if (value && *value=='@')
+            value = mystrtok(listbuf = list_to_str(value+1), notokstr);
+          if (!value || value[0]==(char)'#')
+            {
+            value = "";
+            flagz = 1;
+            }
+          else
+            flagz = 0;
+          for (i=0; i<MAXLIST && value && value[0]!=(char)'#'; i++)
+            {
+            if (i>=key[nkey].nlistmax)
+              error(EXIT_FAILURE, keyword, " has too many members");
+            free(((char **)keyptr)[i]);
+            QMALLOC(((char **)keyptr)[i], char, MAXCHAR);
+            strcpy(((char **)keyptr)[i], value);
+            value = mystrtok((char *)NULL, notokstr);
+            if (flagz)
+              break;
+            }
+          if (i<key[nkey].nlistmin)
+            error(EXIT_FAILURE, keyword, " list has not enough members");
+          *nlistptr = flagz?0:i;
+          break;
+
+        default:
+          error(EXIT_FAILURE, "*Internal ERROR*: Type Unknown",
 				" in readprefs()");
-            break;
-          }
-        if (listbuf)
-          {
-          free(listbuf);
-          listbuf = NULL;
-          }
-        key[nkey].flag = 1;
+          break;
         }
-      else
+      if (listbuf)
         {
-        warning(keyword, " keyword unknown");
-        warn++;
+        free(listbuf);
+        listbuf = NULL;
         }
       }
+    else
+      {
+      warning(keyword, " keyword unknown");
+      (*warn)++;
+      }
     }
 
-  for (i=0; key[i].name[0]; i++)
-    if (!key[i].flag)
-      error(EXIT_FAILURE, key[i].name, " configuration keyword missing");
-  if (!flage)
-    fclose(infile);
+  return nkey;
+  }
+
+
+/******************************** overprefs **********************************/
+/*
+Override preference parameters with a list of keyword/value pairs, on top of
+the current settings.
+*/
+void	overprefs(char **argkey, char **argval, int narg)
+
+  {
+   char		str[MAXCHARL];
+   int		a, warn;
+
+  warn = 0;
+  for (a=0; a<narg; a++)
+    {
+    sprintf(str, "%s %s", argkey[a], argval[a]);
+    setprefline(str, "argument list", &warn);
+    }
 
   return;
   }
 
 
+/******************************** checkprefs *********************************/
+/*
+Check a list of keyword/value pairs before handing them to overprefs(), so
+that processes which must survive invalid requests can reject them instead of
+exiting. Returns RETURN_OK or RETURN_ERROR with a message in errstr.
+*/
+int	checkprefs(char **argkey, char **argval, int narg, char *errstr)
+
+  {
+   char		str[MAXCHARL],
+		*value;
+   double	dval;
+   int		a, i, ival, nkey;
+
+  for (a=0; a<narg; a++)
+    {
+    if ((nkey = findkeys(argkey[a], keylist, FIND_STRICT)) == RETURN_ERROR)
+      {
+      sprintf(errstr, "%.80s keyword unknown", argkey[a]);
+      return RETURN_ERROR;
+      }
+    strncpy(str, argval[a], MAXCHARL-1);
+    str[MAXCHARL-1] = '\0';
+    value = mystrtok(str, notokstr);
+    if (!value || value[0]==(char)'#')
+      {
+      if (key[nkey].type == P_STRINGLIST)
+        continue;
+      sprintf(errstr, "%.80s keyword has no value", argkey[a]);
+      return RETURN_ERROR;
+      }
+/*-- Indirections are left to overprefs() */
+    if (*value=='@' || strchr(value, '$'))
+      continue;
+    for (i=0; value && value[0]!=(char)'#'; i++)
+      {
+      switch(key[nkey].type)
+        {
+        case P_FLOAT:
+        case P_FLOATLIST:
+          dval = atof(value);
+          if (dval<key[nkey].dmin || dval>key[nkey].dmax)
+            {
+            sprintf(errstr, "%.80s keyword out of range", argkey[a]);
+            return RETURN_ERROR;
+            }
+          break;
+        case P_INT:
+        case P_INTLIST:
+          if (getprefint(nkey, value, &ival) != RETURN_OK)
+            {
+            sprintf(errstr, "%.80s keyword has an invalid value", argkey[a]);
+            return RETURN_ERROR;
+            }
+          if (ival<key[nkey].imin || ival>key[nkey].imax)
+            {
+            sprintf(errstr, "%.80s keyword out of range", argkey[a]);
+            return RETURN_ERROR;
+            }
+          break;
+        case P_BOOL:
+        case P_BOOLLIST:
+          if (!strchr("yYnN", (int)value[0]))
+            {
+            sprintf(errstr, "%.80s value must be Y or N", argkey[a]);
+            return RETURN_ERROR;
+            }
+          break;
+        case P_KEY:
+        case P_KEYLIST:
+          if (findkeys(value, key[nkey].keylist, FIND_STRICT)==RETURN_ERROR)
+            {
+            sprintf(errstr, "%.80s set to an unknown keyword", argkey[a]);
+            return RETURN_ERROR;
+            }
+          break;
+        default:
+          break;
+        }
+      if (key[nkey].type != P_BOOLLIST && key[nkey].type != P_INTLIST
+	&& key[nkey].type != P_FLOATLIST && key[nkey].type != P_KEYLIST
+	&& key[nkey].type != P_STRINGLIST)
+        break;
+      if (i>=key[nkey].nlistmax)
+        {
+        sprintf(errstr, "%.80s has too many members", argkey[a]);
+        return RETURN_ERROR;
+        }
+      value = mystrtok((char *)NULL, notokstr);
+      }
+    if (i<key[nkey].nlistmin || (key[nkey].ptr==prefs_key.region && i%4))
+      {
+      sprintf(errstr, "%.80s list has not enough members", argkey[a]);
+      return RETURN_ERROR;
+      }
+    }
+
+  return RETURN_OK;
+  }
+
+
+/****** getprefint ***********************************************************
+PROTO	int getprefint(int nkey, char *value, int *ival)
+PURPOSE	Convert the value of an integer keyword.
+INPUT	Keyword index,
+	value string,
+	pointer to the integer value (output).
+OUTPUT	RETURN_OK if the value is valid, RETURN_ERROR otherwise.
+NOTES	The whole string must be an integer. MEM_MAX and VMEM_MAX also accept
+	AUTO, which stands for 0 (automatic sizing).
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	getprefint(int nkey, char *value, int *ival)
+  {
+   char	*end;
+   long	lval;
+
+  if ((key[nkey].ptr==&prefs_key.mem_max || key[nkey].ptr==&prefs_key.vmem_max)
+	&& !cistrcmp(value, "AUTO", FIND_STRICT))
+    {
+    *ival = 0;
+    return RETURN_OK;
+    }
+  lval = strtol(value, &end, 0);
+  if (end==value || *end)
+    return RETURN_ERROR;
+  *ival = lval<INT_MIN? INT_MIN : (lval>INT_MAX? INT_MAX : (int)lval);
+
+  return RETURN_OK;
+  }
+
+
 /********************************* findkeys **********************************/
 /*
 find an item within a list of keywords.
@@ -465,8 +717,8 @@ Home-brewed strtok() function which handles double quotes in a special way.
 char	*mystrtok(char *str, const char *delim)
 
   {
-   static char	*sptr;
-   char		*ptr;
+   static THREAD_LOCAL char	*sptr;
+   char				*ptr;
 
   ptr = str? str: sptr;
   ptr = ptr+strspn(ptr, delim);
@@ -559,6 +811,24 @@ void	preprefs()
   }
 
 
+/********************************* memprefs *********************************/
+/*
+Set the memory limits left to automatic (0).
+*/
+void	memprefs(void)
+
+  {
+  strcpy(prefs.mem_source, "config");
+  if (!prefs.mem_max)
+    prefs.mem_max = auto_maxdataram(prefs.mem_source);
+  strcpy(prefs.vmem_source, "config");
+  if (!prefs.vmem_max)
+    prefs.vmem_max = auto_maxdatavram(prefs.swapdir_name, prefs.vmem_source);
+
+  return;
+  }
+
+
 /********************************* useprefs *********************************/
 /*
 Update various structures according to the prefs.
@@ -585,6 +855,30 @@ void	useprefs(void)
 	&& (!cistrcmp(str, ".ptif", FIND_STRICT)
 	|| !cistrcmp(str, ".ptiff", FIND_STRICT)))
       prefs.format_type2 = FORMAT_TIFF_PYRAMID;
+    else if (str && !cistrcmp(str, ".dzi", FIND_STRICT))
+      prefs.format_type2 = FORMAT_DEEPZOOM;
+    else if (str && !cistrcmp(str, ".zarr", FIND_STRICT))
+      prefs.format_type2 = FORMAT_ZARR;
+    else if (str && (!cistrcmp(str, ".jpg", FIND_STRICT)
+	|| !cistrcmp(str, ".jpeg", FIND_STRICT)))
+      prefs.format_type2 = FORMAT_JPEG;
+    else if (str && !cistrcmp(str, ".png", FIND_STRICT))
+      prefs.format_type2 = FORMAT_PNG;
+    }
+  if (prefs.nregion%4)
+    error(EXIT_FAILURE, "*Error*: REGION corners must be given as ",
+	"groups of 4 coordinates");
+  if (prefs.mosaic_type != MOSAIC_NONE && prefs.region_type != REGION_NONE)
+    error(EXIT_FAILURE, "*Error*: REGION is not supported ",
+	"with MOSAIC_TYPE");
+  if (prefs.pyrupdate_flag)
+    {
+    if (prefs.format_type2 != FORMAT_TIFF_PYRAMID)
+      error(EXIT_FAILURE, "*Error*: PYRAMID_UPDATE requires ",
+	"IMAGE_TYPE TIFF-PYRAMID");
+    if (prefs.region_type == REGION_NONE || prefs.nregion != 4)
+      error(EXIT_FAILURE, "*Error*: PYRAMID_UPDATE requires ",
+	"a single REGION");
     }
   for (i=prefs.nbin_size; i<2; i++)
     prefs.bin_size[i] = prefs.bin_size[prefs.nbin_size-1];
@@ -616,5 +910,18 @@ void	useprefs(void)
 	= prefs.badpixel_replacement[prefs.nbadpixel_replacement-1];
   prefs.nbadpixel_replacement = nmax;
 
+/* Memory limits (0 = automatic) */
+  memprefs();
+
+/* First-touch placement is only meaningful with threads that do not move */
+  if (prefs.numa_type == NUMA_FIRSTTOUCH)
+    prefs.pinning_flag = 1;
+  set_datapages(prefs.hugepage_type == HUGEPAGE_EXPLICIT? DATA_PAGE_EXPLICIT
+		: (prefs.hugepage_type == HUGEPAGE_TRANSPARENT?
+			DATA_PAGE_TRANSPARENT : DATA_PAGE_NORMAL),
+		prefs.numa_type == NUMA_INTERLEAVE? DATA_NUMA_INTERLEAVE
+		: (prefs.numa_type == NUMA_FIRSTTOUCH?
+			DATA_NUMA_FIRSTTOUCH : DATA_NUMA_DEFAULT));
+
   return;
   }
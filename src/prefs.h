@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -54,10 +54,16 @@ typedef struct
   int		tile_size;		/* Dimension of TIFF tiles */
   int		min_size[2];		/* Minimum size of pyramid plane */
   int		nmin_size;		/* Number of parameters */
+  int		pyrupdate_flag;		/* Update REGION of existing pyramid? */
+  enum {PYRSTORAGE_FLOAT32, PYRSTORAGE_FLOAT16, PYRSTORAGE_UINT16}
+		pyrstorage_type;	/* Storage of pyramid levels */
   char		tiff_name[MAXCHAR];	/* Output filename */
-  enum {FORMAT_AUTO, FORMAT_TIFF, FORMAT_TIFF_PYRAMID}
+  enum {FORMAT_AUTO, FORMAT_TIFF, FORMAT_TIFF_PYRAMID, FORMAT_DEEPZOOM,
+	FORMAT_XYZ, FORMAT_ZARR, FORMAT_JPEG, FORMAT_PNG,
+	FORMAT_RASTER}
 		format_type,
 		format_type2;		/* Output image format */
+  int		tilefile_type;		/* Tile file format in tile trees */
   int		bigtiff_type;		/* BigTIFF support option */
   int		bpp;			/* Number of bits per pixels */
   int		compress_type;		/* TIFF compression algorithm */
@@ -67,6 +73,16 @@ typedef struct
 */
   enum {FLIP_NONE, FLIP_X, FLIP_Y, FLIP_XY}
 		flip_type;		/* Image flip type */
+  enum {REGION_NONE, REGION_PIXEL, REGION_WORLD}
+		region_type;		/* Cutout region coordinates */
+  double	region[MAXLIST];	/* Cutout region corners */
+  int		nregion;		/* Number of parameters */
+  enum {REGIONSTATS_REGION, REGIONSTATS_FULL}
+		regionstats_type;	/* Pixels used for image statistics */
+  enum {MOSAIC_NONE, MOSAIC_OFFSET, MOSAIC_WCS}
+		mosaic_type;		/* Input mosaic alignment */
+  char		*(mosaic_key[2]);	/* Mosaic offset FITS keywords */
+  int		nmosaic_key;		/* Number of parameters */
   double	gamma;     		/* Video gamma */
   double	gamma_fac;     		/* Luminance gamma correction factor */
   enum {GAMMA_POWERLAW, GAMMA_SRGB, GAMMA_REC709}
@@ -104,35 +120,85 @@ typedef struct
   int		mem_max;		/* Max amount of allocatable RAM */ 
   int		vmem_max;		/* Max amount of allocatable VMEM */ 
   char          swapdir_name[MAXCHAR];  /* Name of virtual mem directory */
+  enum {VMEM_FILE, VMEM_COMPRESSED}
+		vmem_type;		/* Storage beyond MEM_MAX */
+  char		mem_source[MAXCHAR];	/* Origin of the RAM limit */
+  char		vmem_source[MAXCHAR];	/* Origin of the VMEM limit */
+  enum {HUGEPAGE_NONE, HUGEPAGE_TRANSPARENT, HUGEPAGE_EXPLICIT}
+		hugepage_type;		/* Huge pages for pixel buffers */
+  enum {NUMA_DEFAULT, NUMA_INTERLEAVE, NUMA_FIRSTTOUCH}
+		numa_type;		/* NUMA placement of pixel buffers */
+  struct structdataarena *arena;	/* Allocator of image data (or NULL) */
+  size_t	mem_peak;		/* Peak RAM use of the job (bytes) */
+  size_t	vmem_peak;		/* Peak VMEM use of the job (bytes) */
 /* Multithreading */
   int		nthreads;		/* Number of active threads */
+  int		pinning_flag;		/* Pin conversion threads to cores? */
+  int		batch_njobs;		/* Number of batch jobs in flight */
 /* Misc */
   enum {QUIET, NORM, WARN, FULL}	verbose_type;	/* display type */
   double	nlines;			/* Image height in pixels */
   double	npix;			/* Number of image pixels */
   int		fitsunsigned_flag;	/* Force unsign FITS */
+  int		checksum_flag;		/* Verify input FITS checksums? */
 /* XML */
   int 		xml_flag;		/* Write XML file? */
   char		xml_name[MAXCHAR];	/* XML file name */
   char		xsl_name[MAXCHAR];	/* XSL file name (or URL) */
+/* Trace */
+  int		trace_flag;		/* Write trace file? */
+  char		trace_name[MAXCHAR];	/* Trace file name */
+/* Progress */
+  int		progress_flag;		/* Maintain progress status file? */
+  char		progress_name[MAXCHAR];	/* Progress status file name */
+  double	progress_interval;	/* Min. time between updates (s) */
+/* Timing probes */
+  char		probe_name[MAXCHAR];	/* Probe histogram file name */
+/* Dry run */
+  enum {PLAN_NONE, PLAN_JSON, PLAN_XML}
+		plan_type;		/* Plan output type */
+  char		plan_name[MAXCHAR];	/* Plan file name */
+  char		planbench_name[MAXCHAR];/* Benchmark output for time estimates */
+/* In-memory input and output (library only) */
+  void		**file_buf;		/* In-memory input images (or NULL) */
+  size_t	*file_bufsize;		/* Sizes of in-memory input images */
+  unsigned char	*raster_pix;		/* Output raster */
+  int		raster_width;		/* Raster width in pixels */
+  int		raster_height;		/* Raster height in pixels */
+  int		raster_nchan;		/* Number of raster channels */
+  int		raster_bpp;		/* Number of bits per raster channel */
 /* Date and Time */
   char		sdate_start[12];	/* STIFF start date */
   char		stime_start[12];	/* STIFF start time */
   char		sdate_end[12];		/* STIFF end date */
   char		stime_end[12];		/* STIFF end time */
+  double	time_start;		/* Execution start (s) */
   double	time_diff;		/* Execution time */
+  char		error_msg[MAXCHAR];	/* Error message of a failed job */
   }	prefstruct;
 
-prefstruct	prefs;
+/* Each thread works on the preferences of its own job */
+extern THREAD_LOCAL prefstruct	*prefs_thread;
+extern prefstruct		prefs_key;
+
+#define	prefs	(*prefs_thread)
 
 /*-------------------------------- protos -----------------------------------*/
 extern char	*list_to_str(char *listname);
 
-extern int	cistrcmp(char *cs, char *ct, int mode);
+extern int	checkprefs(char **argkey, char **argval, int narg,
+			char *errstr),
+		cistrcmp(char *cs, char *ct, int mode);
 
 extern char	*mystrtok(char *str, const char *delim);
 
+extern prefstruct	*bindprefs(prefstruct *newprefs);
+
+extern void	*prefs_ptr(void *keyptr);
+
 extern void	dumpprefs(int state),
+		memprefs(void),
+		overprefs(char **argkey, char **argval, int narg),
 		preprefs(void),
 		readprefs(char *filename,char **argkey,char **argval,int narg),
 		useprefs(void);
@@ -0,0 +1,397 @@
+/*
+*				progress.c
+*
+* Machine-readable progress status of long conversions.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "datamem.h"
+#include "progress.h"
+
+#ifdef USE_THREADS
+#include "threads.h"
+static pthread_mutex_t	progress_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static char	progress_name[MAXCHAR], progress_tmpname[MAXCHAR+8],
+		progress_job[MAXCHAR], progress_stage[PROGRESS_NAMELEN];
+static double	progress_interval, progress_t0, progress_tlast,
+		progress_work, progress_worklast,
+		progress_stagedone, progress_stagetotal,
+		progress_outdone, progress_outtotal;
+static dataarenastruct	*progress_arena;
+static size_t	progress_spillpeak;
+static long	progress_seq;
+static int	progress_flag, progress_level;
+
+static void	get_progressrss(double *rss, double *rsspeak),
+		update_progress(int forceflag),
+		write_progress(char *state, double t),
+		write_progressstring(FILE *file, char *str);
+
+/****** init_progress *********************************************************
+PROTO	void init_progress(char *filename, double interval, char *jobname,
+			dataarenastruct *arena)
+PURPOSE	Start maintaining the progress status of a conversion.
+INPUT	Status file name ("STDOUT" for a stream on the standard output),
+	minimum time between updates (in s),
+	job name (output file name),
+	pointer to the allocator of the image data of the job.
+OUTPUT	-.
+NOTES	The status file is rewritten (atomically) at most every interval
+	seconds. Progress functions do nothing until init_progress() has been
+	called.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	init_progress(char *filename, double interval, char *jobname,
+		dataarenastruct *arena)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&progress_mutex);
+#endif
+  strncpy(progress_name, filename, MAXCHAR-1);
+  progress_name[MAXCHAR-1] = '\0';
+  sprintf(progress_tmpname, "%s.tmp", progress_name);
+  strncpy(progress_job, jobname, MAXCHAR-1);
+  progress_job[MAXCHAR-1] = '\0';
+  strcpy(progress_stage, "loading");
+  progress_interval = interval;
+  progress_arena = arena;
+  progress_t0 = progress_tlast = counter_seconds();
+  progress_work = progress_worklast = progress_stagedone = progress_stagetotal
+	= progress_outdone = progress_outtotal = 0.0;
+  progress_spillpeak = 0;
+  progress_seq = 0;
+  progress_level = -1;
+  progress_flag = 1;
+  update_progress(1);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&progress_mutex);
+#endif
+
+  return;
+  }
+
+
+/****** end_progress **********************************************************
+PROTO	void end_progress(void)
+PURPOSE	Write the final progress status of a conversion.
+INPUT	-.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_progress(void)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&progress_mutex);
+#endif
+  if (progress_flag)
+    {
+    strcpy(progress_stage, "done");
+    progress_level = -1;
+    write_progress("done", counter_seconds());
+    progress_flag = 0;
+    progress_arena = NULL;
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&progress_mutex);
+#endif
+
+  return;
+  }
+
+
+/****** set_progressstage *****************************************************
+PROTO	void set_progressstage(char *stage, int level, double npix)
+PURPOSE	Enter a new processing stage.
+INPUT	Stage name,
+	pyramid level (-1 if irrelevant),
+	number of pixels to be processed in the stage.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_progressstage(char *stage, int level, double npix)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&progress_mutex);
+#endif
+  if (progress_flag)
+    {
+    strncpy(progress_stage, stage, PROGRESS_NAMELEN-1);
+    progress_stage[PROGRESS_NAMELEN-1] = '\0';
+    progress_level = level;
+    progress_stagedone = 0.0;
+    progress_stagetotal = npix;
+    update_progress(0);
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&progress_mutex);
+#endif
+
+  return;
+  }
+
+
+/****** set_progresstotal *****************************************************
+PROTO	void set_progresstotal(double nout)
+PURPOSE	Set the total number of output pixels of the conversion.
+INPUT	Number of output pixels.
+OUTPUT	-.
+NOTES	Used for computing the completion ratio and the ETA.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_progresstotal(double nout)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&progress_mutex);
+#endif
+  progress_outtotal = nout;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&progress_mutex);
+#endif
+
+  return;
+  }
+
+
+/****** add_progress **********************************************************
+PROTO	void add_progress(double npix, double nout)
+PURPOSE	Account for pixels processed in the current stage.
+INPUT	Number of pixels processed in the current stage,
+	number of output pixels completed.
+OUTPUT	-.
+NOTES	Thread-safe. The status is written only if enough time has elapsed
+	since the previous update.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	add_progress(double npix, double nout)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&progress_mutex);
+#endif
+  if (progress_flag)
+    {
+    progress_stagedone += npix;
+    progress_work += npix;
+    progress_outdone += nout;
+    update_progress(0);
+    }
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&progress_mutex);
+#endif
+
+  return;
+  }
+
+
+/****** update_progress *******************************************************
+PROTO	void update_progress(int forceflag)
+PURPOSE	Write the progress status if the update interval has elapsed.
+INPUT	Force writing (0=no, 1=yes).
+OUTPUT	-.
+NOTES	Must be called with the progress mutex locked.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	update_progress(int forceflag)
+  {
+   size_t	ram, spill;
+   double	t;
+
+/* Spill peaks are tracked at every call, not only at updates */
+  get_datause(progress_arena, &ram, &spill);
+  if (spill > progress_spillpeak)
+    progress_spillpeak = spill;
+  t = counter_seconds();
+  if (forceflag || t - progress_tlast >= progress_interval)
+    write_progress("running", t);
+
+  return;
+  }
+
+
+/****** write_progress ********************************************************
+PROTO	void write_progress(char *state, double t)
+PURPOSE	Write the progress status as a single line of JSON.
+INPUT	Job state ("running" or "done"),
+	current time (as returned by counter_seconds()).
+OUTPUT	-.
+NOTES	The file is written under a temporary name and renamed, so that
+	readers never see a partial status. Pixel rates are in Mpixel/s, times
+	in s and memory sizes in bytes. The instantaneous rate covers all
+	pixels processed since the previous update, while the mean rate and the
+	ETA are computed from the output pixels only. Progress reports are
+	disabled after the first write error.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	write_progress(char *state, double t)
+  {
+   FILE		*file;
+   size_t	ram, spill;
+   double	elapsed, dt, rss, rsspeak;
+   int		stdoutflag;
+
+  if ((stdoutflag = !strcmp(progress_name, "STDOUT")))
+    file = stdout;
+  else if (!(file = fopen(progress_tmpname, "w")))
+    {
+    warning("cannot write progress status to ", progress_tmpname);
+    progress_flag = 0;
+    return;
+    }
+
+  get_datause(progress_arena, &ram, &spill);
+  get_progressrss(&rss, &rsspeak);
+  elapsed = t - progress_t0;
+  dt = t - progress_tlast;
+
+  fprintf(file, "{\"pid\": %ld, \"job\": ", (long)getpid());
+  write_progressstring(file, progress_job);
+  fprintf(file, ", \"state\": \"%s\", \"stage\": ", state);
+  write_progressstring(file, progress_stage);
+  if (progress_level < 0)
+    fprintf(file, ", \"level\": null");
+  else
+    fprintf(file, ", \"level\": %d", progress_level);
+  fprintf(file, ", \"stage_done\": %.0f, \"stage_total\": %.0f,"
+	" \"pixels_done\": %.0f, \"pixels_total\": %.0f,"
+	" \"elapsed\": %.3f, \"mpix_s\": %.3f, \"mpix_s_mean\": %.3f",
+	progress_stagedone, progress_stagetotal,
+	progress_outdone, progress_outtotal,
+	elapsed,
+	dt>0.0? (progress_work - progress_worklast)/dt/1.0e6 : 0.0,
+	elapsed>0.0? progress_outdone/elapsed/1.0e6 : 0.0);
+  if (!strcmp(state, "done"))
+    fprintf(file, ", \"eta\": 0.000");
+  else if (progress_outdone>0.0 && progress_outtotal>=progress_outdone)
+    fprintf(file, ", \"eta\": %.3f",
+	(progress_outtotal-progress_outdone)*elapsed/progress_outdone);
+  else
+    fprintf(file, ", \"eta\": null");
+  fprintf(file, ", \"rss_bytes\": %.0f, \"rss_peak_bytes\": %.0f,"
+	" \"ram_bytes\": %.0f, \"spill_bytes\": %.0f,"
+	" \"spill_peak_bytes\": %.0f, \"sequence\": %ld, \"updated\": %ld}\n",
+	rss, rsspeak, (double)ram, (double)spill, (double)progress_spillpeak,
+	progress_seq, (long)time(NULL));
+
+  if (stdoutflag)
+    fflush(file);
+  else if (fclose(file) || rename(progress_tmpname, progress_name))
+    {
+    warning("cannot write progress status to ", progress_name);
+    progress_flag = 0;
+    }
+
+  progress_tlast = t;
+  progress_worklast = progress_work;
+  progress_seq++;
+
+  return;
+  }
+
+
+/****** get_progressrss *******************************************************
+PROTO	void get_progressrss(double *rss, double *rsspeak)
+PURPOSE	Return the current and peak resident set sizes of the process.
+INPUT	Pointer to the current resident set size (in bytes),
+	pointer to the peak resident set size (in bytes).
+OUTPUT	-.
+NOTES	The current RSS is read from /proc and is 0 where not available.
+	getrusage() returns the peak in kbytes on Linux, and in bytes on
+	macOS.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	get_progressrss(double *rss, double *rsspeak)
+  {
+   FILE			*file;
+   struct rusage	usage;
+   long			npage;
+
+  *rss = *rsspeak = 0.0;
+  if ((file = fopen("/proc/self/statm", "r")))
+    {
+    if (fscanf(file, "%*s %ld", &npage) == 1)
+      *rss = (double)npage*(double)sysconf(_SC_PAGESIZE);
+    fclose(file);
+    }
+
+  if (!getrusage(RUSAGE_SELF, &usage))
+#ifdef __APPLE__
+    *rsspeak = (double)usage.ru_maxrss;
+#else
+    *rsspeak = (double)usage.ru_maxrss*1024.0;
+#endif
+
+  return;
+  }
+
+
+/****** write_progressstring **************************************************
+PROTO	void write_progressstring(FILE *file, char *str)
+PURPOSE	Write a string as a quoted JSON string.
+INPUT	File pointer,
+	string.
+OUTPUT	-.
+NOTES	Quotes, backslashes and control characters are escaped.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	write_progressstring(FILE *file, char *str)
+  {
+  putc('"', file);
+  for (; *str; str++)
+    if (*str == '"' || *str == '\\')
+      fprintf(file, "\\%c", *str);
+    else if ((unsigned char)*str < 0x20)
+      fprintf(file, "\\u%04x", (unsigned char)*str);
+    else
+      putc(*str, file);
+  putc('"', file);
+
+  return;
+  }
+
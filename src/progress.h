@@ -0,0 +1,48 @@
+/*
+*				progress.h
+*
+* Include file for progress.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _PROGRESS_H_
+#define _PROGRESS_H_
+
+#ifndef _DATAMEM_H_
+#include "datamem.h"
+#endif
+
+/*----------------------------- Internal constants --------------------------*/
+#define	PROGRESS_NAMELEN	32	/* Max. length of stage names */
+
+/*------------------------------- functions ---------------------------------*/
+
+extern void	add_progress(double npix, double nout),
+		end_progress(void),
+		init_progress(char *filename, double interval, char *jobname,
+			dataarenastruct *arena),
+		set_progressstage(char *stage, int level, double npix),
+		set_progresstotal(double nout);
+
+#endif
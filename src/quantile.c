@@ -0,0 +1,910 @@
+/*
+*				quantile.c
+*
+* Selection of medians and quantiles in large arrays.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(__INTEL_COMPILER) \
+	&& (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define		SIMD_X86
+#endif
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "prefs.h"
+#include "quantile.h"
+
+#ifdef USE_THREADS
+#include "threads.h"
+
+typedef struct
+  {
+  struct structquantile	*quant;		/* Shared context */
+  int			index;		/* Thread index */
+  }	quantilethreadstruct;
+
+typedef struct structquantile
+  {
+  float			*arr, *buf;	/* Data and scatter buffer */
+  long			n;		/* Number of elements */
+  long			nbuf;		/* Size of the scatter buffer */
+  long			*count;		/* Class counts (3 per thread) */
+  float			sample[QUANTILE_NPARSAMP];	/* Pivot sample */
+  float			lo, hi;		/* Class boundaries */
+  int			nthreads;	/* Number of threads */
+  int			endflag;	/* Set to terminate the threads */
+  pthread_t		*thread;	/* Pool threads */
+  quantilethreadstruct	*qthread;	/* Thread arguments */
+  threads_gate_t	*gate,		/* Gate between the passes */
+			*startgate,	/* Gate before each partition */
+			*stopgate;	/* Gate after each partition */
+  }	quantilestruct;
+
+static quantilestruct	quantile_pool;
+static pthread_mutex_t	quantile_poolmutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void	*pthread_partition(void *arg),
+		end_partitionthreads(void),
+		init_partitionthreads(int nthreads);
+static long	partition_threads(float *arr, long n, long k, int nthreads,
+			long *nsub);
+#endif
+
+static float	max_float(float *arr, long n),
+		select_scalar(float *arr, long n, long k),
+		select_vector(float *arr, long n, long k);
+static long	partition_float(float *arr, long n, float pivot, int eqflag),
+		partition_scalar(float *arr, long n, float pivot, int eqflag);
+
+#ifdef SIMD_X86
+static float	max_avx2(float *arr, long n);
+static long	partition_avx2(float *arr, long n, float pivot, int eqflag),
+		partition_avx512(float *arr, long n, float pivot, int eqflag);
+
+static int	partition_lut[256][8];	/* AVX2 lows-first permutations */
+static int	partition_lutflag;
+#endif
+
+/****** select_median *********************************************************
+PROTO	float select_median(float *arr, long n, int nthreads)
+PURPOSE	Compute the median of an array. If n is even, the result is the
+	average of the 2 "central" values.
+INPUT	Input array ptr,
+	number of elements,
+	max. number of threads.
+OUTPUT	Value of the median.
+NOTES	Changes the order of the data (see select_rank()). Same results as
+	the former Numerical Recipes version of fast_median(). If n is odd,
+	the data are also left in the same order, as the upper quantiles in
+	make_imastats() are computed from the n/2 elements that follow
+	the median.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+float	select_median(float *arr, long n, int nthreads)
+  {
+   float	valmax, valmed;
+
+  if (!n)
+    return 0.0;
+  else if (n==1)
+    return *arr;
+  else if (n==2)
+    return 0.5*(*arr+*(arr+1));
+
+  if (n&1)
+/*-- Odd case: keep the former layout of the upper half */
+    return select_scalar(arr, n, n/2);
+
+  valmed = select_rank(arr, n, n/2, nthreads);
+
+/* Even case: the other central value is the largest of the lower half */
+  valmax = max_float(arr, n/2);
+  if (valmax < (float)-BIG)
+    valmax = -BIG;
+
+  return valmax<valmed? (valmed+valmax)/2.0 : valmed;
+  }
+
+
+/****** select_quantile *******************************************************
+PROTO	float select_quantile(float *arr, long n, float frac, int nthreads)
+PURPOSE	Compute a quantile of an array.
+INPUT	Input array ptr,
+	number of elements,
+	quantile fraction (>=0 & <=1),
+	max. number of threads.
+OUTPUT	Value of the quantile.
+NOTES	Changes the order of the data (see select_rank()). Same results as
+	the former Numerical Recipes version of fast_quantile().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+float	select_quantile(float *arr, long n, float frac, int nthreads)
+  {
+  if (frac>1.0)
+    frac = 1.0;
+  else if (frac<0.0)
+    frac = 0.0;
+  if (n<2)
+    return *arr;
+
+  return select_rank(arr, n, (long)(frac*(n-0.5001)), nthreads);
+  }
+
+
+/****** select_rank ***********************************************************
+PROTO	float select_rank(float *arr, long n, long k, int nthreads)
+PURPOSE	Find the element of rank k (starting from 0) of an array.
+INPUT	Input array ptr,
+	number of elements,
+	rank,
+	max. number of threads.
+OUTPUT	Value of the element of rank k.
+NOTES	On output, arr[k] is the element of rank k, with all smaller elements
+	before it and all larger ones after it. Large arrays are first split
+	in 3 classes by several threads around pivots drawn from a sample;
+	selection proceeds in the class containing k with vectorized
+	partitions. Concurrent calls are safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+float	select_rank(float *arr, long n, long k, int nthreads)
+  {
+#ifdef USE_THREADS
+   long		start, nsub;
+
+  if (nthreads>1 && n>=QUANTILE_NPARMIN)
+    {
+    start = partition_threads(arr, n, k, nthreads, &nsub);
+    return select_vector(arr+start, nsub, k-start);
+    }
+#endif
+
+  return select_vector(arr, n, k);
+  }
+
+
+/****** select_vector *********************************************************
+PROTO	float select_vector(float *arr, long n, long k)
+PURPOSE	Quickselect the element of rank k with vectorized partitions.
+INPUT	Input array ptr,
+	number of elements,
+	rank.
+OUTPUT	Value of the element of rank k.
+NOTES	Pivots are "ninthers"; after QUANTILE_NBADMAX lopsided partitions
+	the pivot is taken as the median of a larger sample instead, to keep
+	adversarial data from making the search quadratic. Elements equal to
+	the pivot are isolated in a second pass, which ends the search at
+	once in arrays with many duplicates.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static float	select_vector(float *arr, long n, long k)
+  {
+   float	sample[QUANTILE_NPIVSAMP],
+		a,b,c, m1,m2,m3, pivot;
+   long		i, step, nsample, nless, neq, nold;
+   int		nbad;
+
+#define	MED3(x,y,z)	((x)<(y)? ((y)<(z)? (y) : ((x)<(z)? (z) : (x))) \
+				: ((x)<(z)? (x) : ((y)<(z)? (z) : (y))))
+
+  nbad = 0;
+  while (n > QUANTILE_NSCALAR)
+    {
+    if (nbad < QUANTILE_NBADMAX)
+      {
+/*---- Median of the medians of 3 triplets */
+      step = n/8;
+      a = arr[0]; b = arr[step]; c = arr[2*step];
+      m1 = MED3(a,b,c);
+      a = arr[3*step]; b = arr[4*step]; c = arr[5*step];
+      m2 = MED3(a,b,c);
+      a = arr[6*step]; b = arr[7*step]; c = arr[n-1];
+      m3 = MED3(a,b,c);
+      pivot = MED3(m1,m2,m3);
+      }
+    else
+      {
+/*---- Median of a larger sample */
+      nsample = n<QUANTILE_NPIVSAMP? n : QUANTILE_NPIVSAMP;
+      step = n/nsample;
+      for (i=0; i<nsample; i++)
+        sample[i] = arr[i*step];
+      pivot = select_scalar(sample, nsample, nsample/2);
+      nbad = 0;
+      }
+/*-- A NaN pivot would not split anything */
+    if (pivot != pivot)
+      break;
+    nold = n;
+    nless = partition_float(arr, n, pivot, 0);
+    if (k < nless)
+      n = nless;
+    else
+      {
+      arr += nless;
+      n -= nless;
+      k -= nless;
+/*---- Elements equal to the pivot (there is at least one) */
+      neq = partition_float(arr, n, pivot, 1);
+      if (k < neq)
+        return pivot;
+      arr += neq;
+      n -= neq;
+      k -= neq;
+      }
+    if (n > nold - nold/8)
+      nbad++;
+    }
+
+#undef MED3
+
+  return select_scalar(arr, n, k);
+  }
+
+
+/****** select_scalar *********************************************************
+PROTO	float select_scalar(float *arr, long n, long k)
+PURPOSE	Find the element of rank k using the select() routine (Numerical
+	Recipes, 2nd ed. Section 8.5 and http://www.eso.org/~ndevilla/median/).
+INPUT	Input array ptr,
+	number of elements,
+	rank.
+OUTPUT	Value of the element of rank k.
+NOTES	n must be >0. Changes the order of the data (see select_rank()).
+AUTHOR	E. Bertin (IAP), optimized from N.Devillard's code
+VERSION	19/10/2026
+ ***/
+#define QUANTILE_SWAP(a,b) { float t=(a);(a)=(b);(b)=t; }
+
+static float	select_scalar(float *arr, long n, long k)
+  {
+   float	*alow, *ahigh, *arank, *amiddle, *all, *ahh;
+
+  alow = arr;
+  ahigh = arr + n - 1;
+  arank = arr + k;
+  while (ahigh > (all=alow + 1))
+    {
+/*-- Find median of low, middle and high items; swap into position low */
+    amiddle = alow + (ahigh-alow)/2;
+    if (*amiddle > *ahigh)
+      QUANTILE_SWAP(*amiddle, *ahigh);
+    if (*alow > *ahigh)
+      QUANTILE_SWAP(*alow, *ahigh);
+    if (*amiddle > *alow)
+      QUANTILE_SWAP(*amiddle, *alow);
+
+/*-- Swap low item (now in position middle) into position (low+1) */
+    QUANTILE_SWAP(*amiddle, *all);
+
+/*-- Nibble from each end towards middle, swapping items when stuck */
+    ahh = ahigh;
+    for (;;)
+      {
+      while (*alow > *(++all));
+      while (*(--ahh) > *alow);
+
+      if (ahh < all)
+        break;
+
+      QUANTILE_SWAP(*all, *ahh);
+      }
+
+/*-- Swap middle item (in position low) back into correct position */
+    QUANTILE_SWAP(*alow, *ahh) ;
+
+/*-- Re-set active partition */
+    if (ahh <= arank)
+      alow = all;
+    if (ahh >= arank)
+      ahigh = ahh - 1;
+    }
+
+/* One or two elements left */
+  if (ahigh == all && *alow > *ahigh)
+    QUANTILE_SWAP(*alow, *ahigh);
+
+  return *arank;
+  }
+
+
+/****** partition_float *******************************************************
+PROTO	long partition_float(float *arr, long n, float pivot, int eqflag)
+PURPOSE	Move the elements lower than (or equal to) a pivot to the beginning
+	of an array, and the others to the end.
+INPUT	Input array ptr,
+	number of elements,
+	pivot,
+	flag set to also move elements equal to the pivot to the beginning.
+OUTPUT	Number of elements moved to the beginning.
+NOTES	Uses the widest vector instruction set available.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static long	partition_float(float *arr, long n, float pivot, int eqflag)
+  {
+#ifdef SIMD_X86
+   int		level;
+
+  level = get_simdlevel();
+  if (level == SIMD_AVX512 && n >= 64)
+    return partition_avx512(arr, n, pivot, eqflag);
+  else if (level >= SIMD_AVX2 && n >= 32)
+    return partition_avx2(arr, n, pivot, eqflag);
+#endif
+
+  return partition_scalar(arr, n, pivot, eqflag);
+  }
+
+
+/****** partition_scalar ******************************************************
+PROTO	long partition_scalar(float *arr, long n, float pivot, int eqflag)
+PURPOSE	Scalar version of partition_float().
+INPUT	Input array ptr,
+	number of elements,
+	pivot,
+	flag set to also move elements equal to the pivot to the beginning.
+OUTPUT	Number of elements moved to the beginning.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static long	partition_scalar(float *arr, long n, float pivot, int eqflag)
+  {
+   float	val;
+   long		i, j;
+
+#define	QUANTILE_LOW(x)	(eqflag? (x)<=pivot : (x)<pivot)
+
+  i = 0;
+  j = n - 1;
+  for (;;)
+    {
+    while (i<=j && QUANTILE_LOW(arr[i]))
+      i++;
+    while (i<j && !QUANTILE_LOW(arr[j]))
+      j--;
+    if (i >= j)
+      break;
+    val = arr[i];
+    arr[i++] = arr[j];
+    arr[j--] = val;
+    }
+
+#undef QUANTILE_LOW
+
+  return i;
+  }
+
+
+/****** max_float *************************************************************
+PROTO	float max_float(float *arr, long n)
+PURPOSE	Find the largest element of an array.
+INPUT	Input array ptr,
+	number of elements (>0).
+OUTPUT	Largest value.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static float	max_float(float *arr, long n)
+  {
+   float	val, valmax;
+   long		i;
+
+#ifdef SIMD_X86
+  if (get_simdlevel() >= SIMD_AVX2 && n >= 32)
+    return max_avx2(arr, n);
+#endif
+
+  valmax = *arr;
+  for (i=1; i<n; i++)
+    if ((val=arr[i]) > valmax)
+      valmax = val;
+
+  return valmax;
+  }
+
+
+#ifdef USE_THREADS
+/****** partition_threads *****************************************************
+PROTO	long partition_threads(float *arr, long n, long k, int nthreads,
+			long *nsub)
+PURPOSE	Split an array in 3 contiguous classes (below, between and above a
+	pair of pivots bracketing rank k) using several threads.
+INPUT	Input array ptr,
+	number of elements,
+	rank,
+	number of threads,
+	pointer to the number of elements in the class containing rank k.
+OUTPUT	Index of the first element in the class containing rank k.
+NOTES	The pivots are drawn from a sorted subset of the data, a few sigmas
+	away from the rank in the sample, so that the class containing rank k
+	is small in general. Elements are scattered to a temporary buffer
+	and copied back. The threads and the buffer are kept from one call to
+	the next; if they are busy with another selection, the whole array is
+	returned as the class, and selection proceeds in the calling thread.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static long	partition_threads(float *arr, long n, long k, int nthreads,
+			long *nsub)
+  {
+   quantilestruct	*quant;
+   long			step, r, rlo, rhi, n0, n1;
+   int			t;
+
+  *nsub = n;
+  if (pthread_mutex_trylock(&quantile_poolmutex))
+    return 0;
+  error_holdtrap(1);
+  quant = &quantile_pool;
+  if (quant->nthreads != nthreads)
+    {
+    end_partitionthreads();
+    init_partitionthreads(nthreads);
+    }
+
+/* Pivots from a regular subsample */
+  step = n/QUANTILE_NPARSAMP;
+  for (r=0; r<QUANTILE_NPARSAMP; r++)
+    quant->sample[r] = arr[r*step];
+  r = (long)((double)k*QUANTILE_NPARSAMP/n);
+  if ((rlo = r - QUANTILE_PARMARGIN) < 0)
+    rlo = 0;
+  if ((rhi = r + QUANTILE_PARMARGIN) > QUANTILE_NPARSAMP-1)
+    rhi = QUANTILE_NPARSAMP-1;
+  quant->lo = select_vector(quant->sample, QUANTILE_NPARSAMP, rlo);
+  quant->hi = select_vector(quant->sample+rlo, QUANTILE_NPARSAMP-rlo,
+		rhi-rlo);
+  if (quant->lo != quant->lo || quant->hi != quant->hi)
+    {
+    QPTHREAD_MUTEX_UNLOCK(&quantile_poolmutex);
+    return 0;
+    }
+
+/* Count, scatter and copy back in parallel */
+  if (n > quant->nbuf)
+    {
+    free(quant->buf);
+    QMALLOC(quant->buf, float, n);
+    quant->nbuf = n;
+    }
+  quant->arr = arr;
+  quant->n = n;
+  threads_gate_sync(quant->startgate);
+/* ( Slave threads partition the array here ) */
+  threads_gate_sync(quant->stopgate);
+
+  n0 = n1 = 0;
+  for (t=0; t<nthreads; t++)
+    {
+    n0 += quant->count[3*t];
+    n1 += quant->count[3*t+1];
+    }
+  quant->arr = NULL;
+  QPTHREAD_MUTEX_UNLOCK(&quantile_poolmutex);
+
+  if (k < n0)
+    {
+    *nsub = n0;
+    return 0;
+    }
+  else if (k < n0+n1)
+    {
+    *nsub = n1;
+    return n0;
+    }
+
+  *nsub = n - n0 - n1;
+  return n0 + n1;
+  }
+
+
+/****** init_partitionthreads *************************************************
+PROTO	void init_partitionthreads(int nthreads)
+PURPOSE	Start the pool of threads used by partition_threads().
+INPUT	Number of threads.
+OUTPUT	-.
+NOTES	Must be called with quantile_poolmutex held.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	init_partitionthreads(int nthreads)
+  {
+   quantilestruct	*quant;
+   pthread_attr_t	pthread_attr;
+   int			t;
+
+  quant = &quantile_pool;
+  quant->nthreads = nthreads;
+  quant->endflag = 0;
+  QMALLOC(quant->count, long, 3*nthreads);
+  QMALLOC(quant->qthread, quantilethreadstruct, nthreads);
+  QMALLOC(quant->thread, pthread_t, nthreads);
+  quant->gate = threads_gate_init(nthreads, NULL);
+  quant->startgate = threads_gate_init(nthreads+1, NULL);
+  quant->stopgate = threads_gate_init(nthreads+1, NULL);
+  QPTHREAD_ATTR_INIT(&pthread_attr);
+  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
+  for (t=0; t<nthreads; t++)
+    {
+    quant->qthread[t].quant = quant;
+    quant->qthread[t].index = t;
+    QPTHREAD_CREATE(&quant->thread[t], &pthread_attr, &pthread_partition,
+	&quant->qthread[t]);
+    }
+  QPTHREAD_ATTR_DESTROY(&pthread_attr);
+
+  return;
+  }
+
+
+/****** end_partitionthreads **************************************************
+PROTO	void end_partitionthreads(void)
+PURPOSE	Terminate the pool of threads used by partition_threads().
+INPUT	-.
+OUTPUT	-.
+NOTES	Must be called with quantile_poolmutex held. The scatter buffer is
+	kept.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	end_partitionthreads(void)
+  {
+   quantilestruct	*quant;
+   int			t;
+
+  quant = &quantile_pool;
+  if (!quant->nthreads)
+    return;
+  quant->endflag = 1;
+  threads_gate_sync(quant->startgate);
+  for (t=0; t<quant->nthreads; t++)
+    QPTHREAD_JOIN(quant->thread[t], NULL);
+  threads_gate_end(quant->gate);
+  threads_gate_end(quant->startgate);
+  threads_gate_end(quant->stopgate);
+  free(quant->count);
+  free(quant->qthread);
+  free(quant->thread);
+  quant->nthreads = 0;
+
+  return;
+  }
+
+
+/****** pthread_partition *****************************************************
+PROTO	void *pthread_partition(void *arg)
+PURPOSE	Pool thread that classifies a segment of the array for
+	partition_threads().
+INPUT	Pointer to the thread structure.
+OUTPUT	NULL.
+NOTES	Class 0 (below the low pivot) also receives NaNs. The thread outlives
+	the job that started it, and therefore uses the default preferences.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	*pthread_partition(void *arg)
+  {
+   quantilethreadstruct	*qthread;
+   quantilestruct	*quant;
+   float		*arr, *buf,
+			val, lo, hi;
+   long			*count,
+			off[3], ntot[3], i, start, end;
+   int			c, t, t2;
+
+  bindprefs(NULL);
+  qthread = (quantilethreadstruct *)arg;
+  quant = qthread->quant;
+  t = qthread->index;
+  for (;;)
+    {
+    threads_gate_sync(quant->startgate);
+    if (quant->endflag)
+      break;
+    arr = quant->arr;
+    buf = quant->buf;
+    lo = quant->lo;
+    hi = quant->hi;
+    start = quant->n*t/quant->nthreads;
+    end = quant->n*(t+1)/quant->nthreads;
+
+/*-- Count the members of each class in the segment */
+    count = quant->count + 3*t;
+    count[0] = count[1] = count[2] = 0;
+    for (i=start; i<end; i++)
+      {
+      val = arr[i];
+      count[(val>=lo)+(val>hi)]++;
+      }
+    threads_gate_sync(quant->gate);
+
+/*-- Scatter the segment to its place in each class */
+    off[0] = off[1] = off[2] = ntot[0] = ntot[1] = ntot[2] = 0;
+    for (t2=0; t2<quant->nthreads; t2++)
+      for (c=0; c<3; c++)
+        {
+        if (t2 < t)
+          off[c] += quant->count[3*t2+c];
+        ntot[c] += quant->count[3*t2+c];
+        }
+    off[1] += ntot[0];
+    off[2] += ntot[0] + ntot[1];
+    for (i=start; i<end; i++)
+      {
+      val = arr[i];
+      buf[off[(val>=lo)+(val>hi)]++] = val;
+      }
+    threads_gate_sync(quant->gate);
+
+/*-- Copy back */
+    memcpy(arr+start, buf+start, (end-start)*sizeof(float));
+    threads_gate_sync(quant->stopgate);
+    }
+
+  return NULL;
+  }
+#endif
+
+
+/****** end_quantile **********************************************************
+PROTO	void end_quantile(void)
+PURPOSE	Terminate the selection threads and free the selection buffers.
+INPUT	-.
+OUTPUT	-.
+NOTES	Must not be called during a selection (once at exit for the stiff
+	executable).
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_quantile(void)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&quantile_poolmutex);
+  end_partitionthreads();
+  free(quantile_pool.buf);
+  quantile_pool.buf = NULL;
+  quantile_pool.nbuf = 0;
+  QPTHREAD_MUTEX_UNLOCK(&quantile_poolmutex);
+#endif
+
+  return;
+  }
+
+
+#ifdef SIMD_X86
+/****** partition_avx2 ********************************************************
+PROTO	long partition_avx2(float *arr, long n, float pivot, int eqflag)
+PURPOSE	AVX2 version of partition_float().
+INPUT	Input array ptr,
+	number of elements (>=32),
+	pivot,
+	flag set to also move elements equal to the pivot to the beginning.
+OUTPUT	Number of elements moved to the beginning.
+NOTES	In-place: the first and last vectors are put aside to open some room
+	at both ends, and vectors are then read from the end with less room
+	left. Each vector is permuted with its lower elements first and stored
+	at both ends.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("avx2")))
+static long	partition_avx2(float *arr, long n, float pivot, int eqflag)
+  {
+   __m256	vpivot, vfirst, vlast, v, m;
+   float	rest[32],
+		val;
+   long		readl, readr, writel, writer;
+   int		i, j, bits, nrest;
+
+/* Build the permutation table once (concurrent builds write the same) */
+  if (!__atomic_load_n(&partition_lutflag, __ATOMIC_ACQUIRE))
+    {
+    for (bits=0; bits<256; bits++)
+      {
+      for (i=j=0; i<8; i++)
+        if (bits & (1<<i))
+          partition_lut[bits][j++] = i;
+      for (i=0; i<8; i++)
+        if (!(bits & (1<<i)))
+          partition_lut[bits][j++] = i;
+      }
+    __atomic_store_n(&partition_lutflag, 1, __ATOMIC_RELEASE);
+    }
+
+  vpivot = _mm256_set1_ps(pivot);
+  vfirst = _mm256_loadu_ps(arr);
+  vlast = _mm256_loadu_ps(arr+n-8);
+  readl = 8;
+  writel = 0;
+  readr = n - 8;
+  writer = n;
+  while (readr - readl >= 8)
+    {
+    if (readl - writel <= writer - readr)
+      {
+      v = _mm256_loadu_ps(arr+readl);
+      readl += 8;
+      }
+    else
+      {
+      readr -= 8;
+      v = _mm256_loadu_ps(arr+readr);
+      }
+    m = eqflag? _mm256_cmp_ps(v, vpivot, _CMP_LE_OQ)
+		: _mm256_cmp_ps(v, vpivot, _CMP_LT_OQ);
+    bits = _mm256_movemask_ps(m);
+    v = _mm256_permutevar8x32_ps(v,
+		_mm256_loadu_si256((__m256i *)partition_lut[bits]));
+    _mm256_storeu_ps(arr+writel, v);
+    _mm256_storeu_ps(arr+writer-8, v);
+    i = __builtin_popcount(bits);
+    writel += i;
+    writer -= 8 - i;
+    }
+
+/* Leftovers and the 2 vectors put aside fill the remaining room */
+  nrest = readr - readl;
+  memcpy(rest, arr+readl, nrest*sizeof(float));
+  _mm256_storeu_ps(rest+nrest, vfirst);
+  _mm256_storeu_ps(rest+nrest+8, vlast);
+  nrest += 16;
+  for (i=0; i<nrest; i++)
+    {
+    val = rest[i];
+    if (eqflag? val<=pivot : val<pivot)
+      arr[writel++] = val;
+    else
+      arr[--writer] = val;
+    }
+
+  return writel;
+  }
+
+
+/****** partition_avx512 ******************************************************
+PROTO	long partition_avx512(float *arr, long n, float pivot, int eqflag)
+PURPOSE	AVX-512 version of partition_float().
+INPUT	Input array ptr,
+	number of elements (>=64),
+	pivot,
+	flag set to also move elements equal to the pivot to the beginning.
+OUTPUT	Number of elements moved to the beginning.
+NOTES	Same scheme as partition_avx2(), with compress/expand instructions
+	instead of a permutation table.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("avx512f")))
+static long	partition_avx512(float *arr, long n, float pivot, int eqflag)
+  {
+   __m512	vpivot, vfirst, vlast, v;
+   __mmask16	m;
+   float	rest[64],
+		val;
+   long		readl, readr, writel, writer;
+   int		i, nrest;
+
+  vpivot = _mm512_set1_ps(pivot);
+  vfirst = _mm512_loadu_ps(arr);
+  vlast = _mm512_loadu_ps(arr+n-16);
+  readl = 16;
+  writel = 0;
+  readr = n - 16;
+  writer = n;
+  while (readr - readl >= 16)
+    {
+    if (readl - writel <= writer - readr)
+      {
+      v = _mm512_loadu_ps(arr+readl);
+      readl += 16;
+      }
+    else
+      {
+      readr -= 16;
+      v = _mm512_loadu_ps(arr+readr);
+      }
+    m = eqflag? _mm512_cmp_ps_mask(v, vpivot, _CMP_LE_OQ)
+		: _mm512_cmp_ps_mask(v, vpivot, _CMP_LT_OQ);
+    i = __builtin_popcount(m);
+    v = _mm512_mask_expand_ps(_mm512_maskz_compress_ps(m, v),
+		(__mmask16)(0xFFFF<<i), _mm512_maskz_compress_ps(~m, v));
+    _mm512_storeu_ps(arr+writel, v);
+    _mm512_storeu_ps(arr+writer-16, v);
+    writel += i;
+    writer -= 16 - i;
+    }
+
+/* Leftovers and the 2 vectors put aside fill the remaining room */
+  nrest = readr - readl;
+  memcpy(rest, arr+readl, nrest*sizeof(float));
+  _mm512_storeu_ps(rest+nrest, vfirst);
+  _mm512_storeu_ps(rest+nrest+16, vlast);
+  nrest += 32;
+  for (i=0; i<nrest; i++)
+    {
+    val = rest[i];
+    if (eqflag? val<=pivot : val<pivot)
+      arr[writel++] = val;
+    else
+      arr[--writer] = val;
+    }
+
+  return writel;
+  }
+
+
+/****** max_avx2 **************************************************************
+PROTO	float max_avx2(float *arr, long n)
+PURPOSE	AVX2 version of max_float().
+INPUT	Input array ptr,
+	number of elements (>=8).
+OUTPUT	Largest value.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+__attribute__((target("avx2")))
+static float	max_avx2(float *arr, long n)
+  {
+   __m256	vmax1, vmax2;
+   float	vals[8],
+		valmax;
+   long		i;
+
+  vmax1 = vmax2 = _mm256_loadu_ps(arr);
+  for (i=8; i+16<=n; i+=16)
+    {
+    vmax1 = _mm256_max_ps(vmax1, _mm256_loadu_ps(arr+i));
+    vmax2 = _mm256_max_ps(vmax2, _mm256_loadu_ps(arr+i+8));
+    }
+  _mm256_storeu_ps(vals, _mm256_max_ps(vmax1, vmax2));
+  valmax = vals[0];
+  for (i=1; i<8; i++)
+    if (vals[i] > valmax)
+      valmax = vals[i];
+  for (i=8+((n-8)/16)*16; i<n; i++)
+    if (arr[i] > valmax)
+      valmax = arr[i];
+
+  return valmax;
+  }
+#endif
+
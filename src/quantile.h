@@ -0,0 +1,48 @@
+/*
+*				quantile.h
+*
+* Include file for quantile.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _QUANTILE_H_
+#define _QUANTILE_H_
+
+/*----------------------------- Internal constants --------------------------*/
+#define	QUANTILE_NSCALAR	64	/* Max. size for scalar selection */
+#define	QUANTILE_NBADMAX	4	/* Max. lopsided rounds before sampling */
+#define	QUANTILE_NPIVSAMP	255	/* Sample size for safe pivots */
+#define	QUANTILE_NPARMIN	(1L<<20)/* Min. size for parallel selection */
+#define	QUANTILE_NPARSAMP	4096	/* Sample size for parallel pivots */
+#define	QUANTILE_PARMARGIN	128	/* Rank margin of parallel pivots */
+
+/*------------------------------- functions ---------------------------------*/
+
+extern float	select_median(float *arr, long n, int nthreads),
+		select_quantile(float *arr, long n, float frac, int nthreads),
+		select_rank(float *arr, long n, long k, int nthreads);
+
+extern void	end_quantile(void);
+
+#endif
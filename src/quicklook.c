@@ -0,0 +1,486 @@
+/*
+*				quicklook.c
+*
+* Write single-file JPEG and PNG images, encoded in parallel bands.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "image.h"
+#include "jpeg.h"
+#include "png.h"
+#include "quicklook.h"
+#include "timing.h"
+
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
+
+/* Band encoding context of a quick-look image */
+typedef struct structquicklookenc
+  {
+  unsigned char		**buf;			/* Encoded bands */
+  size_t		*size;			/* Sizes of encoded bands */
+  unsigned int		*adler;			/* Adler-32 of bands (PNG) */
+  int			nbandmax;		/* Max. number of bands */
+#ifdef USE_THREADS
+  pthread_t		*thread;		/* Encoding threads */
+  pthread_mutex_t	mutex;			/* Band counter lock */
+  threads_gate_t	*startgate, *stopgate;	/* Encoding thread gates */
+  imagestruct		*image;			/* Quick-look image */
+  int			nbands,			/* Number of bands in bunch */
+			band,			/* Next band to be encoded */
+			nproc,			/* Number of encoding threads */
+			endflag;		/* Shutdown flag */
+#endif
+  }	quicklookencstruct;
+
+#ifdef USE_THREADS
+   static void		*pthread_encode_bands(void *arg);
+#endif
+
+static int	encode_quicklookband(imagestruct *image, int b),
+		write_quicklookbytes(imagestruct *image, unsigned char *buf,
+			size_t size);
+
+static void	end_quicklookenc(imagestruct *image);
+
+/****** create_quicklook ******************************************************
+PROTO	imagestruct *create_quicklook(char *filename, int filetype,
+			int width, int height, int nchan, int bpp,
+			int quality, int nthreads)
+PURPOSE	Create a single-file JPEG or PNG image and return an imagestruct.
+INPUT	Output filename,
+	file format (QUICKLOOK_JPEG or QUICKLOOK_PNG),
+	image width in pixels,
+	image height in pixels,
+	number of channels,
+	number of bits per channel,
+	compression quality (0-100),
+	number of encoding threads.
+OUTPUT	Pointer to an imagestruct.
+NOTES	Lines are encoded in bands of QUICKLOOK_BANDLINES lines. JPEG bands
+	are stitched using restart markers, PNG bands with sync-flushed
+	deflate segments.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+imagestruct	*create_quicklook(char *filename, int filetype,
+			int width, int height, int nchan, int bpp,
+			int quality, int nthreads)
+  {
+   imagestruct		*image;
+   quicklookencstruct	*enc;
+   unsigned char	header[PNG_HEADERSIZE],
+			zheader[2] = {0x78, 0x9c};
+
+  if (bpp<0)
+    error(EXIT_FAILURE, "*Error*: floating-point pixels are not supported",
+	" in JPEG or PNG images");
+  if (filetype==QUICKLOOK_JPEG)
+    {
+    if (bpp!=8)
+      error(EXIT_FAILURE, "*Error*: JPEG images require ",
+	"BITS_PER_CHANNEL 8");
+    if (nchan!=1 && nchan!=3)
+      error(EXIT_FAILURE, "*Error*: JPEG images require ", "1 or 3 channels");
+    }
+  else if (nchan>4)
+    error(EXIT_FAILURE, "*Error*: PNG images require ", "1 to 4 channels");
+
+  QCALLOC(image, imagestruct, 1);
+  strcpy(image->filename, filename);
+  image->width = width;
+  image->height = height;
+  image->nchan = nchan;
+  image->bpp = bpp;
+  image->bypp = bpp/8;
+  image->filetype = filetype;
+  image->quality = quality;
+  if (nthreads<1)
+    nthreads = 1;
+  image->nlines = nthreads*QUICKLOOK_BANDLINES;
+  if (image->nlines < IMAGE_NLINES)
+    image->nlines = IMAGE_NLINES;
+  QMALLOC(image->buf, unsigned char,
+	(size_t)width*nchan*image->bypp*image->nlines);
+  QCALLOC(enc, quicklookencstruct, 1);
+  image->encoder = enc;
+  enc->nbandmax = (image->nlines+QUICKLOOK_BANDLINES-1) / QUICKLOOK_BANDLINES;
+  QCALLOC(enc->buf, unsigned char *, enc->nbandmax);
+  QMALLOC(enc->size, size_t, enc->nbandmax);
+  QMALLOC(enc->adler, unsigned int, enc->nbandmax);
+
+  if (!(image->file = fopen(filename, "wb")))
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename);
+
+  if (filetype==QUICKLOOK_PNG)
+    {
+    QMALLOC(image->prevline, unsigned char, (size_t)width*nchan*image->bypp);
+    image->adler = (unsigned int)adler32(0L, Z_NULL, 0);
+/*-- Signature, IHDR, and the zlib stream header in its own IDAT chunk */
+    put_pngheader(header, width, height, nchan, image->bypp);
+    QFWRITE(header, PNG_HEADERSIZE, image->file, filename);
+    if (write_pngchunk(image->file, "IDAT", zheader, 2) != RETURN_OK)
+      error(EXIT_FAILURE, "*Error*: cannot write ", filename);
+    }
+
+#ifdef USE_THREADS
+   pthread_attr_t	pthread_attr;
+   int			p;
+
+  enc->nproc = nthreads;
+  QPTHREAD_MUTEX_INIT(&enc->mutex, NULL);
+  QPTHREAD_ATTR_INIT(&pthread_attr);
+  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
+  enc->startgate = threads_gate_init(enc->nproc+1, NULL);
+  enc->stopgate = threads_gate_init(enc->nproc+1, NULL);
+  enc->image = image;
+  QMALLOC(enc->thread, pthread_t, enc->nproc);
+  for (p=0; p<enc->nproc; p++)
+    QPTHREAD_CREATE(&enc->thread[p], &pthread_attr,
+	&pthread_encode_bands, enc);
+  QPTHREAD_ATTR_DESTROY(&pthread_attr);
+#endif
+
+  return image;
+  }
+
+
+/****** write_quicklooklines **************************************************
+PROTO	int write_quicklooklines(imagestruct *image)
+PURPOSE	Encode and write a bunch of lines to a JPEG or PNG image.
+INPUT	Pointer to the image structure.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Bands are encoded in parallel in the multithreaded version, and
+	written in order. May be called from a thread other than the one that
+	created the image: errors are reported to the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	write_quicklooklines(imagestruct *image)
+  {
+   quicklookencstruct	*enc;
+   unsigned char	rstmarker[2];
+   size_t		hsize, rowsize;
+   int			b, nbands, h, status;
+
+  enc = (quicklookencstruct *)image->encoder;
+  nbands = (image->nlines+QUICKLOOK_BANDLINES-1)/QUICKLOOK_BANDLINES;
+#ifdef USE_THREADS
+  enc->band = 0;
+  enc->nbands = nbands;
+  threads_gate_sync(enc->startgate);
+/* ( Slave threads encode the bands here ) */
+  threads_gate_sync(enc->stopgate);
+#else
+  for (b=0; b<nbands; b++)
+    if (encode_quicklookband(image, b) != RETURN_OK)
+      return RETURN_ERROR;
+#endif
+
+  rowsize = (size_t)image->width*image->nchan*image->bypp;
+  status = RETURN_OK;
+  for (b=0; b<nbands; b++)
+    {
+    if (!enc->buf[b])
+      status = RETURN_ERROR;
+    if (status != RETURN_OK)
+      {
+/*---- Only release the remaining bands */
+      free(enc->buf[b]);
+      enc->buf[b] = NULL;
+      continue;
+      }
+    if (image->filetype==QUICKLOOK_JPEG)
+      {
+/*---- Keep the entropy-coded data only, and stitch with restart markers */
+      if (!(hsize = jpeg_headersize(enc->buf[b], enc->size[b])))
+        status = RETURN_ERROR;
+      else
+        {
+        if (!image->y && !b)
+          {
+          jpeg_setheight(enc->buf[b], hsize, image->height);
+          status = write_quicklookbytes(image, enc->buf[b], hsize);
+          }
+        else
+          {
+          rstmarker[0] = 0xff;
+          rstmarker[1] = 0xd0 + (image->rst++&7);
+          status = write_quicklookbytes(image, rstmarker, 2);
+          }
+        image->rst = jpeg_renumberrst(enc->buf[b]+hsize,
+		enc->size[b]-hsize-2, image->rst);
+        if (status == RETURN_OK)
+          status = write_quicklookbytes(image, enc->buf[b]+hsize,
+		enc->size[b]-hsize-2);
+        }
+      }
+    else
+      {
+      if ((h = image->nlines - b*QUICKLOOK_BANDLINES) > QUICKLOOK_BANDLINES)
+        h = QUICKLOOK_BANDLINES;
+      status = write_pngchunk(image->file, "IDAT", enc->buf[b], enc->size[b]);
+      image->adler = (unsigned int)adler32_combine(image->adler,
+		enc->adler[b], (z_off_t)((rowsize+1)*h));
+      }
+    add_timingbytes(TIMING_ENCODE, (double)enc->size[b]);
+    free(enc->buf[b]);
+    enc->buf[b] = NULL;
+    }
+  if (status != RETURN_OK)
+    return RETURN_ERROR;
+
+/* Save the last line for filtering the next bunch */
+  if (image->filetype==QUICKLOOK_PNG)
+    memcpy(image->prevline, image->buf + (image->nlines-1)*rowsize, rowsize);
+
+  return RETURN_OK;
+  }
+
+
+/****** encode_quicklookband **************************************************
+PROTO	int encode_quicklookband(imagestruct *image, int b)
+PURPOSE	Encode a band of lines from the current bunch of lines.
+INPUT	Pointer to the image structure,
+	band index.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	JPEG bands restart the DC prediction at every MCU row.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	encode_quicklookband(imagestruct *image, int b)
+  {
+   quicklookencstruct	*enc;
+   unsigned char	*pix;
+   size_t		rowsize;
+   int			h, y, status;
+
+  enc = (quicklookencstruct *)image->encoder;
+  rowsize = (size_t)image->width*image->nchan*image->bypp;
+  y = b*QUICKLOOK_BANDLINES;
+  if ((h = image->nlines - y) > QUICKLOOK_BANDLINES)
+    h = QUICKLOOK_BANDLINES;
+  pix = image->buf + y*rowsize;
+  start_timing(TIMING_ENCODE);
+  if (image->filetype==QUICKLOOK_JPEG)
+    status = encode_jpeg(pix, image->width, h, rowsize, image->nchan,
+		image->quality, 1, &enc->buf[b], &enc->size[b]);
+  else
+    status = encode_pngband(pix,
+		y? pix-rowsize : (image->y? image->prevline : NULL),
+		image->width, h, rowsize, image->nchan, image->bypp,
+		image->quality*9/100, image->y+y+h>=image->height,
+		&enc->buf[b], &enc->size[b], &enc->adler[b]);
+  if (status != RETURN_OK)
+    enc->buf[b] = NULL;
+  stop_timing(TIMING_ENCODE, (double)image->width*h, 0.0);
+
+  return status;
+  }
+
+
+/****** end_quicklook *********************************************************
+PROTO	void end_quicklook(imagestruct *image)
+PURPOSE	Terminate a JPEG or PNG image and free memory.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_quicklook(imagestruct *image)
+  {
+   unsigned char	trailer[4];
+
+  if (!image)
+    return;
+
+  end_quicklookenc(image);
+  if (image->filetype==QUICKLOOK_JPEG)
+    {
+    trailer[0] = 0xff;
+    trailer[1] = 0xd9;			/* EOI */
+    QFWRITE(trailer, 2, image->file, image->filename);
+    }
+  else
+    {
+    trailer[0] = (image->adler>>24)&0xff;
+    trailer[1] = (image->adler>>16)&0xff;
+    trailer[2] = (image->adler>>8)&0xff;
+    trailer[3] = image->adler&0xff;
+    if (write_pngchunk(image->file, "IDAT", trailer, 4) != RETURN_OK
+	|| write_pngchunk(image->file, "IEND", NULL, 0) != RETURN_OK)
+      error(EXIT_FAILURE, "*Error*: cannot write ", image->filename);
+    }
+  if (fclose(image->file))
+    error(EXIT_FAILURE, "*Error*: cannot write ", image->filename);
+
+  free(image->prevline);
+  free(image->buf);
+  free(image);
+
+  return;
+  }
+
+
+/****** abort_quicklook *******************************************************
+PROTO	void abort_quicklook(imagestruct *image)
+PURPOSE	Terminate an incomplete JPEG or PNG image and free memory.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	The output file is closed as is.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	abort_quicklook(imagestruct *image)
+  {
+  if (!image)
+    return;
+
+  end_quicklookenc(image);
+  fclose(image->file);
+  free(image->prevline);
+  free(image->buf);
+  free(image);
+
+  return;
+  }
+
+
+/****** end_quicklookenc ******************************************************
+PROTO	void end_quicklookenc(imagestruct *image)
+PURPOSE	Shut down the band encoder of a JPEG or PNG image.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	end_quicklookenc(imagestruct *image)
+  {
+   quicklookencstruct	*enc;
+   int			b;
+
+  enc = (quicklookencstruct *)image->encoder;
+#ifdef USE_THREADS
+   int			p;
+
+  enc->endflag = 1;
+  threads_gate_sync(enc->startgate);
+  for (p=0; p<enc->nproc; p++)
+    QPTHREAD_JOIN(enc->thread[p], NULL);
+  threads_gate_end(enc->startgate);
+  threads_gate_end(enc->stopgate);
+  QPTHREAD_MUTEX_DESTROY(&enc->mutex);
+  free(enc->thread);
+#endif
+  for (b=0; b<enc->nbandmax; b++)
+    free(enc->buf[b]);
+  free(enc->buf);
+  free(enc->size);
+  free(enc->adler);
+  free(enc);
+  image->encoder = NULL;
+
+  return;
+  }
+
+
+/****** write_quicklookbytes **************************************************
+PROTO	int write_quicklookbytes(imagestruct *image, unsigned char *buf,
+			size_t size)
+PURPOSE	Write raw bytes to a JPEG or PNG image.
+INPUT	Pointer to the image structure,
+	pointer to the bytes,
+	number of bytes.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	write_quicklookbytes(imagestruct *image, unsigned char *buf,
+			size_t size)
+  {
+  return fwrite(buf, 1, size, image->file)==size? RETURN_OK : RETURN_ERROR;
+  }
+
+
+#ifdef USE_THREADS
+
+/****** pthread_encode_bands **************************************************
+PROTO   void *pthread_encode_bands(void *arg)
+PURPOSE thread that takes care of encoding individual bands of lines.
+INPUT   Pointer to the band encoding context.
+OUTPUT  -.
+NOTES   Failed bands are left empty and reported by write_quicklooklines().
+AUTHOR  E. Bertin (IAP)
+VERSION 19/10/2026
+ ***/
+static void	*pthread_encode_bands(void *arg)
+  {
+   quicklookencstruct	*enc;
+   int			band;
+
+  enc = (quicklookencstruct *)arg;
+  set_timingthread("encode");
+  threads_gate_sync(enc->startgate);
+  while (!enc->endflag)
+    {
+    QPTHREAD_MUTEX_LOCK(&enc->mutex);
+    if (enc->band<enc->nbands)
+      {
+      band = enc->band++;
+      QPTHREAD_MUTEX_UNLOCK(&enc->mutex);
+      encode_quicklookband(enc->image, band);
+      }
+    else
+      {
+      QPTHREAD_MUTEX_UNLOCK(&enc->mutex);
+/*---- Wait for the next bunch of lines */
+      threads_gate_sync(enc->stopgate);
+/* ( Master thread writes the encoded bands here ) */
+      threads_gate_sync(enc->startgate);
+      }
+    }
+
+  pthread_exit(NULL);
+
+  return (void *)NULL;
+  }
+
+#endif
+
@@ -0,0 +1,55 @@
+/*
+*				quicklook.h
+*
+* Include file for quicklook.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+
+#ifndef _QUICKLOOK_H_
+#define _QUICKLOOK_H_
+
+#ifndef _IMAGE_H_
+#include "image.h"
+#endif
+
+/*---------------------------------- defines --------------------------------*/
+#define	QUICKLOOK_JPEG		0	/* Single JPEG file */
+#define	QUICKLOOK_PNG		1	/* Single PNG file */
+
+#define	QUICKLOOK_BANDLINES	32	/* Lines per band (multiple of the */
+					/* largest JPEG MCU height) */
+
+/*------------------------------- functions ---------------------------------*/
+extern imagestruct	*create_quicklook(char *filename, int filetype,
+				int width, int height, int nchan, int bpp,
+				int quality, int nthreads);
+
+extern int		write_quicklooklines(imagestruct *image);
+
+extern void		abort_quicklook(imagestruct *image),
+			end_quicklook(imagestruct *image);
+
+#endif
+
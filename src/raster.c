@@ -0,0 +1,129 @@
+/*
+*				raster.c
+*
+* Convert images to in-memory rasters (library output).
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "image.h"
+#include "prefs.h"
+#include "raster.h"
+
+/****** create_raster *********************************************************
+PROTO	imagestruct *create_raster(char *filename, int width, int height,
+			int nchan, int bpp)
+PURPOSE	Create an in-memory raster image and return an imagestruct.
+INPUT	Output name (for messages only),
+	image width in pixels,
+	image height in pixels,
+	number of channels,
+	number of bits per channel (negative for floating-point).
+OUTPUT	Pointer to an imagestruct.
+NOTES	Pixels are stored top line first, with interleaved channels.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+imagestruct	*create_raster(char *filename, int width, int height,
+			int nchan, int bpp)
+  {
+   imagestruct		*image;
+
+  QCALLOC(image, imagestruct, 1);
+  strcpy(image->filename, filename);
+  image->width = width;
+  image->height = height;
+  image->nchan = nchan;
+  image->bpp = bpp;
+  image->bypp = abs(bpp/8);
+  image->fflag = (bpp<0);
+  image->nlines = IMAGE_NLINES;
+  QMALLOC(image->buf, unsigned char,
+	(size_t)width*nchan*image->bypp*image->nlines);
+  QMALLOC(image->raster, unsigned char,
+	(size_t)width*height*nchan*image->bypp);
+
+  return image;
+  }
+
+
+/****** write_rasterlines *****************************************************
+PROTO	int write_rasterlines(imagestruct *image)
+PURPOSE	Copy a bunch of lines to an in-memory raster image.
+INPUT	Pointer to the image structure.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	write_rasterlines(imagestruct *image)
+  {
+   size_t	rowsize;
+
+  if (image->y<0 || image->y+image->nlines>image->height)
+    return RETURN_ERROR;
+  rowsize = (size_t)image->width*image->nchan*image->bypp;
+  memcpy(image->raster + image->y*rowsize, image->buf, image->nlines*rowsize);
+
+  return RETURN_OK;
+  }
+
+
+/****** end_raster ************************************************************
+PROTO	void end_raster(imagestruct *image)
+PURPOSE	Terminate an in-memory raster image and hand it over to the caller.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	The raster and its dimensions are stored in the preferences of the
+	current job (raster_* members); the raster must be freed with free()
+	by the caller.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_raster(imagestruct *image)
+  {
+  if (!image)
+    return;
+
+  prefs.raster_pix = image->raster;
+  prefs.raster_width = image->width;
+  prefs.raster_height = image->height;
+  prefs.raster_nchan = image->nchan;
+  prefs.raster_bpp = image->bpp;
+  free(image->buf);
+  free(image);
+
+  return;
+  }
+
@@ -0,0 +1,626 @@
+/*
+*				regress.c
+*
+* Regression tests of conversions against reference pixel checksums.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include	<math.h>
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	LIBTIFF_H
+
+#include	"define.h"
+#include	"globals.h"
+#include	"fits/fitscat.h"
+#include	"batch.h"
+#include	"prefs.h"
+#include	"regress.h"
+
+static const char	*regress_mode[] = {"single", "pyramid"},
+			*regress_ext[] = {"tif", "ptif"},
+			*regress_gamma[] = {"POWER-LAW", "SRGB", "REC.709"},
+			*regress_bin[] = {"1", "3"},
+			*regress_flip[] = {"NONE", "XY"},
+			*regress_compress[] = {"NONE", "LZW", "JPEG"},
+			*regress_storage[] = {"FLOAT16", "UINT16"};
+static const int	regress_bits[] = {8, 16, -32};
+
+static regresslevelstruct	*regress_loadgold(char *filename, int *nlevel),
+				*regress_readtiff(char *filename, char *name,
+					double mpix_s, int *nlevel);
+
+static double	regress_deviation(regresslevelstruct *gold,
+			regresslevelstruct *level);
+
+static int	regress_savegold(char *filename, regresslevelstruct *level,
+			int nlevel);
+
+static void	regress_free(regresslevelstruct *level, int nlevel);
+
+/****** regress_run ***********************************************************
+PROTO	int regress_run(prefstruct *prefs0, char **filename, int nfile,
+			int npix, char *dirname, char *goldname,
+			int writeflag, double slowfrac, int nrep)
+PURPOSE	Run a matrix of conversions and check the output pixels and
+	throughputs against those of a reference run.
+INPUT	Pointer to the base configuration,
+	array of input file names (one per channel),
+	number of input files,
+	number of pixels of input images,
+	work directory,
+	reference file name,
+	flag set to write the reference file instead of checking it,
+	max. fractional loss of throughput,
+	number of runs of every conversion (the fastest is kept).
+OUTPUT	Number of failed checks.
+NOTES	The matrix spans GAMMA_TYPE, BITS_PER_CHANNEL, BINNING, FLIP_TYPE,
+	COMPRESSION_TYPE and single versus pyramidal TIFF. JPEG compression
+	is only tested with 8 bits per channel, and gamma corrections are not
+	tested with floating-point output. Every level of the output is
+	decoded and summarized with a hash of its pixels, a grid of block
+	means, and the means of every row and column. A level passes if the
+	hash is identical or if all the means agree within the tolerance of
+	the mode; row and column means catch pixels that were moved within a
+	block. Pyramids with integer output are also built with every 16-bit
+	PYRAMID_STORAGE, which must give the same hashes as FLOAT32.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	regress_run(prefstruct *prefs0, char **filename, int nfile,
+			int npix, char *dirname, char *goldname,
+			int writeflag, double slowfrac, int nrep)
+  {
+   regresslevelstruct	*gold, *level, *levels, *levelt, *goldt;
+   char			name[REGRESS_NAMELEN], outname[MAXCHAR],
+			bitstr[16],
+			*argkey[16], *argval[16], *status;
+   double		dtime, tmin, dev, tol;
+   int			m,g,b,n,f,c,s, a, l, r, narg, ngold, nlevel, nlevelt,
+			nlevels, nlevelsmax, nconf, nfail, nslow, failflag;
+
+  gold = NULL;
+  ngold = 0;
+  if (!writeflag && !(gold = regress_loadgold(goldname, &ngold)))
+    error(EXIT_FAILURE, "*Error*: cannot read reference file ", goldname);
+
+  levels = NULL;
+  nlevels = nlevelsmax = 0;
+  nconf = nfail = nslow = 0;
+  for (m=0; m<2; m++)
+    for (b=0; b<3; b++)
+      for (g=0; g<(regress_bits[b]>0? 3:1); g++)
+        for (n=0; n<2; n++)
+          for (f=0; f<2; f++)
+            for (c=0; c<(regress_bits[b]==8? 3:2); c++)
+              {
+              sprintf(name, "%s/%s/%d/%s/%s/%s", regress_mode[m],
+			regress_gamma[g], regress_bits[b], regress_bin[n],
+			regress_flip[f], regress_compress[c]);
+              sprintf(outname, "%s/regress.%s", dirname, regress_ext[m]);
+              sprintf(bitstr, "%d", regress_bits[b]);
+              narg = 0;
+              argkey[narg] = "OUTFILE_NAME"; argval[narg++] = outname;
+              argkey[narg] = "GAMMA_TYPE";
+              argval[narg++] = (char *)regress_gamma[g];
+              argkey[narg] = "BITS_PER_CHANNEL"; argval[narg++] = bitstr;
+              argkey[narg] = "BINNING"; argval[narg++] = (char *)regress_bin[n];
+              argkey[narg] = "FLIP_TYPE";
+              argval[narg++] = (char *)regress_flip[f];
+              argkey[narg] = "COMPRESSION_TYPE";
+              argval[narg++] = (char *)regress_compress[c];
+              argkey[narg] = "VERBOSE_TYPE"; argval[narg++] = "QUIET";
+              argkey[narg] = "WRITE_XML"; argval[narg++] = "N";
+              argkey[narg] = "WRITE_TRACE"; argval[narg++] = "N";
+              tmin = BIG;
+              for (r=0; r<nrep; r++)
+                {
+                setjob(prefs0, filename, nfile, argkey, argval, narg);
+                dtime = counter_seconds();
+                makeit();
+                dtime = counter_seconds() - dtime;
+                freejob();
+                if (dtime < tmin)
+                  tmin = dtime;
+                }
+              nconf++;
+              if (!(level = regress_readtiff(outname, name, npix/tmin*1e-6,
+			&nlevel)))
+                {
+                fprintf(stdout, "FAIL  %s: cannot read output\n", name);
+                nfail++;
+                continue;
+                }
+              if (writeflag)
+                {
+/*-------------- Keep the summary of every level for the reference file */
+                if (nlevels+nlevel > nlevelsmax)
+                  {
+                  nlevelsmax = 2*(nlevels+nlevel);
+                  QREALLOC(levels, regresslevelstruct, nlevelsmax);
+                  }
+                memcpy(levels+nlevels, level,
+			nlevel*sizeof(regresslevelstruct));
+                nlevels += nlevel;
+                fprintf(stdout, "DONE  %s (%.3f Mpix/s)\n", name,
+			level->mpix_s);
+                free(level);
+                continue;
+                }
+/*------------ Check pixels, level by level */
+              failflag = 0;
+              status = "OK  ";
+              for (l=0; l<nlevel; l++)
+                {
+                for (goldt=gold, a=ngold; a--; goldt++)
+                  if (goldt->level == level[l].level
+			&& !strcmp(goldt->name, name))
+                    break;
+                if (a<0)
+                  {
+                  fprintf(stdout, "FAIL  %s: level %d missing from %s\n",
+			name, level[l].level, goldname);
+                  failflag = 1;
+                  continue;
+                  }
+                if (goldt->width != level[l].width
+			|| goldt->height != level[l].height
+			|| goldt->nchan != level[l].nchan
+			|| goldt->bits != level[l].bits)
+                  {
+                  fprintf(stdout, "FAIL  %s: level %d is %dx%dx%dx%d bits,"
+			" %dx%dx%dx%d bits expected\n",
+			name, level[l].level, level[l].width, level[l].height,
+			level[l].nchan, level[l].bits, goldt->width,
+			goldt->height, goldt->nchan, goldt->bits);
+                  failflag = 1;
+                  continue;
+                  }
+                if (goldt->hash == level[l].hash)
+                  continue;
+                dev = regress_deviation(goldt, &level[l]);
+                tol = level[l].bits<0? REGRESS_TOLFLOAT
+			: (c==2? REGRESS_TOLJPEG : REGRESS_TOLINT);
+                if (dev > tol)
+                  {
+                  fprintf(stdout, "FAIL  %s: level %d deviates by %g"
+			" (tolerance: %g)\n",
+			name, level[l].level, dev, tol);
+                  failflag = 1;
+                  }
+                else
+                  status = "OK~ ";
+                }
+/*------------ 16-bit pyramid storage must not change integer output */
+              if (m==1 && regress_bits[b]>0)
+                for (s=0; s<2; s++)
+                  {
+                  argkey[narg] = "PYRAMID_STORAGE";
+                  argval[narg] = (char *)regress_storage[s];
+                  setjob(prefs0, filename, nfile, argkey, argval, narg+1);
+                  makeit();
+                  freejob();
+                  if (!(levelt = regress_readtiff(outname, name, 0.0,
+			&nlevelt)))
+                    {
+                    fprintf(stdout, "FAIL  %s: cannot read output with"
+			" PYRAMID_STORAGE %s\n", name, regress_storage[s]);
+                    failflag = 1;
+                    continue;
+                    }
+                  for (a=0; a<nlevel; a++)
+                    if (a>=nlevelt || levelt[a].hash != level[a].hash)
+                      {
+                      fprintf(stdout, "FAIL  %s: level %d differs with"
+			" PYRAMID_STORAGE %s\n", name, a, regress_storage[s]);
+                      failflag = 1;
+                      }
+                  regress_free(levelt, nlevelt);
+                  }
+/*------------ Check throughput */
+              if (!failflag && l)
+                {
+                for (goldt=gold, a=ngold; a--; goldt++)
+                  if (!goldt->level && !strcmp(goldt->name, name))
+                    break;
+                if (a>=0 && level->mpix_s < goldt->mpix_s*(1.0-slowfrac))
+                  {
+                  fprintf(stdout, "SLOW  %s: %.3f Mpix/s instead of %.3f\n",
+			name, level->mpix_s, goldt->mpix_s);
+                  nslow++;
+                  }
+                else
+                  fprintf(stdout, "%s  %s (%.3f Mpix/s)\n", status, name,
+			level->mpix_s);
+                }
+              nfail += failflag;
+              regress_free(level, nlevel);
+              }
+
+  for (m=0; m<2; m++)
+    {
+    sprintf(outname, "%s/regress.%s", dirname, regress_ext[m]);
+    remove(outname);
+    }
+  if (writeflag)
+    {
+    if (regress_savegold(goldname, levels, nlevels) != RETURN_OK)
+      error(EXIT_FAILURE, "*Error*: cannot write reference file ", goldname);
+    regress_free(levels, nlevels);
+    fprintf(OUTPUT, "> %d configurations saved to %s\n", nconf, goldname);
+    }
+  else
+    {
+    regress_free(gold, ngold);
+    fprintf(OUTPUT, "> %d configurations: %d failed, %d slower by more than"
+	" %.0f%%\n", nconf, nfail, nslow, slowfrac*100.0);
+    }
+
+  return nfail + nslow;
+  }
+
+
+/****** regress_readtiff ******************************************************
+PROTO	regresslevelstruct *regress_readtiff(char *filename, char *name,
+			double mpix_s, int *nlevel)
+PURPOSE	Decode all the levels of a TIFF file and summarize their pixels.
+INPUT	File name,
+	configuration name,
+	conversion throughput,
+	pointer to the number of levels.
+OUTPUT	Pointer to an array of level summaries, or NULL if the file cannot be
+	read.
+NOTES	Strips and tiles are supported. Hashes are computed on pixel values
+	in native byte order.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static regresslevelstruct	*regress_readtiff(char *filename, char *name,
+					double mpix_s, int *nlevel)
+  {
+   TIFF			*tiff;
+   regresslevelstruct	*levels, *level;
+   unsigned long long	hash;
+   unsigned char	*pix, *tile, *pixt;
+   double		*sum, *psum, val;
+   long			*npix, *pnpix;
+   size_t		linesize, i;
+   uint32_t		width, height, tilesize, tilesizey;
+   uint16_t		nchan, bpp, sampleformat;
+   int			a, l, x,y, tx,ty, gx,gy, g, p, bypp, nx, ny, errflag;
+
+  if (!(tiff = TIFFOpen(filename, "r")))
+    return NULL;
+  *nlevel = (int)TIFFNumberOfDirectories(tiff);
+  QCALLOC(levels, regresslevelstruct, *nlevel);
+  for (l=0; l<*nlevel; l++)
+    {
+    if (!TIFFSetDirectory(tiff, (tdir_t)l))
+      {
+      TIFFClose(tiff);
+      regress_free(levels, *nlevel);
+      return NULL;
+      }
+    width = height = tilesize = tilesizey = 0;
+    nchan = 1;
+    bpp = 8;
+    sampleformat = SAMPLEFORMAT_UINT;
+    TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+    TIFFGetField(tiff, TIFFTAG_SAMPLESPERPIXEL, &nchan);
+    TIFFGetField(tiff, TIFFTAG_BITSPERSAMPLE, &bpp);
+    TIFFGetField(tiff, TIFFTAG_SAMPLEFORMAT, &sampleformat);
+    bypp = bpp/8;
+    linesize = (size_t)width*nchan*bypp;
+    QMALLOC(pix, unsigned char, linesize*height);
+/*-- Decode the whole level */
+    errflag = 0;
+    if (TIFFIsTiled(tiff))
+      {
+      TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tilesize);
+      TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tilesizey);
+      QMALLOC(tile, unsigned char, TIFFTileSize(tiff));
+      for (ty=0; ty<(int)height && !errflag; ty+=tilesizey)
+        for (tx=0; tx<(int)width; tx+=tilesize)
+          {
+          if (TIFFReadTile(tiff, tile, tx, ty, 0, 0) < 0)
+            {
+            errflag = 1;
+            break;
+            }
+          nx = (tx+tilesize>width? width-tx : tilesize)*nchan*bypp;
+          ny = ty+tilesizey>height? height-ty : tilesizey;
+          for (y=0; y<ny; y++)
+            memcpy(pix + (ty+y)*linesize + (size_t)tx*nchan*bypp,
+		tile + (size_t)y*tilesize*nchan*bypp, nx);
+          }
+      free(tile);
+      }
+    else
+      for (y=0; y<(int)height; y++)
+        if (TIFFReadScanline(tiff, pix + y*linesize, y, 0) < 0)
+          {
+          errflag = 1;
+          break;
+          }
+    if (errflag)
+      {
+      free(pix);
+      TIFFClose(tiff);
+      regress_free(levels, *nlevel);
+      return NULL;
+      }
+    level = &levels[l];
+    strcpy(level->name, name);
+    level->level = l;
+    level->width = (int)width;
+    level->height = (int)height;
+    level->nchan = (int)nchan;
+    level->bits = sampleformat==SAMPLEFORMAT_IEEEFP? -(int)bpp : (int)bpp;
+    level->mpix_s = mpix_s;
+/*-- FNV-1a hash */
+    hash = 0xCBF29CE484222325ULL;
+    for (pixt=pix, i=linesize*height; i--;)
+      hash = (hash ^ *(pixt++)) * 0x100000001B3ULL;
+    level->hash = hash;
+/*-- Block, row and column means */
+    level->ngridx = width<REGRESS_NGRID? (int)width : REGRESS_NGRID;
+    level->ngridy = height<REGRESS_NGRID? (int)height : REGRESS_NGRID;
+    g = level->ngridx*level->ngridy;
+    QCALLOC(level->grid, double, g*nchan);
+    QCALLOC(sum, double, g*nchan);
+    QCALLOC(npix, long, g*nchan);
+    p = (int)(height+width);
+    QCALLOC(level->prof, double, p*nchan);
+    QCALLOC(psum, double, p*nchan);
+    QCALLOC(pnpix, long, p*nchan);
+    for (y=0; y<(int)height; y++)
+      {
+      gy = (int)((long)y*level->ngridy/height);
+      pixt = pix + y*linesize;
+      for (x=0; x<(int)width; x++)
+        {
+        gx = (int)((long)x*level->ngridx/width);
+        for (a=0; a<nchan; a++, pixt+=bypp)
+          {
+          if (level->bits<0)
+            val = *((float *)pixt);
+          else if (bypp==2)
+            val = *((unsigned short *)pixt);
+          else
+            val = *pixt;
+          if (isnan(val))
+            continue;
+          sum[(gy*level->ngridx+gx)*nchan+a] += val;
+          npix[(gy*level->ngridx+gx)*nchan+a]++;
+          psum[y*nchan+a] += val;
+          pnpix[y*nchan+a]++;
+          psum[((int)height+x)*nchan+a] += val;
+          pnpix[((int)height+x)*nchan+a]++;
+          }
+        }
+      }
+    for (i=0; i<(size_t)g*nchan; i++)
+      level->grid[i] = npix[i]? sum[i]/npix[i] : 0.0;
+    for (i=0; i<(size_t)p*nchan; i++)
+      level->prof[i] = pnpix[i]? psum[i]/pnpix[i] : 0.0;
+    free(sum);
+    free(npix);
+    free(psum);
+    free(pnpix);
+    free(pix);
+    }
+
+  TIFFClose(tiff);
+
+  return levels;
+  }
+
+
+/****** regress_deviation *****************************************************
+PROTO	double regress_deviation(regresslevelstruct *gold,
+			regresslevelstruct *level)
+PURPOSE	Compare the block, row and column means of a level with those of the
+	reference.
+INPUT	Pointer to the reference level summary,
+	pointer to the level summary.
+OUTPUT	Max. absolute difference of means, relative to the largest reference
+	mean for floating-point pixels.
+NOTES	Both levels must have the same dimensions.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static double	regress_deviation(regresslevelstruct *gold,
+			regresslevelstruct *level)
+  {
+   double	dev, norm, d;
+   int		i, n;
+
+  n = gold->ngridx*gold->ngridy*gold->nchan;
+  dev = norm = 0.0;
+  for (i=0; i<n; i++)
+    {
+    if ((d = fabs(level->grid[i] - gold->grid[i])) > dev)
+      dev = d;
+    if (fabs(gold->grid[i]) > norm)
+      norm = fabs(gold->grid[i]);
+    }
+  n = (gold->width+gold->height)*gold->nchan;
+  for (i=0; i<n; i++)
+    {
+    if ((d = fabs(level->prof[i] - gold->prof[i])) > dev)
+      dev = d;
+    if (fabs(gold->prof[i]) > norm)
+      norm = fabs(gold->prof[i]);
+    }
+
+  return (gold->bits<0 && norm>0.0)? dev/norm : dev;
+  }
+
+
+/****** regress_loadgold ******************************************************
+PROTO	regresslevelstruct *regress_loadgold(char *filename, int *nlevel)
+PURPOSE	Load level summaries from a reference file.
+INPUT	File name,
+	pointer to the number of levels.
+OUTPUT	Pointer to an array of level summaries, or NULL in case of error.
+NOTES	Lines starting with '#' are skipped.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static regresslevelstruct	*regress_loadgold(char *filename, int *nlevel)
+  {
+   FILE			*file;
+   regresslevelstruct	*levels, *level;
+   char			str[MAXCHAR];
+   int			i, n, p, nmax;
+
+  if (!(file = fopen(filename, "r")))
+    return NULL;
+  levels = NULL;
+  n = nmax = 0;
+  while (fscanf(file, " %511s", str) == 1)
+    {
+    if (*str == '#')
+      {
+      if (!fgets(str, MAXCHAR, file))
+        break;
+      continue;
+      }
+    if (n >= nmax)
+      {
+      nmax = nmax? 2*nmax : 256;
+      QREALLOC(levels, regresslevelstruct, nmax);
+      }
+    if (strlen(str) >= REGRESS_NAMELEN)
+      break;
+    level = &levels[n];
+    memset(level, 0, sizeof(regresslevelstruct));
+    strcpy(level->name, str);
+    if (fscanf(file, "%d %d %d %d %d %llx %lf %d %d", &level->level,
+		&level->width, &level->height, &level->nchan, &level->bits,
+		&level->hash, &level->mpix_s, &level->ngridx, &level->ngridy)
+		!= 9
+	|| level->ngridx<1 || level->ngridy<1 || level->nchan<1
+	|| level->width<1 || level->height<1)
+      break;
+    QMALLOC(level->grid, double, level->ngridx*level->ngridy*level->nchan);
+    p = (level->width+level->height)*level->nchan;
+    QMALLOC(level->prof, double, p);
+    n++;
+    for (i=0; i<level->ngridx*level->ngridy*level->nchan; i++)
+      if (fscanf(file, "%lf", &level->grid[i]) != 1)
+        break;
+    if (i<level->ngridx*level->ngridy*level->nchan)
+      break;
+    for (i=0; i<p; i++)
+      if (fscanf(file, "%lf", &level->prof[i]) != 1)
+        break;
+    if (i<p)
+      break;
+    }
+  if (!feof(file))
+    {
+    fclose(file);
+    regress_free(levels, n);
+    return NULL;
+    }
+  fclose(file);
+  *nlevel = n;
+
+  return levels;
+  }
+
+
+/****** regress_savegold ******************************************************
+PROTO	int regress_savegold(char *filename, regresslevelstruct *level,
+			int nlevel)
+PURPOSE	Save level summaries to a reference file.
+INPUT	File name,
+	pointer to an array of level summaries,
+	number of levels.
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	One line per level.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	regress_savegold(char *filename, regresslevelstruct *level,
+			int nlevel)
+  {
+   FILE		*file;
+   int		i, l;
+
+  if (!(file = fopen(filename, "w")))
+    return RETURN_ERROR;
+  fprintf(file, "# %s %s regression reference\n", BANNER, MYVERSION);
+  fprintf(file, "# configuration level width height nchan bits hash"
+	" Mpix/s ngridx ngridy block_means... row_means... column_means...\n");
+  for (l=0; l<nlevel; l++, level++)
+    {
+    fprintf(file, "%s %d %d %d %d %d %016llx %.3f %d %d",
+	level->name, level->level, level->width, level->height,
+	level->nchan, level->bits, level->hash, level->mpix_s,
+	level->ngridx, level->ngridy);
+    for (i=0; i<level->ngridx*level->ngridy*level->nchan; i++)
+      fprintf(file, " %.9g", level->grid[i]);
+    for (i=0; i<(level->width+level->height)*level->nchan; i++)
+      fprintf(file, " %.9g", level->prof[i]);
+    fprintf(file, "\n");
+    }
+
+  return fclose(file)? RETURN_ERROR : RETURN_OK;
+  }
+
+
+/****** regress_free **********************************************************
+PROTO	void regress_free(regresslevelstruct *level, int nlevel)
+PURPOSE	Free an array of level summaries.
+INPUT	Pointer to an array of level summaries,
+	number of levels.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	regress_free(regresslevelstruct *level, int nlevel)
+  {
+   int	l;
+
+  if (!level)
+    return;
+  for (l=0; l<nlevel; l++)
+    {
+    free(level[l].grid);
+    free(level[l].prof);
+    }
+  free(level);
+
+  return;
+  }
+
@@ -0,0 +1,65 @@
+/*
+*				regress.h
+*
+* Include file for regress.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _REGRESS_H_
+#define _REGRESS_H_
+
+#ifndef _PREFS_H_
+#include "prefs.h"
+#endif
+
+/*----------------------------- Internal constants --------------------------*/
+#define	REGRESS_NGRID		8	/* Block means along each axis */
+#define	REGRESS_TOLINT		0.02	/* Tolerance on means (LSB) */
+#define	REGRESS_TOLJPEG		1.0	/* Same for JPEG compression (LSB) */
+#define	REGRESS_TOLFLOAT	1e-5	/* Relative tolerance for floats */
+#define	REGRESS_SLOWFRAC	0.2	/* Default throughput loss threshold */
+#define	REGRESS_NAMELEN		64	/* Max. length of configuration names */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct regresslevel
+  {
+  char			name[REGRESS_NAMELEN];	/* Configuration name */
+  int			level;			/* Pyramid level */
+  int			width, height;		/* Level dimensions */
+  int			nchan;			/* Number of channels */
+  int			bits;			/* Bits per channel (<0: float) */
+  unsigned long long	hash;			/* FNV-1a hash of the pixels */
+  double		mpix_s;			/* Conversion throughput */
+  int			ngridx, ngridy;		/* Number of blocks */
+  double		*grid;			/* Block means, per channel */
+  double		*prof;			/* Row, then column means */
+  }	regresslevelstruct;
+
+/*------------------------------- functions ---------------------------------*/
+extern int	regress_run(prefstruct *prefs0, char **filename, int nfile,
+			int npix, char *dirname, char *goldname,
+			int writeflag, double slowfrac, int nrep);
+
+#endif
+
@@ -0,0 +1,409 @@
+/*
+*				server.c
+*
+* Serve conversion requests over a local (Unix-domain) socket.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "batch.h"
+#include "field.h"
+#include "prefs.h"
+#include "server.h"
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
+#include "xml.h"
+
+/* Server state shared by connection threads */
+typedef struct
+  {
+  batchpoolstruct	*pool;			/* Persistent job pool */
+  int			sock;			/* Listening socket */
+  int			*conn;			/* Open connections */
+  int			nconn, nconnmax;	/* Number of open connections */
+  int			nreq;			/* Number of requests so far */
+  int			quitflag;		/* Set on shutdown requests */
+  xmljobstruct		*xmljob;		/* Meta-data of served jobs */
+  int			nxmljob;		/* Number of served jobs */
+#ifdef USE_THREADS
+  pthread_mutex_t	mutex;			/* Protects the above */
+  pthread_cond_t	conncond;		/* Signaled on disconnections */
+#endif
+  }	serverstruct;
+
+/* Arguments of a connection thread */
+typedef struct
+  {
+  serverstruct		*server;		/* Server state */
+  int			conn;			/* Connection file descriptor */
+  }	serverconnstruct;
+
+static int	server_checkfile(char *filename);
+
+static void	server_lock(serverstruct *server),
+		server_serve(serverstruct *server, int conn),
+		server_unlock(serverstruct *server);
+
+#ifdef USE_THREADS
+static void	*pthread_serverconn(void *arg);
+#endif
+
+/****** makeserver ************************************************************
+PROTO	void makeserver(char *sockname)
+PURPOSE	Listen on a Unix-domain socket and run the conversion requests sent
+	by clients.
+INPUT	Socket path name.
+OUTPUT	-.
+NOTES	Each request is a single line following the batch manifest syntax:
+	input FITS file(s), followed by -<keyword> <value> overrides, e.g.
+	"r.fits,g.fits,b.fits -OUTFILE_NAME rgb.tif -MAX_LEVEL 10".
+	Each request gets a one-line reply: "OK <output_name> <seconds>" or
+	"ERROR <message>". A "SHUTDOWN" line stops the server.
+	Overrides apply on top of the configuration read once at startup,
+	which must not have gone through useprefs() yet: every request
+	starts from that configuration. Connections are served concurrently,
+	and requests run on a persistent pool of BATCH_NJOBS job threads (see
+	init_batchpool()). Input files are kept open, and their statistics
+	cached, between requests. Failed requests, including fatal errors
+	during a conversion (e.g. corrupted data), get an ERROR reply and do
+	not stop the server. Requests do not write XML or trace files
+	themselves; a single XML file with per-request timings is written at
+	shutdown if WRITE_XML is set.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	makeserver(char *sockname)
+  {
+   static prefstruct	prefs0;
+   serverstruct		server;
+   struct sockaddr_un	addr;
+#ifdef USE_THREADS
+   serverconnstruct	*sconn;
+   pthread_t		thread;
+   pthread_attr_t	pthread_attr;
+#endif
+   int			c, conn, xmlflag;
+
+  if (strlen(sockname) >= sizeof(addr.sun_path))
+    error(EXIT_FAILURE, "*Error*: socket path name too long: ", sockname);
+
+/* Clients hanging up must not kill the server */
+  signal(SIGPIPE, SIG_IGN);
+  memset(&server, 0, sizeof(server));
+  if ((server.sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+    error(EXIT_FAILURE, "*Error*: cannot create socket ", sockname);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, sockname);
+  unlink(sockname);
+  if (bind(server.sock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+	|| listen(server.sock, SERVER_BACKLOG) < 0)
+    error(EXIT_FAILURE, "*Error*: cannot listen on socket ", sockname);
+
+  prefs.time_start = counter_seconds();
+  set_datetime(prefs.sdate_start, prefs.stime_start);
+/* Requests do not write XML or trace files themselves */
+  xmlflag = prefs.xml_flag;
+  prefs.xml_flag = prefs.trace_flag = 0;
+  prefs0 = prefs;
+  init_fieldcache(FIELDCACHE_NMAX);
+  server.pool = init_batchpool(&prefs0, prefs.batch_njobs);
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_INIT(&server.mutex, NULL);
+  QPTHREAD_COND_INIT(&server.conncond, NULL);
+  QPTHREAD_ATTR_INIT(&pthread_attr);
+  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_DETACHED);
+#endif
+  NFPRINTF(OUTPUT, "");
+  QPRINTF(OUTPUT, "\n===== Listening on %s\n\n", sockname);
+
+  while (!server.quitflag)
+    {
+    if ((conn = accept(server.sock, NULL, NULL)) < 0)
+      {
+      if (server.quitflag)
+        break;
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      error(EXIT_FAILURE, "*Error*: cannot accept connections on ", sockname);
+      }
+/*-- Keep track of open connections, to close them at shutdown */
+    server_lock(&server);
+    if (server.nconn >= server.nconnmax)
+      {
+      server.nconnmax = server.nconnmax? 2*server.nconnmax : SERVER_BACKLOG;
+      QREALLOC(server.conn, int, server.nconnmax);
+      }
+    server.conn[server.nconn++] = conn;
+    server_unlock(&server);
+#ifdef USE_THREADS
+    QMALLOC(sconn, serverconnstruct, 1);
+    sconn->server = &server;
+    sconn->conn = conn;
+    QPTHREAD_CREATE(&thread, &pthread_attr, &pthread_serverconn, sconn);
+#else
+    server_serve(&server, conn);
+#endif
+    }
+
+/* Wake up and wait for the remaining connections */
+  server_lock(&server);
+  for (c=0; c<server.nconn; c++)
+    shutdown(server.conn[c], SHUT_RD);
+#ifdef USE_THREADS
+  while (server.nconn)
+    QPTHREAD_COND_WAIT(&server.conncond, &server.mutex);
+#endif
+  server_unlock(&server);
+#ifdef USE_THREADS
+  QPTHREAD_ATTR_DESTROY(&pthread_attr);
+  QPTHREAD_MUTEX_DESTROY(&server.mutex);
+  QPTHREAD_COND_DESTROY(&server.conncond);
+#endif
+  close(server.sock);
+  unlink(sockname);
+  end_batchpool(server.pool);
+  end_fieldcache();
+  free(server.conn);
+
+  prefs = prefs0;
+  prefs.xml_flag = xmlflag;
+  set_datetime(prefs.sdate_end, prefs.stime_end);
+  prefs.time_diff = counter_seconds() - prefs.time_start;
+  QPRINTF(OUTPUT, "\n===== %d request%s served\n", server.nreq,
+	server.nreq>1? "s":"");
+  if (xmlflag)
+    {
+    init_xml(0);
+    for (c=0; c<server.nxmljob; c++)
+      update_xmljob(&server.xmljob[c]);
+    write_xml(prefs.xml_name);
+    end_xml();
+    }
+  free(server.xmljob);
+
+  return;
+  }
+
+
+/****** server_serve **********************************************************
+PROTO	void server_serve(serverstruct *server, int conn)
+PURPOSE	Serve the requests of a client connection.
+INPUT	Pointer to the server state,
+	connection file descriptor.
+OUTPUT	-.
+NOTES	The connection is closed on return.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	server_serve(serverstruct *server, int conn)
+  {
+   FILE			*infile, *outfile;
+   batchjobstruct	*job;
+   char			str[MAXCHARL], errstr[MAXCHAR],
+			*argkey[BATCH_MAXARG], *argval[BATCH_MAXARG],
+			*filename0[MAXFILE];
+   double		dtime;
+   int			c, f, fd, nim, narg;
+
+  infile = outfile = NULL;
+  if ((infile = fdopen(conn, "r")) && (fd = dup(conn)) >= 0
+	&& !(outfile = fdopen(fd, "w")))
+    close(fd);
+  QMALLOC(job, batchjobstruct, 1);
+  while (infile && outfile && !server->quitflag
+	&& fgets(job->str, MAXCHARL, infile))
+    {
+    dtime = counter_seconds();
+/*-- Validate the request before it gets queued */
+    strcpy(str, job->str);
+    if (!strncmp(str, "SHUTDOWN", 8))
+      {
+      server_lock(server);
+      server->quitflag = 1;
+      server_unlock(server);
+/*---- Wake up the listening thread */
+      shutdown(server->sock, SHUT_RDWR);
+      fprintf(outfile, "OK shutdown\n");
+      }
+    else if (splitjob(str, filename0, &nim, argkey, argval, &narg, errstr)
+		!= RETURN_OK)
+      fprintf(outfile, "ERROR %s\n", errstr);
+    else if (!nim)
+      fprintf(outfile, "ERROR no input image\n");
+    else if (checkprefs(argkey, argval, narg, errstr) != RETURN_OK)
+      fprintf(outfile, "ERROR %s\n", errstr);
+    else
+      {
+      for (f=0; f<nim; f++)
+        if (server_checkfile(filename0[f]) != RETURN_OK)
+          break;
+      if (f<nim)
+        fprintf(outfile, "ERROR cannot read %s\n", filename0[f]);
+      else
+        {
+        server_lock(server);
+        job->index = job->lineno = ++server->nreq;
+        server_unlock(server);
+        submit_batchjob(server->pool, job);
+        wait_batchjob(server->pool, job);
+        dtime = counter_seconds() - dtime;
+        if (job->status == RETURN_OK)
+          {
+          fprintf(outfile, "OK %s %.3f\n", job->xml.name, dtime);
+          server_lock(server);
+          QREALLOC(server->xmljob, xmljobstruct, server->nxmljob+1);
+          server->xmljob[server->nxmljob++] = job->xml;
+          server_unlock(server);
+          }
+        else
+          fprintf(outfile, "ERROR %s\n", job->error_msg);
+        NFPRINTF(OUTPUT, "");
+        QPRINTF(OUTPUT, "===== Request #%d served in %.3f s\n",
+		job->index, dtime);
+        }
+      }
+    fflush(outfile);
+    }
+  free(job);
+  if (outfile)
+    fclose(outfile);
+  if (infile)
+    fclose(infile);
+  else
+    close(conn);
+
+  server_lock(server);
+  for (c=0; c<server->nconn && server->conn[c]!=conn; c++);
+  if (c<server->nconn)
+    server->conn[c] = server->conn[--server->nconn];
+#ifdef USE_THREADS
+  QPTHREAD_COND_SIGNAL(&server->conncond);
+#endif
+  server_unlock(server);
+
+  return;
+  }
+
+
+#ifdef USE_THREADS
+/****** pthread_serverconn ****************************************************
+PROTO	void *pthread_serverconn(void *arg)
+PURPOSE	Thread serving a client connection.
+INPUT	Pointer to the connection arguments (freed here).
+OUTPUT	NULL.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	*pthread_serverconn(void *arg)
+  {
+   serverconnstruct	*sconn;
+
+  sconn = (serverconnstruct *)arg;
+  server_serve(sconn->server, sconn->conn);
+  free(sconn);
+
+  return NULL;
+  }
+#endif
+
+
+/****** server_lock ***********************************************************
+PROTO	void server_lock(serverstruct *server)
+PURPOSE	Acquire exclusive access to the server state.
+INPUT	Pointer to the server state.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	server_lock(serverstruct *server)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&server->mutex);
+#endif
+
+  return;
+  }
+
+
+/****** server_unlock *********************************************************
+PROTO	void server_unlock(serverstruct *server)
+PURPOSE	Release exclusive access to the server state.
+INPUT	Pointer to the server state.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	server_unlock(serverstruct *server)
+  {
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&server->mutex);
+#endif
+
+  return;
+  }
+
+
+/****** server_checkfile ******************************************************
+PROTO	int server_checkfile(char *filename)
+PURPOSE	Check that an input file can be read.
+INPUT	File name, possibly followed by an extension specification.
+OUTPUT	RETURN_OK if the file is readable, RETURN_ERROR otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	server_checkfile(char *filename)
+  {
+   char	str[MAXCHAR],
+	*pstr;
+
+  strncpy(str, filename, MAXCHAR-1);
+  str[MAXCHAR-1] = '\0';
+  if ((pstr = strrchr(str, '[')))
+    *pstr = '\0';
+
+  return access(str, R_OK)? RETURN_ERROR : RETURN_OK;
+  }
+
@@ -0,0 +1,75 @@
+/*
+*				stiff.h
+*
+* Public interface of the STIFF conversion library (libstiff).
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _STIFF_H_
+#define _STIFF_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*-------------------------------- constants --------------------------------*/
+#define	STIFF_OK	0		/* Same as RETURN_OK */
+#define	STIFF_ERROR	(-1)		/* Same as RETURN_ERROR */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct structstiff	stiffstruct;	/* Opaque conversion context */
+
+/*------------------------------- functions ---------------------------------*/
+extern stiffstruct	*stiff_new(char *configname, char **argkey,
+				char **argval, int narg);
+
+extern int		stiff_convert(stiffstruct *stiff, char **filename,
+				int nfile, char *outfilename, char **argkey,
+				char **argval, int narg),
+			stiff_convertbuf(stiffstruct *stiff, void **buf,
+				size_t *bufsize, int nbuf, char *outfilename,
+				char **argkey, char **argval, int narg),
+			stiff_render(stiffstruct *stiff, char **filename,
+				int nfile, char **argkey, char **argval,
+				int narg, unsigned char **pix, int *width,
+				int *height, int *nchan, int *bpp),
+			stiff_renderbuf(stiffstruct *stiff, void **buf,
+				size_t *bufsize, int nbuf, char **argkey,
+				char **argval, int narg, unsigned char **pix,
+				int *width, int *height, int *nchan, int *bpp);
+
+extern const char	*stiff_errormsg(void);
+
+extern void		stiff_free(stiffstruct *stiff),
+			stiff_stats(double *time, double *nlines,
+				double *npix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -0,0 +1,312 @@
+/*
+*				synth.c
+*
+* Deterministic synthetic FITS images for benchmarks and regression tests.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "synth.h"
+
+static double	synth_gauss(unsigned long long *state),
+		synth_random(unsigned long long *state);
+
+/****** synth_image ***********************************************************
+PROTO	float *synth_image(int width, int height, int chan, unsigned int seed)
+PURPOSE	Simulate an image of a star field.
+INPUT	Image width,
+	image height,
+	channel index,
+	random seed.
+OUTPUT	Pointer to the pixel values (to be freed with free()).
+NOTES	The image is made of a sky background with a gradient, stars with a
+	Gaussian profile and a power-law distribution of fluxes, photon and
+	read-out noise, and a few circular holes filled with NaNs. Star
+	positions and holes depend only on the seed, so that channels
+	simulated with the same seed overlap; star colours and noise differ
+	from channel to channel. The random generators do not depend on the
+	C library, so that images are reproducible from one system to the
+	next.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+float	*synth_image(int width, int height, int chan, unsigned int seed)
+  {
+   unsigned long long	state, nstate;
+   float		*pix, *pixt;
+   double		flux, colour, x0,y0, dx,dy, r2max, fac, norm;
+   long			npix, nstar, s;
+   int			x,y, xmin,xmax, ymin,ymax, r, h;
+
+  npix = (long)width*height;
+  QMALLOC(pix, float, npix);
+
+/* Sky background */
+  pixt = pix;
+  for (y=0; y<height; y++)
+    for (x=0; x<width; x++)
+      *(pixt++) = SYNTH_SKY*(1.0 + SYNTH_SKYGRAD*(0.5*x/width + 0.5*y/height));
+
+/* Stars */
+  state = 0x9E3779B97F4A7C15ULL ^ seed;
+  nstar = (long)(SYNTH_STARDENS*npix + 0.5);
+  r = (int)(4.0*SYNTH_SEEING + 1.0);
+  r2max = (double)r*r;
+  norm = 1.0/(2.0*PI*SYNTH_SEEING*SYNTH_SEEING);
+  fac = -0.5/(SYNTH_SEEING*SYNTH_SEEING);
+  for (s=0; s<nstar; s++)
+    {
+    x0 = synth_random(&state)*width;
+    y0 = synth_random(&state)*height;
+/*-- dN/dS propto S^-2.5 (Euclidean counts) */
+    flux = SYNTH_FLUXMIN / pow(1.0 - synth_random(&state)
+		*(1.0 - pow(SYNTH_FLUXMIN/SYNTH_FLUXMAX, 1.5)), 1.0/1.5);
+    colour = 2.0*synth_random(&state) - 1.0;
+    flux *= norm*pow(2.0, 0.5*colour*(chan-1));
+    xmin = (int)x0 - r;
+    if (xmin<0)
+      xmin = 0;
+    xmax = (int)x0 + r;
+    if (xmax>=width)
+      xmax = width-1;
+    ymin = (int)y0 - r;
+    if (ymin<0)
+      ymin = 0;
+    ymax = (int)y0 + r;
+    if (ymax>=height)
+      ymax = height-1;
+    for (y=ymin; y<=ymax; y++)
+      {
+      dy = y + 0.5 - y0;
+      pixt = pix + (size_t)y*width + xmin;
+      for (x=xmin; x<=xmax; x++, pixt++)
+        {
+        dx = x + 0.5 - x0;
+        if (dx*dx+dy*dy < r2max)
+          *pixt += (float)(flux*exp(fac*(dx*dx+dy*dy)));
+        }
+      }
+    }
+
+/* Noise */
+  nstate = 0xD1B54A32D192ED03ULL ^ seed ^ ((unsigned long long)(chan+1)<<32);
+  pixt = pix;
+  for (s=npix; s--; pixt++)
+    *pixt += (float)(synth_gauss(&nstate)
+	* sqrt(SYNTH_RON*SYNTH_RON + (*pixt>0.0? *pixt/SYNTH_GAIN : 0.0)));
+
+/* Holes */
+  r = 1 + width/128;
+  for (h=0; h<SYNTH_NHOLE; h++)
+    {
+    x0 = synth_random(&state)*width;
+    y0 = synth_random(&state)*height;
+    for (y=(int)y0-r; y<=(int)y0+r; y++)
+      {
+      if (y<0 || y>=height)
+        continue;
+      for (x=(int)x0-r; x<=(int)x0+r; x++)
+        if (x>=0 && x<width && (x-(int)x0)*(x-(int)x0)+(y-(int)y0)*(y-(int)y0)
+		<= r*r)
+          pix[(size_t)y*width+x] = NAN;
+      }
+    }
+
+  return pix;
+  }
+
+
+/****** synth_fits ************************************************************
+PROTO	int synth_fits(char *filename, int width, int height, int bitpix,
+			int chan, unsigned int seed)
+PURPOSE	Simulate an image of a star field and save it as a FITS file.
+INPUT	File name,
+	image width,
+	image height,
+	FITS BITPIX,
+	channel index,
+	random seed.
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	Fluxes are scaled down to fit in BITPIX 8 images.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	synth_fits(char *filename, int width, int height, int bitpix,
+			int chan, unsigned int seed)
+  {
+   float	*pix, *pixt;
+   long		n;
+   int		status;
+
+  pix = synth_image(width, height, chan, seed);
+  if (bitpix == BP_BYTE)
+    for (pixt=pix, n=(long)width*height; n--; pixt++)
+      *pixt *= SYNTH_BYTESCALE;
+  status = synth_writefits(filename, pix, width, height, bitpix);
+  free(pix);
+
+  return status;
+  }
+
+
+/****** synth_writefits *******************************************************
+PROTO	int synth_writefits(char *filename, float *pix, int width, int height,
+			int bitpix)
+PURPOSE	Save an image as a FITS file.
+INPUT	File name,
+	pointer to the pixel values,
+	image width,
+	image height,
+	FITS BITPIX.
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	For integer BITPIX, pixel values are clipped to the range of the data
+	type and NaNs are replaced with the BLANK value. Pixel values are
+	modified in place.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	synth_writefits(char *filename, float *pix, int width, int height,
+			int bitpix)
+  {
+   catstruct	*cat;
+   tabstruct	*tab;
+   float	*pixt, fmin, fmax;
+   long		n, npix;
+   int		blank;
+
+  npix = (long)width*height;
+  cat = new_cat(1);
+  init_cat(cat);
+  strcpy(cat->filename, filename);
+  tab = cat->tab;
+  tab->cat = cat;
+  tab->naxis = 2;
+  QMALLOC(tab->naxisn, int, 2);
+  tab->naxisn[0] = width;
+  tab->naxisn[1] = height;
+  tab->bitpix = bitpix;
+  tab->bytepix = abs(bitpix)/8;
+  tab->bitsgn = (bitpix != BP_BYTE);
+  tab->bscale = 1.0;
+  tab->bzero = 0.0;
+  tab->tabsize = (KINGSIZE_T)npix*tab->bytepix;
+  addkeywordto_head(tab, "OBJECT  ", "Object name");
+  fitswrite(tab->headbuf, "OBJECT  ", "Synthetic star field", H_STRING,
+	T_STRING);
+
+  if (bitpix > 0)
+    {
+    switch(bitpix)
+      {
+      case BP_BYTE:
+        blank = 0;
+        fmin = 1.0;
+        fmax = 255.0;
+        break;
+      case BP_SHORT:
+        blank = -32768;
+        fmin = -32767.0;
+        fmax = 32767.0;
+        break;
+      case BP_LONG:
+        blank = -2147483647;	/* Survives float round-off */
+        fmin = -2147483520.0;
+        fmax = 2147483520.0;
+        break;
+      default:
+        free_cat(&cat, 1);
+        return RETURN_ERROR;
+      }
+    for (pixt=pix, n=npix; n--; pixt++)
+      if (isnan(*pixt))
+        *pixt = (float)blank - 0.5;	/* write_body() rounds towards 0 */
+      else if (*pixt < fmin)
+        *pixt = fmin;
+      else if (*pixt > fmax)
+        *pixt = fmax;
+    addkeywordto_head(tab, "BLANK   ", "Value of undefined pixels");
+    fitswrite(tab->headbuf, "BLANK   ", &blank, H_INT, T_LONG);
+    }
+
+  if (open_cat(cat, WRITE_ONLY) != RETURN_OK)
+    {
+    free_cat(&cat, 1);
+    return RETURN_ERROR;
+    }
+  save_head(cat, tab);
+  write_body(tab, pix, (size_t)npix);
+  pad_tab(cat, tab->tabsize);
+  free_cat(&cat, 1);
+
+  return RETURN_OK;
+  }
+
+
+/****** synth_random **********************************************************
+PROTO	double synth_random(unsigned long long *state)
+PURPOSE	Draw a uniform random number in [0,1[.
+INPUT	Pointer to the generator state.
+OUTPUT	Random number.
+NOTES	xorshift64* generator; the state must not be 0.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static double	synth_random(unsigned long long *state)
+  {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+
+  return (double)((*state * 2685821657736338717ULL) >> 11)
+	* (1.0/9007199254740992.0);
+  }
+
+
+/****** synth_gauss ***********************************************************
+PROTO	double synth_gauss(unsigned long long *state)
+PURPOSE	Draw a normally distributed random number.
+INPUT	Pointer to the generator state.
+OUTPUT	Random number.
+NOTES	Irwin-Hall approximation (sum of 4 uniform deviates), which is good
+	enough for simulated noise and does not depend on the math library.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static double	synth_gauss(unsigned long long *state)
+  {
+  return (synth_random(state) + synth_random(state) + synth_random(state)
+	+ synth_random(state) - 2.0) * 1.7320508075688772;
+  }
+
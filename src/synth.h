@@ -0,0 +1,54 @@
+/*
+*				synth.h
+*
+* Include file for synth.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _SYNTH_H_
+#define _SYNTH_H_
+
+/*----------------------------- Internal constants --------------------------*/
+#define	SYNTH_SKY	1000.0	/* Sky level (ADU) */
+#define	SYNTH_SKYGRAD	0.1	/* Relative sky gradient across the image */
+#define	SYNTH_GAIN	4.0	/* Gain (e-/ADU) for the photon noise */
+#define	SYNTH_RON	5.0	/* Read-out noise (ADU) */
+#define	SYNTH_STARDENS	5e-4	/* Number of stars per pixel */
+#define	SYNTH_FLUXMIN	1e3	/* Min. star flux (ADU) */
+#define	SYNTH_FLUXMAX	1e8	/* Max. star flux (ADU) */
+#define	SYNTH_SEEING	1.5	/* Standard deviation of the PSF (pixels) */
+#define	SYNTH_NHOLE	8	/* Number of NaN (or BLANK) holes */
+#define	SYNTH_BYTESCALE	0.0625	/* Flux scaling for BITPIX 8 images */
+
+/*------------------------------- functions ---------------------------------*/
+extern float	*synth_image(int width, int height, int chan,
+			unsigned int seed);
+
+extern int	synth_fits(char *filename, int width, int height,
+			int bitpix, int chan, unsigned int seed),
+		synth_writefits(char *filename, float *pix, int width,
+			int height, int bitpix);
+
+#endif
+
@@ -24,14 +24,19 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		13/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
+#ifndef _GNU_SOURCE
+#define	_GNU_SOURCE		/* for CPU affinity functions */
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include	"config.h"
 #endif
 
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -44,9 +49,24 @@
 #include "types.h"
 #include "globals.h"
 #include "fits/fitscat.h"
+#include "prefs.h"
+#include "timing.h"
 
 #ifdef USE_THREADS
 
+/* Start-up arguments of a new thread */
+typedef struct structthreadsstart
+  {
+  void		*(*func)(void *arg);	/* Thread function */
+  void		*arg;			/* Thread function argument */
+  prefstruct	*jobprefs;		/* Preferences of the creator */
+  }	threadsstartstruct;
+
+static int	threads_ncpu(void);
+
+static void	*threads_start(void *arg);
+
+
 /******* threads_gate_init ***************************************************
 PROTO	threads_gate_t *threads_gate_init(int nthreads, void (*func)(void))
 PURPOSE	Create a new gate.
@@ -107,13 +127,14 @@ OUTPUT	-.
 NOTES   From Mark Hays' POSIX tutorial.
 	See e.g. http://www.cs.ualberta.ca/~paullu/C681/mark.hays.threads.html.
 AUTHOR  E. Bertin (IAP)
-VERSION 03/07/2003
+VERSION 19/10/2026
  ***/
 void threads_gate_sync(threads_gate_t *gate)
 
   {
   if (gate->nthreads<2)
     return;		/* trivial case */
+  start_timing(TIMING_WAIT);
   QPTHREAD_MUTEX_LOCK(&gate->block);		/* lock the block -- new */
 						/* threads sleep here */
   QPTHREAD_MUTEX_LOCK(&gate->mutex);		/* lock the mutex */
@@ -133,8 +154,201 @@ void threads_gate_sync(threads_gate_t *gate)
   if (--(gate->ngate)==1)			/* next to last one out? */
     QPTHREAD_COND_BROADCAST(&gate->last);	/* yes, wake up last one */
   QPTHREAD_MUTEX_UNLOCK(&gate->mutex);		/* release the mutex */
+  stop_timing(TIMING_WAIT, 0.0, 0.0);
+
+  return;
+  }
+
+
+/******* threads_create *****************************************************
+PROTO	int threads_create(pthread_t *thread, const pthread_attr_t *attr,
+			void *(*func)(void *arg), void *arg)
+PURPOSE	Start a new POSIX thread that works on the preferences of its creator.
+INPUT	Pointer to the new thread,
+	thread attributes,
+	thread function,
+	thread function argument.
+OUTPUT	0 if OK, an error number otherwise (as pthread_create()).
+NOTES	Used by QPTHREAD_CREATE(), so that the threads of a conversion see the
+	same preferences as the (library or batch) thread that runs it.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int threads_create(pthread_t *thread, const pthread_attr_t *attr,
+		void *(*func)(void *arg), void *arg)
+
+  {
+   threadsstartstruct	*start;
+   int			status;
+
+  QMALLOC(start, threadsstartstruct, 1);
+  start->func = func;
+  start->arg = arg;
+  start->jobprefs = prefs_thread;
+  if ((status = pthread_create(thread, attr, &threads_start, start)))
+    free(start);
+
+  return status;
+  }
+
+
+/******* threads_start ********************************************************
+PROTO	void *threads_start(void *arg)
+PURPOSE	Bind the preferences of the creator and run the thread function.
+INPUT	Pointer to the start-up arguments.
+OUTPUT	Value returned by the thread function.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	*threads_start(void *arg)
+
+  {
+   threadsstartstruct	start;
+
+  start = *(threadsstartstruct *)arg;
+  free(arg);
+  bindprefs(start.jobprefs);
+
+  return start.func(start.arg);
+  }
+
+
+/* Number of conversion threads pinned to each allowed core */
+#ifdef CPU_SETSIZE
+static int		threads_pinuse[CPU_SETSIZE];
+#else
+static int		threads_pinuse[1];
+#endif
+static pthread_mutex_t	threads_pinmutex = PTHREAD_MUTEX_INITIALIZER;
+
+/******* threads_pinreserve ***************************************************
+PROTO	int threads_pinreserve(int n)
+PURPOSE	Reserve a range of CPU cores for a pool of pinned threads.
+INPUT	Number of threads in the pool.
+OUTPUT	Index of the first core of the range (to be added to the thread
+	indices given to threads_pin()).
+NOTES	The range of n consecutive cores (modulo the number of cores allowed
+	to the process) with the fewest threads already pinned is chosen, so
+	that concurrent pools do not share cores as long as there are enough.
+	The range must be returned with threads_pinrelease(). Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int threads_pinreserve(int n)
+
+  {
+   int		b,k, best, load, bestload, ncpu;
+
+  if ((ncpu = threads_ncpu()) < 2)
+    return 0;
+  QPTHREAD_MUTEX_LOCK(&threads_pinmutex);
+  best = 0;
+  bestload = -1;
+  for (b=0; b<ncpu; b++)
+    {
+    for (load=k=0; k<n; k++)
+      load += threads_pinuse[(b+k)%ncpu];
+    if (bestload<0 || load<bestload)
+      {
+      best = b;
+      bestload = load;
+      }
+    }
+  for (k=0; k<n; k++)
+    threads_pinuse[(best+k)%ncpu]++;
+  QPTHREAD_MUTEX_UNLOCK(&threads_pinmutex);
+
+  return best;
+  }
+
+
+/******* threads_pinrelease ***************************************************
+PROTO	void threads_pinrelease(int base, int n)
+PURPOSE	Release a range of CPU cores reserved with threads_pinreserve().
+INPUT	Index of the first core of the range,
+	number of threads in the pool.
+OUTPUT	-.
+NOTES	Thread-safe.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void threads_pinrelease(int base, int n)
+
+  {
+   int		k, ncpu;
+
+  if ((ncpu = threads_ncpu()) < 2)
+    return;
+  QPTHREAD_MUTEX_LOCK(&threads_pinmutex);
+  for (k=0; k<n; k++)
+    if (threads_pinuse[(base+k)%ncpu] > 0)
+      threads_pinuse[(base+k)%ncpu]--;
+  QPTHREAD_MUTEX_UNLOCK(&threads_pinmutex);
 
   return;
   }
 
+
+/******* threads_ncpu *********************************************************
+PROTO	int threads_ncpu(void)
+PURPOSE	Return the number of CPU cores allowed to the process.
+INPUT	-.
+OUTPUT	Number of cores, or 0 if unknown.
+NOTES	Only supported on Linux.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int threads_ncpu(void)
+
+  {
+#if defined(__linux__) && defined(CPU_SET)
+   cpu_set_t	allowed;
+
+  if (sched_getaffinity(0, sizeof(allowed), &allowed))
+    return 0;
+
+  return CPU_COUNT(&allowed);
+#else
+  return 0;
+#endif
+  }
+
+
+/******* threads_pin **********************************************************
+PROTO	int threads_pin(pthread_t thread, int index)
+PURPOSE	Pin a POSIX thread to a single CPU core.
+INPUT	Thread,
+	thread index in its pool.
+OUTPUT	RETURN_OK if the thread could be pinned, RETURN_ERROR otherwise.
+NOTES	Threads are pinned to the index-th core (modulo the number of cores)
+	allowed to the calling process. Pools should offset their indices
+	with threads_pinreserve(). Only supported on Linux.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int threads_pin(pthread_t thread, int index)
+
+  {
+#if defined(__linux__) && defined(CPU_SET)
+   cpu_set_t	allowed, cpuset;
+   int		c, ncpu;
+
+  if (sched_getaffinity(0, sizeof(allowed), &allowed)
+	|| !(ncpu = CPU_COUNT(&allowed)))
+    return RETURN_ERROR;
+  index %= ncpu;
+  for (c=0; c<CPU_SETSIZE; c++)
+    if (CPU_ISSET(c, &allowed) && !index--)
+      break;
+  CPU_ZERO(&cpuset);
+  CPU_SET(c, &cpuset);
+
+  return pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset)?
+	RETURN_ERROR : RETURN_OK;
+#else
+  return RETURN_ERROR;
+#endif
+  }
+
 #endif
@@ -23,7 +23,7 @@
 *	along with AstrOmatic software.
 *	If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		10/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -57,7 +57,7 @@
 		"*Error*: pthread_attr_destroy() failed for ",#pthread_attr);;}
 
 #define QPTHREAD_CREATE(pthread, attr, func, arg) \
-	{if (pthread_create(pthread, attr, func, arg)) \
+	{if (threads_create(pthread, attr, func, arg)) \
 		error(EXIT_FAILURE, \
 		"*Error*: pthread_create() failed for ", #pthread );;}
 
@@ -76,13 +76,16 @@
 		error(EXIT_FAILURE, \
 		"*Error*: pthread_mutex_init() failed for ", #mutex );;}
 
+/* Errors raised while a mutex is held cannot be trapped (see error()) */
 #define QPTHREAD_MUTEX_LOCK(mutex) \
 	{if (pthread_mutex_lock(mutex)) \
 		error(EXIT_FAILURE, \
-		"*Error*: pthread_mutex_lock() failed for ", #mutex );;}
+		"*Error*: pthread_mutex_lock() failed for ", #mutex ); \
+	error_holdtrap(1);}
 
 #define QPTHREAD_MUTEX_UNLOCK(mutex) \
-	{if (pthread_mutex_unlock(mutex)) \
+	{error_holdtrap(-1); \
+	if (pthread_mutex_unlock(mutex)) \
 		error(EXIT_FAILURE, \
 		"*Error*: pthread_mutex_unlock() failed for ", #mutex );;}
 
@@ -134,6 +137,12 @@ typedef struct _threads_gate_t
 /*--------------------------------- Functions -------------------------------*/
 threads_gate_t	*threads_gate_init(int nthreads, void (*func)(void));
 
+int		threads_create(pthread_t *thread, const pthread_attr_t *attr,
+			void *(*func)(void *arg), void *arg),
+		threads_pin(pthread_t thread, int index),
+		threads_pinreserve(int n);
+
 void		threads_gate_end(threads_gate_t *gate),
+		threads_pinrelease(int base, int n),
 		threads_gate_sync(threads_gate_t *gate);
 
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -36,12 +36,14 @@
 #include <time.h>
 #include LIBTIFF_H
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "define.h"
 #include "globals.h"
 #include "fits/fitscat.h"
 #include "image.h"
 #include "tiff.h"
+#include "timing.h"
 
 int	tiff_compflag[] = {COMPRESSION_NONE, COMPRESSION_LZW, COMPRESSION_JPEG,
 			COMPRESSION_DEFLATE, COMPRESSION_ADOBE_DEFLATE};
@@ -147,7 +149,7 @@ void	create_tiffdir(imagestruct *image, int width, int height,
   {
    TIFF		*tiff;
    time_t	thetime;
-   struct tm	*tm;
+   struct tm	tm;
    char		datetimeb[32],
 		psuserb[MAXCHAR],
 		pshostb[MAXCHAR],
@@ -229,10 +231,8 @@ void	create_tiffdir(imagestruct *image, int width, int height,
 
 /* Date and time */
   thetime = time(NULL);
-  tm = localtime(&thetime);
-  sprintf(datetimeb,"%04d:%02d:%02d %02d:%02d:%02d",
-	tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday,
-	tm->tm_hour, tm->tm_min, tm->tm_sec);
+  localtime_r(&thetime, &tm);
+  strftime(datetimeb, 20, "%Y:%m:%d %H:%M:%S", &tm);
   TIFFSetField(tiff, TIFFTAG_DATETIME, datetimeb);
 
 /* Username and host computer */
@@ -292,7 +292,7 @@ INPUT	Pointer to the image structure.
 OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	26/03/2015
+VERSION	19/10/2026
  ***/
 int	write_tifflines(imagestruct *image)
   {
@@ -302,12 +302,14 @@ int	write_tifflines(imagestruct *image)
   y = image->y / IMAGE_ROWS;
   step = (size_t)image->nchan*image->bypp*image->width*IMAGE_ROWS;
   nstrip = (image->nlines+IMAGE_ROWS-1)/IMAGE_ROWS;
+  start_timing(TIMING_ENCODE);
   for (n=0; n<nstrip; n++)
     if (TIFFWriteEncodedStrip(image->tiff, y++,
 	(tdata_t *)(image->buf + n * step), step) < 0)
-      return RETURN_ERROR;
+      break;
+  stop_timing(TIMING_ENCODE, (double)image->width*image->nlines, 0.0);
 
-  return RETURN_OK;
+  return n<nstrip? RETURN_ERROR : RETURN_OK;
   }
 
 
@@ -319,7 +321,7 @@ INPUT	Pointer to the image structure,
 OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	26/03/2015
+VERSION	19/10/2026
  ***/
 int	write_tifftiles(imagestruct *image)
   {
@@ -330,32 +332,169 @@ int	write_tifftiles(imagestruct *image)
   nx = image->ntilesx;
   npix = (size_t)image->tilesize*image->tilesize*image->nchan*image->bypp;
   buft = image->buf;
+  start_timing(TIMING_ENCODE);
   for (x=0; x<nx; x++)
     {
    if (TIFFWriteTile(image->tiff, buft,
 	x*image->tilesize, image->tiley*image->tilesize, 0, 0) < 0)
-      return RETURN_ERROR;
+      break;
     buft += npix;
     }
+  stop_timing(TIMING_ENCODE, (double)x*image->tilesize*image->tilesize, 0.0);
+
+  return x<nx? RETURN_ERROR : RETURN_OK;
+  }
+
+
+/****** open_tiff *************************************************************
+PROTO	imagestruct *open_tiff(char *filename, int compress_quality)
+PURPOSE	Open an existing tiled TIFF image for updating some of its tiles.
+INPUT	File name,
+	JPEG compression quality of re-encoded tiles.
+OUTPUT	Pointer to an imagestruct.
+NOTES	The first TIFF directory (subimage) is selected.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+imagestruct	*open_tiff(char *filename, int compress_quality)
+  {
+   TIFF		*tiff;
+   imagestruct	*image;
+
+  if ((tiff = TIFFOpen(filename, "r+")) == NULL)
+    error(EXIT_FAILURE, "*Error*: cannot open for updating ", filename);
+  QCALLOC(image, imagestruct, 1);
+  strcpy(image->filename, filename);
+  image->tiff = tiff;
+  image->quality = compress_quality;
+  image->nlevels = (int)TIFFNumberOfDirectories(tiff);
+  image->level = -1;
+  if (set_tiffdir(image, 0) != RETURN_OK || !image->tilesize)
+    error(EXIT_FAILURE, "*Error*: not a tiled TIFF image: ", filename);
+
+  return image;
+  }
+
+
+/****** set_tiffdir ***********************************************************
+PROTO	int set_tiffdir(imagestruct *image, int dir)
+PURPOSE	Select a TIFF directory (subimage) for updating its tiles.
+INPUT	Pointer to the image structure,
+	directory index (starting from 0).
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Tiles written to the previous directory are flushed first: those that
+	do not fit their original location are appended to the file, and the
+	directory is rewritten with the updated tile offsets.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	set_tiffdir(imagestruct *image, int dir)
+  {
+   TIFF		*tiff;
+   uint32_t	width, height, tilesize;
+   uint16_t	nchan, bpp, sampleformat, compress;
+
+  tiff = image->tiff;
+  if (image->level>=0 && !TIFFFlush(tiff))
+    return RETURN_ERROR;
+  if (!TIFFSetDirectory(tiff, (tdir_t)dir))
+    return RETURN_ERROR;
+
+  width = height = tilesize = 0;
+  nchan = 1;
+  bpp = 8;
+  sampleformat = SAMPLEFORMAT_UINT;
+  compress = COMPRESSION_NONE;
+  TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+  TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+  TIFFGetField(tiff, TIFFTAG_SAMPLESPERPIXEL, &nchan);
+  TIFFGetField(tiff, TIFFTAG_BITSPERSAMPLE, &bpp);
+  TIFFGetField(tiff, TIFFTAG_SAMPLEFORMAT, &sampleformat);
+  TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tilesize);
+  TIFFGetField(tiff, TIFFTAG_COMPRESSION, &compress);
+/* JPEG quality is a pseudo-tag, which is not stored in the file */
+  if (compress == COMPRESSION_JPEG)
+    TIFFSetField(tiff, TIFFTAG_JPEGQUALITY, image->quality);
+
+  image->level = dir;
+  image->width = (int)width;
+  image->height = (int)height;
+  image->nchan = (int)nchan;
+  image->bpp = (int)bpp;
+  image->bypp = (int)bpp/8;
+  image->fflag = (sampleformat == SAMPLEFORMAT_IEEEFP);
+  image->tilesize = (int)tilesize;
+  if (tilesize)
+    {
+    image->ntilesx = (image->width+image->tilesize-1)/image->tilesize;
+    image->ntilesy = (image->height+image->tilesize-1)/image->tilesize;
+    }
 
   return RETURN_OK;
   }
 
 
+/****** read_tifftile *********************************************************
+PROTO	int read_tifftile(imagestruct *image, int tilex, int tiley,
+			unsigned char *buf)
+PURPOSE	Read and decode a single tile from the current TIFF directory.
+INPUT	Pointer to the image structure,
+	horizontal tile index,
+	vertical tile index,
+	pointer to the output tile buffer.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	read_tifftile(imagestruct *image, int tilex, int tiley,
+			unsigned char *buf)
+  {
+  return TIFFReadTile(image->tiff, buf, tilex*image->tilesize,
+	tiley*image->tilesize, 0, 0) < 0? RETURN_ERROR : RETURN_OK;
+  }
+
+
+/****** write_tifftile ********************************************************
+PROTO	int write_tifftile(imagestruct *image, int tilex, int tiley,
+			unsigned char *buf)
+PURPOSE	Encode and write a single tile to the current TIFF directory.
+INPUT	Pointer to the image structure,
+	horizontal tile index,
+	vertical tile index,
+	pointer to the input tile buffer.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	In update mode, libtiff overwrites the former tile if the new one fits
+	in place, and appends it to the file otherwise.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	write_tifftile(imagestruct *image, int tilex, int tiley,
+			unsigned char *buf)
+  {
+  return TIFFWriteTile(image->tiff, buf, tilex*image->tilesize,
+	tiley*image->tilesize, 0, 0) < 0? RETURN_ERROR : RETURN_OK;
+  }
+
+
 /****** end_tiff **************************************************************
 PROTO	void	end_tiff(imagestruct *image)
 PURPOSE	Terminate everything related to a TIFF file.
 INPUT	Pointer to the image structure.
-OUTPUT	Computed background.
-NOTES	-.
+OUTPUT	-.
+NOTES	The size of the output file is counted as written bytes.
 AUTHOR	E. Bertin (IAP)
-VERSION	01/12/2009
+VERSION	19/10/2026
  ***/
 void	end_tiff(imagestruct *image)
   {
+   struct stat	st;
+
   if (!image)
     return;
   TIFFClose(image->tiff);
+  if (!stat(image->filename, &st))
+    add_timingbytes(TIMING_ENCODE, (double)st.st_size);
   if (image->buf)
     _TIFFfree(image->buf);
   free(image);
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		06/02/2014
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -49,7 +49,14 @@ extern imagestruct	*create_tiff(char *filename, int width, int height,
 				int compress_type, int compress_quality,
 				char *copyright, char *description);
 
-extern int		write_tifflines(imagestruct *image),
+extern imagestruct	*open_tiff(char *filename, int compress_quality);
+
+extern int		read_tifftile(imagestruct *image, int tilex, int tiley,
+				unsigned char *buf),
+			set_tiffdir(imagestruct *image, int dir),
+			write_tifflines(imagestruct *image),
+			write_tifftile(imagestruct *image, int tilex, int tiley,
+				unsigned char *buf),
 			write_tifftiles(imagestruct *image);
 
 extern void		create_tiffdir(imagestruct *image, int width,
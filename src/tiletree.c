@@ -0,0 +1,715 @@
+/*
+*				tiletree.c
+*
+* Write image pyramids as trees of individual tile files (DeepZoom, XYZ,
+* Zarr).
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "image.h"
+#include "jpeg.h"
+#include "png.h"
+#include "tiletree.h"
+#include "timing.h"
+
+#ifdef USE_THREADS
+#include "threads.h"
+
+/* Multithreading context of a tile tree */
+typedef struct structtiletreethread
+  {
+  pthread_t		*thread;		/* Encoding threads */
+  pthread_mutex_t	mutex;			/* Tile counter lock */
+  threads_gate_t	*startgate, *stopgate;	/* Encoding thread gates */
+  imagestruct		*image;			/* Tile tree */
+  int			ntiles,			/* Number of tiles in row */
+			tile,			/* Next tile to be encoded */
+			nproc,			/* Number of encoding threads */
+			errflag,		/* Encoding error flag */
+			endflag;		/* Shutdown flag */
+  }	tiletreethreadstruct;
+
+   static void		*pthread_encode_tiles(void *arg),
+			end_tiletreethreads(imagestruct *image);
+#endif
+
+static void	make_tiletreedir(char *dirname),
+		make_tiletreepath(char *path, char *format, ...),
+		make_tiletreetilepath(imagestruct *image, int x, int y,
+			char *path);
+
+static int	encode_zarrchunk(imagestruct *image, int x,
+			unsigned char **outbuf, size_t *outsize),
+		write_tiletreetile(imagestruct *image, int x);
+
+static void	write_zarrarray(imagestruct *image);
+
+static char	*tiletree_ext[] = {"jpeg", "png", ""};
+
+/****** create_tiletree *******************************************************
+PROTO	imagestruct *create_tiletree(char *filename, int treetype,
+			int width, int height, int nchan, int bpp,
+			int tilesize, int nlevels, int filetype, int quality,
+			int nthreads)
+PURPOSE	Create a tile tree (directory structure) and return an imagestruct.
+INPUT	Output filename,
+	tree layout (TILETREE_DEEPZOOM, TILETREE_XYZ or TILETREE_ZARR),
+	full resolution image width in pixels,
+	full resolution image height in pixels,
+	number of channels,
+	number of bits per channel,
+	tile size (pixels),
+	number of pyramid levels,
+	tile file format (TILEFILE_JPEG or TILEFILE_PNG, ignored for Zarr),
+	compression quality (0-100),
+	number of encoding threads.
+OUTPUT	Pointer to an imagestruct.
+NOTES	The first level (full resolution) is also created. Zarr stores are
+	made of zlib-compressed chunks and accept floating-point pixels.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+imagestruct	*create_tiletree(char *filename, int treetype,
+			int width, int height, int nchan, int bpp,
+			int tilesize, int nlevels, int filetype, int quality,
+			int nthreads)
+  {
+   imagestruct	*image;
+   char		base[MAXCHAR],
+		*str, *str2;
+
+  if (treetype == TILETREE_ZARR)
+    filetype = TILEFILE_ZARR;
+  else if (bpp<0)
+    error(EXIT_FAILURE, "*Error*: floating-point pixels are not supported",
+	" in tile trees");
+  if (filetype==TILEFILE_JPEG)
+    {
+    if (bpp!=8)
+      error(EXIT_FAILURE, "*Error*: JPEG tiles require ",
+	"BITS_PER_CHANNEL 8");
+    if (nchan!=1 && nchan!=3)
+      error(EXIT_FAILURE, "*Error*: JPEG tiles require ", "1 or 3 channels");
+    }
+  else if (filetype==TILEFILE_PNG && nchan>4)
+    error(EXIT_FAILURE, "*Error*: PNG tiles require ", "1 to 4 channels");
+
+  QCALLOC(image, imagestruct, 1);
+  image->width = width;
+  image->height = height;
+  image->nchan = nchan;
+  image->bpp = bpp;
+  image->bypp = abs(bpp/8);
+  image->fflag = (bpp<0);
+  image->tilesize = tilesize;
+  image->treetype = treetype;
+  image->filetype = filetype;
+  image->quality = quality;
+  image->nlevels = nlevels;
+  image->level = treetype==TILETREE_ZARR? -1 : nlevels;
+
+/* Strip the filename extension, if any */
+  make_tiletreepath(base, "%s", filename);
+  if ((str = strrchr(base, '.')) && (!(str2 = strrchr(base, '/')) || str>str2))
+    *str = '\0';
+  if (treetype == TILETREE_DEEPZOOM)
+    {
+    make_tiletreepath(image->filename, "%s.dzi", base);
+    make_tiletreepath(image->dirname, "%s_files", base);
+    }
+  else if (treetype == TILETREE_ZARR)
+    {
+    make_tiletreepath(image->dirname, "%s.zarr", base);
+    make_tiletreepath(image->filename, "%s/.zattrs", image->dirname);
+    }
+  else
+    {
+    make_tiletreepath(image->dirname, "%s", base);
+    make_tiletreepath(image->filename, "%s/tilemap.json", base);
+    }
+  make_tiletreedir(image->dirname);
+
+#ifdef USE_THREADS
+   tiletreethreadstruct	*tthread;
+   pthread_attr_t	pthread_attr;
+   int			p;
+
+  QCALLOC(tthread, tiletreethreadstruct, 1);
+  tthread->nproc = nthreads>0? nthreads : 1;
+  QPTHREAD_MUTEX_INIT(&tthread->mutex, NULL);
+  QPTHREAD_ATTR_INIT(&pthread_attr);
+  QPTHREAD_ATTR_SETDETACHSTATE(&pthread_attr, PTHREAD_CREATE_JOINABLE);
+  tthread->startgate = threads_gate_init(tthread->nproc+1, NULL);
+  tthread->stopgate = threads_gate_init(tthread->nproc+1, NULL);
+  tthread->image = image;
+  QMALLOC(tthread->thread, pthread_t, tthread->nproc);
+  image->encoder = tthread;
+  for (p=0; p<tthread->nproc; p++)
+    QPTHREAD_CREATE(&tthread->thread[p], &pthread_attr,
+	&pthread_encode_tiles, tthread);
+  QPTHREAD_ATTR_DESTROY(&pthread_attr);
+#endif
+
+  create_tiletreelevel(image, width, height);
+
+  return image;
+  }
+
+
+/****** create_tiletreelevel **************************************************
+PROTO	void create_tiletreelevel(imagestruct *image, int width, int height)
+PURPOSE	Create the directories of a new tile tree level.
+INPUT	Image structure pointer,
+	level width in pixels,
+	level height in pixels.
+OUTPUT	-.
+NOTES	Levels must be created from the highest resolution to the lowest.
+	Zarr levels are numbered from the highest resolution (0) down.
+	Tile path names are checked here, so that encoding threads never
+	have to.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	create_tiletreelevel(imagestruct *image, int width, int height)
+  {
+   char		dirname[MAXCHAR];
+   int		x, tilesize;
+
+  tilesize = image->tilesize;
+  if (image->treetype == TILETREE_ZARR)
+    image->level++;
+  else
+    image->level--;
+  image->levwidth = width;
+  image->levheight = height;
+  image->ntilesx = (width+tilesize-1)/tilesize;
+  image->ntilesy = (height+tilesize-1)/tilesize;
+  if (image->buf)
+    free(image->buf);
+  QMALLOC(image->buf, unsigned char,
+	(size_t)image->ntilesx*tilesize*tilesize*image->nchan*image->bypp);
+
+  make_tiletreepath(dirname, "%s/%d", image->dirname, image->level);
+  make_tiletreedir(dirname);
+  if (image->treetype == TILETREE_XYZ)
+    for (x=0; x<image->ntilesx; x++)
+      {
+      make_tiletreepath(dirname, "%s/%d/%d", image->dirname, image->level,
+	x);
+      make_tiletreedir(dirname);
+      }
+  else if (image->treetype == TILETREE_ZARR)
+    write_zarrarray(image);
+/* The last tile has the longest path name */
+  make_tiletreetilepath(image, image->ntilesx-1, image->ntilesy-1, dirname);
+
+  return;
+  }
+
+
+/****** write_tiletreetiles ***************************************************
+PROTO	int write_tiletreetiles(imagestruct *image)
+PURPOSE	Encode and write a row of tiles, one file per tile.
+INPUT	Pointer to the image structure.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Tiles are encoded in parallel in the multithreaded version. May be
+	called from a thread other than the one that created the tile tree.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	write_tiletreetiles(imagestruct *image)
+  {
+#ifdef USE_THREADS
+   tiletreethreadstruct	*tthread;
+
+  tthread = (tiletreethreadstruct *)image->encoder;
+  tthread->tile = 0;
+  tthread->ntiles = image->ntilesx;
+  threads_gate_sync(tthread->startgate);
+/* ( Slave threads encode and write the tiles here ) */
+  threads_gate_sync(tthread->stopgate);
+  if (tthread->errflag)
+    return RETURN_ERROR;
+#else
+   int	x;
+
+  for (x=0; x<image->ntilesx; x++)
+    if (write_tiletreetile(image, x) != RETURN_OK)
+      return RETURN_ERROR;
+#endif
+
+  return RETURN_OK;
+  }
+
+
+/****** write_tiletreetile ****************************************************
+PROTO	int write_tiletreetile(imagestruct *image, int x)
+PURPOSE	Encode and write a single tile from the current row of tiles.
+INPUT	Pointer to the image structure,
+	tile index along x.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Tiles on the right and bottom edges are cropped to the level size.
+	Errors are reported to the caller, as this runs in encoding threads.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	write_tiletreetile(imagestruct *image, int x)
+  {
+   FILE			*file;
+   char			filename[MAXCHAR];
+   unsigned char	*outbuf;
+   size_t		outsize, nbytes;
+   int			tilesize, w,h, status;
+
+  tilesize = image->tilesize;
+  nbytes = (size_t)image->nchan*image->bypp;
+  if ((w = image->levwidth - x*tilesize) > tilesize)
+    w = tilesize;
+  if ((h = image->levheight - image->tiley*tilesize) > tilesize)
+    h = tilesize;
+  start_timing(TIMING_ENCODE);
+  if (image->treetype == TILETREE_ZARR)
+    status = encode_zarrchunk(image, x, &outbuf, &outsize);
+  else if (image->filetype == TILEFILE_JPEG)
+    status = encode_jpeg(image->buf + (size_t)x*tilesize*tilesize*nbytes,
+		w, h, tilesize*nbytes, image->nchan, image->quality, 0,
+		&outbuf, &outsize);
+  else
+    status = encode_png(image->buf + (size_t)x*tilesize*tilesize*nbytes,
+		w, h, tilesize*nbytes, image->nchan, image->bypp,
+		image->quality*9/100, &outbuf, &outsize);
+  if (status != RETURN_OK)
+    {
+    stop_timing(TIMING_ENCODE, 0.0, 0.0);
+    return RETURN_ERROR;
+    }
+
+  make_tiletreetilepath(image, x, image->tiley, filename);
+  status = RETURN_ERROR;
+  if ((file = fopen(filename, "wb")))
+    {
+    if (fwrite(outbuf, 1, outsize, file) == outsize)
+      status = RETURN_OK;
+    if (fclose(file))
+      status = RETURN_ERROR;
+    }
+  free(outbuf);
+  stop_timing(TIMING_ENCODE, (double)w*h, (double)outsize);
+
+  return status;
+  }
+
+
+/****** make_tiletreetilepath *************************************************
+PROTO	void make_tiletreetilepath(imagestruct *image, int x, int y,
+			char *path)
+PURPOSE	Build the path name of a tile from the current tile tree level.
+INPUT	Pointer to the image structure,
+	tile index along x,
+	tile index along y,
+	output path (MAXCHAR bytes).
+OUTPUT	-.
+NOTES	Exits with an error if the path does not fit.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	make_tiletreetilepath(imagestruct *image, int x, int y,
+			char *path)
+  {
+  if (image->treetype == TILETREE_DEEPZOOM)
+    make_tiletreepath(path, "%s/%d/%d_%d.%s", image->dirname,
+	image->level, x, y, tiletree_ext[image->filetype]);
+  else if (image->treetype == TILETREE_ZARR)
+    make_tiletreepath(path,
+	image->nchan>1? "%s/%d/0.%d.%d" : "%s/%d/%d.%d",
+	image->dirname, image->level, y, x);
+  else
+    make_tiletreepath(path, "%s/%d/%d/%d.%s", image->dirname,
+	image->level, x, y, tiletree_ext[image->filetype]);
+
+  return;
+  }
+
+
+/****** encode_zarrchunk ******************************************************
+PROTO	int encode_zarrchunk(imagestruct *image, int x,
+			unsigned char **outbuf, size_t *outsize)
+PURPOSE	Compress a tile from the current row of tiles as a Zarr chunk.
+INPUT	Pointer to the image structure,
+	tile index along x,
+	pointer to the output buffer pointer (allocated here),
+	pointer to the output size in bytes.
+OUTPUT	RETURN_OK if OK, RETURN_ERROR otherwise.
+NOTES	Channels are de-interleaved to planes. Edge chunks are kept at full
+	size (padded with zeroes), as required by Zarr.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static int	encode_zarrchunk(imagestruct *image, int x,
+			unsigned char **outbuf, size_t *outsize)
+  {
+   unsigned char	*tile, *plane, *in, *out;
+   uLongf		zsize;
+   size_t		npix, size, p;
+   int			a, b, nchan, bypp;
+
+  nchan = image->nchan;
+  bypp = image->bypp;
+  npix = (size_t)image->tilesize*image->tilesize;
+  size = npix*nchan*bypp;
+  tile = image->buf + x*size;
+  if (nchan>1)
+    {
+    QMALLOC(plane, unsigned char, size);
+    for (a=0; a<nchan; a++)
+      {
+      in = tile + a*bypp;
+      out = plane + a*npix*bypp;
+      for (p=npix; p--; in += nchan*bypp)
+        for (b=0; b<bypp; b++)
+          *(out++) = in[b];
+      }
+    }
+  else
+    plane = tile;
+
+  zsize = compressBound((uLong)size);
+  QMALLOC(*outbuf, unsigned char, zsize);
+  if (compress2(*outbuf, &zsize, plane, (uLong)size, image->quality*9/100)
+	!= Z_OK)
+    {
+    free(*outbuf);
+    if (nchan>1)
+      free(plane);
+    return RETURN_ERROR;
+    }
+  *outsize = zsize;
+  if (nchan>1)
+    free(plane);
+
+  return RETURN_OK;
+  }
+
+
+/****** write_zarrarray *******************************************************
+PROTO	void write_zarrarray(imagestruct *image)
+PURPOSE	Write the Zarr array metadata of the current tile tree level.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	Pixels are stored in native byte order.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	write_zarrarray(imagestruct *image)
+  {
+   FILE		*file;
+   char		filename[MAXCHAR], dtype[8], cshape[16];
+
+  sprintf(dtype, "%c%c%d", image->bypp>1? (bswapflag? '<' : '>') : '|',
+	image->fflag? 'f' : 'u', image->bypp);
+  if (image->nchan>1)
+    sprintf(cshape, "%d, ", image->nchan);
+  else
+    *cshape = '\0';
+  make_tiletreepath(filename, "%s/%d/.zarray", image->dirname, image->level);
+  if (!(file = fopen(filename, "w")))
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename);
+  fprintf(file,
+	"{\n"
+	"  \"zarr_format\": 2,\n"
+	"  \"shape\": [%s%d, %d],\n"
+	"  \"chunks\": [%s%d, %d],\n"
+	"  \"dtype\": \"%s\",\n"
+	"  \"compressor\": {\"id\": \"zlib\", \"level\": %d},\n"
+	"  \"fill_value\": 0,\n"
+	"  \"order\": \"C\",\n"
+	"  \"filters\": null\n"
+	"}\n",
+	cshape, image->levheight, image->levwidth,
+	cshape, image->tilesize, image->tilesize,
+	dtype, image->quality*9/100);
+  fclose(file);
+
+  return;
+  }
+
+
+/****** end_tiletree **********************************************************
+PROTO	void end_tiletree(imagestruct *image)
+PURPOSE	Write the tile set manifest and terminate everything related to a
+	tile tree.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	The manifest is written last so that incomplete tile sets are not
+	advertised.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_tiletree(imagestruct *image)
+  {
+   FILE		*file;
+   char		filename[MAXCHAR];
+   int		l;
+
+  if (!image)
+    return;
+
+#ifdef USE_THREADS
+  end_tiletreethreads(image);
+#endif
+
+  if (image->treetype == TILETREE_ZARR)
+    {
+    make_tiletreepath(filename, "%s/.zgroup", image->dirname);
+    if (!(file = fopen(filename, "w")))
+      error(EXIT_FAILURE, "*Error*: cannot open for writing ", filename);
+    fprintf(file, "{\n  \"zarr_format\": 2\n}\n");
+    fclose(file);
+    }
+
+  if (!(file = fopen(image->filename, "w")))
+    error(EXIT_FAILURE, "*Error*: cannot open for writing ", image->filename);
+  if (image->treetype == TILETREE_DEEPZOOM)
+    fprintf(file,
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\"\n"
+	"  Format=\"%s\" Overlap=\"0\" TileSize=\"%d\">\n"
+	"  <Size Width=\"%d\" Height=\"%d\"/>\n"
+	"</Image>\n",
+	tiletree_ext[image->filetype], image->tilesize,
+	image->width, image->height);
+  else if (image->treetype == TILETREE_ZARR)
+    {
+    fprintf(file,
+	"{\n"
+	"  \"multiscales\": [\n"
+	"    {\n"
+	"      \"version\": \"0.4\",\n"
+	"      \"name\": \"%s\",\n"
+	"      \"axes\": [\n"
+	"%s"
+	"        {\"name\": \"y\", \"type\": \"space\"},\n"
+	"        {\"name\": \"x\", \"type\": \"space\"}\n"
+	"      ],\n"
+	"      \"datasets\": [\n",
+	BANNER,
+	image->nchan>1?
+		"        {\"name\": \"c\", \"type\": \"channel\"},\n" : "");
+    for (l=0; l<image->nlevels; l++)
+      fprintf(file,
+	"        {\"path\": \"%d\", \"coordinateTransformations\": "
+	"[{\"type\": \"scale\", \"scale\": [%s%d.0, %d.0]}]}%s\n",
+	l, image->nchan>1? "1.0, " : "", 1<<l, 1<<l,
+	l<image->nlevels-1? "," : "");
+    fprintf(file,
+	"      ]\n"
+	"    }\n"
+	"  ]\n"
+	"}\n");
+    }
+  else
+    fprintf(file,
+	"{\n"
+	"  \"format\": \"%s\",\n"
+	"  \"tileSize\": %d,\n"
+	"  \"width\": %d,\n"
+	"  \"height\": %d,\n"
+	"  \"minzoom\": 0,\n"
+	"  \"maxzoom\": %d,\n"
+	"  \"tiles\": [\"{z}/{x}/{y}.%s\"]\n"
+	"}\n",
+	tiletree_ext[image->filetype], image->tilesize,
+	image->width, image->height, image->nlevels-1,
+	tiletree_ext[image->filetype]);
+  fclose(file);
+
+  free(image->buf);
+  free(image);
+
+  return;
+  }
+
+
+/****** abort_tiletree ********************************************************
+PROTO	void abort_tiletree(imagestruct *image)
+PURPOSE	Terminate an incomplete tile tree without advertising it.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	The tiles already written are left in place, but no manifest is
+	written.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	abort_tiletree(imagestruct *image)
+  {
+  if (!image)
+    return;
+
+#ifdef USE_THREADS
+  end_tiletreethreads(image);
+#endif
+  free(image->buf);
+  free(image);
+
+  return;
+  }
+
+
+/****** make_tiletreedir ******************************************************
+PROTO	void make_tiletreedir(char *dirname)
+PURPOSE	Create a directory if it does not exist already.
+INPUT	Directory name.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	make_tiletreedir(char *dirname)
+  {
+  if (mkdir(dirname, 0777) && errno != EEXIST)
+    error(EXIT_FAILURE, "*Error*: cannot create directory ", dirname);
+
+  return;
+  }
+
+
+/****** make_tiletreepath *****************************************************
+PROTO	void make_tiletreepath(char *path, char *format, ...)
+PURPOSE	Build a tile tree path name from a printf()-like format.
+INPUT	Output path (MAXCHAR bytes),
+	format string,
+	format arguments.
+OUTPUT	-.
+NOTES	Exits with an error if the path does not fit.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	make_tiletreepath(char *path, char *format, ...)
+  {
+   va_list	ap;
+   int		n;
+
+  va_start(ap, format);
+  n = vsnprintf(path, MAXCHAR, format, ap);
+  va_end(ap);
+  if (n<0 || n>=MAXCHAR)
+    error(EXIT_FAILURE, "*Error*: path name too long: ", path);
+
+  return;
+  }
+
+
+#ifdef USE_THREADS
+
+/****** end_tiletreethreads **************************************************
+PROTO	void end_tiletreethreads(imagestruct *image)
+PURPOSE	Shut down the encoding threads of a tile tree.
+INPUT	Pointer to the image structure.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	end_tiletreethreads(imagestruct *image)
+  {
+   tiletreethreadstruct	*tthread;
+   int			p;
+
+  tthread = (tiletreethreadstruct *)image->encoder;
+  tthread->endflag = 1;
+  threads_gate_sync(tthread->startgate);
+  for (p=0; p<tthread->nproc; p++)
+    QPTHREAD_JOIN(tthread->thread[p], NULL);
+  threads_gate_end(tthread->startgate);
+  threads_gate_end(tthread->stopgate);
+  QPTHREAD_MUTEX_DESTROY(&tthread->mutex);
+  free(tthread->thread);
+  free(tthread);
+  image->encoder = NULL;
+
+  return;
+  }
+
+
+/****** pthread_encode_tiles **************************************************
+PROTO   void *pthread_encode_tiles(void *arg)
+PURPOSE thread that takes care of encoding and writing individual tiles.
+INPUT   Pointer to the multithreading context of the tile tree.
+OUTPUT  -.
+NOTES   Failures are flagged in the context and reported by
+	write_tiletreetiles().
+AUTHOR  E. Bertin (IAP)
+VERSION 19/10/2026
+ ***/
+static void	*pthread_encode_tiles(void *arg)
+  {
+   tiletreethreadstruct	*tthread;
+   int			tile;
+
+  tthread = (tiletreethreadstruct *)arg;
+  set_timingthread("encode");
+  threads_gate_sync(tthread->startgate);
+  while (!tthread->endflag)
+    {
+    QPTHREAD_MUTEX_LOCK(&tthread->mutex);
+    if (tthread->tile<tthread->ntiles)
+      {
+      tile = tthread->tile++;
+      QPTHREAD_MUTEX_UNLOCK(&tthread->mutex);
+      if (write_tiletreetile(tthread->image, tile) != RETURN_OK)
+        tthread->errflag = 1;
+      }
+    else
+      {
+      QPTHREAD_MUTEX_UNLOCK(&tthread->mutex);
+/*---- Wait for the next row of tiles */
+      threads_gate_sync(tthread->stopgate);
+/* ( Master thread prepares the next row of tiles here ) */
+      threads_gate_sync(tthread->startgate);
+      }
+    }
+
+  pthread_exit(NULL);
+
+  return (void *)NULL;
+  }
+
+#endif
+
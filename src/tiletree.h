@@ -0,0 +1,59 @@
+/*
+*				tiletree.h
+*
+* Include file for tiletree.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _TILETREE_H_
+#define _TILETREE_H_
+
+#ifndef _IMAGE_H_
+#include "image.h"
+#endif
+
+/*---------------------------------- defines --------------------------------*/
+#define	TILETREE_DEEPZOOM	0	/* <name>_files/<level>/<x>_<y>.<ext> */
+#define	TILETREE_XYZ		1	/* <name>/<z>/<x>/<y>.<ext> */
+#define	TILETREE_ZARR		2	/* <name>.zarr/<level>/[0.]<y>.<x> */
+
+#define	TILEFILE_JPEG		0	/* JPEG tiles */
+#define	TILEFILE_PNG		1	/* PNG tiles */
+#define	TILEFILE_ZARR		2	/* zlib-compressed Zarr chunks */
+
+/*------------------------------- functions ---------------------------------*/
+extern imagestruct	*create_tiletree(char *filename, int treetype,
+				int width, int height, int nchan, int bpp,
+				int tilesize, int nlevels, int filetype,
+				int quality, int nthreads);
+
+extern int		write_tiletreetiles(imagestruct *image);
+
+extern void		abort_tiletree(imagestruct *image),
+			create_tiletreelevel(imagestruct *image, int width,
+				int height),
+			end_tiletree(imagestruct *image);
+
+#endif
+
@@ -0,0 +1,624 @@
+/*
+*				timing.c
+*
+* Low-overhead, per-thread timing and tracing of processing stages.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "timing.h"
+
+#ifdef USE_THREADS
+#include "threads.h"
+#endif
+
+const char	*timing_stagename[TIMING_NSTAGE] = {"stats", "read", "bin",
+			"convert", "tile", "encode", "wait"};
+
+static timingthreadstruct	*timing_threads;
+static char			**timing_jobname;
+static double			timing_trace0, timing_job0;
+static int			timing_nthread, timing_traceflag, timing_clockflag,
+				timing_job, timing_njob, timing_njobmax;
+
+#ifdef USE_THREADS
+static __thread timingthreadstruct	*timing_self;
+static pthread_mutex_t			timing_mutex
+					= PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t			timing_key;
+static pthread_once_t			timing_once = PTHREAD_ONCE_INIT;
+
+static void	init_timingkey(void),
+		release_timingthread(void *thread);
+#else
+static timingthreadstruct		*timing_self;
+#endif
+
+static timingthreadstruct	*get_timingself(void),
+				*get_timingthread(char *name);
+
+static void			add_timingevent(timingthreadstruct *thread,
+					int stage, double t0, double t1,
+					double npix),
+				get_timingclocks(double *wall, double *cpu),
+				write_tracestring(FILE *file, char *str);
+
+/****** reset_timing **********************************************************
+PROTO	void reset_timing(void)
+PURPOSE	Reset the timing counters of all threads.
+INPUT	-.
+OUTPUT	-.
+NOTES	Must be called while no other thread is being timed. The calling
+	thread is named "main" if it has not been named before. Clocks are
+	only read from the first call on (see get_timingclocks()).
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	reset_timing(void)
+  {
+   timingthreadstruct	*thread;
+
+  if (!timing_self)
+    set_timingthread("main");
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_LOCK(&timing_mutex);
+#endif
+  for (thread=timing_threads; thread; thread=thread->next)
+    memset(thread->count, 0, sizeof(thread->count));
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&timing_mutex);
+#endif
+  timing_clockflag = 1;
+  get_timingclocks(&timing_self->wall0, &timing_self->cpu0);
+
+  return;
+  }
+
+
+/****** set_timingthread ******************************************************
+PROTO	void set_timingthread(char *name)
+PURPOSE	Name the counters of the calling thread after its role.
+INPUT	Thread role (e.g., "convert").
+OUTPUT	-.
+NOTES	Threads of the same role are told apart by an index. Counters of
+	terminated threads are taken over by new threads of the same role,
+	so that successive pools of workers share the same counters. Threads
+	that are not named get the "other" role.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_timingthread(char *name)
+  {
+  if (timing_self)
+    {
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_LOCK(&timing_mutex);
+#endif
+    timing_self->activeflag = 0;
+#ifdef USE_THREADS
+    QPTHREAD_MUTEX_UNLOCK(&timing_mutex);
+#endif
+    }
+  timing_self = get_timingthread(name);
+
+  return;
+  }
+
+
+/****** start_timing **********************************************************
+PROTO	void start_timing(int stage)
+PURPOSE	Start timing a processing stage in the calling thread.
+INPUT	Stage (TIMING_STATS, TIMING_READ, ...).
+OUTPUT	-.
+NOTES	Stages may be nested: time spent in a nested stage is not counted in
+	the enclosing one, so that stage times add up to the thread time.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	start_timing(int stage)
+  {
+   timingthreadstruct	*self;
+   timingcountstruct	*count;
+   double		wall, cpu;
+
+  self = get_timingself();
+  if (self->depth >= TIMING_MAXDEPTH)
+    error(EXIT_FAILURE, "*Internal Error*: too many nested stages in ",
+	"start_timing()");
+  get_timingclocks(&wall, &cpu);
+/* Pause the enclosing stage */
+  if (self->depth)
+    {
+    count = &self->count[self->stage[self->depth-1]];
+    count->wall += wall - self->wall0;
+    count->cpu += cpu - self->cpu0;
+    }
+  self->start[self->depth] = wall;
+  self->stage[self->depth++] = stage;
+  self->wall0 = wall;
+  self->cpu0 = cpu;
+
+  return;
+  }
+
+
+/****** stop_timing ***********************************************************
+PROTO	void stop_timing(int stage, double npix, double nbytes)
+PURPOSE	Stop timing a processing stage in the calling thread.
+INPUT	Stage (must be the last one started),
+	number of pixels processed,
+	number of bytes read or written.
+OUTPUT	-.
+NOTES	The enclosing stage, if any, is resumed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	stop_timing(int stage, double npix, double nbytes)
+  {
+   timingthreadstruct	*self;
+   timingcountstruct	*count;
+   double		wall, cpu;
+
+  self = timing_self;
+  if (!self || !self->depth || self->stage[self->depth-1] != stage)
+    error(EXIT_FAILURE, "*Internal Error*: unmatched stage in ",
+	"stop_timing()");
+  get_timingclocks(&wall, &cpu);
+  count = &self->count[stage];
+  count->ncall++;
+  count->wall += wall - self->wall0;
+  count->cpu += cpu - self->cpu0;
+  count->npix += npix;
+  count->nbytes += nbytes;
+  if (timing_traceflag)
+    add_timingevent(self, stage, self->start[self->depth-1], wall, npix);
+  self->depth--;
+  self->wall0 = wall;
+  self->cpu0 = cpu;
+
+  return;
+  }
+
+
+/****** add_timingbytes *******************************************************
+PROTO	void add_timingbytes(int stage, double nbytes)
+PURPOSE	Count bytes read or written in a stage, outside of timed calls.
+INPUT	Stage (TIMING_STATS, TIMING_READ, ...),
+	number of bytes.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	add_timingbytes(int stage, double nbytes)
+  {
+  get_timingself()->count[stage].nbytes += nbytes;
+
+  return;
+  }
+
+
+/****** init_trace ************************************************************
+PROTO	void init_trace(void)
+PURPOSE	Start recording a trace of processing stages.
+INPUT	-.
+OUTPUT	-.
+NOTES	Every timed stage then leaves a trace event in the buffer of its
+	thread; nothing is recorded as long as init_trace() is not called.
+	Must be called while no other thread is being timed. The calling
+	thread is named "main" if it has not been named before.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	init_trace(void)
+  {
+   double	cpu;
+
+  if (!timing_self)
+    set_timingthread("main");
+  end_trace();
+  timing_clockflag = 1;
+  get_timingclocks(&timing_self->wall0, &timing_self->cpu0);
+  get_timingclocks(&timing_trace0, &cpu);
+  timing_traceflag = 1;
+
+  return;
+  }
+
+
+/****** end_trace *************************************************************
+PROTO	void end_trace(void)
+PURPOSE	Stop recording a trace and free the trace buffers.
+INPUT	-.
+OUTPUT	-.
+NOTES	Must be called while no other thread is being timed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	end_trace(void)
+  {
+   timingthreadstruct	*thread;
+   int			j;
+
+  timing_traceflag = 0;
+  for (thread=timing_threads; thread; thread=thread->next)
+    {
+    free(thread->event);
+    thread->event = NULL;
+    thread->nevent = thread->neventmax = 0;
+    }
+  for (j=0; j<timing_njob; j++)
+    free(timing_jobname[j]);
+  free(timing_jobname);
+  timing_jobname = NULL;
+  timing_job = timing_njob = timing_njobmax = 0;
+
+  return;
+  }
+
+
+/****** start_tracejob ********************************************************
+PROTO	void start_tracejob(char *name)
+PURPOSE	Start a new job in the trace.
+INPUT	Job name (e.g. the output file name).
+OUTPUT	-.
+NOTES	Trace events are tagged with the index of the current job. Does
+	nothing if no trace is being recorded.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	start_tracejob(char *name)
+  {
+   double	cpu;
+
+  if (!timing_traceflag)
+    return;
+  if (timing_njob >= timing_njobmax)
+    {
+    timing_njobmax += 16;
+    QREALLOC(timing_jobname, char *, timing_njobmax);
+    }
+  QMALLOC(timing_jobname[timing_njob], char, strlen(name)+1);
+  strcpy(timing_jobname[timing_njob], name);
+  timing_job = timing_njob++;
+  get_timingclocks(&timing_job0, &cpu);
+
+  return;
+  }
+
+
+/****** stop_tracejob *********************************************************
+PROTO	void stop_tracejob(void)
+PURPOSE	End the current job in the trace.
+INPUT	-.
+OUTPUT	-.
+NOTES	The job is recorded as a span of the calling thread. Does nothing if
+	no trace is being recorded.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	stop_tracejob(void)
+  {
+   double	wall, cpu;
+
+  if (!timing_traceflag || !timing_njob)
+    return;
+  get_timingclocks(&wall, &cpu);
+  add_timingevent(get_timingself(), TIMING_JOB, timing_job0, wall, 0.0);
+
+  return;
+  }
+
+
+/****** write_trace ***********************************************************
+PROTO	int write_trace(char *filename)
+PURPOSE	Save the recorded trace in the Chrome trace event format.
+INPUT	File name.
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	The file can be loaded in chrome://tracing or Perfetto. Every thread
+	has its own track, named after its role and index. Time stamps are in
+	microseconds from the start of the trace.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	write_trace(char *filename)
+  {
+   FILE			*file;
+   timingthreadstruct	*thread;
+   timingeventstruct	*event;
+   char			*sep;
+   int			e;
+
+  if (!(file = fopen(filename, "w")))
+    return RETURN_ERROR;
+
+  fprintf(file, "{\"displayTimeUnit\": \"ms\",\n"
+	" \"otherData\": {\"software\": \"%s\", \"version\": \"%s\"},\n"
+	" \"traceEvents\": [\n", BANNER, MYVERSION);
+  fprintf(file, "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1,"
+	" \"tid\": 0, \"args\": {\"name\": \"%s\"}}", BANNER);
+  sep = ",\n";
+  for (thread=timing_threads; thread; thread=thread->next)
+    {
+    fprintf(file, "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1,"
+	" \"tid\": %d, \"args\": {\"name\": \"%s #%d\"}}",
+	sep, thread->id, thread->name, thread->index);
+    fprintf(file, "%s  {\"name\": \"thread_sort_index\", \"ph\": \"M\","
+	" \"pid\": 1, \"tid\": %d, \"args\": {\"sort_index\": %d}}",
+	sep, thread->id, thread->id);
+    for (event=thread->event, e=thread->nevent; e--; event++)
+      {
+      fprintf(file, "%s  {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\","
+	" \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f,"
+	" \"args\": {\"job\": %d",
+	sep,
+	event->stage==TIMING_JOB? "job" : timing_stagename[event->stage],
+	event->stage==TIMING_JOB? "job" : "stage",
+	thread->id, event->t0*1e6, event->dt*1e6, event->job+1);
+      if (event->stage==TIMING_JOB)
+        {
+        fprintf(file, ", \"file\": ");
+        write_tracestring(file, timing_jobname[event->job]);
+        }
+      else if (event->npix > 0.0)
+        fprintf(file, ", \"npix\": %.0f", event->npix);
+      fprintf(file, "}}");
+      }
+    }
+  fprintf(file, "\n ]\n}\n");
+
+  if (fclose(file))
+    return RETURN_ERROR;
+
+  return RETURN_OK;
+  }
+
+
+/****** get_timingthreads *****************************************************
+PROTO	timingthreadstruct *get_timingthreads(void)
+PURPOSE	Give access to the timing counters of all threads.
+INPUT	-.
+OUTPUT	Pointer to the first thread of the list.
+NOTES	Counters should only be read once the timed threads are done.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+timingthreadstruct	*get_timingthreads(void)
+  {
+  return timing_threads;
+  }
+
+
+/****** get_timingself ******************************************************
+PROTO	timingthreadstruct *get_timingself(void)
+PURPOSE	Give access to the counters of the calling thread.
+INPUT	-.
+OUTPUT	Pointer to the counters.
+NOTES	Threads that have not been named get a name of their own.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static timingthreadstruct	*get_timingself(void)
+  {
+  if (!timing_self)
+    timing_self = get_timingthread("other");
+
+  return timing_self;
+  }
+
+
+/****** get_timingthread *****************************************************
+PROTO	timingthreadstruct *get_timingthread(char *name)
+PURPOSE	Find free counters for a thread of a given role, or create new ones.
+INPUT	Thread role.
+OUTPUT	Pointer to the counters.
+NOTES	Threads are listed in order of creation. Under multithreading, the
+	counters are released when the thread terminates.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static timingthreadstruct	*get_timingthread(char *name)
+  {
+   timingthreadstruct	*thread, **pthread;
+   int			index;
+
+#ifdef USE_THREADS
+  pthread_once(&timing_once, init_timingkey);
+  QPTHREAD_MUTEX_LOCK(&timing_mutex);
+#endif
+  index = 0;
+  for (pthread=&timing_threads; (thread=*pthread); pthread=&thread->next)
+    if (!strcmp(thread->name, name))
+      {
+      if (!thread->activeflag)
+        break;
+      index++;
+      }
+  if (!thread)
+    {
+    QCALLOC(thread, timingthreadstruct, 1);
+    strncpy(thread->name, name, TIMING_NAMELEN-1);
+    thread->index = index;
+    thread->id = ++timing_nthread;
+    *pthread = thread;
+    }
+  thread->activeflag = 1;
+  thread->depth = 0;
+#ifdef USE_THREADS
+  QPTHREAD_MUTEX_UNLOCK(&timing_mutex);
+  pthread_setspecific(timing_key, thread);
+#endif
+
+  return thread;
+  }
+
+
+/****** add_timingevent ******************************************************
+PROTO	void add_timingevent(timingthreadstruct *thread, int stage,
+			double t0, double t1, double npix)
+PURPOSE	Add a span to the trace buffer of a thread.
+INPUT	Pointer to the thread counters,
+	stage (or TIMING_JOB),
+	wall-clock start time (s),
+	wall-clock end time (s),
+	number of pixels processed.
+OUTPUT	-.
+NOTES	Only the owner thread writes to its buffer, so no locking is needed.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	add_timingevent(timingthreadstruct *thread, int stage,
+			double t0, double t1, double npix)
+  {
+   timingeventstruct	*event;
+
+  if (thread->nevent >= thread->neventmax)
+    {
+    thread->neventmax += TIMING_NEVENTINC;
+    QREALLOC(thread->event, timingeventstruct, thread->neventmax);
+    }
+  event = &thread->event[thread->nevent++];
+  event->t0 = t0 - timing_trace0;
+  event->dt = t1 - t0;
+  event->npix = npix;
+  event->stage = stage;
+  event->job = timing_job;
+
+  return;
+  }
+
+
+/****** write_tracestring *****************************************************
+PROTO	void write_tracestring(FILE *file, char *str)
+PURPOSE	Write a string as a quoted JSON string.
+INPUT	File pointer,
+	string.
+OUTPUT	-.
+NOTES	Quotes, backslashes and control characters are escaped.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	write_tracestring(FILE *file, char *str)
+  {
+  putc('"', file);
+  for (; *str; str++)
+    if (*str == '"' || *str == '\\')
+      fprintf(file, "\\%c", *str);
+    else if ((unsigned char)*str < 0x20)
+      fprintf(file, "\\u%04x", (unsigned char)*str);
+    else
+      putc(*str, file);
+  putc('"', file);
+
+  return;
+  }
+
+
+#ifdef USE_THREADS
+/****** init_timingkey ********************************************************
+PROTO	void init_timingkey(void)
+PURPOSE	Create the key that releases thread counters on thread termination.
+INPUT	-.
+OUTPUT	-.
+NOTES	Called once through pthread_once().
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	init_timingkey(void)
+  {
+  if (pthread_key_create(&timing_key, release_timingthread))
+    error(EXIT_FAILURE, "*Error*: pthread_key_create() failed for ",
+	"timing_key");
+
+  return;
+  }
+
+
+/****** release_timingthread **************************************************
+PROTO	void release_timingthread(void *thread)
+PURPOSE	Release the counters of a terminated thread.
+INPUT	Pointer to the counters.
+OUTPUT	-.
+NOTES	-.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	release_timingthread(void *thread)
+  {
+  QPTHREAD_MUTEX_LOCK(&timing_mutex);
+  ((timingthreadstruct *)thread)->activeflag = 0;
+  QPTHREAD_MUTEX_UNLOCK(&timing_mutex);
+
+  return;
+  }
+#endif
+
+
+/****** get_timingclocks ******************************************************
+PROTO	void get_timingclocks(double *wall, double *cpu)
+PURPOSE	Read the wall-clock and CPU time of the calling thread.
+INPUT	Pointer to the wall-clock time (s),
+	pointer to the thread CPU time (s).
+OUTPUT	-.
+NOTES	Falls back to the process CPU time where per-thread CPU clocks are not
+	available. Both times are 0 as long as neither the timing counters
+	(reset_timing()) nor a trace (init_trace()) have been requested, so
+	that stages of conversions without XML output or trace cost no
+	system calls.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+static void	get_timingclocks(double *wall, double *cpu)
+  {
+   struct timespec	ts;
+
+  if (!timing_clockflag)
+    {
+    *wall = *cpu = 0.0;
+    return;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  *wall = (double)ts.tv_sec + 1e-9*ts.tv_nsec;
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  *cpu = (double)ts.tv_sec + 1e-9*ts.tv_nsec;
+#else
+  *cpu = (double)clock()/CLOCKS_PER_SEC;
+#endif
+
+  return;
+  }
+
@@ -0,0 +1,101 @@
+/*
+*				timing.h
+*
+* Include file for timing.c.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+/*----------------------------- Internal constants --------------------------*/
+#define	TIMING_MAXDEPTH		8	/* Max. nesting of timed stages */
+#define	TIMING_NAMELEN		32	/* Max. length of thread names */
+#define	TIMING_NEVENTINC	4096	/* Increment of the trace buffers */
+
+/* Processing stages */
+#define	TIMING_STATS		0	/* Image statistics */
+#define	TIMING_READ		1	/* Reading FITS rows */
+#define	TIMING_BIN		2	/* Binning and pyramid reduction */
+#define	TIMING_CONVERT		3	/* Conversion to output pixel values */
+#define	TIMING_TILE		4	/* Re-arranging rows into tiles */
+#define	TIMING_ENCODE		5	/* Encoding and writing output */
+#define	TIMING_WAIT		6	/* Waiting at thread barriers */
+#define	TIMING_NSTAGE		7	/* Number of stages */
+#define	TIMING_JOB		TIMING_NSTAGE	/* Whole job (trace only) */
+
+/*--------------------------------- typedefs --------------------------------*/
+typedef struct timingcount
+  {
+  long		ncall;			/* Number of timed calls */
+  double	wall;			/* Wall-clock time (s) */
+  double	cpu;			/* Thread CPU time (s) */
+  double	npix;			/* Number of pixels processed */
+  double	nbytes;			/* Number of bytes read or written */
+  }	timingcountstruct;
+
+typedef struct timingevent
+  {
+  double	t0;			/* Start time (s since trace start) */
+  double	dt;			/* Duration (s) */
+  double	npix;			/* Number of pixels processed */
+  int		stage;			/* Stage (or TIMING_JOB) */
+  int		job;			/* Job index */
+  }	timingeventstruct;
+
+typedef struct timingthread
+  {
+  char		name[TIMING_NAMELEN];	/* Thread role (e.g. "convert") */
+  int		index;			/* Index among threads of that role */
+  int		id;			/* Unique thread id in the trace */
+  int		activeflag;		/* Thread still running? */
+  timingcountstruct count[TIMING_NSTAGE];	/* Per-stage counters */
+  int		stage[TIMING_MAXDEPTH];	/* Stack of running stages */
+  int		depth;			/* Number of running stages */
+  double	start[TIMING_MAXDEPTH];	/* Start times of running stages */
+  double	wall0, cpu0;		/* Start of the current time slice */
+  timingeventstruct *event;		/* Trace events */
+  int		nevent, neventmax;	/* Number of trace events */
+  struct timingthread *next;		/* Next thread in the list */
+  }	timingthreadstruct;
+
+/*------------------------------- functions ---------------------------------*/
+
+extern timingthreadstruct	*get_timingthreads(void);
+
+extern const char		*timing_stagename[TIMING_NSTAGE];
+
+extern void	add_timingbytes(int stage, double nbytes),
+		end_trace(void),
+		init_trace(void),
+		reset_timing(void),
+		set_timingthread(char *name),
+		start_timing(int stage),
+		start_tracejob(char *name),
+		stop_timing(int stage, double npix, double nbytes),
+		stop_tracejob(void);
+
+extern int	write_trace(char *filename);
+
+#endif
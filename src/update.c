@@ -0,0 +1,313 @@
+/*
+*				update.c
+*
+* Update a sub-region of an existing TIFF pyramid.
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+*
+*	This file part of:	STIFF
+*
+*	Copyright:		(C) 2026 IAP/CNRS/UPMC
+*
+*	License:		GNU General Public License
+*
+*	STIFF is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*	STIFF is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*	You should have received a copy of the GNU General Public License
+*	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
+*
+*	Last modified:		19/10/2026
+*
+*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifdef HAVE_CONFIG_H
+#include	"config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "define.h"
+#include "globals.h"
+#include "fits/fitscat.h"
+#include "field.h"
+#include "image.h"
+#include "prefs.h"
+#include "progress.h"
+#include "tiff.h"
+#include "update.h"
+
+/****** image_update_pyramid **************************************************
+PROTO	int image_update_pyramid(char *filename, fieldstruct **field,
+			int nchan)
+PURPOSE	Recompute the tiles of an existing TIFF pyramid that depend on the
+	REGION of the input images, at all pyramid levels.
+INPUT	Name of the TIFF pyramid to be updated,
+	array of pointers to the input fields,
+	number of input fields (channels).
+OUTPUT	Number of updated tiles.
+NOTES	Uses the global preferences. Field levels must be those of the
+	original conversion. The full resolution window read from the input
+	images is aligned on the coarsest affected level, so that updated
+	pixels are identical to those of a complete conversion; other pixels of
+	the affected tiles are left untouched. JPEG-compressed pyramids must be
+	updated with the original COMPRESSION_QUALITY.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	image_update_pyramid(char *filename, fieldstruct **field, int nchan)
+  {
+   fieldstruct		wfield;
+   imagestruct		*image;
+   float		*data[MAXFILE], *datao[MAXFILE],
+			*fbuf,*fbuft, *datat, *fsbuf,
+			fpix, fac;
+   double		corner[4];
+   unsigned char	*pix, *tbuf, *tbuft;
+   size_t		tilebytes, pixbytes;
+   int			area[4], rect[4], recto[4], *levsize,
+			a,l,r, x,y, xm,ym, bx,by, tx,ty, tx1,ty1, x1,x2,
+			nlevels, ntiles, ntilesx, ntot, tilesize, nx,
+			width,height, fwidth,fheight, rwidth,owidth,
+			binsizex0,binsizey0, binsizex,binsizey,
+			binsizexmax,binsizeymax, flipxflag,flipyflag, bypp;
+
+  fwidth = field[0]->size[0];
+  fheight = field[0]->size[1];
+  for (a=1; a<nchan; a++)
+    if (field[a]->size[0] != fwidth || field[a]->size[1] != fheight)
+      error(EXIT_FAILURE, "*Error*: Image size doesn't match in ",
+		field[a]->rfilename);
+
+  flipxflag = (prefs.flip_type == FLIP_X) || (prefs.flip_type == FLIP_XY);
+  flipyflag = (prefs.flip_type == FLIP_Y) || (prefs.flip_type == FLIP_XY);
+  binsizex0 = prefs.bin_size[0];
+  binsizey0 = prefs.bin_size[1];
+  if (!(binsizexmax = fwidth%binsizex0))
+    binsizexmax = binsizex0;
+  if (!(binsizeymax = fheight%binsizey0))
+    binsizeymax = binsizey0;
+  width = (fwidth+binsizex0-1)/binsizex0;
+  height = (fheight+binsizey0-1)/binsizey0;
+
+/* Check that the pyramid was made from the same images and settings */
+  image = open_tiff(filename, prefs.compress_quality);
+  nlevels = pyramid_nlevels(width, height);
+  if (image->nlevels != nlevels)
+    error(EXIT_FAILURE, "*Error*: number of pyramid levels doesn't match in ",
+		filename);
+  if (image->nchan != nchan || image->bpp != abs(prefs.bpp)
+	|| image->fflag != (prefs.bpp<0))
+    error(EXIT_FAILURE, "*Error*: pixel format doesn't match in ", filename);
+  bypp = image->bypp;
+  QMALLOC(levsize, int, 2*nlevels);
+  for (l=0, x=width, y=height; l<nlevels; l++, x/=2, y/=2)
+    {
+    levsize[2*l] = x;
+    levsize[2*l+1] = y;
+    }
+
+/* Dirty area in full resolution pyramid pixels */
+  wfield = *field[0];
+  wfield.cache = NULL;
+  set_fieldregion(&wfield, prefs.region_type, prefs.region);
+  x = wfield.origin[0]/binsizex0;
+  xm = (wfield.origin[0]+wfield.size[0]-1)/binsizex0;
+  area[0] = flipxflag? width-1-xm : x;
+  area[2] = flipxflag? width-1-x : xm;
+  y = wfield.origin[1];
+  ym = wfield.origin[1]+wfield.size[1]-1;
+  area[1] = flipyflag? y/binsizey0 : (fheight-1-ym)/binsizey0;
+  area[3] = flipyflag? ym/binsizey0 : (fheight-1-y)/binsizey0;
+
+/* Full resolution window that covers the affected pixels of all levels */
+  rect[0] = area[0];
+  rect[1] = area[1];
+  rect[2] = area[2];
+  rect[3] = area[3];
+  for (l=1; l<nlevels && (area[0]>>l)<levsize[2*l]
+		&& (area[1]>>l)<levsize[2*l+1]; l++)
+    {
+    rect[0] = (area[0]>>l)<<l;
+    rect[1] = (area[1]>>l)<<l;
+    xm = (area[2]>>l)<levsize[2*l]? (area[2]>>l) : levsize[2*l]-1;
+    ym = (area[3]>>l)<levsize[2*l+1]? (area[3]>>l) : levsize[2*l+1]-1;
+    if (((xm+1)<<l)-1 > rect[2])
+      rect[2] = ((xm+1)<<l)-1;
+    if (((ym+1)<<l)-1 > rect[3])
+      rect[3] = ((ym+1)<<l)-1;
+    }
+
+/* Corresponding input image pixels (FITS convention) */
+  x = flipxflag? width-1-rect[2] : rect[0];
+  xm = flipxflag? width-1-rect[0] : rect[2];
+  corner[0] = x*binsizex0 + 1;
+  corner[2] = (xm+1)*binsizex0 < fwidth? (xm+1)*binsizex0 : fwidth;
+  if (flipyflag)
+    {
+    corner[1] = rect[1]*binsizey0 + 1;
+    corner[3] = (rect[3]+1)*binsizey0 < fheight? (rect[3]+1)*binsizey0
+						: fheight;
+    }
+  else
+    {
+    corner[1] = fheight-(rect[3]+1)*binsizey0 > 0?
+			fheight-(rect[3]+1)*binsizey0 + 1 : 1;
+    corner[3] = fheight - rect[1]*binsizey0;
+    }
+
+/* Read and bin the window pixels, exactly as image_convert_pyramid() does */
+  rwidth = rect[2]-rect[0]+1;
+  set_progressstage("reducing", -1, (double)rwidth*(rect[3]-rect[1]+1)*nchan);
+  for (a=0; a<nchan; a++)
+    {
+    wfield = *field[a];
+    wfield.cache = NULL;
+    set_fieldregion(&wfield, REGION_PIXEL, corner);
+    QMALLOC(fbuf, PIXTYPE, wfield.size[0]);
+    QCALLOC(data[a], float, (size_t)rwidth*(rect[3]-rect[1]+1));
+    datat = data[a];
+    for (y=rect[1]; y<=rect[3]; y++, datat+=rwidth)
+      {
+      if (y==rect[1] || !((y-rect[1]+1)%100))
+        NPRINTF(OUTPUT,
+		"\33[1M> Updating pyramid: Channel %1d/%-1d: "
+		"Reducing line %7d/%-7d\n\33[1A",
+		a+1, nchan, y-rect[1]+1, rect[3]-rect[1]+1);
+      binsizey = (y+1)<height? binsizey0 : binsizeymax;
+      ym = (flipyflag? y*binsizey0 : fheight-y*binsizey0-binsizey)
+		- wfield.origin[1];
+      for (by=0; by<binsizey; by++)
+        {
+        seek_fieldrow(&wfield, ym+by);
+        read_body(wfield.tab, fbuf, (size_t)wfield.size[0]);
+        for (x=rect[0]; x<=rect[2]; x++)
+          {
+          xm = flipxflag? width-1-x : x;
+          binsizex = (xm+1)<width? binsizex0 : binsizexmax;
+          fac = 1.0/(binsizex*binsizey);
+          fbuft = fbuf + xm*binsizex0 - wfield.origin[0];
+          fpix = 0;
+          for (bx=binsizex; bx--;)
+            fpix += *(fbuft++);
+          datat[x-rect[0]] += fac*fpix;
+          }
+        }
+      add_progress((double)rwidth, 0.0);
+      }
+    free(fbuf);
+    }
+
+  tilesize = image->tilesize;
+  tilebytes = (size_t)tilesize*tilesize*nchan*bypp;
+  pixbytes = (size_t)nchan*bypp;
+  ntot = 0;
+  for (l=0; l<nlevels && (area[0]>>l)<levsize[2*l]
+		&& (area[1]>>l)<levsize[2*l+1]; l++)
+    {
+    if (set_tiffdir(image, l) != RETURN_OK || image->width != levsize[2*l]
+	|| image->height != levsize[2*l+1] || image->tilesize != tilesize)
+      error(EXIT_FAILURE, "*Error*: pyramid level size doesn't match in ",
+		filename);
+/*-- Affected pixels and tiles at this level */
+    x = area[0]>>l;
+    y = area[1]>>l;
+    xm = (area[2]>>l)<levsize[2*l]? (area[2]>>l) : levsize[2*l]-1;
+    ym = (area[3]>>l)<levsize[2*l+1]? (area[3]>>l) : levsize[2*l+1]-1;
+    nx = xm-x+1;
+    tx = x/tilesize;
+    ty = y/tilesize;
+    tx1 = xm/tilesize;
+    ty1 = ym/tilesize;
+    ntilesx = tx1-tx+1;
+    ntiles = ntilesx*(ty1-ty+1);
+    NPRINTF(OUTPUT,
+		"\33[1M> Updating pyramid level %2d/%-2d: %d tile%s\n\33[1A",
+		l+1, nlevels, ntiles, ntiles>1? "s":"");
+/*-- Decode all the affected tiles before re-encoding any of them */
+    QMALLOC(tbuf, unsigned char, ntiles*tilebytes);
+    for (by=ty; by<=ty1; by++)
+      for (bx=tx; bx<=tx1; bx++)
+        if (read_tifftile(image, bx, by,
+		tbuf+((by-ty)*ntilesx+bx-tx)*tilebytes) != RETURN_OK)
+          error(EXIT_FAILURE, "*Error*: cannot read tile from ", filename);
+    QMALLOC(pix, unsigned char, nx*pixbytes);
+    QMALLOC(fsbuf, float, nx);
+    set_progressstage("updating", l, (double)nx*(ym-y+1));
+    for (r=y; r<=ym; r++)
+      {
+      data_to_pix(field, data, (size_t)(r-rect[1])*rwidth + x-rect[0], pix,
+		(size_t)nx, nchan, bypp, image->fflag, fsbuf);
+      by = r/tilesize;
+      for (bx=tx; bx<=tx1; bx++)
+        {
+        x1 = bx*tilesize > x? bx*tilesize : x;
+        x2 = (bx+1)*tilesize-1 < xm? (bx+1)*tilesize-1 : xm;
+        tbuft = tbuf + ((by-ty)*ntilesx+bx-tx)*tilebytes
+		+ ((size_t)(r-by*tilesize)*tilesize + x1-bx*tilesize)*pixbytes;
+        memcpy(tbuft, pix+(x1-x)*pixbytes, (x2-x1+1)*pixbytes);
+        }
+      add_progress((double)nx, (double)nx);
+      }
+    for (by=ty; by<=ty1; by++)
+      for (bx=tx; bx<=tx1; bx++)
+        if (write_tifftile(image, bx, by,
+		tbuf+((by-ty)*ntilesx+bx-tx)*tilebytes) != RETURN_OK)
+          error(EXIT_FAILURE, "*Error*: cannot write tile to ", filename);
+    free(fsbuf);
+    free(pix);
+    free(tbuf);
+    ntot += ntiles;
+
+/*-- Bin the window 2x2 for the next level */
+    recto[0] = (rect[0]+1)/2;
+    recto[1] = (rect[1]+1)/2;
+    recto[2] = (rect[2]+1)/2-1;
+    recto[3] = (rect[3]+1)/2-1;
+    owidth = recto[2]-recto[0]+1;
+    if (l==nlevels-1 || owidth<1 || recto[3]<recto[1])
+      break;
+    fac = 1.0/(2*2);
+    for (a=0; a<nchan; a++)
+      {
+      QCALLOC(datao[a], float, (size_t)owidth*(recto[3]-recto[1]+1));
+      datat = datao[a];
+      for (y=recto[1]; y<=recto[3]; y++, datat+=owidth)
+        for (by=0; by<2; by++)
+          {
+          fbuf = data[a] + (size_t)(2*y+by-rect[1])*rwidth;
+          for (x=recto[0]; x<=recto[2]; x++)
+            {
+            fbuft = fbuf + 2*x-rect[0];
+            fpix = 0;
+            for (bx=2; bx--;)
+              fpix += *(fbuft++);
+            datat[x-recto[0]] += fac*fpix;
+            }
+          }
+      free(data[a]);
+      data[a] = datao[a];
+      }
+    rect[0] = recto[0];
+    rect[1] = recto[1];
+    rect[2] = recto[2];
+    rect[3] = recto[3];
+    rwidth = owidth;
+    }
+
+/* Closing the file writes the updated directories */
+  end_tiff(image);
+  for (a=0; a<nchan; a++)
+    free(data[a]);
+  free(levsize);
+
+  return ntot;
+  }
+
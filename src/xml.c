@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		07/06/2016
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -40,17 +40,21 @@
 #include "define.h"
 #include "globals.h"
 #include "fits/fitscat.h"
+#include "datamem.h"
 #include "field.h"
 #include "key.h"
 #include "prefs.h"
+#include "timing.h"
 #include "xml.h"
 
 extern pkeystruct	key[];			/* from preflist.h */
 extern char		keylist[][32];		/* from preflist.h */
-extern time_t		thetime,thetime2;	/* from makeit.c */
-extern double		dtime;			/* from makeit.c */
-fieldstruct		**field_xml;
-int                     nxml, nxmlmax;
+/* Meta-data are kept per thread, for the job that thread runs */
+static THREAD_LOCAL fieldstruct		**field_xml;
+static THREAD_LOCAL xmljobstruct	*job_xml;
+static THREAD_LOCAL int			nxml, nxmlmax, njob_xml;
+/* Checksum verification status, in the order of field.h */
+static const char	*checksum_str[] = {"UNCHECKED", "NONE", "OK", "BAD"};
 
 /****** init_xml ************************************************************
 PROTO	int	init_xml(int nchan)
@@ -58,9 +62,10 @@ PURPOSE	Initialize a set of meta-data kept in memory before being written to the
 	XML file
 INPUT	Number of images (channels).
 OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
-NOTES	-.
+NOTES	Timing counters are reset, so that they cover what the XML file
+	reports.
 AUTHOR	E. Bertin (IAP)
-VERSION	30/12/2009
+VERSION	19/10/2026
  ***/
 int	init_xml(int nchan)
   {
@@ -72,6 +77,9 @@ int	init_xml(int nchan)
     field_xml = NULL;
   nxml = 0;
   nxmlmax = nchan;
+  job_xml = NULL;
+  njob_xml = 0;
+  reset_timing();
 
   return EXIT_SUCCESS;
   }
@@ -84,11 +92,15 @@ INPUT	-.
 OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	30/12/2009
+VERSION	19/10/2026
  ***/
 int	end_xml(void)
   {
   free(field_xml);
+  field_xml = NULL;
+  free(job_xml);
+  job_xml = NULL;
+  nxml = nxmlmax = njob_xml = 0;
 
   return EXIT_SUCCESS;
   }
@@ -113,6 +125,51 @@ int	update_xml(fieldstruct *field)
   }
 
 
+/****** set_xmljob ***********************************************************
+PROTO	void	set_xmljob(xmljobstruct *job)
+PURPOSE	Gather the meta-data of a batch job that has just completed.
+INPUT	Pointer to the job meta-data (output).
+OUTPUT	-.
+NOTES	Preferences of the job (bound to the calling thread) are used.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+void	set_xmljob(xmljobstruct *job)
+  {
+  strncpy(job->name, prefs.tiff_name, MAXCHAR-1);
+  job->name[MAXCHAR-1] = '\0';
+  job->nfile = prefs.nfile;
+  strcpy(job->sdate_end, prefs.sdate_end);
+  strcpy(job->stime_end, prefs.stime_end);
+  job->time_diff = prefs.time_diff;
+  job->nlines = prefs.nlines;
+  job->npix = prefs.npix;
+  job->mem_peak = prefs.mem_peak;
+  job->vmem_peak = prefs.vmem_peak;
+
+  return;
+  }
+
+
+/****** update_xmljob ********************************************************
+PROTO	int	update_xmljob(xmljobstruct *job)
+PURPOSE	Record the meta-data of a batch job that has completed.
+INPUT	Pointer to the job meta-data (see set_xmljob()).
+OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
+NOTES	Jobs may have run in other threads; they are recorded in the XML
+	meta-data of the calling thread.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	update_xmljob(xmljobstruct *job)
+  {
+  QREALLOC(job_xml, xmljobstruct, njob_xml+1);
+  job_xml[njob_xml++] = *job;
+
+  return EXIT_SUCCESS;
+  }
+
+
 /****** write_xml ************************************************************
 PROTO	int	write_xml(char *filename)
 PURPOSE	Save meta-data to an XML file/stream.
@@ -201,27 +258,25 @@ INPUT	Pointer to the output file (or stream),
 OUTPUT	RETURN_OK if everything went fine, RETURN_ERROR otherwise.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	07/06/2016
+VERSION	19/10/2026
  ***/
 int	write_xml_meta(FILE *file, char *error)
   {
-   struct tm		*tm;
    char			psuserb[MAXCHAR],
 			pshostb[MAXCHAR],
 			pspathb[MAXCHAR],
 			*pspath,*psuser, *pshost, *str;
-   int			n;
+   timingthreadstruct	*thread;
+   timingcountstruct	stage[TIMING_NSTAGE], *count;
+   size_t		peakram, peakvram, peakscratch;
+   double		busy;
+   int			n, s, nscratch;
 
 /* Processing date and time if msg error present */
   if (error)
     {
-    thetime2 = time(NULL);
-    tm = localtime(&thetime2);
-    sprintf(prefs.sdate_end,"%04d-%02d-%02d",
-        tm->tm_year+1900, tm->tm_mon+1, tm->tm_mday);
-    sprintf(prefs.stime_end,"%02d:%02d:%02d",
-        tm->tm_hour, tm->tm_min, tm->tm_sec);
-    prefs.time_diff = counter_seconds() - dtime;
+    set_datetime(prefs.sdate_end, prefs.stime_end);
+    prefs.time_diff = counter_seconds() - prefs.time_start;
     }
 
 /* Username and host computer */
@@ -272,6 +327,61 @@ int	write_xml_meta(FILE *file, char *error)
   fprintf(file, "  <PARAM name=\"NThreads\" datatype=\"int\""
 	" ucd=\"meta.number;meta.software\" value=\"%d\"/>\n",
     	prefs.nthreads);
+/* Batch jobs have their own budgets: report the largest peaks */
+  get_datapeaks(prefs.arena, &peakram, &peakvram);
+  for (n=0; n<njob_xml; n++)
+    {
+    if (job_xml[n].mem_peak > peakram)
+      peakram = job_xml[n].mem_peak;
+    if (job_xml[n].vmem_peak > peakvram)
+      peakvram = job_xml[n].vmem_peak;
+    }
+  fprintf(file, "  <PARAM name=\"Mem_Max\" datatype=\"int\""
+	" ucd=\"meta.number;stat.max\" value=\"%d\" unit=\"Mbyte\"/>\n",
+	prefs.mem_max);
+  fprintf(file, "  <PARAM name=\"Mem_Source\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta\" value=\"%s\"/>\n",
+	prefs.mem_source);
+  fprintf(file, "  <PARAM name=\"Mem_Peak\" datatype=\"float\""
+	" ucd=\"meta.number;stat.max\" value=\"%.1f\" unit=\"Mbyte\"/>\n",
+	peakram/(1024.0*1024.0));
+  fprintf(file, "  <PARAM name=\"VMem_Max\" datatype=\"int\""
+	" ucd=\"meta.number;stat.max\" value=\"%d\" unit=\"Mbyte\"/>\n",
+	prefs.vmem_max);
+  fprintf(file, "  <PARAM name=\"VMem_Source\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta\" value=\"%s\"/>\n",
+	prefs.vmem_source);
+  fprintf(file, "  <PARAM name=\"VMem_Peak\" datatype=\"float\""
+	" ucd=\"meta.number;stat.max\" value=\"%.1f\" unit=\"Mbyte\"/>\n",
+	peakvram/(1024.0*1024.0));
+  get_scratchpeaks(&peakscratch, &nscratch);
+  fprintf(file, "  <PARAM name=\"Scratch_Peak\" datatype=\"float\""
+	" ucd=\"meta.number;stat.max\" value=\"%.1f\" unit=\"Mbyte\"/>\n",
+	peakscratch/(1024.0*1024.0));
+  fprintf(file, "  <PARAM name=\"Scratch_NBuf\" datatype=\"int\""
+	" ucd=\"meta.number;stat.max\" value=\"%d\"/>\n",
+	nscratch);
+/* Sum up the timing counters of all threads */
+  memset(stage, 0, sizeof(stage));
+  for (thread=get_timingthreads(); thread; thread=thread->next)
+    for (count=thread->count, s=0; s<TIMING_NSTAGE; s++, count++)
+      {
+      stage[s].ncall += count->ncall;
+      stage[s].wall += count->wall;
+      stage[s].cpu += count->cpu;
+      stage[s].npix += count->npix;
+      stage[s].nbytes += count->nbytes;
+      }
+  fprintf(file, "  <PARAM name=\"Bytes_Read\" datatype=\"double\""
+	" ucd=\"meta.number\" value=\"%.0f\" unit=\"byte\"/>\n",
+	stage[TIMING_STATS].nbytes + stage[TIMING_READ].nbytes);
+  fprintf(file, "  <PARAM name=\"Bytes_Written\" datatype=\"double\""
+	" ucd=\"meta.number\" value=\"%.0f\" unit=\"byte\"/>\n",
+	stage[TIMING_ENCODE].nbytes);
+  fprintf(file, "  <PARAM name=\"Pixel_Throughput\" datatype=\"float\""
+	" ucd=\"arith.rate\" value=\"%.3f\" unit=\"Mpix/s\"/>\n",
+	prefs.time_diff>0.0? stage[TIMING_CONVERT].npix/prefs.time_diff*1e-6
+			: 0.0);
   fprintf(file, "  <PARAM name=\"Date\" datatype=\"char\" arraysize=\"*\""
 	" ucd=\"time.event.end;meta.software\" value=\"%s\"/>\n",
 	prefs.sdate_end);
@@ -342,11 +452,15 @@ int	write_xml_meta(FILE *file, char *error)
 	" ucd=\"phot.flux.sb;obs.image;stat.min\" unit=\"adu\"/>\n");
   fprintf(file, "   <FIELD name=\"Level_Max\" datatype=\"float\""
 	" ucd=\"phot.flux.sb;obs.image;stat.max\" unit=\"adu\"/>\n");
+  fprintf(file, "   <FIELD name=\"Checksum\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code.qual\"/>\n");
+/* Levels are written with full (float) precision for read_xmllevels() */
   fprintf(file, "   <DATA><TABLEDATA>\n");
   for (n=0; n<nxml; n++)
     fprintf(file, "    <TR>\n"
 	"     <TD>%d</TD><TD>%s</TD><TD>%s</TD><TD>%s</TD>\n"
-	"     <TD>%d %d</TD><TD>%g</TD><TD>%g</TD><TD>%g</TD>\n"
+	"     <TD>%d %d</TD><TD>%.9g</TD><TD>%.9g</TD><TD>%.9g</TD>\n"
+	"     <TD>%s</TD>\n"
 	"    </TR>\n",
 	n+1,
 	field_xml[n]->rfilename,
@@ -355,7 +469,117 @@ int	write_xml_meta(FILE *file, char *error)
 	field_xml[n]->size[0], field_xml[n]->size[1],
 	field_xml[n]->back,
 	field_xml[n]->min,
-	field_xml[n]->max);
+	field_xml[n]->max,
+	checksum_str[field_xml[n]->checksum_status]);
+  fprintf(file, "   </TABLEDATA></DATA>\n");
+  fprintf(file, "  </TABLE>\n");
+
+/* Meta-data for each batch job */
+  if (njob_xml)
+    {
+    fprintf(file, "  <TABLE ID=\"Batch_Jobs\" name=\"Batch_Jobs\">\n");
+    fprintf(file, "   <DESCRIPTION>Data gathered by %s for every batch"
+	" job</DESCRIPTION>\n", BANNER);
+    fprintf(file, "   <PARAM name=\"NJobs\" datatype=\"int\""
+	" ucd=\"meta.number;meta.dataset\" value=\"%d\"/>\n", njob_xml);
+    fprintf(file, "   <FIELD name=\"Job_Index\" datatype=\"int\""
+	" ucd=\"meta.record\"/>\n");
+    fprintf(file, "   <FIELD name=\"Image_Name\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"obs.image;meta.file\"/>\n");
+    fprintf(file, "   <FIELD name=\"NInputs\" datatype=\"int\""
+	" ucd=\"meta.number;meta.dataset\"/>\n");
+    fprintf(file, "   <FIELD name=\"Date\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"time.event.end;meta.software\"/>\n");
+    fprintf(file, "   <FIELD name=\"Time\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"time.event.end;meta.software\"/>\n");
+    fprintf(file, "   <FIELD name=\"Duration\" datatype=\"float\""
+	" ucd=\"time.event;meta.software\" unit=\"s\"/>\n");
+    fprintf(file, "   <FIELD name=\"Image_Size\" datatype=\"int\""
+	" arraysize=\"2\" ucd=\"meta.number;obs.image\" unit=\"pix\"/>\n");
+    fprintf(file, "   <FIELD name=\"Mem_Peak\" datatype=\"float\""
+	" ucd=\"meta.number;stat.max\" unit=\"Mbyte\"/>\n");
+    fprintf(file, "   <FIELD name=\"VMem_Peak\" datatype=\"float\""
+	" ucd=\"meta.number;stat.max\" unit=\"Mbyte\"/>\n");
+    fprintf(file, "   <DATA><TABLEDATA>\n");
+    for (n=0; n<njob_xml; n++)
+      fprintf(file, "    <TR>\n"
+	"     <TD>%d</TD><TD>%s</TD><TD>%d</TD><TD>%s</TD><TD>%s</TD>\n"
+	"     <TD>%.3f</TD><TD>%.0f %.0f</TD><TD>%.1f</TD><TD>%.1f</TD>\n"
+	"    </TR>\n",
+	n+1,
+	job_xml[n].name,
+	job_xml[n].nfile,
+	job_xml[n].sdate_end,
+	job_xml[n].stime_end,
+	job_xml[n].time_diff,
+	job_xml[n].nlines>0.0? job_xml[n].npix/job_xml[n].nlines : 0.0,
+	job_xml[n].nlines,
+	job_xml[n].mem_peak/(1024.0*1024.0),
+	job_xml[n].vmem_peak/(1024.0*1024.0));
+    fprintf(file, "   </TABLEDATA></DATA>\n");
+    fprintf(file, "  </TABLE>\n");
+    }
+
+/* Timing of processing stages (times are summed over threads) */
+  fprintf(file, "  <TABLE ID=\"Stage_Timing\" name=\"Stage_Timing\">\n");
+  fprintf(file, "   <DESCRIPTION>%s processing stages, summed over all"
+	" threads</DESCRIPTION>\n", BANNER);
+  fprintf(file, "   <FIELD name=\"Stage\" datatype=\"char\" arraysize=\"*\""
+	" ucd=\"meta.code\"/>\n");
+  fprintf(file, "   <FIELD name=\"NCalls\" datatype=\"long\""
+	" ucd=\"meta.number\"/>\n");
+  fprintf(file, "   <FIELD name=\"Wall_Time\" datatype=\"float\""
+	" ucd=\"time.duration\" unit=\"s\"/>\n");
+  fprintf(file, "   <FIELD name=\"CPU_Time\" datatype=\"float\""
+	" ucd=\"time.duration\" unit=\"s\"/>\n");
+  fprintf(file, "   <FIELD name=\"NPixels\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"pix\"/>\n");
+  fprintf(file, "   <FIELD name=\"NBytes\" datatype=\"double\""
+	" ucd=\"meta.number\" unit=\"byte\"/>\n");
+  fprintf(file, "   <FIELD name=\"Throughput\" datatype=\"float\""
+	" ucd=\"arith.rate\" unit=\"Mpix/s\"/>\n");
+  fprintf(file, "   <DATA><TABLEDATA>\n");
+  for (s=0; s<TIMING_NSTAGE; s++)
+    fprintf(file, "    <TR><TD>%s</TD><TD>%ld</TD><TD>%.3f</TD><TD>%.3f</TD>"
+	"<TD>%.0f</TD><TD>%.0f</TD><TD>%.3f</TD></TR>\n",
+	timing_stagename[s],
+	stage[s].ncall,
+	stage[s].wall,
+	stage[s].cpu,
+	stage[s].npix,
+	stage[s].nbytes,
+	stage[s].wall>0.0? stage[s].npix/stage[s].wall*1e-6 : 0.0);
+  fprintf(file, "   </TABLEDATA></DATA>\n");
+  fprintf(file, "  </TABLE>\n");
+
+/* Busy and idle times of every thread */
+  fprintf(file, "  <TABLE ID=\"Thread_Timing\" name=\"Thread_Timing\">\n");
+  fprintf(file, "   <DESCRIPTION>%s threads: time spent in processing stages"
+	" and waiting at barriers</DESCRIPTION>\n", BANNER);
+  fprintf(file, "   <FIELD name=\"Thread_Role\" datatype=\"char\""
+	" arraysize=\"*\" ucd=\"meta.code\"/>\n");
+  fprintf(file, "   <FIELD name=\"Thread_Index\" datatype=\"int\""
+	" ucd=\"meta.record\"/>\n");
+  fprintf(file, "   <FIELD name=\"Busy_Time\" datatype=\"float\""
+	" ucd=\"time.duration\" unit=\"s\"/>\n");
+  fprintf(file, "   <FIELD name=\"Idle_Time\" datatype=\"float\""
+	" ucd=\"time.duration\" unit=\"s\"/>\n");
+  fprintf(file, "   <FIELD name=\"NWaits\" datatype=\"long\""
+	" ucd=\"meta.number\"/>\n");
+  fprintf(file, "   <DATA><TABLEDATA>\n");
+  for (thread=get_timingthreads(); thread; thread=thread->next)
+    {
+    for (busy=0.0, s=0; s<TIMING_NSTAGE; s++)
+      if (s != TIMING_WAIT)
+        busy += thread->count[s].wall;
+    fprintf(file, "    <TR><TD>%s</TD><TD>%d</TD><TD>%.3f</TD><TD>%.3f</TD>"
+	"<TD>%ld</TD></TR>\n",
+	thread->name,
+	thread->index,
+	busy,
+	thread->count[TIMING_WAIT].wall,
+	thread->count[TIMING_WAIT].ncall);
+    }
   fprintf(file, "   </TABLEDATA></DATA>\n");
   fprintf(file, "  </TABLE>\n");
 
@@ -382,10 +606,9 @@ int	write_xml_meta(FILE *file, char *error)
   fprintf(file, "   <DESCRIPTION>%s configuration</DESCRIPTION>\n", BANNER);
   fprintf(file,
 	"   <PARAM name=\"Command_Line\" datatype=\"char\" arraysize=\"*\""
-	" ucd=\"obs.param\" value=\"%s",
-	prefs.command_line[0]);
-  for (n=1; n<prefs.ncommand_line; n++)
-    fprintf(file, " %s", prefs.command_line[n]);
+	" ucd=\"obs.param\" value=\"");
+  for (n=0; n<prefs.ncommand_line; n++)
+    fprintf(file, n? " %s" : "%s", prefs.command_line[n]);
   fprintf(file, "\"/>\n");
   fprintf(file,
 	"   <PARAM name=\"Prefs_Name\" datatype=\"char\" arraysize=\"*\""
@@ -401,6 +624,8 @@ int	write_xml_meta(FILE *file, char *error)
     write_xmlconfigparam(file,"Compression_Type","","meta.code;meta.file","%s");
     write_xmlconfigparam(file, "Compression_Quality", "","arith.factor","%d");
     write_xmlconfigparam(file, "Tile_Size", "", "meta.number", "%d");
+    write_xmlconfigparam(file, "TileFile_Type", "", "meta.code;meta.file",
+	"%s");
     write_xmlconfigparam(file, "Pyramid_MinSize", "", "meta.number", "%d");
     write_xmlconfigparam(file, "Binning", "", "meta.number", "%d");
     write_xmlconfigparam(file, "Flip_Type", "", "meta.code;pos", "%s");
@@ -496,11 +721,12 @@ INPUT	Output stream (file) pointer,
 OUTPUT	RETURN_OK if the keyword exists, RETURN_ERROR otherwise.
 NOTES	-.
 AUTHOR	E. Bertin (IAP)
-VERSION	28/01/2015
+VERSION	19/10/2026
  ***/
 int	write_xmlconfigparam(FILE *file, char *name, char *unit,
 		 char *ucd, char *format)
   {
+   void		*ptr;
    char		value[MAXCHAR], uunit[MAXCHAR];
    int		i,j,n;
 
@@ -508,6 +734,9 @@ int	write_xmlconfigparam(FILE *file, char *name, char *unit,
   if (!key[i].name[0])
     return RETURN_ERROR;
 
+/* Values are read from the preferences of the current job */
+  ptr = prefs_ptr(key[i].ptr);
+
   if (*unit)
     sprintf(uunit, " unit=\"%s\"", unit);
   else
@@ -515,22 +744,22 @@ int	write_xmlconfigparam(FILE *file, char *name, char *unit,
   switch(key[i].type)
     {
     case P_FLOAT:
-      sprintf(value, format, *((double *)key[i].ptr));
+      sprintf(value, format, *((double *)ptr));
       fprintf(file, "   <PARAM name=\"%s\"%s datatype=\"double\""
 	" ucd=\"%s\" value=\"%s\"/>\n",
 	name, uunit, ucd, value);
       break;
     case P_FLOATLIST:
-      n = *(key[i].nlistptr);
+      n = *(int *)prefs_ptr(key[i].nlistptr);
       if (n)
         {
-        sprintf(value, format, ((double *)key[i].ptr)[0]);
+        sprintf(value, format, ((double *)ptr)[0]);
         fprintf(file, "   <PARAM name=\"%s\"%s datatype=\"double\""
 		" arraysize=\"%d\" ucd=\"%s\" value=\"%s",
 		name, uunit, n, ucd, value);
         for (j=1; j<n; j++)
           {
-          sprintf(value, format, ((double *)key[i].ptr)[j]);
+          sprintf(value, format, ((double *)ptr)[j]);
           fprintf(file, " %s", value);
           }
         fprintf(file, "\"/>\n");
@@ -541,22 +770,22 @@ int	write_xmlconfigparam(FILE *file, char *name, char *unit,
 		name, uunit, ucd);
       break;
     case P_INT:
-      sprintf(value, format, *((int *)key[i].ptr));
+      sprintf(value, format, *((int *)ptr));
       fprintf(file, "   <PARAM name=\"%s\"%s datatype=\"int\""
 	" ucd=\"%s\" value=\"%s\"/>\n",
 	name, uunit, ucd, value);
       break;
     case P_INTLIST:
-      n = *(key[i].nlistptr);
+      n = *(int *)prefs_ptr(key[i].nlistptr);
       if (n)
         {
-        sprintf(value, format, ((int *)key[i].ptr)[0]);
+        sprintf(value, format, ((int *)ptr)[0]);
         fprintf(file, "   <PARAM name=\"%s\"%s datatype=\"int\""
 		" arraysize=\"%d\" ucd=\"%s\" value=\"%s",
 		name, uunit, n, ucd, value);
         for (j=1; j<n; j++)
           {
-          sprintf(value, format, ((int *)key[i].ptr)[j]);
+          sprintf(value, format, ((int *)ptr)[j]);
           fprintf(file, " %s", value);
           }
         fprintf(file, "\"/>\n");
@@ -567,22 +796,22 @@ int	write_xmlconfigparam(FILE *file, char *name, char *unit,
 		name, uunit, ucd);
       break;
     case P_BOOL:
-      sprintf(value, "%c", *((int *)key[i].ptr)? 'T':'F');
+      sprintf(value, "%c", *((int *)ptr)? 'T':'F');
       fprintf(file, "   <PARAM name=\"%s\" datatype=\"boolean\""
 	" ucd=\"%s\" value=\"%s\"/>\n",
 	name, ucd, value);
       break;
     case P_BOOLLIST:
-      n = *(key[i].nlistptr);
+      n = *(int *)prefs_ptr(key[i].nlistptr);
       if (n)
         {
-        sprintf(value, "%c", ((int *)key[i].ptr)[0]? 'T':'F');
+        sprintf(value, "%c", ((int *)ptr)[0]? 'T':'F');
         fprintf(file, "   <PARAM name=\"%s\" datatype=\"boolean\""
 		" arraysize=\"%d\" ucd=\"%s\" value=\"%s",
 		name, n, ucd, value);
         for (j=1; j<n; j++)
           {
-          sprintf(value, "%c", ((int *)key[i].ptr)[j]? 'T':'F');
+          sprintf(value, "%c", ((int *)ptr)[j]? 'T':'F');
           fprintf(file, " %s", value);
           }
         fprintf(file, "\"/>\n");
@@ -593,22 +822,22 @@ int	write_xmlconfigparam(FILE *file, char *name, char *unit,
 		name, ucd);
       break;
     case P_STRING:
-      sprintf(value, "%s", (char *)key[i].ptr);
+      sprintf(value, "%s", (char *)ptr);
       fprintf(file, "   <PARAM name=\"%s\" datatype=\"char\" arraysize=\"*\""
 	" ucd=\"%s\" value=\"%s\"/>\n",
 	name, ucd, value);
       break;
     case P_STRINGLIST:
-      n = *(key[i].nlistptr);
+      n = *(int *)prefs_ptr(key[i].nlistptr);
       if (n)
         {
-        sprintf(value, "%s", ((char **)key[i].ptr)[0]);
+        sprintf(value, "%s", ((char **)ptr)[0]);
         fprintf(file, "   <PARAM name=\"%s\" datatype=\"char\""
 		" arraysize=\"*\" ucd=\"%s\" value=\"%s",
 		name, ucd, value);
         for (j=1; j<n; j++)
           {
-          strcpy(value, ((char **)key[i].ptr)[j]);
+          strcpy(value, ((char **)ptr)[j]);
           fprintf(file, ",%s", value);
           }
         fprintf(file, "\"/>\n");
@@ -619,22 +848,22 @@ int	write_xmlconfigparam(FILE *file, char *name, char *unit,
 		name, ucd);
       break;
     case P_KEY:
-      strcpy(value, key[i].keylist[*((int *)key[i].ptr)]);
+      strcpy(value, key[i].keylist[*((int *)ptr)]);
       fprintf(file, "   <PARAM name=\"%s\" datatype=\"char\" arraysize=\"*\""
 	" ucd=\"%s\" value=\"%s\"/>\n",
 	name, ucd, value);
       break;
     case P_KEYLIST:
-      n = *(key[i].nlistptr);
+      n = *(int *)prefs_ptr(key[i].nlistptr);
       if (n)
         {
-        strcpy(value, key[i].keylist[((int *)key[i].ptr)[0]]);
+        strcpy(value, key[i].keylist[((int *)ptr)[0]]);
         fprintf(file, "   <PARAM name=\"%s\" datatype=\"char\""
 		" arraysize=\"*\" ucd=\"%s\" value=\"%s",
 		name, ucd, value);
         for (j=1; j<n; j++)
           {
-          strcpy(value, key[i].keylist[((int *)key[i].ptr)[j]]);
+          strcpy(value, key[i].keylist[((int *)ptr)[j]]);
           fprintf(file, ",%s", value);
           }
         fprintf(file, "\"/>\n");
@@ -652,3 +881,73 @@ int	write_xmlconfigparam(FILE *file, char *name, char *unit,
   return RETURN_OK;
   }
 
+
+
+/****** read_xmllevels ********************************************************
+PROTO	int read_xmllevels(char *filename, fieldstruct **field, int nfield)
+PURPOSE	Read back the background, min. and max. levels of the input images
+	from the XML file of a previous run.
+INPUT	XML file name,
+	array of pointers to the input fields,
+	number of input fields.
+OUTPUT	RETURN_OK if the levels of all fields were found, RETURN_ERROR
+	otherwise.
+NOTES	Only the "Input_Image_Data" table written by write_xml_meta() is
+	parsed; rows are matched to the (tagged and sorted) fields through
+	their position.
+AUTHOR	E. Bertin (IAP)
+VERSION	19/10/2026
+ ***/
+int	read_xmllevels(char *filename, fieldstruct **field, int nfield)
+  {
+   FILE		*file;
+   char		*buf, *str, *end, *rowend, *col[8];
+   long		size;
+   int		c,n, nfound;
+
+  if (!(file = fopen(filename, "r")))
+    return RETURN_ERROR;
+  fseek(file, 0L, SEEK_END);
+  size = ftell(file);
+  rewind(file);
+  QMALLOC(buf, char, size+1);
+  size = (long)fread(buf, 1, (size_t)size, file);
+  fclose(file);
+  buf[size] = '\0';
+
+  nfound = 0;
+  if (!(str = strstr(buf, "\"Input_Image_Data\""))
+	|| !(str = strstr(str, "<TABLEDATA>"))
+	|| !(end = strstr(str, "</TABLEDATA>")))
+    {
+    free(buf);
+    return RETURN_ERROR;
+    }
+  *end = '\0';
+  while ((str = strstr(str, "<TR>")) && (rowend = strstr(str, "</TR>")))
+    {
+    *rowend = '\0';
+/*-- Collect the row cells */
+    for (c=0; c<8 && (str = strstr(str, "<TD>")); c++)
+      {
+      col[c] = (str += 4);
+      if ((str = strstr(str, "</TD>")))
+        *(str++) = '\0';
+      else
+        break;
+      }
+    str = rowend + 5;
+    if (c<8)
+      continue;
+    if ((n = atoi(col[0]) - 1) < 0 || n >= nfield)
+      continue;
+    field[n]->back = (PIXTYPE)atof(col[5]);
+    field[n]->min = (PIXTYPE)atof(col[6]);
+    field[n]->max = (PIXTYPE)atof(col[7]);
+    nfound++;
+    }
+
+  free(buf);
+
+  return nfound==nfield? RETURN_OK : RETURN_ERROR;
+  }
@@ -22,7 +22,7 @@
 *	You should have received a copy of the GNU General Public License
 *	along with STIFF. If not, see <http://www.gnu.org/licenses/>.
 *
-*	Last modified:		13/10/2010
+*	Last modified:		19/10/2026
 *
 *%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
@@ -30,6 +30,9 @@
 #include	"config.h"
 #endif
 
+#ifndef _XML_H_
+#define _XML_H_
+
 #ifndef _FITSCAT_H_
 #include "fits/fitscat.h"
 #endif
@@ -44,12 +47,27 @@
 #endif
 
 /*--------------------------------- typedefs --------------------------------*/
+typedef struct
+  {
+  char		name[MAXCHAR];		/* Output file name */
+  int		nfile;			/* Number of input images */
+  char		sdate_end[12];		/* Job end date */
+  char		stime_end[12];		/* Job end time */
+  double	time_diff;		/* Job duration */
+  double	nlines;			/* Output image height */
+  double	npix;			/* Number of output image pixels */
+  size_t	mem_peak;		/* Peak RAM use (bytes) */
+  size_t	vmem_peak;		/* Peak VMEM use (bytes) */
+  }	xmljobstruct;
 
 /*------------------------------- functions ---------------------------------*/
 
 extern int		end_xml(void),
 			init_xml(int nchan),
+			read_xmllevels(char *filename, fieldstruct **field,
+				int nfield),
 			update_xml(fieldstruct *field),
+			update_xmljob(xmljobstruct *job),
 			write_xml(char *filename),
 			write_xml_header(FILE *file),
 			write_xml_meta(FILE *file, char *error),
@@ -57,4 +75,7 @@ extern int		end_xml(void),
 					char *ucd, char *format);
 
 
-extern void		write_xmlerror(char *filename, char *error);
+extern void		set_xmljob(xmljobstruct *job),
+			write_xmlerror(char *filename, char *error);
+
+#endif